@@ -1,6 +1,8 @@
 from pybind11.setup_helpers import Pybind11Extension, build_ext
 from setuptools import setup, find_packages
+import numpy
 import pybind11
+import os
 import platform
 
 ext_modules = [
@@ -8,10 +10,39 @@ ext_modules = [
         "vectors._vectors_core",
         [
             "src/vectors_cpp/vector_core.cpp",
+            "src/vectors_cpp/allocator.cpp",
+            "src/vectors_cpp/async_jobs.cpp",
+            "src/vectors_cpp/bvh.cpp",
+            "src/vectors_cpp/centroid_trackers.cpp",
+            "src/vectors_cpp/concurrent_store.cpp",
+            "src/vectors_cpp/dedup.cpp",
+            "src/vectors_cpp/dim_reduction.cpp",
+            "src/vectors_cpp/elementwise.cpp",
+            "src/vectors_cpp/file_io.cpp",
+            "src/vectors_cpp/geometry.cpp",
+            "src/vectors_cpp/loaders.cpp",
+            "src/vectors_cpp/lsh_index.cpp",
+            "src/vectors_cpp/matrix.cpp",
+            "src/vectors_cpp/morton.cpp",
+            "src/vectors_cpp/norm_cached_batch.cpp",
+            "src/vectors_cpp/online_stats.cpp",
+            "src/vectors_cpp/parallel.cpp",
+            "src/vectors_cpp/reduction.cpp",
+            "src/vectors_cpp/serialization.cpp",
+            "src/vectors_cpp/shared_batch.cpp",
+            "src/vectors_cpp/sparse_batch.cpp",
+            "src/vectors_cpp/sparse_vector.cpp",
+            "src/vectors_cpp/transform.cpp",
+            "src/vectors_cpp/ufuncs.cpp",
+            "src/vectors_cpp/vector_batch.cpp",
+            "src/vectors_cpp/vector_hash.cpp",
+            "src/vectors_cpp/vector_set.cpp",
+            "src/vectors_cpp/vector_store.cpp",
             "src/vectors_cpp/python_bindings.cpp",
         ],
         include_dirs=[
             "src/vectors_cpp",
+            numpy.get_include(),
         ],
         language="c++",
     ),
@@ -21,10 +52,27 @@ ext_modules = [
 if platform.system() == "Windows":
     extra_compile_args = ["/W4", "/std:c++17"]
 else:
-    extra_compile_args = ["-std=c++17", "-O3", "-march=native"]
+    # -fno-math-errno lets loops calling sqrt vectorize
+    extra_compile_args = ["-std=c++17", "-O3", "-march=native", "-fno-math-errno", "-pthread"]
 
 for ext in ext_modules:
     ext.extra_compile_args.extend(extra_compile_args)
+    if platform.system() != "Windows":
+        ext.extra_link_args.append("-pthread")
+    # shm_open lives in librt on older glibc
+    if platform.system() == "Linux":
+        ext.libraries.append("rt")
+    # Optional parallel backends: VECTORS_OPENMP=1 / VECTORS_TBB=1
+    if os.environ.get("VECTORS_OPENMP") == "1":
+        ext.define_macros.append(("VECTORS_WITH_OPENMP", None))
+        if platform.system() == "Windows":
+            ext.extra_compile_args.append("/openmp")
+        else:
+            ext.extra_compile_args.append("-fopenmp")
+            ext.extra_link_args.append("-fopenmp")
+    if os.environ.get("VECTORS_TBB") == "1":
+        ext.define_macros.append(("VECTORS_WITH_TBB", None))
+        ext.libraries.append("tbb")
 
 
 setup(
@@ -38,6 +38,7 @@ from .operations import (
     min_element,
     mean_element,
 )
+from .memory import arena, allocator_stats, reset_allocator_stats
 
 __all__ = [
     "Vector",
@@ -64,5 +65,8 @@ __all__ = [
     "max_element",
     "min_element",
     "mean_element",
+    "arena",
+    "allocator_stats",
+    "reset_allocator_stats",
 ]
 
@@ -0,0 +1,267 @@
+"""
+Async Batch API - Awaitable batch kernels for asyncio applications
+
+Each call submits its kernel to a native executor, which runs it on the C++
+thread pool with the GIL released, and returns once the result is ready. The
+event loop is woken through a file descriptor the executor signals when jobs
+finish, so no Python thread is tied up per job.
+
+Cancelling the awaiting task cancels the job: a queued job never starts and
+a running row-wise kernel stops at its next chunk of rows. Until a job has
+finished, calls that would reallocate a VectorBatch or NormCachedBatch it
+reads raise BufferError.
+"""
+
+import asyncio
+import collections
+import weakref
+
+
+def _core():
+    try:
+        from . import _vectors_core
+    except ImportError as exc:
+        raise ImportError("vectors.aio requires the compiled C++ core (_vectors_core)") from exc
+    return _vectors_core
+
+
+class AsyncBatchExecutor:
+    """
+    Runs batch kernels off the event loop with a bound on jobs in flight.
+
+    Args:
+        max_in_flight: Jobs that may be queued or running at once; further
+            calls wait for a free slot, which gives callers backpressure
+        dispatchers: Native threads that start jobs; each job's kernel is
+            itself spread over the shared thread pool
+
+    Examples:
+        >>> async with AsyncBatchExecutor(max_in_flight=8) as executor:
+        ...     scores = await executor.batch_cosine_similarity(corpus, query)
+    """
+
+    def __init__(self, max_in_flight: int = 64, dispatchers: int = 1):
+        self._executor = _core().AsyncExecutor(max_in_flight, dispatchers)
+        # A counter rather than asyncio.Semaphore, which would keep the loop
+        # alive for as long as the executor
+        self._free_slots = self._executor.max_in_flight
+        self._slot_waiters = collections.deque()
+        self._futures = {}
+        self._loop = None
+        self._watching = False
+        self._closing = None
+
+    @property
+    def max_in_flight(self) -> int:
+        """Limit on jobs queued or running at once."""
+        return self._executor.max_in_flight
+
+    @property
+    def in_flight(self) -> int:
+        """Jobs submitted whose results have not been delivered yet."""
+        return len(self._futures)
+
+    async def batch_dot_product(self, a, b):
+        """Dot products of matching rows, as a NumPy array."""
+        return await self._run(self._executor.submit_batch_dot_product, a, b)
+
+    async def batch_distance(self, vectors, query):
+        """Euclidean distance from every row to the query, as a NumPy array."""
+        return await self._run(self._executor.submit_batch_distance, vectors, query)
+
+    async def batch_cosine_similarity(self, vectors, query):
+        """Cosine similarity of every row with the query, as a NumPy array."""
+        return await self._run(self._executor.submit_batch_cosine_similarity, vectors, query)
+
+    async def batch_norms(self, vectors):
+        """Magnitude of every row, as a NumPy array."""
+        return await self._run(self._executor.submit_batch_norms, vectors)
+
+    async def batch_add(self, a, b):
+        """Row-wise sums of two batches, as a VectorBatch."""
+        return await self._run(self._executor.submit_batch_add, a, b)
+
+    async def centroid(self, vectors, mode=None):
+        """Centroid of the rows of a batch."""
+        return await self._run(self._executor.submit_centroid, vectors, mode)
+
+    async def k_nearest(self, vectors, query, k: int):
+        """Exact k nearest rows to the query, as (indices, distances)."""
+        return await self._run(self._executor.submit_k_nearest, vectors, query, k)
+
+    def close(self) -> None:
+        """
+        Cancel outstanding jobs and stop the native threads.
+
+        Stopping waits for running kernels, so on the executor's event loop
+        it is handed to the loop's default thread pool; ``aclose()`` awaits it.
+        """
+        loop = self._bound_loop()
+        if self._watching:
+            if loop is not None and not loop.is_closed():
+                loop.remove_reader(self._executor.notify_fd)
+            self._watching = False
+        for job, future in self._futures.values():
+            job.cancel()
+            if not future.done():
+                future.cancel()
+        self._futures.clear()
+        try:
+            running = asyncio.get_running_loop()
+        except RuntimeError:
+            running = None
+        if running is None or (self._loop is not None and running is not loop):
+            self._executor.close()
+        elif self._closing is None:
+            self._closing = running.run_in_executor(None, self._executor.close)
+
+    async def aclose(self) -> None:
+        """Close without blocking the event loop and wait for the native threads."""
+        self.close()
+        if self._closing is not None:
+            await self._closing
+
+    async def __aenter__(self):
+        return self
+
+    async def __aexit__(self, *exc_info):
+        await self.aclose()
+
+    def _bound_loop(self):
+        return self._loop() if self._loop is not None else None
+
+    async def _run(self, submit, *args):
+        loop = asyncio.get_running_loop()
+        if self._loop is None:
+            self._loop = weakref.ref(loop)
+        elif self._loop() is not loop:
+            raise RuntimeError("AsyncBatchExecutor is bound to a different event loop")
+
+        # The slot is returned when the job is drained, not when the caller
+        # stops waiting, so cancelled jobs still count until they have ended
+        await self._acquire_slot(loop)
+        try:
+            job = submit(*args)
+        except BaseException:
+            self._release_slot()
+            raise
+        future = loop.create_future()
+        self._futures[job.id] = (job, future)
+        self._watch(job)
+        try:
+            return await future
+        except asyncio.CancelledError:
+            job.cancel()
+            raise
+
+    async def _acquire_slot(self, loop):
+        while self._free_slots == 0:
+            waiter = loop.create_future()
+            self._slot_waiters.append(waiter)
+            try:
+                await waiter
+            except asyncio.CancelledError:
+                # Pass on a wakeup that arrived together with the cancellation
+                if waiter.done() and not waiter.cancelled():
+                    self._wake_slot_waiter()
+                raise
+            finally:
+                if waiter in self._slot_waiters:
+                    self._slot_waiters.remove(waiter)
+        self._free_slots -= 1
+
+    def _release_slot(self):
+        self._free_slots += 1
+        self._wake_slot_waiter()
+
+    def _wake_slot_waiter(self):
+        while self._slot_waiters:
+            waiter = self._slot_waiters.popleft()
+            if not waiter.done():
+                waiter.set_result(None)
+                return
+
+    def _watch(self, job):
+        if self._watching:
+            return
+        loop = self._bound_loop()
+        fd = self._executor.notify_fd
+        if fd >= 0:
+            try:
+                loop.add_reader(fd, self._deliver)
+                self._watching = True
+                return
+            except NotImplementedError:
+                pass
+        # Loops without add_reader (e.g. the Windows proactor loop) wait for
+        # each job on the default thread pool instead
+        waiting = loop.run_in_executor(None, job.wait)
+        waiting.add_done_callback(lambda _: self._deliver())
+
+    def _deliver(self):
+        for job in self._executor.drain():
+            entry = self._futures.pop(job.id, None)
+            if entry is None:
+                continue
+            self._release_slot()
+            future = entry[1]
+            if future.done():
+                continue
+            if job.state == _core().JobState.CANCELLED:
+                future.cancel()
+                continue
+            try:
+                future.set_result(job.result())
+            except Exception as exc:
+                future.set_exception(exc)
+
+
+_default_executors = weakref.WeakKeyDictionary()
+
+
+def default_executor() -> AsyncBatchExecutor:
+    """The executor used by this module's functions for the running event loop."""
+    loop = asyncio.get_running_loop()
+    executor = _default_executors.get(loop)
+    if executor is None:
+        executor = AsyncBatchExecutor()
+        _default_executors[loop] = executor
+        # The executor only refers to the loop weakly, so the entry goes with
+        # the loop, and its native threads are stopped then
+        weakref.finalize(loop, executor.close)
+    return executor
+
+
+async def batch_dot_product(a, b):
+    """Awaitable ``batch_dot_product`` on the default executor."""
+    return await default_executor().batch_dot_product(a, b)
+
+
+async def batch_distance(vectors, query):
+    """Awaitable ``batch_distance`` on the default executor."""
+    return await default_executor().batch_distance(vectors, query)
+
+
+async def batch_cosine_similarity(vectors, query):
+    """Awaitable ``batch_cosine_similarity`` on the default executor."""
+    return await default_executor().batch_cosine_similarity(vectors, query)
+
+
+async def batch_norms(vectors):
+    """Awaitable ``batch_norms`` on the default executor."""
+    return await default_executor().batch_norms(vectors)
+
+
+async def batch_add(a, b):
+    """Awaitable ``batch_add`` on the default executor."""
+    return await default_executor().batch_add(a, b)
+
+
+async def centroid(vectors, mode=None):
+    """Awaitable ``centroid`` on the default executor."""
+    return await default_executor().centroid(vectors, mode)
+
+
+async def k_nearest(vectors, query, k: int):
+    """Awaitable ``k_nearest`` on the default executor."""
+    return await default_executor().k_nearest(vectors, query, k)
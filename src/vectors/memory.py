@@ -0,0 +1,46 @@
+"""
+Memory Controls - Storage pooling for the C++ core
+
+Vectors created and dropped inside an ``arena()`` block reuse each other's
+storage instead of going back to malloc. Vectors may safely outlive the block.
+"""
+
+
+def _core():
+    try:
+        from . import _vectors_core
+    except ImportError as exc:
+        raise ImportError("vectors.arena requires the compiled C++ core (_vectors_core)") from exc
+    return _vectors_core
+
+
+def arena():
+    """
+    Pool VectorND storage on the calling thread for the duration of a block.
+    
+    Returns:
+        A context manager; blocks nest, and cached storage is released when
+        the outermost one exits.
+    
+    Examples:
+        >>> with arena():
+        ...     for _ in range(1000):
+        ...         position = position + velocity * dt
+    """
+    return _core().arena()
+
+
+def allocator_stats():
+    """
+    Allocation counters of the calling thread.
+    
+    Returns:
+        AllocatorStats with allocations, pool_hits, system_allocations,
+        system_frees and pooled_bytes
+    """
+    return _core().allocator_stats()
+
+
+def reset_allocator_stats() -> None:
+    """Reset the calling thread's allocation counters."""
+    _core().reset_allocator_stats()
@@ -0,0 +1,31 @@
+"""
+NumPy Ufuncs - Core vector kernels as NumPy generalized ufuncs
+
+Each function works on the last axis of its arguments and broadcasts over
+the rest, so stacks of vectors need no Python loop and no VectorND objects.
+All of them accept ``out=`` and the other standard ufunc keywords.
+
+Zero vectors give NaN from ``normalize`` and ``cosine_similarity``, reported
+as an invalid value under ``numpy.errstate`` rather than raised.
+"""
+
+try:
+    from ._vectors_core import ufuncs as _ufuncs
+except ImportError as exc:
+    raise ImportError("vectors.ufuncs requires the compiled C++ core (_vectors_core)") from exc
+
+dot = _ufuncs.dot                              # (n),(n)->()
+cross = _ufuncs.cross                          # (3),(3)->(3)
+normalize = _ufuncs.normalize                  # (n)->(n)
+magnitude = _ufuncs.magnitude                  # (n)->()
+distance = _ufuncs.distance                    # (n),(n)->()
+cosine_similarity = _ufuncs.cosine_similarity  # (n),(n)->()
+
+__all__ = [
+    "dot",
+    "cross",
+    "normalize",
+    "magnitude",
+    "distance",
+    "cosine_similarity",
+]
@@ -0,0 +1,114 @@
+#include "allocator.h"
+#include <new>
+#include <utility>
+
+namespace vectors {
+
+namespace {
+
+constexpr size_t kGranule = sizeof(double);
+constexpr size_t kClasses = kMaxPooledBytes / kGranule + 1;
+
+// Cached buffers by capacity; exists only while a scope is open
+struct Cache {
+    std::vector<std::vector<double>> free_lists[kClasses];
+};
+
+// Trivially destructible on purpose: storage freed during thread or static
+// teardown must still find a valid (if inactive) pool
+struct ThreadPool {
+    size_t depth;
+    Cache* cache;
+    AllocatorStats stats;
+};
+
+thread_local ThreadPool pool = {};
+
+// Free-list index for a buffer size, or 0 if the size is not pooled
+size_t size_class(size_t bytes) {
+    if (bytes == 0 || bytes > kMaxPooledBytes || bytes % kGranule != 0) {
+        return 0;
+    }
+    return bytes / kGranule;
+}
+
+} // namespace
+
+namespace detail {
+
+std::vector<double> pool_acquire(size_t count, double value) {
+    ++pool.stats.allocations;
+    const size_t bytes = count * sizeof(double);
+    const size_t index = size_class(bytes);
+    if (pool.cache && index != 0 && !pool.cache->free_lists[index].empty()) {
+        std::vector<std::vector<double>>& list = pool.cache->free_lists[index];
+        std::vector<double> storage = std::move(list.back());
+        list.pop_back();
+        pool.stats.pooled_bytes -= bytes;
+        ++pool.stats.pool_hits;
+        storage.assign(count, value);
+        return storage;
+    }
+    if (count != 0) {
+        ++pool.stats.system_allocations;
+    }
+    return std::vector<double>(count, value);
+}
+
+void pool_release(std::vector<double>& storage) noexcept {
+    const size_t bytes = storage.capacity() * sizeof(double);
+    if (bytes == 0) {
+        return;
+    }
+    const size_t index = size_class(bytes);
+    if (pool.cache && index != 0) {
+        try {
+            pool.cache->free_lists[index].push_back(std::move(storage));
+            pool.stats.pooled_bytes += bytes;
+            return;
+        } catch (const std::bad_alloc&) {
+            // The free list could not grow; free the buffer instead
+        }
+    }
+    ++pool.stats.system_frees;
+    std::vector<double>().swap(storage);
+}
+
+} // namespace detail
+
+AllocatorStats allocator_stats() {
+    return pool.stats;
+}
+
+void reset_allocator_stats() {
+    uint64_t pooled = pool.stats.pooled_bytes;
+    pool.stats = AllocatorStats{};
+    pool.stats.pooled_bytes = pooled;
+}
+
+void release_pooled_memory() {
+    if (!pool.cache) {
+        return;
+    }
+    for (std::vector<std::vector<double>>& list : pool.cache->free_lists) {
+        pool.stats.system_frees += list.size();
+        list.clear();
+    }
+    pool.stats.pooled_bytes = 0;
+}
+
+PoolScope::PoolScope() {
+    if (pool.depth++ == 0) {
+        pool.cache = new Cache();
+    }
+}
+
+PoolScope::~PoolScope() {
+    if (--pool.depth == 0) {
+        release_pooled_memory();
+        delete pool.cache;
+        pool.cache = nullptr;
+    }
+}
+
+} // namespace vectors
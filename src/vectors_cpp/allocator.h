@@ -0,0 +1,67 @@
+#ifndef ALLOCATOR_H
+#define ALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vectors {
+
+/**
+ * Opt-in pooling for VectorND storage.
+ *
+ * While a PoolScope is open on a thread, storage that thread frees is kept
+ * in per-size free lists and handed back out for the next vector of the same
+ * size, so loops that create and drop temporaries stop calling malloc once
+ * warmed up. Blocks are ordinary heap blocks: a vector may outlive the scope
+ * or move to another thread. When the outermost scope closes, the cached
+ * blocks are released.
+ *
+ * VectorND keeps its components in a plain std::vector<double>; the pool
+ * caches whole buffers, keyed by capacity, rather than replacing the
+ * allocator. Only buffers of up to kMaxPooledBytes are pooled; larger ones
+ * always go back to the system allocator.
+ */
+constexpr size_t kMaxPooledBytes = 2048;
+
+// Counters for the calling thread
+struct AllocatorStats {
+    uint64_t allocations;         // storage requests
+    uint64_t pool_hits;           // requests served from the pool
+    uint64_t system_allocations;  // calls to operator new
+    uint64_t system_frees;        // calls to operator delete
+    uint64_t pooled_bytes;        // bytes currently cached in the pool
+};
+
+AllocatorStats allocator_stats();
+void reset_allocator_stats();
+
+/**
+ * PoolScope - Enables storage pooling on the current thread
+ *
+ * Scopes nest; cached blocks are released when the outermost one closes.
+ */
+class PoolScope {
+public:
+    PoolScope();
+    ~PoolScope();
+
+    PoolScope(const PoolScope&) = delete;
+    PoolScope& operator=(const PoolScope&) = delete;
+};
+
+// Releases the blocks cached by this thread's pool without closing the scope
+void release_pooled_memory();
+
+namespace detail {
+// Storage for a new vector of `count` components set to `value`, reusing a
+// cached buffer of exactly that capacity when the pool has one
+std::vector<double> pool_acquire(size_t count, double value);
+// Takes the buffer of a vector being destroyed or overwritten, caching it
+// while a scope is open; `storage` is left empty
+void pool_release(std::vector<double>& storage) noexcept;
+} // namespace detail
+
+} // namespace vectors
+
+#endif // ALLOCATOR_H
@@ -0,0 +1,200 @@
+#include "async_jobs.h"
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#include <unistd.h>
+#elif !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace vectors {
+
+// AsyncJob
+
+AsyncJob::AsyncJob(uint64_t id, Work work) : id_(id), work_(std::move(work)) {}
+
+bool AsyncJob::finished() const {
+    JobState s = state();
+    return s == JobState::Done || s == JobState::Failed || s == JobState::Cancelled;
+}
+
+void AsyncJob::wait() const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [&] { return finished(); });
+}
+
+void AsyncJob::rethrow() const {
+    if (state() == JobState::Failed) {
+        std::rethrow_exception(error_);
+    }
+}
+
+void AsyncJob::finish(JobState state, std::exception_ptr error) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        error_ = std::move(error);
+        state_.store(state, std::memory_order_release);
+        // The work may hold references to its inputs; drop them now
+        work_ = nullptr;
+    }
+    done_.notify_all();
+}
+
+// AsyncExecutor
+
+AsyncExecutor::AsyncExecutor(size_t max_in_flight, size_t dispatchers)
+    : max_in_flight_(max_in_flight) {
+    if (max_in_flight == 0 || dispatchers == 0) {
+        throw std::invalid_argument("AsyncExecutor needs at least one job slot and dispatcher");
+    }
+#if defined(__linux__)
+    notify_read_ = notify_write_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#elif !defined(_WIN32)
+    int fds[2];
+    if (pipe(fds) == 0) {
+        for (int fd : fds) {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+        }
+        notify_read_ = fds[0];
+        notify_write_ = fds[1];
+    }
+#endif
+    dispatchers_.reserve(dispatchers);
+    for (size_t i = 0; i < dispatchers; ++i) {
+        dispatchers_.emplace_back([this] { dispatch(); });
+    }
+}
+
+AsyncExecutor::~AsyncExecutor() {
+    close();
+#if !defined(_WIN32)
+    if (notify_read_ >= 0) {
+        ::close(notify_read_);
+    }
+    if (notify_write_ >= 0 && notify_write_ != notify_read_) {
+        ::close(notify_write_);
+    }
+#endif
+}
+
+size_t AsyncExecutor::in_flight() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return in_flight_;
+}
+
+std::shared_ptr<AsyncJob> AsyncExecutor::submit(AsyncJob::Work work) {
+    std::shared_ptr<AsyncJob> job;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_) {
+            throw std::runtime_error("AsyncExecutor is closed");
+        }
+        if (in_flight_ >= max_in_flight_) {
+            throw std::runtime_error("Too many jobs in flight: limit is " +
+                                     std::to_string(max_in_flight_));
+        }
+        job.reset(new AsyncJob(next_id_++, std::move(work)));
+        queue_.push_back(job);
+        ++in_flight_;
+    }
+    wake_.notify_one();
+    return job;
+}
+
+std::vector<std::shared_ptr<AsyncJob>> AsyncExecutor::drain() {
+    // Clear the signal before taking the list: a job finishing in between
+    // signals again, so no completion is left unannounced
+    clear_signal();
+    std::vector<std::shared_ptr<AsyncJob>> jobs;
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs.swap(finished_);
+    return jobs;
+}
+
+void AsyncExecutor::close() {
+    std::deque<std::shared_ptr<AsyncJob>> queued;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_) {
+            return;
+        }
+        closed_ = true;
+        queued.swap(queue_);
+    }
+    wake_.notify_all();
+    for (const auto& job : queued) {
+        complete(job, JobState::Cancelled, nullptr);
+    }
+    for (auto& dispatcher : dispatchers_) {
+        dispatcher.join();
+    }
+}
+
+void AsyncExecutor::dispatch() {
+    for (;;) {
+        std::shared_ptr<AsyncJob> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [&] { return closed_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                return;
+            }
+            job = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        if (job->cancel_requested()) {
+            complete(job, JobState::Cancelled, nullptr);
+            continue;
+        }
+        job->state_.store(JobState::Running, std::memory_order_release);
+        try {
+            job->work_(*job);
+            complete(job, job->cancel_requested() ? JobState::Cancelled : JobState::Done, nullptr);
+        } catch (...) {
+            complete(job, JobState::Failed, std::current_exception());
+        }
+    }
+}
+
+void AsyncExecutor::complete(const std::shared_ptr<AsyncJob>& job, JobState state,
+                             std::exception_ptr error) {
+    job->finish(state, std::move(error));
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finished_.push_back(job);
+        --in_flight_;
+    }
+    signal();
+}
+
+void AsyncExecutor::signal() {
+#if defined(__linux__)
+    uint64_t one = 1;
+    ssize_t written = write(notify_write_, &one, sizeof(one));
+    (void)written;
+#elif !defined(_WIN32)
+    // A full pipe already reads as ready, so a failed write loses nothing
+    char byte = 1;
+    ssize_t written = write(notify_write_, &byte, 1);
+    (void)written;
+#endif
+}
+
+void AsyncExecutor::clear_signal() {
+#if defined(__linux__)
+    uint64_t count;
+    ssize_t got = read(notify_read_, &count, sizeof(count));
+    (void)got;
+#elif !defined(_WIN32)
+    char buffer[64];
+    while (read(notify_read_, buffer, sizeof(buffer)) > 0) {
+    }
+#endif
+}
+
+} // namespace vectors
@@ -0,0 +1,129 @@
+#ifndef ASYNC_JOBS_H
+#define ASYNC_JOBS_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vectors {
+
+enum class JobState : uint8_t { Pending, Running, Done, Failed, Cancelled };
+
+/**
+ * AsyncJob - One unit of work submitted to an AsyncExecutor
+ *
+ * Cancelling a pending job keeps it from starting. A running job stops at
+ * its next chunk boundary if its work checks cancel_requested(), as the
+ * for_each_job_chunk helper does; otherwise it runs to completion.
+ */
+class AsyncJob {
+public:
+    using Work = std::function<void(const AsyncJob&)>;
+
+    // Elements processed between cancellation checks by for_each_job_chunk
+    static constexpr size_t kChunkWork = size_t(1) << 20;
+
+    uint64_t id() const { return id_; }
+    JobState state() const { return state_.load(std::memory_order_acquire); }
+    bool finished() const;
+
+    void cancel() { cancel_requested_.store(true, std::memory_order_relaxed); }
+    bool cancel_requested() const { return cancel_requested_.load(std::memory_order_relaxed); }
+
+    // Blocks until the job has finished
+    void wait() const;
+    // Rethrows the exception of a failed job
+    void rethrow() const;
+
+private:
+    friend class AsyncExecutor;
+
+    AsyncJob(uint64_t id, Work work);
+
+    uint64_t id_;
+    Work work_;
+    std::atomic<JobState> state_{JobState::Pending};
+    std::atomic<bool> cancel_requested_{false};
+    std::exception_ptr error_;
+    mutable std::mutex mutex_;
+    mutable std::condition_variable done_;
+
+    void finish(JobState state, std::exception_ptr error);
+};
+
+/**
+ * AsyncExecutor - Runs jobs on background dispatcher threads and reports
+ * completions through a pollable file descriptor
+ *
+ * Jobs call the ordinary batch kernels, which spread their work over the
+ * shared thread pool. Finished jobs are collected with drain(); notify_fd()
+ * becomes readable whenever there is something to drain, so event loops can
+ * wait on it instead of blocking a thread per job. At most max_in_flight
+ * jobs may be queued or running at once; submit throws beyond that.
+ */
+class AsyncExecutor {
+public:
+    explicit AsyncExecutor(size_t max_in_flight = 64, size_t dispatchers = 1);
+    AsyncExecutor(const AsyncExecutor&) = delete;
+    AsyncExecutor& operator=(const AsyncExecutor&) = delete;
+    ~AsyncExecutor();
+
+    size_t max_in_flight() const { return max_in_flight_; }
+    size_t in_flight() const;
+
+    std::shared_ptr<AsyncJob> submit(AsyncJob::Work work);
+    // Jobs finished since the last call, in completion order
+    std::vector<std::shared_ptr<AsyncJob>> drain();
+
+    // Readable while finished jobs are waiting to be drained; -1 on
+    // platforms without one
+    int notify_fd() const { return notify_read_; }
+
+    // Cancels queued jobs and waits for running ones; further submits throw
+    void close();
+
+private:
+    size_t max_in_flight_;
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<std::shared_ptr<AsyncJob>> queue_;
+    std::vector<std::shared_ptr<AsyncJob>> finished_;
+    size_t in_flight_ = 0;
+    uint64_t next_id_ = 0;
+    bool closed_ = false;
+    std::vector<std::thread> dispatchers_;
+    int notify_read_ = -1;
+    int notify_write_ = -1;
+
+    void dispatch();
+    void complete(const std::shared_ptr<AsyncJob>& job, JobState state, std::exception_ptr error);
+    void signal();
+    void clear_signal();
+};
+
+// Runs body(begin, end) over consecutive row ranges of about
+// AsyncJob::kChunkWork elements, checking for cancellation in between;
+// returns false if the job was cancelled before all rows were done
+template <typename Body>
+bool for_each_job_chunk(const AsyncJob& job, size_t count, size_t dim, const Body& body) {
+    size_t rows = std::max<size_t>(1, AsyncJob::kChunkWork / std::max<size_t>(1, dim));
+    for (size_t begin = 0; begin < count; begin += rows) {
+        if (job.cancel_requested()) {
+            return false;
+        }
+        body(begin, std::min(count, begin + rows));
+    }
+    return true;
+}
+
+} // namespace vectors
+
+#endif // ASYNC_JOBS_H
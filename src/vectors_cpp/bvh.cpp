@@ -0,0 +1,659 @@
+#include "bvh.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace vectors {
+
+namespace {
+
+// Rows per task
+constexpr size_t kRowBlock = 4096;
+
+// Queries per task; a multiple of the packet width. Queries cost far more
+// than a row copy, so tasks are kept small
+constexpr size_t kQueryBlock = 64;
+
+// Rough work per query, in the units of the parallel threshold
+constexpr size_t kQueryWork = 256;
+
+// Rays traced together
+constexpr size_t kPacket = 8;
+
+constexpr size_t kBins = 16;
+
+// Nodes with at most kLeafSize primitives are always leaves and nodes with
+// more than kMaxLeafSize are always split
+constexpr size_t kLeafSize = 2;
+constexpr size_t kMaxLeafSize = 16;
+
+// Subtrees with this many primitives are built as tasks of their own
+constexpr size_t kParallelBuild = size_t(1) << 14;
+
+// Deeper nodes split at the median instead, which bounds the depth
+// for pathological centroid distributions
+constexpr size_t kMaxSahDepth = 48;
+
+// Cost of visiting a node relative to testing one primitive
+constexpr double kTraversalCost = 1.0;
+
+// Node indices must fit the 32-bit node fields
+constexpr size_t kMaxPrimitives = size_t(1) << 30;
+
+constexpr double kInf = std::numeric_limits<double>::infinity();
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+constexpr uint64_t kNone = std::numeric_limits<uint64_t>::max();
+
+// Runs body(begin, end) over row blocks, in parallel for large batches
+template <typename Body>
+void for_each_row_block(size_t count, size_t dim, const Body& body) {
+    size_t blocks = (count + kRowBlock - 1) / kRowBlock;
+    auto task = [&](size_t b) {
+        body(b * kRowBlock, std::min(count, (b + 1) * kRowBlock));
+    };
+    parallel_for(blocks, count * dim, task);
+}
+
+// Runs body(begin, end) over query blocks, in parallel
+template <typename Body>
+void for_each_query_block(size_t count, const Body& body) {
+    size_t blocks = (count + kQueryBlock - 1) / kQueryBlock;
+    auto task = [&](size_t b) {
+        body(b * kQueryBlock, std::min(count, (b + 1) * kQueryBlock));
+    };
+    parallel_for(blocks, count * kQueryWork, task);
+}
+
+void check_points(const BatchView& points, const char* operation) {
+    if (points.dim != 3) {
+        throw std::runtime_error(
+            std::string("Dimension mismatch in ") + operation + ": 3 vs " +
+            std::to_string(points.dim)
+        );
+    }
+}
+
+// Checks that `b` pairs with `a` and returns it as a view of a.count rows,
+// repeating a single row
+BatchView paired(const BatchView& a, const BatchView& b, const char* operation) {
+    check_points(b, operation);
+    if (b.count == 1) {
+        return BatchView{b.data, a.count, b.dim, 0};
+    }
+    if (a.count != b.count) {
+        throw std::runtime_error(
+            std::string("Batch size mismatch in ") + operation + ": " +
+            std::to_string(a.count) + " vs " + std::to_string(b.count)
+        );
+    }
+    return b;
+}
+
+struct Bounds {
+    double lo[3];
+    double hi[3];
+};
+
+Bounds empty_bounds() {
+    return Bounds{{kInf, kInf, kInf}, {-kInf, -kInf, -kInf}};
+}
+
+void grow(Bounds& b, const Bounds& other) {
+    for (size_t d = 0; d < 3; ++d) {
+        b.lo[d] = std::min(b.lo[d], other.lo[d]);
+        b.hi[d] = std::max(b.hi[d], other.hi[d]);
+    }
+}
+
+void grow(Bounds& b, const double* p) {
+    for (size_t d = 0; d < 3; ++d) {
+        b.lo[d] = std::min(b.lo[d], p[d]);
+        b.hi[d] = std::max(b.hi[d], p[d]);
+    }
+}
+
+// Half the surface area; 0 for empty bounds
+double half_area(const Bounds& b) {
+    const double x = b.hi[0] - b.lo[0];
+    const double y = b.hi[1] - b.lo[1];
+    const double z = b.hi[2] - b.lo[2];
+    if (!(x >= 0.0 && y >= 0.0 && z >= 0.0)) {
+        return 0.0;
+    }
+    return x * y + y * z + z * x;
+}
+
+struct Bin {
+    size_t count = 0;
+    Bounds bounds = empty_bounds();
+};
+
+// Arranges primitives into leaf order and emits their subtree depth-first
+struct Builder {
+    const std::vector<Bounds>& boxes;
+    const std::vector<double>& centroids;  // 3 per primitive
+    uint32_t* order;
+
+    // Bin of a centroid coordinate, clamped to the bins; NaN goes to bin 0
+    static size_t bin_of(double c, double lo, double scale) {
+        const double b = (c - lo) * scale;
+        if (!(b > 0.0)) {
+            return 0;
+        }
+        return b < double(kBins - 1) ? static_cast<size_t>(b) : kBins - 1;
+    }
+
+    void build(size_t begin, size_t end, size_t depth, std::vector<BvhNode>& out) const;
+};
+
+void Builder::build(size_t begin, size_t end, size_t depth, std::vector<BvhNode>& out) const {
+    const size_t self = out.size();
+    out.push_back(BvhNode{});
+    Bounds box = empty_bounds();
+    Bounds centers = empty_bounds();
+    for (size_t i = begin; i < end; ++i) {
+        grow(box, boxes[order[i]]);
+        grow(centers, &centroids[3 * order[i]]);
+    }
+    auto node = [&](uint32_t index, uint32_t count, uint32_t axis) {
+        BvhNode& n = out[self];
+        std::copy(box.lo, box.lo + 3, n.lo);
+        std::copy(box.hi, box.hi + 3, n.hi);
+        n.index = index;
+        n.count = count;
+        n.axis = axis;
+    };
+    const size_t count = end - begin;
+    if (count <= kLeafSize) {
+        node(static_cast<uint32_t>(begin), static_cast<uint32_t>(count), 0);
+        return;
+    }
+
+    // Cheapest boundary between bins over the three axes
+    double best = kInf;
+    size_t axis = 0;
+    size_t split = 0;
+    for (size_t a = 0; a < 3 && depth < kMaxSahDepth; ++a) {
+        const double extent = centers.hi[a] - centers.lo[a];
+        if (!(extent > 0.0 && extent < kInf)) {
+            continue;
+        }
+        const double lo = centers.lo[a];
+        const double scale = kBins / extent;
+        Bin bins[kBins];
+        for (size_t i = begin; i < end; ++i) {
+            Bin& bin = bins[bin_of(centroids[3 * order[i] + a], lo, scale)];
+            ++bin.count;
+            grow(bin.bounds, boxes[order[i]]);
+        }
+        double right_cost[kBins];
+        Bounds right = empty_bounds();
+        size_t right_count = 0;
+        for (size_t b = kBins - 1; b > 0; --b) {
+            grow(right, bins[b].bounds);
+            right_count += bins[b].count;
+            right_cost[b] = half_area(right) * right_count;
+        }
+        Bounds left = empty_bounds();
+        size_t left_count = 0;
+        for (size_t b = 1; b < kBins; ++b) {
+            grow(left, bins[b - 1].bounds);
+            left_count += bins[b - 1].count;
+            if (left_count == 0 || left_count == count) {
+                continue;
+            }
+            const double cost = half_area(left) * left_count + right_cost[b];
+            if (cost < best) {
+                best = cost;
+                axis = a;
+                split = b;
+            }
+        }
+    }
+
+    const double area = half_area(box);
+    size_t mid;
+    if (best < kInf) {
+        if (count <= kMaxLeafSize && kTraversalCost * area + best >= area * count) {
+            node(static_cast<uint32_t>(begin), static_cast<uint32_t>(count), 0);
+            return;
+        }
+        const double lo = centers.lo[axis];
+        const double scale = kBins / (centers.hi[axis] - lo);
+        mid = std::partition(order + begin, order + end, [&](uint32_t p) {
+            return bin_of(centroids[3 * p + axis], lo, scale) < split;
+        }) - order;
+    } else {
+        // Coincident centroids, or too deep: halve along the widest axis
+        if (count <= kMaxLeafSize) {
+            node(static_cast<uint32_t>(begin), static_cast<uint32_t>(count), 0);
+            return;
+        }
+        for (size_t a = 1; a < 3; ++a) {
+            if (centers.hi[a] - centers.lo[a] > centers.hi[axis] - centers.lo[axis]) {
+                axis = a;
+            }
+        }
+        mid = begin + count / 2;
+        std::nth_element(order + begin, order + mid, order + end, [&](uint32_t p, uint32_t q) {
+            return centroids[3 * p + axis] < centroids[3 * q + axis];
+        });
+    }
+
+    size_t second;
+    if (count >= kParallelBuild) {
+        // Subtrees are built apart and spliced, giving the same layout as the
+        // serial build
+        std::vector<BvhNode> parts[2];
+        parallel_for(2, count, [&](size_t side) {
+            if (side == 0) {
+                build(begin, mid, depth + 1, parts[0]);
+            } else {
+                build(mid, end, depth + 1, parts[1]);
+            }
+        });
+        auto splice = [&](const std::vector<BvhNode>& part) {
+            const uint32_t offset = static_cast<uint32_t>(out.size());
+            for (BvhNode n : part) {
+                if (n.count == 0) {
+                    n.index += offset;
+                }
+                out.push_back(n);
+            }
+        };
+        splice(parts[0]);
+        second = out.size();
+        splice(parts[1]);
+    } else {
+        build(begin, mid, depth + 1, out);
+        second = out.size();
+        build(mid, end, depth + 1, out);
+    }
+    node(static_cast<uint32_t>(second), 0, static_cast<uint32_t>(axis));
+}
+
+// Rays of a packet by lane. Unused lanes have t = -1 and never hit.
+struct Packet {
+    double o[3][kPacket];
+    double d[3][kPacket];
+    double inv[3][kPacket];
+    double t[kPacket];       // t of the nearest hit so far, or t_max
+    uint64_t hit[kPacket];   // primitive of the nearest hit, or kNone
+};
+
+// Where lane l enters and leaves the box, clipped to t >= 0
+inline void slab(const double* lo, const double* hi, const Packet& p, size_t l,
+                 double& enter, double& leave) {
+    const double x0 = (lo[0] - p.o[0][l]) * p.inv[0][l];
+    const double x1 = (hi[0] - p.o[0][l]) * p.inv[0][l];
+    const double y0 = (lo[1] - p.o[1][l]) * p.inv[1][l];
+    const double y1 = (hi[1] - p.o[1][l]) * p.inv[1][l];
+    const double z0 = (lo[2] - p.o[2][l]) * p.inv[2][l];
+    const double z1 = (hi[2] - p.o[2][l]) * p.inv[2][l];
+    enter = std::max(std::max(std::min(x0, x1), std::min(y0, y1)),
+                     std::max(std::min(z0, z1), 0.0));
+    leave = std::min(std::min(std::max(x0, x1), std::max(y0, y1)), std::max(z0, z1));
+}
+
+bool packet_hits(const BvhNode& node, const Packet& p) {
+    size_t hits = 0;
+    for (size_t l = 0; l < kPacket; ++l) {
+        double enter;
+        double leave;
+        slab(node.lo, node.hi, p, l, enter, leave);
+        hits += (enter <= leave) & (enter <= p.t[l]);
+    }
+    return hits != 0;
+}
+
+// Keeps hit (t, id) in lane l when it is nearer, or as near with a lower id
+inline void record(Packet& p, size_t l, bool valid, double t, uint64_t id) {
+    const bool keep = valid & ((t < p.t[l]) | ((t == p.t[l]) & (id < p.hit[l])));
+    p.t[l] = keep ? t : p.t[l];
+    p.hit[l] = keep ? id : p.hit[l];
+}
+
+// Moller-Trumbore, two-sided
+void hit_triangle(const double* v, uint64_t id, Packet& p) {
+    const double e1[3] = {v[3] - v[0], v[4] - v[1], v[5] - v[2]};
+    const double e2[3] = {v[6] - v[0], v[7] - v[1], v[8] - v[2]};
+    double hits[kPacket];  // t of each lane's hit, or NaN
+    for (size_t l = 0; l < kPacket; ++l) {
+        const double dx = p.d[0][l];
+        const double dy = p.d[1][l];
+        const double dz = p.d[2][l];
+        const double px = dy * e2[2] - dz * e2[1];
+        const double py = dz * e2[0] - dx * e2[2];
+        const double pz = dx * e2[1] - dy * e2[0];
+        const double inv = 1.0 / (e1[0] * px + e1[1] * py + e1[2] * pz);
+        const double sx = p.o[0][l] - v[0];
+        const double sy = p.o[1][l] - v[1];
+        const double sz = p.o[2][l] - v[2];
+        const double u = (sx * px + sy * py + sz * pz) * inv;
+        const double qx = sy * e1[2] - sz * e1[1];
+        const double qy = sz * e1[0] - sx * e1[2];
+        const double qz = sx * e1[1] - sy * e1[0];
+        const double w = (dx * qx + dy * qy + dz * qz) * inv;
+        const double t = (e2[0] * qx + e2[1] * qy + e2[2] * qz) * inv;
+        const bool valid = (u >= 0.0) & (w >= 0.0) & (u + w <= 1.0) & (t >= 0.0);
+        hits[l] = valid ? t : kNaN;
+    }
+    // A separate pass, which keeps both loops vectorizable
+    for (size_t l = 0; l < kPacket; ++l) {
+        record(p, l, hits[l] >= 0.0, hits[l], id);
+    }
+}
+
+void hit_box(const double* b, uint64_t id, Packet& p) {
+    for (size_t l = 0; l < kPacket; ++l) {
+        double enter;
+        double leave;
+        slab(b, b + 3, p, l, enter, leave);
+        record(p, l, enter <= leave, enter, id);
+    }
+}
+
+// Squared distance from q to the box
+double box_distance2(const double* lo, const double* hi, const double* q) {
+    double sum = 0.0;
+    for (size_t d = 0; d < 3; ++d) {
+        const double gap = std::max(std::max(lo[d] - q[d], q[d] - hi[d]), 0.0);
+        sum += gap * gap;
+    }
+    return sum;
+}
+
+void closest_on_box(const double* b, const double* q, double* out) {
+    for (size_t d = 0; d < 3; ++d) {
+        out[d] = std::min(std::max(q[d], b[d]), b[3 + d]);
+    }
+}
+
+double dot3(const double* a, const double* b) {
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+// Ericson, Real-Time Collision Detection 5.1.5: finds the Voronoi region of
+// the triangle that q falls in
+void closest_on_triangle(const double* v, const double* q, double* out) {
+    const double* a = v;
+    const double* b = v + 3;
+    const double* c = v + 6;
+    const double ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+    const double ac[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+    auto at = [&](const double* base, const double* edge, double s) {
+        for (size_t d = 0; d < 3; ++d) {
+            out[d] = base[d] + s * edge[d];
+        }
+    };
+    const double ap[3] = {q[0] - a[0], q[1] - a[1], q[2] - a[2]};
+    const double d1 = dot3(ab, ap);
+    const double d2 = dot3(ac, ap);
+    if (d1 <= 0.0 && d2 <= 0.0) {
+        return at(a, ab, 0.0);
+    }
+    const double bp[3] = {q[0] - b[0], q[1] - b[1], q[2] - b[2]};
+    const double d3 = dot3(ab, bp);
+    const double d4 = dot3(ac, bp);
+    if (d3 >= 0.0 && d4 <= d3) {
+        return at(b, ab, 0.0);
+    }
+    const double vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0) {
+        return at(a, ab, d1 / (d1 - d3));
+    }
+    const double cp[3] = {q[0] - c[0], q[1] - c[1], q[2] - c[2]};
+    const double d5 = dot3(ab, cp);
+    const double d6 = dot3(ac, cp);
+    if (d6 >= 0.0 && d5 <= d6) {
+        return at(c, ab, 0.0);
+    }
+    const double vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0) {
+        return at(a, ac, d2 / (d2 - d6));
+    }
+    const double va = d3 * d6 - d5 * d4;
+    if (va <= 0.0 && d4 - d3 >= 0.0 && d5 - d6 >= 0.0) {
+        const double bc[3] = {c[0] - b[0], c[1] - b[1], c[2] - b[2]};
+        return at(b, bc, (d4 - d3) / ((d4 - d3) + (d5 - d6)));
+    }
+    const double denom = 1.0 / (va + vb + vc);
+    at(a, ab, vb * denom);
+    for (size_t d = 0; d < 3; ++d) {
+        out[d] += vc * denom * ac[d];
+    }
+}
+
+// Traces every ray through the nodes in packets; leaf(primitive, id, packet)
+// records the packet's hits on one primitive
+template <typename Leaf>
+void trace(const std::vector<BvhNode>& nodes, const double* data, size_t width,
+           const uint64_t* ids, const BatchView& origins, const BatchView& directions,
+           double t_max, const Leaf& leaf, int64_t* indices, double* t) {
+    for_each_query_block(origins.count, [&](size_t begin, size_t end) {
+        std::vector<uint32_t> stack;
+        for (size_t first = begin; first < end; first += kPacket) {
+            const size_t lanes = std::min(kPacket, end - first);
+            Packet p;
+            for (size_t l = 0; l < kPacket; ++l) {
+                const bool used = l < lanes;
+                const double* o = used ? origins.row(first + l) : nullptr;
+                const double* d = used ? directions.row(first + l) : nullptr;
+                for (size_t a = 0; a < 3; ++a) {
+                    p.o[a][l] = used ? o[a] : 0.0;
+                    p.d[a][l] = used ? d[a] : 1.0;
+                    p.inv[a][l] = 1.0 / p.d[a][l];
+                }
+                p.t[l] = used ? t_max : -1.0;
+                p.hit[l] = kNone;
+            }
+
+            uint32_t current = 0;
+            stack.clear();
+            while (!nodes.empty()) {
+                const BvhNode& node = nodes[current];
+                if (packet_hits(node, p)) {
+                    if (node.count == 0) {
+                        // Nearer child first, judged by the first ray
+                        uint32_t near = current + 1;
+                        uint32_t far = node.index;
+                        if (p.d[node.axis][0] < 0.0) {
+                            std::swap(near, far);
+                        }
+                        stack.push_back(far);
+                        current = near;
+                        continue;
+                    }
+                    for (size_t i = node.index; i < node.index + node.count; ++i) {
+                        leaf(data + i * width, ids[i], p);
+                    }
+                }
+                if (stack.empty()) {
+                    break;
+                }
+                current = stack.back();
+                stack.pop_back();
+            }
+
+            for (size_t l = 0; l < lanes; ++l) {
+                const bool found = p.hit[l] != kNone;
+                indices[first + l] = found ? static_cast<int64_t>(p.hit[l]) : -1;
+                t[first + l] = found ? p.t[l] : kNaN;
+            }
+        }
+    });
+}
+
+} // namespace
+
+Bvh Bvh::from_triangles(const BatchView& triangles) {
+    return Bvh(BvhPrimitive::Triangle, triangles);
+}
+
+Bvh Bvh::from_boxes(const BatchView& boxes) {
+    return Bvh(BvhPrimitive::Box, boxes);
+}
+
+Bvh::Bvh(BvhPrimitive kind, const BatchView& primitives)
+    : kind_(kind), width_(kind == BvhPrimitive::Triangle ? 9 : 6) {
+    if (primitives.dim != width_) {
+        throw std::runtime_error(
+            std::string("BVH ") + (kind == BvhPrimitive::Triangle ? "triangles" : "boxes") +
+            " need rows of " + std::to_string(width_) + " values, got " +
+            std::to_string(primitives.dim)
+        );
+    }
+    const size_t n = primitives.count;
+    if (n > kMaxPrimitives) {
+        throw std::runtime_error(
+            "BVH supports at most " + std::to_string(kMaxPrimitives) + " primitives"
+        );
+    }
+
+    // Boxes are stored with their corners ordered
+    auto load = [&](size_t i, double* out) {
+        const double* row = primitives.row(i);
+        if (kind_ == BvhPrimitive::Triangle) {
+            std::copy(row, row + 9, out);
+            return;
+        }
+        for (size_t d = 0; d < 3; ++d) {
+            out[d] = std::min(row[d], row[3 + d]);
+            out[3 + d] = std::max(row[d], row[3 + d]);
+        }
+    };
+
+    std::vector<Bounds> boxes(n);
+    std::vector<double> centroids(3 * n);
+    for_each_row_block(n, width_, [&](size_t begin, size_t end) {
+        double values[9];
+        for (size_t i = begin; i < end; ++i) {
+            load(i, values);
+            boxes[i] = empty_bounds();
+            for (size_t v = 0; v < width_; v += 3) {
+                grow(boxes[i], values + v);
+            }
+            for (size_t d = 0; d < 3; ++d) {
+                centroids[3 * i + d] = 0.5 * (boxes[i].lo[d] + boxes[i].hi[d]);
+            }
+        }
+    });
+
+    std::vector<uint32_t> order(n);
+    std::iota(order.begin(), order.end(), uint32_t(0));
+    if (n > 0) {
+        nodes_.reserve(2 * n / kLeafSize);
+        Builder{boxes, centroids, order.data()}.build(0, n, 0, nodes_);
+    }
+
+    data_.resize(n * width_);
+    ids_.resize(n);
+    for_each_row_block(n, width_, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            load(order[i], data_.data() + i * width_);
+            ids_[i] = order[i];
+        }
+    });
+}
+
+void Bvh::intersect(const BatchView& origins, const BatchView& directions, double t_max,
+                    int64_t* indices, double* t) const {
+    check_points(origins, "BVH ray query");
+    const BatchView rays = paired(origins, directions, "BVH ray query");
+    if (kind_ == BvhPrimitive::Triangle) {
+        trace(nodes_, data_.data(), width_, ids_.data(), origins, rays, t_max, hit_triangle,
+              indices, t);
+    } else {
+        trace(nodes_, data_.data(), width_, ids_.data(), origins, rays, t_max, hit_box,
+              indices, t);
+    }
+}
+
+void Bvh::intersect_segments(const BatchView& starts, const BatchView& ends, int64_t* indices,
+                             double* t) const {
+    check_points(starts, "BVH segment query");
+    const BatchView stops = paired(starts, ends, "BVH segment query");
+    VectorBatch directions(starts.count, 3);
+    for_each_row_block(starts.count, 3, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            for (size_t d = 0; d < 3; ++d) {
+                directions.row(i)[d] = stops.row(i)[d] - starts.row(i)[d];
+            }
+        }
+    });
+    intersect(starts, directions.view(), 1.0, indices, t);
+}
+
+void Bvh::closest_points(const BatchView& points, double max_distance, int64_t* indices,
+                         double* distances, double* closest) const {
+    check_points(points, "BVH closest point query");
+    if (!(max_distance >= 0.0)) {
+        throw std::runtime_error("BVH max_distance must be non-negative");
+    }
+    const double limit = max_distance * max_distance;
+    for_each_query_block(points.count, [&](size_t begin, size_t end) {
+        std::vector<std::pair<uint32_t, double>> stack;
+        for (size_t r = begin; r < end; ++r) {
+            const double* q = points.row(r);
+            double best = limit;
+            uint64_t best_id = kNone;
+            double best_point[3] = {kNaN, kNaN, kNaN};
+            stack.clear();
+            if (!nodes_.empty()) {
+                stack.emplace_back(0, box_distance2(nodes_[0].lo, nodes_[0].hi, q));
+            }
+            while (!stack.empty()) {
+                const std::pair<uint32_t, double> entry = stack.back();
+                stack.pop_back();
+                if (entry.second > best) {
+                    continue;
+                }
+                const BvhNode& node = nodes_[entry.first];
+                if (node.count == 0) {
+                    // The nearer child goes on top
+                    std::pair<uint32_t, double> near(entry.first + 1, 0.0);
+                    std::pair<uint32_t, double> far(node.index, 0.0);
+                    near.second = box_distance2(nodes_[near.first].lo, nodes_[near.first].hi, q);
+                    far.second = box_distance2(nodes_[far.first].lo, nodes_[far.first].hi, q);
+                    if (far.second < near.second) {
+                        std::swap(near, far);
+                    }
+                    if (far.second <= best) {
+                        stack.push_back(far);
+                    }
+                    if (near.second <= best) {
+                        stack.push_back(near);
+                    }
+                    continue;
+                }
+                for (size_t i = node.index; i < node.index + node.count; ++i) {
+                    const double* primitive = data_.data() + i * width_;
+                    double point[3];
+                    if (kind_ == BvhPrimitive::Triangle) {
+                        closest_on_triangle(primitive, q, point);
+                    } else {
+                        closest_on_box(primitive, q, point);
+                    }
+                    const double gap[3] = {point[0] - q[0], point[1] - q[1], point[2] - q[2]};
+                    const double d2 = dot3(gap, gap);
+                    if (d2 < best || (d2 == best && ids_[i] < best_id)) {
+                        best = d2;
+                        best_id = ids_[i];
+                        std::copy(point, point + 3, best_point);
+                    }
+                }
+            }
+            const bool found = best_id != kNone;
+            indices[r] = found ? static_cast<int64_t>(best_id) : -1;
+            distances[r] = found ? std::sqrt(best) : kNaN;
+            std::copy(best_point, best_point + 3, closest + 3 * r);
+        }
+    });
+}
+
+} // namespace vectors
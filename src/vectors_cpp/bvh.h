@@ -0,0 +1,83 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include "vector_batch.h"
+#include <cstdint>
+#include <vector>
+
+namespace vectors {
+
+// Node of a Bvh. Nodes are stored depth-first, so an interior node's first
+// child directly follows it.
+struct BvhNode {
+    double lo[3];
+    double hi[3];
+    uint32_t index;  // interior: second child; leaf: first primitive position
+    uint32_t count;  // primitives in a leaf, 0 for an interior node
+    uint32_t axis;   // interior: axis the children were split along
+    uint32_t padding;
+};
+
+enum class BvhPrimitive {
+    Triangle,  // rows of 9: three xyz vertices
+    Box        // rows of 6: xyz minimum, then xyz maximum
+};
+
+/**
+ * Bvh - Bounding volume hierarchy over 3D triangles or axis-aligned boxes
+ *
+ * Built top-down with the surface area heuristic over 16 centroid bins per
+ * axis; nodes with many primitives hand their two subtrees to the worker
+ * threads and splice the results, so the tree does not depend on the thread
+ * count. Primitives are copied into leaf order, so a leaf's primitives are
+ * contiguous.
+ *
+ * Ray queries run in packets of 8 consecutive rays that traverse the tree
+ * together: every box and primitive test is a loop over the packet's lanes
+ * that the compiler vectorizes, and a node is entered when any lane hits it.
+ * Coherent rays (neighbouring origins and similar directions, e.g. after
+ * morton_order) share most of their traversal. Closest-point queries walk
+ * the tree nearest box first and skip boxes farther than the best hit.
+ * Both kinds split their queries over the worker threads and write results
+ * into caller-provided arrays. Ties are broken toward the lower primitive
+ * index, so results do not depend on the tree's shape.
+ */
+class Bvh {
+public:
+    static Bvh from_triangles(const BatchView& triangles);
+    static Bvh from_boxes(const BatchView& boxes);
+
+    BvhPrimitive primitive() const { return kind_; }
+    size_t size() const { return ids_.size(); }
+    const std::vector<BvhNode>& nodes() const { return nodes_; }
+
+    // Nearest hit along each ray with t in [0, t_max], t measured in lengths
+    // of the direction: the primitive index and t, or -1 and NaN. Triangles
+    // are hit from both sides; a box is hit where the ray enters it, or at
+    // t = 0 from inside. `directions` has a row per origin or a single row
+    // shared by all.
+    void intersect(const BatchView& origins, const BatchView& directions, double t_max,
+                   int64_t* indices, double* t) const;
+    // Segments from starts[i] to ends[i]; t is the fraction along the segment
+    void intersect_segments(const BatchView& starts, const BatchView& ends, int64_t* indices,
+                            double* t) const;
+
+    // Nearest point on any primitive within max_distance of each point: the
+    // primitive index, the distance and the point (3 values per query), or
+    // -1 and NaN
+    void closest_points(const BatchView& points, double max_distance, int64_t* indices,
+                        double* distances, double* closest) const;
+
+private:
+    Bvh(BvhPrimitive kind, const BatchView& primitives);
+
+    BvhPrimitive kind_;
+    size_t width_;                 // values per primitive
+    std::vector<double> data_;     // primitives in leaf order
+    std::vector<uint64_t> ids_;    // input index of each stored primitive
+    std::vector<BvhNode> nodes_;
+};
+
+} // namespace vectors
+
+#endif // BVH_H
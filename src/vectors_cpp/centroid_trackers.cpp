@@ -0,0 +1,162 @@
+#include "centroid_trackers.h"
+#include <algorithm>
+#include <limits>
+#include <string>
+
+namespace vectors {
+
+namespace {
+
+void check_row_dimensions(size_t expected, size_t actual, const char* operation) {
+    if (expected != actual) {
+        throw std::runtime_error(
+            std::string("Dimension mismatch in ") + operation +
+            ": " + std::to_string(expected) + " vs " + std::to_string(actual)
+        );
+    }
+}
+
+// Same contract as weighted_average(): reject an (almost) zero total weight
+VectorND weighted_mean(const std::vector<double>& weighted_sum, double total_weight) {
+    if (total_weight < std::numeric_limits<double>::epsilon()) {
+        throw std::runtime_error("Total weight cannot be zero");
+    }
+    VectorND result(weighted_sum.size());
+    for (size_t i = 0; i < weighted_sum.size(); ++i) {
+        result[i] = weighted_sum[i] / total_weight;
+    }
+    return result;
+}
+
+} // namespace
+
+// SlidingWindowCentroid
+
+SlidingWindowCentroid::SlidingWindowCentroid(size_t dimensions, size_t window)
+    : dimensions_(dimensions),
+      window_(window),
+      size_(0),
+      head_(0),
+      inserts_since_rebuild_(0),
+      ring_(dimensions * window, 0.0),
+      weights_(window, 0.0),
+      weighted_sum_(dimensions, 0.0),
+      total_weight_(0.0) {
+    if (window == 0) {
+        throw std::runtime_error("Window size must be positive");
+    }
+}
+
+void SlidingWindowCentroid::add(const VectorND& v, double weight) {
+    check_row_dimensions(dimensions_, v.size(), "sliding window centroid");
+    add(v.data().data(), weight);
+}
+
+void SlidingWindowCentroid::add(const double* row, double weight) {
+    double* slot = ring_.data() + head_ * dimensions_;
+    if (size_ == window_) {
+        const double old_weight = weights_[head_];
+        for (size_t i = 0; i < dimensions_; ++i) {
+            weighted_sum_[i] += weight * row[i] - old_weight * slot[i];
+        }
+        total_weight_ += weight - old_weight;
+    } else {
+        for (size_t i = 0; i < dimensions_; ++i) {
+            weighted_sum_[i] += weight * row[i];
+        }
+        total_weight_ += weight;
+        ++size_;
+    }
+    std::copy(row, row + dimensions_, slot);
+    weights_[head_] = weight;
+    head_ = (head_ + 1) % window_;
+
+    if (++inserts_since_rebuild_ >= window_) {
+        rebuild();
+    }
+}
+
+void SlidingWindowCentroid::add_batch(const double* data, size_t count, size_t stride,
+                                      const double* weights) {
+    // Rows that would be evicted within this batch never need to be summed
+    size_t skip = count > window_ ? count - window_ : 0;
+    if (skip > 0) {
+        clear();
+    }
+    for (size_t r = skip; r < count; ++r) {
+        add(data + r * stride, weights ? weights[r] : 1.0);
+    }
+}
+
+void SlidingWindowCentroid::clear() {
+    size_ = 0;
+    head_ = 0;
+    inserts_since_rebuild_ = 0;
+    std::fill(weighted_sum_.begin(), weighted_sum_.end(), 0.0);
+    total_weight_ = 0.0;
+}
+
+void SlidingWindowCentroid::rebuild() {
+    std::fill(weighted_sum_.begin(), weighted_sum_.end(), 0.0);
+    total_weight_ = 0.0;
+    // Occupied slots are [0, size_) until the ring wraps, then all of them
+    for (size_t s = 0; s < size_; ++s) {
+        const double* slot = ring_.data() + s * dimensions_;
+        for (size_t i = 0; i < dimensions_; ++i) {
+            weighted_sum_[i] += weights_[s] * slot[i];
+        }
+        total_weight_ += weights_[s];
+    }
+    inserts_since_rebuild_ = 0;
+}
+
+VectorND SlidingWindowCentroid::centroid() const {
+    if (size_ == 0) {
+        throw std::runtime_error("Cannot calculate centroid of empty window");
+    }
+    return weighted_mean(weighted_sum_, total_weight_);
+}
+
+// DecayedCentroid
+
+DecayedCentroid::DecayedCentroid(size_t dimensions, double decay)
+    : decay_(decay), count_(0), weighted_sum_(dimensions, 0.0), total_weight_(0.0) {
+    if (!(decay > 0.0 && decay <= 1.0)) {
+        throw std::runtime_error("Decay factor must be in (0, 1]");
+    }
+}
+
+void DecayedCentroid::add(const VectorND& v, double weight) {
+    check_row_dimensions(weighted_sum_.size(), v.size(), "decayed centroid");
+    add(v.data().data(), weight);
+}
+
+void DecayedCentroid::add(const double* row, double weight) {
+    for (size_t i = 0; i < weighted_sum_.size(); ++i) {
+        weighted_sum_[i] = decay_ * weighted_sum_[i] + weight * row[i];
+    }
+    total_weight_ = decay_ * total_weight_ + weight;
+    ++count_;
+}
+
+void DecayedCentroid::add_batch(const double* data, size_t count, size_t stride,
+                                const double* weights) {
+    for (size_t r = 0; r < count; ++r) {
+        add(data + r * stride, weights ? weights[r] : 1.0);
+    }
+}
+
+void DecayedCentroid::clear() {
+    count_ = 0;
+    std::fill(weighted_sum_.begin(), weighted_sum_.end(), 0.0);
+    total_weight_ = 0.0;
+}
+
+VectorND DecayedCentroid::centroid() const {
+    if (count_ == 0) {
+        throw std::runtime_error("Cannot calculate centroid of empty tracker");
+    }
+    return weighted_mean(weighted_sum_, total_weight_);
+}
+
+} // namespace vectors
@@ -0,0 +1,80 @@
+#ifndef CENTROID_TRACKERS_H
+#define CENTROID_TRACKERS_H
+
+#include "vector_core.h"
+#include <vector>
+
+namespace vectors {
+
+/**
+ * SlidingWindowCentroid - Weighted centroid of the last W vectors
+ *
+ * Vectors live in a preallocated W x D ring buffer next to a running weighted
+ * sum, so an insert costs O(D) and never allocates. The running sum is rebuilt
+ * from the ring once per W inserts to keep rounding drift bounded.
+ * centroid() follows weighted_average(): sum(w_i * v_i) / sum(w_i).
+ */
+class SlidingWindowCentroid {
+public:
+    SlidingWindowCentroid(size_t dimensions, size_t window);
+
+    size_t dimensions() const { return dimensions_; }
+    size_t window() const { return window_; }
+    size_t size() const { return size_; }
+    bool full() const { return size_ == window_; }
+    double total_weight() const { return total_weight_; }
+
+    void add(const VectorND& v, double weight = 1.0);
+    void add(const double* row, double weight);
+    // weights may be null for unit weights
+    void add_batch(const double* data, size_t count, size_t stride, const double* weights);
+    void clear();
+
+    VectorND centroid() const;
+
+private:
+    size_t dimensions_;
+    size_t window_;
+    size_t size_;
+    size_t head_;  // slot the next insert overwrites
+    size_t inserts_since_rebuild_;
+    std::vector<double> ring_;
+    std::vector<double> weights_;
+    std::vector<double> weighted_sum_;
+    double total_weight_;
+
+    void rebuild();
+};
+
+/**
+ * DecayedCentroid - Exponentially decayed weighted mean
+ *
+ * Each insert scales the previous state by `decay` before adding w * v, so a
+ * vector added k steps ago contributes with weight w * decay^k. O(D) per insert.
+ */
+class DecayedCentroid {
+public:
+    DecayedCentroid(size_t dimensions, double decay);
+
+    size_t dimensions() const { return weighted_sum_.size(); }
+    double decay() const { return decay_; }
+    size_t count() const { return count_; }
+    double total_weight() const { return total_weight_; }
+
+    void add(const VectorND& v, double weight = 1.0);
+    void add(const double* row, double weight);
+    void add_batch(const double* data, size_t count, size_t stride, const double* weights);
+    void clear();
+
+    VectorND centroid() const;
+
+private:
+    double decay_;
+    size_t count_;
+    std::vector<double> weighted_sum_;
+    double total_weight_;
+};
+
+} // namespace vectors
+
+#endif // CENTROID_TRACKERS_H
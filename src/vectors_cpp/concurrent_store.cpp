@@ -0,0 +1,404 @@
+#include "concurrent_store.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace vectors {
+
+// EpochReclaimer
+//
+// Readers announce themselves in the counter of the epoch they entered.
+// The epoch only advances once nobody is left in the previous one, so
+// memory retired in epoch e is unreachable after the advance to e + 2;
+// three counters and limbo lists are enough to cycle through.
+
+EpochReclaimer::Guard::Guard(EpochReclaimer& reclaimer)
+    : reclaimer_(&reclaimer), epoch_(reclaimer.enter()) {}
+
+EpochReclaimer::Guard::Guard(Guard&& other) noexcept
+    : reclaimer_(other.reclaimer_), epoch_(other.epoch_) {
+    other.reclaimer_ = nullptr;
+}
+
+EpochReclaimer::Guard& EpochReclaimer::Guard::operator=(Guard&& other) noexcept {
+    if (this != &other) {
+        release();
+        reclaimer_ = other.reclaimer_;
+        epoch_ = other.epoch_;
+        other.reclaimer_ = nullptr;
+    }
+    return *this;
+}
+
+EpochReclaimer::Guard::~Guard() {
+    release();
+}
+
+void EpochReclaimer::Guard::release() {
+    if (reclaimer_) {
+        reclaimer_->exit(epoch_);
+        reclaimer_ = nullptr;
+    }
+}
+
+EpochReclaimer::~EpochReclaimer() {
+    for (auto& list : limbo_) {
+        for (const Retired& item : list) {
+            item.deleter(item.p);
+        }
+    }
+}
+
+uint64_t EpochReclaimer::enter() {
+    for (;;) {
+        uint64_t epoch = epoch_.load();
+        counters_[epoch % 3].active.fetch_add(1);
+        // Recheck so a reader never registers in an epoch already retired
+        if (epoch_.load() == epoch) {
+            return epoch;
+        }
+        counters_[epoch % 3].active.fetch_sub(1);
+    }
+}
+
+void EpochReclaimer::exit(uint64_t epoch) {
+    counters_[epoch % 3].active.fetch_sub(1);
+}
+
+void EpochReclaimer::retire(void* p, void (*deleter)(void*)) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    limbo_[epoch_.load() % 3].push_back(Retired{p, deleter});
+    try_advance();
+}
+
+void EpochReclaimer::collect() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Two advances release everything retired so far when no reader is in
+    try_advance();
+    try_advance();
+}
+
+// Called with mutex_ held; the epoch only changes here
+void EpochReclaimer::try_advance() {
+    uint64_t epoch = epoch_.load();
+    if (counters_[(epoch + 2) % 3].active.load() != 0) {
+        return;
+    }
+    epoch_.store(epoch + 1);
+    std::vector<Retired> expired;
+    expired.swap(limbo_[(epoch + 2) % 3]);
+    for (const Retired& item : expired) {
+        item.deleter(item.p);
+    }
+}
+
+// ConcurrentVectorStore
+
+namespace {
+
+unsigned log2_ceil(size_t n) {
+    unsigned shift = 0;
+    while ((size_t(1) << shift) < n) {
+        ++shift;
+    }
+    return shift;
+}
+
+} // namespace
+
+ConcurrentVectorStore::Segment::Segment(size_t rows, size_t dim)
+    : data(new double[rows * dim]),
+      ready(new std::atomic<uint8_t>[rows]()),
+      deleted(new std::atomic<uint8_t>[rows]()) {}
+
+ConcurrentVectorStore::ConcurrentVectorStore(size_t dimensions, size_t segment_rows)
+    : dim_(dimensions) {
+    if (dimensions == 0) {
+        throw std::runtime_error("Vector store dimensions must be positive");
+    }
+    // The largest power of two for which a segment's values and the rows of
+    // a full directory can still be counted in a size_t
+    const size_t limit = std::min(SIZE_MAX / (kDirectoryChunks * kChunkSegments),
+                                  SIZE_MAX / sizeof(double) / dimensions);
+    unsigned max_shift = log2_ceil(limit);
+    if ((size_t(1) << max_shift) > limit) {
+        --max_shift;
+    }
+    if (segment_rows > (size_t(1) << max_shift)) {
+        throw std::runtime_error("Segment rows must be at most " +
+                                 std::to_string(size_t(1) << max_shift));
+    }
+    // Rounded up to a power of two so indices split with shifts and masks
+    segment_shift_ = log2_ceil(segment_rows == 0 ? 1 : segment_rows);
+    segment_rows_ = size_t(1) << segment_shift_;
+    for (auto& chunk : directory_) {
+        chunk.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+ConcurrentVectorStore::~ConcurrentVectorStore() {
+    for (auto& chunk : directory_) {
+        SegmentSlot* slots = chunk.load();
+        if (!slots) {
+            continue;
+        }
+        for (size_t s = 0; s < kChunkSegments; ++s) {
+            Segment* segment = slots[s].load();
+            if (segment != &retired_) {
+                delete segment;
+            }
+        }
+        delete[] slots;
+    }
+}
+
+ConcurrentVectorStore::SegmentSlot* ConcurrentVectorStore::slot(size_t segment, bool create) {
+    auto& chunk = directory_[segment / kChunkSegments];
+    SegmentSlot* slots = chunk.load(std::memory_order_acquire);
+    if (!slots) {
+        if (!create) {
+            return nullptr;
+        }
+        SegmentSlot* fresh = new SegmentSlot[kChunkSegments]();
+        if (chunk.compare_exchange_strong(slots, fresh, std::memory_order_acq_rel)) {
+            slots = fresh;
+        } else {
+            delete[] fresh;
+        }
+    }
+    return slots + segment % kChunkSegments;
+}
+
+ConcurrentVectorStore::Segment* ConcurrentVectorStore::segment_for_write(size_t segment) {
+    SegmentSlot* target = slot(segment, true);
+    Segment* current = target->load(std::memory_order_acquire);
+    if (current) {
+        return current;
+    }
+    Segment* fresh = new Segment(segment_rows_, dim_);
+    if (target->compare_exchange_strong(current, fresh, std::memory_order_acq_rel)) {
+        return fresh;
+    }
+    delete fresh;
+    return current;
+}
+
+const ConcurrentVectorStore::Segment* ConcurrentVectorStore::find_segment(size_t index) const {
+    size_t segment = index >> segment_shift_;
+    const SegmentSlot* slots = directory_[segment / kChunkSegments].load(std::memory_order_acquire);
+    if (!slots) {
+        return nullptr;
+    }
+    const Segment* current = slots[segment % kChunkSegments].load(std::memory_order_acquire);
+    return current == &retired_ ? nullptr : current;
+}
+
+size_t ConcurrentVectorStore::reserve(size_t count) {
+    const size_t capacity = kDirectoryChunks * kChunkSegments * segment_rows_;
+    size_t first = reserved_.load();
+    do {
+        if (count > capacity - first) {
+            throw std::runtime_error("Vector store capacity exceeded");
+        }
+    } while (!reserved_.compare_exchange_weak(first, first + count));
+    return first;
+}
+
+void ConcurrentVectorStore::write_row(size_t index, const double* row) {
+    Segment* segment = segment_for_write(index >> segment_shift_);
+    size_t offset = index & (segment_rows_ - 1);
+    std::memcpy(segment->data.get() + offset * dim_, row, dim_ * sizeof(double));
+    segment->ready[offset].store(1);
+}
+
+// Moves the committed size over every ready row that follows it. A writer
+// stopping at a row that is not ready yet leaves the rest to that row's
+// writer, which runs this after marking it.
+void ConcurrentVectorStore::advance_committed() {
+    size_t committed = committed_.load();
+    for (;;) {
+        size_t end = reserved_.load();
+        if (committed >= end) {
+            return;
+        }
+        const Segment* segment = find_segment(committed);
+        if (!segment) {
+            // Not created yet, or retired because the size already moved on
+            size_t now = committed_.load();
+            if (now == committed) {
+                return;
+            }
+            committed = now;
+            continue;
+        }
+        size_t segment_end = std::min(end, ((committed >> segment_shift_) + 1) << segment_shift_);
+        size_t scan = committed;
+        while (scan < segment_end && segment->ready[scan & (segment_rows_ - 1)].load()) {
+            ++scan;
+        }
+        if (scan == committed) {
+            return;
+        }
+        if (committed_.compare_exchange_strong(committed, scan)) {
+            committed = scan;
+        }
+    }
+}
+
+size_t ConcurrentVectorStore::append(const VectorND& v) {
+    if (v.size() != dim_) {
+        throw std::runtime_error(
+            "Dimension mismatch in vector store: " + std::to_string(dim_) +
+            " vs " + std::to_string(v.size())
+        );
+    }
+    return append(v.data().data());
+}
+
+size_t ConcurrentVectorStore::append(const double* row) {
+    EpochReclaimer::Guard guard(reclaimer_);
+    size_t index = reserve(1);
+    write_row(index, row);
+    advance_committed();
+    return index;
+}
+
+size_t ConcurrentVectorStore::append(const BatchView& rows) {
+    if (rows.dim != dim_) {
+        throw std::runtime_error(
+            "Dimension mismatch in vector store: " + std::to_string(dim_) +
+            " vs " + std::to_string(rows.dim)
+        );
+    }
+    EpochReclaimer::Guard guard(reclaimer_);
+    size_t first = reserve(rows.count);
+    for (size_t i = 0; i < rows.count; ++i) {
+        write_row(first + i, rows.row(i));
+    }
+    advance_committed();
+    return first;
+}
+
+bool ConcurrentVectorStore::remove(size_t index) {
+    EpochReclaimer::Guard guard(reclaimer_);
+    if (index >= size()) {
+        throw std::out_of_range("Index out of range");
+    }
+    SegmentSlot* target = slot(index >> segment_shift_, false);
+    Segment* segment = target->load(std::memory_order_acquire);
+    if (segment == &retired_ ||
+        segment->deleted[index & (segment_rows_ - 1)].exchange(1) != 0) {
+        return false;
+    }
+    // Only committed rows can be deleted, so a fully deleted segment has no
+    // writers left; readers may still hold it until their guards end
+    if (segment->deleted_count.fetch_add(1) + 1 == segment_rows_) {
+        target->store(&retired_, std::memory_order_release);
+        reclaimer_.retire(segment, [](void* p) { delete static_cast<Segment*>(p); });
+    }
+    return true;
+}
+
+StoreSnapshot ConcurrentVectorStore::snapshot() {
+    return StoreSnapshot(*this);
+}
+
+// StoreSnapshot
+
+StoreSnapshot::StoreSnapshot(ConcurrentVectorStore& store)
+    : store_(&store), guard_(store.reclaimer_), count_(store.size()) {}
+
+void StoreSnapshot::check_active() const {
+    if (!guard_.active()) {
+        throw std::runtime_error("Snapshot was released");
+    }
+}
+
+void StoreSnapshot::check_index(size_t index) const {
+    check_active();
+    if (index >= count_) {
+        throw std::out_of_range("Index out of range");
+    }
+}
+
+bool StoreSnapshot::is_deleted(size_t index) const {
+    return row(index) == nullptr;
+}
+
+const double* StoreSnapshot::row(size_t index) const {
+    check_index(index);
+    const auto* segment = store_->find_segment(index);
+    size_t offset = index & (store_->segment_rows_ - 1);
+    if (!segment || segment->deleted[offset].load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    return segment->data.get() + offset * store_->dim_;
+}
+
+VectorND StoreSnapshot::get(size_t index) const {
+    const double* data = row(index);
+    if (!data) {
+        throw std::out_of_range("Row was deleted");
+    }
+    return VectorND(std::vector<double>(data, data + store_->dim_));
+}
+
+VectorBatch StoreSnapshot::to_batch(std::vector<size_t>& indices) const {
+    VectorBatch result(store_->dim_);
+    indices.clear();
+    for_each_segment([&](size_t first, const BatchView& rows) {
+        for (size_t i = 0; i < rows.count; ++i) {
+            if (!is_deleted(first + i)) {
+                result.append(rows.row(i));
+                indices.push_back(first + i);
+            }
+        }
+    });
+    return result;
+}
+
+std::vector<Neighbor> k_nearest(const StoreSnapshot& snapshot, const VectorND& query, size_t k) {
+    if (query.size() != snapshot.dimensions()) {
+        throw std::runtime_error(
+            "Dimension mismatch in nearest neighbor search: " +
+            std::to_string(snapshot.dimensions()) + " vs " + std::to_string(query.size())
+        );
+    }
+    auto closer = [](const Neighbor& a, const Neighbor& b) {
+        return a.distance < b.distance || (a.distance == b.distance && a.index < b.index);
+    };
+    std::vector<Neighbor> heap;
+    k = std::min(k, snapshot.size());
+    if (k == 0) {
+        return heap;
+    }
+    heap.reserve(k);
+    std::vector<double> distances;
+    snapshot.for_each_segment([&](size_t first, const BatchView& rows) {
+        distances.resize(rows.count);
+        batch_distance(rows, query, distances.data());
+        for (size_t i = 0; i < rows.count; ++i) {
+            Neighbor candidate{first + i, distances[i]};
+            if (heap.size() == k && !closer(candidate, heap.front())) {
+                continue;
+            }
+            if (snapshot.is_deleted(first + i)) {
+                continue;
+            }
+            if (heap.size() == k) {
+                std::pop_heap(heap.begin(), heap.end(), closer);
+                heap.back() = candidate;
+            } else {
+                heap.push_back(candidate);
+            }
+            std::push_heap(heap.begin(), heap.end(), closer);
+        }
+    });
+    std::sort_heap(heap.begin(), heap.end(), closer);
+    return heap;
+}
+
+} // namespace vectors
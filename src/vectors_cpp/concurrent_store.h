@@ -0,0 +1,207 @@
+#ifndef CONCURRENT_STORE_H
+#define CONCURRENT_STORE_H
+
+#include "vector_batch.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace vectors {
+
+/**
+ * EpochReclaimer - Epoch-based reclamation of memory shared with lock-free
+ * readers
+ *
+ * Threads touching shared memory hold a Guard. Memory unlinked from the
+ * shared structure is retired rather than freed and is only released once
+ * every guard that could still reference it has been dropped. Guards cost
+ * two atomic increments; retiring takes a mutex but is rare.
+ */
+class EpochReclaimer {
+public:
+    class Guard {
+    public:
+        explicit Guard(EpochReclaimer& reclaimer);
+        Guard(Guard&& other) noexcept;
+        Guard& operator=(Guard&& other) noexcept;
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+        ~Guard();
+
+        void release();
+        bool active() const { return reclaimer_ != nullptr; }
+
+    private:
+        EpochReclaimer* reclaimer_;
+        uint64_t epoch_;
+    };
+
+    EpochReclaimer() = default;
+    EpochReclaimer(const EpochReclaimer&) = delete;
+    EpochReclaimer& operator=(const EpochReclaimer&) = delete;
+    ~EpochReclaimer();
+
+    // Frees `p` with `deleter` once no current guard can reach it
+    void retire(void* p, void (*deleter)(void*));
+    // Frees whatever retired memory is no longer reachable
+    void collect();
+
+private:
+    struct Retired {
+        void* p;
+        void (*deleter)(void*);
+    };
+    struct alignas(64) Counter {
+        std::atomic<size_t> active{0};
+    };
+
+    std::atomic<uint64_t> epoch_{0};
+    Counter counters_[3];
+    std::mutex mutex_;
+    std::vector<Retired> limbo_[3];
+
+    uint64_t enter();
+    void exit(uint64_t epoch);
+    void try_advance();
+};
+
+class StoreSnapshot;
+
+/**
+ * ConcurrentVectorStore - Append-only vector store for concurrent writers
+ * and lock-free readers
+ *
+ * Rows live in fixed-size segments that are never moved, so readers can
+ * hold row pointers while writers append. Writers reserve row indices with
+ * one compare-and-swap, copy their rows, then mark them ready; the
+ * committed size only advances over fully written rows, so readers always
+ * see a consistent prefix.
+ *
+ * Deleted rows keep their index and are skipped by snapshot searches. A
+ * segment whose rows have all been deleted is unlinked and retired through
+ * the store's EpochReclaimer, so memory is released only after every
+ * snapshot that could read it is gone.
+ */
+class ConcurrentVectorStore {
+public:
+    explicit ConcurrentVectorStore(size_t dimensions, size_t segment_rows = 4096);
+    ConcurrentVectorStore(const ConcurrentVectorStore&) = delete;
+    ConcurrentVectorStore& operator=(const ConcurrentVectorStore&) = delete;
+    ~ConcurrentVectorStore();
+
+    size_t dimensions() const { return dim_; }
+    size_t segment_rows() const { return segment_rows_; }
+    // Rows visible to readers
+    size_t size() const { return committed_.load(std::memory_order_acquire); }
+
+    // Append rows and return the index of the first one
+    size_t append(const VectorND& v);
+    size_t append(const double* row);
+    size_t append(const BatchView& rows);
+
+    // Marks a committed row deleted; false if it already was
+    bool remove(size_t index);
+    // Releases retired segments no snapshot can still reach
+    void collect() { reclaimer_.collect(); }
+
+    StoreSnapshot snapshot();
+
+private:
+    friend class StoreSnapshot;
+
+    struct Segment {
+        Segment() = default;
+        Segment(size_t rows, size_t dim);
+
+        std::unique_ptr<double[]> data;
+        std::unique_ptr<std::atomic<uint8_t>[]> ready;
+        std::unique_ptr<std::atomic<uint8_t>[]> deleted;
+        std::atomic<size_t> deleted_count{0};
+    };
+
+    using SegmentSlot = std::atomic<Segment*>;
+
+    // Two-level segment directory; chunks are created on demand and live
+    // as long as the store
+    static constexpr size_t kDirectoryChunks = 1024;
+    static constexpr size_t kChunkSegments = 1024;
+
+    size_t dim_;
+    size_t segment_rows_;
+    unsigned segment_shift_;
+    std::atomic<SegmentSlot*> directory_[kDirectoryChunks];
+    // Marks the slot of a retired segment, so it is never recreated
+    Segment retired_;
+
+    std::atomic<size_t> reserved_{0};
+    std::atomic<size_t> committed_{0};
+    EpochReclaimer reclaimer_;
+
+    SegmentSlot* slot(size_t segment, bool create);
+    Segment* segment_for_write(size_t segment);
+    // Live segment holding `index`, or null once it has been retired
+    const Segment* find_segment(size_t index) const;
+    size_t reserve(size_t count);
+    void write_row(size_t index, const double* row);
+    void advance_committed();
+};
+
+/**
+ * StoreSnapshot - Consistent read-only view of a ConcurrentVectorStore
+ *
+ * Covers the rows committed when it was taken. Rows deleted afterwards read
+ * as deleted, but their memory stays valid while the snapshot is alive, so
+ * keep snapshots short-lived to let retired segments be freed.
+ */
+class StoreSnapshot {
+public:
+    size_t size() const { return count_; }
+    size_t dimensions() const { return store_->dim_; }
+
+    bool is_deleted(size_t index) const;
+    // Row data, or null for deleted rows
+    const double* row(size_t index) const;
+    VectorND get(size_t index) const;
+
+    // Runs body(first_index, rows) over each live segment in order; the
+    // views include deleted rows, which callers filter with is_deleted
+    template <typename Body>
+    void for_each_segment(const Body& body) const {
+        check_active();
+        for (size_t first = 0; first < count_; first += store_->segment_rows_) {
+            const auto* segment = store_->find_segment(first);
+            if (segment) {
+                size_t rows = std::min(store_->segment_rows_, count_ - first);
+                body(first, BatchView{segment->data.get(), rows, store_->dim_, store_->dim_});
+            }
+        }
+    }
+
+    // Live rows copied into one batch, with their store indices
+    VectorBatch to_batch(std::vector<size_t>& indices) const;
+
+    // Ends the snapshot early; it cannot be read afterwards
+    void release() { guard_.release(); }
+
+private:
+    friend class ConcurrentVectorStore;
+
+    StoreSnapshot(ConcurrentVectorStore& store);
+
+    const ConcurrentVectorStore* store_;
+    EpochReclaimer::Guard guard_;
+    size_t count_;
+
+    void check_active() const;
+    void check_index(size_t index) const;
+};
+
+// Exact k nearest live rows of a snapshot, closest first (ties by index)
+std::vector<Neighbor> k_nearest(const StoreSnapshot& snapshot, const VectorND& query, size_t k);
+
+} // namespace vectors
+
+#endif // CONCURRENT_STORE_H
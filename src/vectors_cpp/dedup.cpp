@@ -0,0 +1,350 @@
+#include "dedup.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace vectors {
+
+namespace {
+
+// Rows per task
+constexpr size_t kRowBlock = 4096;
+
+// Grid cells are this many tolerances wide, so few components fall within
+// `tolerance` of a cell boundary
+constexpr double kCellWidthInTolerances = 1024.0;
+
+// Rows with more components near a boundary than this are compared with
+// every row instead of looking in 2^n neighbouring cells
+constexpr size_t kMaxProbeDims = 12;
+
+// Beyond this many tolerances, neighbouring doubles are more than
+// `tolerance` apart, so close components are equal and always share a cell
+constexpr double kExactRange = 18014398509481984.0;  // 2^54
+
+// Cell indices are clamped to this range before hashing
+constexpr double kMaxCell = 4611686018427387904.0;  // 2^62
+
+void check_tolerance(double tolerance) {
+    if (!(tolerance > 0.0)) {
+        throw std::runtime_error("Tolerance must be positive");
+    }
+}
+
+// Checks that `b` pairs with `a` and returns it as a view of a.count rows,
+// repeating a single row
+BatchView paired(const BatchView& a, const BatchView& b, const char* operation) {
+    if (a.dim != b.dim) {
+        throw std::runtime_error(
+            std::string("Dimension mismatch in ") + operation + ": " +
+            std::to_string(a.dim) + " vs " + std::to_string(b.dim)
+        );
+    }
+    if (b.count == 1) {
+        return BatchView{b.data, a.count, b.dim, 0};
+    }
+    if (a.count != b.count) {
+        throw std::runtime_error(
+            std::string("Batch size mismatch in ") + operation + ": " +
+            std::to_string(a.count) + " vs " + std::to_string(b.count)
+        );
+    }
+    return b;
+}
+
+// Components differing by `tolerance` or more, the test of operator==;
+// zero means the rows are close
+size_t far_components(const double* a, const double* b, size_t dim, double tolerance) {
+    size_t far = 0;
+    for (size_t i = 0; i < dim; ++i) {
+        far += std::abs(a[i] - b[i]) >= tolerance;
+    }
+    return far;
+}
+
+bool finite_row(const double* row, size_t dim) {
+    size_t bad = 0;
+    for (size_t i = 0; i < dim; ++i) {
+        bad += !std::isfinite(row[i]);
+    }
+    return bad == 0;
+}
+
+// splitmix64 finalizer
+uint64_t mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// Grid over row space. A row's key is the sum of one hashed term per
+// component, so moving one component to the neighbouring cell changes the
+// key by a difference of two terms.
+struct Grid {
+    double tolerance;
+    double inv_width;
+    double margin;                // `tolerance` in cell widths
+    std::vector<double> offset;   // per-dimension shift, in cell widths
+    std::vector<uint64_t> seed;
+
+    Grid(double tol, size_t dim)
+        : tolerance(tol),
+          inv_width(1.0 / (tol * kCellWidthInTolerances)),
+          margin(1.0 / kCellWidthInTolerances),
+          offset(dim),
+          seed(dim) {
+        // Offsets between 1/4 and 3/4 of a cell keep zeros and other round
+        // values away from the cell boundaries
+        for (size_t d = 0; d < dim; ++d) {
+            seed[d] = mix(d + 1);
+            offset[d] = 0.25 + 0.5 * static_cast<double>(seed[d] >> 11) * 0x1p-53;
+        }
+    }
+
+    double position(size_t d, double x) const { return x * inv_width + offset[d]; }
+
+    uint64_t term(size_t d, double cell) const {
+        cell = std::max(-kMaxCell, std::min(kMaxCell, cell));
+        return mix(static_cast<uint64_t>(static_cast<int64_t>(cell)) ^ seed[d]);
+    }
+
+    uint64_t key(const double* row, size_t dim) const {
+        uint64_t key = 0;
+        for (size_t d = 0; d < dim; ++d) {
+            key += term(d, std::floor(position(d, row[d])));
+        }
+        return key;
+    }
+
+    // Key changes that move the row across each nearby cell boundary. The
+    // margin is widened by a few ulps of the position so that rounding in
+    // position() cannot hide a boundary.
+    void probes(const double* row, size_t dim, std::vector<uint64_t>& deltas) const {
+        deltas.clear();
+        for (size_t d = 0; d < dim; ++d) {
+            if (std::abs(row[d]) >= tolerance * kExactRange) {
+                continue;
+            }
+            double u = position(d, row[d]);
+            double cell = std::floor(u);
+            double frac = u - cell;
+            double slack = margin + std::abs(u) * 0x1p-50;
+            if (frac < slack) {
+                deltas.push_back(term(d, cell - 1.0) - term(d, cell));
+            }
+            if (1.0 - frac < slack) {
+                deltas.push_back(term(d, cell + 1.0) - term(d, cell));
+            }
+        }
+    }
+};
+
+// Union-find whose roots are the smallest index of each set
+struct DisjointSets {
+    std::vector<size_t> parent;
+
+    explicit DisjointSets(size_t n) : parent(n) {
+        std::iota(parent.begin(), parent.end(), size_t(0));
+    }
+
+    size_t find(size_t x) {
+        while (parent[x] != x) {
+            parent[x] = parent[parent[x]];
+            x = parent[x];
+        }
+        return x;
+    }
+
+    void unite(size_t a, size_t b) {
+        a = find(a);
+        b = find(b);
+        if (a != b) {
+            parent[std::max(a, b)] = std::min(a, b);
+        }
+    }
+};
+
+using Pair = std::pair<size_t, size_t>;
+
+} // namespace
+
+void batch_isclose(const BatchView& a, const BatchView& b, double tolerance, uint8_t* result) {
+    check_tolerance(tolerance);
+    const BatchView rhs = paired(a, b, "batch isclose");
+    size_t blocks = (a.count + kRowBlock - 1) / kRowBlock;
+    parallel_for(blocks, a.count * a.dim, [&](size_t blk) {
+        size_t end = std::min(a.count, (blk + 1) * kRowBlock);
+        for (size_t r = blk * kRowBlock; r < end; ++r) {
+            result[r] = far_components(a.row(r), rhs.row(r), a.dim, tolerance) == 0;
+        }
+    });
+}
+
+bool batch_allclose(const BatchView& a, const BatchView& b, double tolerance) {
+    check_tolerance(tolerance);
+    const BatchView rhs = paired(a, b, "batch allclose");
+    size_t blocks = (a.count + kRowBlock - 1) / kRowBlock;
+    size_t far_rows = parallel_reduce(blocks, a.count * a.dim, size_t(0), [&](size_t blk) {
+        size_t far = 0;
+        size_t end = std::min(a.count, (blk + 1) * kRowBlock);
+        for (size_t r = blk * kRowBlock; r < end; ++r) {
+            far += far_components(a.row(r), rhs.row(r), a.dim, tolerance) != 0;
+        }
+        return far;
+    }, [](size_t x, size_t y) { return x + y; });
+    return far_rows == 0;
+}
+
+std::vector<std::vector<size_t>> find_near_duplicates(const BatchView& vectors,
+                                                      double tolerance) {
+    check_tolerance(tolerance);
+    const size_t n = vectors.count;
+    const size_t dim = vectors.dim;
+    const Grid grid(tolerance, dim);
+    const size_t blocks = (n + kRowBlock - 1) / kRowBlock;
+
+    // Keys of the finite rows
+    std::vector<uint64_t> keys(n);
+    std::vector<uint8_t> finite(n);
+    parallel_for(blocks, n * dim, [&](size_t blk) {
+        size_t end = std::min(n, (blk + 1) * kRowBlock);
+        for (size_t r = blk * kRowBlock; r < end; ++r) {
+            finite[r] = finite_row(vectors.row(r), dim);
+            keys[r] = finite[r] ? grid.key(vectors.row(r), dim) : 0;
+        }
+    });
+
+    // Rows sorted by key, with bitwise identical rows next to each other
+    std::vector<size_t> order;
+    order.reserve(n);
+    for (size_t r = 0; r < n; ++r) {
+        if (finite[r]) {
+            order.push_back(r);
+        }
+    }
+    const size_t row_bytes = dim * sizeof(double);
+    std::sort(order.begin(), order.end(), [&](size_t x, size_t y) {
+        if (keys[x] != keys[y]) {
+            return keys[x] < keys[y];
+        }
+        int c = std::memcmp(vectors.row(x), vectors.row(y), row_bytes);
+        return c != 0 ? c < 0 : x < y;
+    });
+    const size_t m = order.size();
+    std::vector<uint64_t> sorted_keys(m);
+    for (size_t p = 0; p < m; ++p) {
+        sorted_keys[p] = keys[order[p]];
+    }
+
+    // Only the first of each run of identical rows is compared; the others
+    // join it directly
+    DisjointSets sets(n);
+    std::vector<size_t> distinct;
+    for (size_t p = 0; p < m; ++p) {
+        if (p > 0 && sorted_keys[p] == sorted_keys[p - 1] &&
+            std::memcmp(vectors.row(order[p]), vectors.row(order[p - 1]), row_bytes) == 0) {
+            sets.unite(order[p], order[p - 1]);
+        } else {
+            distinct.push_back(p);
+        }
+    }
+
+    // Close pairs among the distinct rows: later rows in the same cell, rows
+    // in the cells across nearby boundaries, or every row when there are too
+    // many such boundaries. A pair across a boundary may be found from both
+    // sides, which the union ignores.
+    const size_t d_count = distinct.size();
+    const size_t d_blocks = (d_count + kRowBlock - 1) / kRowBlock;
+    std::vector<std::vector<Pair>> found(d_blocks);
+    auto close = [&](size_t x, size_t y) {
+        return far_components(vectors.row(x), vectors.row(y), dim, tolerance) == 0;
+    };
+    auto distinct_at = [&](size_t p) {
+        return std::binary_search(distinct.begin(), distinct.end(), p);
+    };
+    parallel_for(d_blocks, d_count * dim, [&](size_t blk) {
+        std::vector<Pair>& pairs = found[blk];
+        std::vector<uint64_t> deltas;
+        size_t end = std::min(d_count, (blk + 1) * kRowBlock);
+        for (size_t k = blk * kRowBlock; k < end; ++k) {
+            const size_t p = distinct[k];
+            const size_t row = order[p];
+            const uint64_t key = sorted_keys[p];
+            for (size_t q = k + 1; q < d_count && sorted_keys[distinct[q]] == key; ++q) {
+                if (close(row, order[distinct[q]])) {
+                    pairs.emplace_back(row, order[distinct[q]]);
+                }
+            }
+
+            grid.probes(vectors.row(row), dim, deltas);
+            if (deltas.empty()) {
+                continue;
+            }
+            if (deltas.size() > kMaxProbeDims) {
+                for (size_t q : distinct) {
+                    if (sorted_keys[q] != key && close(row, order[q])) {
+                        pairs.emplace_back(row, order[q]);
+                    }
+                }
+                continue;
+            }
+            const size_t masks = size_t(1) << deltas.size();
+            for (size_t mask = 1; mask < masks; ++mask) {
+                uint64_t probe = key;
+                for (size_t d = 0; d < deltas.size(); ++d) {
+                    if (mask & (size_t(1) << d)) {
+                        probe += deltas[d];
+                    }
+                }
+                if (probe == key) {
+                    continue;
+                }
+                auto range = std::equal_range(sorted_keys.begin(), sorted_keys.end(), probe);
+                for (auto it = range.first; it != range.second; ++it) {
+                    size_t q = static_cast<size_t>(it - sorted_keys.begin());
+                    if (distinct_at(q) && close(row, order[q])) {
+                        pairs.emplace_back(row, order[q]);
+                    }
+                }
+            }
+        }
+    });
+    for (const auto& pairs : found) {
+        for (const Pair& pair : pairs) {
+            sets.unite(pair.first, pair.second);
+        }
+    }
+
+    // Groups keyed by their root, which is also their smallest index. A group
+    // is opened at its root, so groups come out in order of their first index.
+    std::vector<size_t> root_of(n);
+    std::vector<uint8_t> has_members(n, 0);
+    for (size_t r = 0; r < n; ++r) {
+        root_of[r] = sets.find(r);
+        if (root_of[r] != r) {
+            has_members[root_of[r]] = 1;
+        }
+    }
+    std::vector<std::vector<size_t>> groups;
+    std::vector<size_t> group_of(n, std::numeric_limits<size_t>::max());
+    for (size_t r = 0; r < n; ++r) {
+        if (has_members[r]) {
+            group_of[r] = groups.size();
+            groups.push_back({r});
+        } else if (root_of[r] != r) {
+            groups[group_of[root_of[r]]].push_back(r);
+        }
+    }
+    return groups;
+}
+
+} // namespace vectors
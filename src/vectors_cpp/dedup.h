@@ -0,0 +1,43 @@
+#ifndef DEDUP_H
+#define DEDUP_H
+
+#include "vector_batch.h"
+#include <cstdint>
+#include <vector>
+
+namespace vectors {
+
+/**
+ * Batched epsilon equality.
+ *
+ * Rows are compared like VectorND::operator==: two rows are close when
+ * every component differs by less than `tolerance`. Row i of `a` is compared
+ * with row i of `b`; a `b` with a single row is compared with every row.
+ * Each row is checked without an early exit, so the loop vectorizes.
+ */
+void batch_isclose(const BatchView& a, const BatchView& b, double tolerance, uint8_t* result);
+bool batch_allclose(const BatchView& a, const BatchView& b, double tolerance);
+
+/**
+ * Near-duplicate rows, grouped.
+ *
+ * Two rows are near duplicates when they are close in the sense of
+ * batch_isclose. A group holds rows that are linked by a chain of
+ * near-duplicate pairs. Each group lists its row indices in ascending order,
+ * and groups are ordered by their first index. Only groups of two or more
+ * rows are returned. Rows with NaN or infinite components are never grouped.
+ *
+ * Rows are hashed by their cell on a grid much coarser than `tolerance`,
+ * and only rows that share a cell are compared. A component within
+ * `tolerance` of a cell boundary also makes the row look in the cell across
+ * that boundary, so no pair is missed. Bitwise identical rows are merged
+ * before any comparison. Hashing and candidate checks run in parallel over
+ * row blocks. Cost grows with the square of the number of distinct rows
+ * sharing a grid cell.
+ */
+std::vector<std::vector<size_t>> find_near_duplicates(const BatchView& vectors,
+                                                      double tolerance);
+
+} // namespace vectors
+
+#endif // DEDUP_H
@@ -0,0 +1,550 @@
+#include "dim_reduction.h"
+#include "online_stats.h"
+#include "parallel.h"
+#include "transform.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace vectors {
+
+namespace {
+
+// Rows per task
+constexpr size_t kRowBlock = 4096;
+
+// Rows centered and folded into the scatter matrix at a time, and scatter
+// rows per task while they are
+constexpr size_t kScatterTile = 256;
+constexpr size_t kScatterStripe = 8;
+
+// Extra directions tracked by subspace iteration. Each iteration shrinks the
+// error of component k by about lambda[k + oversample] / lambda[k]; iteration
+// stops once every residual |C v - lambda v| is below kRitzTolerance times
+// the largest variance.
+constexpr size_t kOversample = 10;
+constexpr size_t kMaxSubspaceIterations = 50;
+constexpr double kRitzTolerance = 1e-10;
+
+constexpr size_t kMaxJacobiSweeps = 64;
+
+// A basis row that loses all but this fraction of its length to
+// orthogonalization is linearly dependent and is replaced
+constexpr double kDependentRow = 1e-10;
+
+// Runs body(begin, end) over row blocks, in parallel for large batches
+template <typename Body>
+void for_each_row_block(size_t count, size_t dim, const Body& body) {
+    size_t blocks = (count + kRowBlock - 1) / kRowBlock;
+    auto task = [&](size_t b) {
+        body(b * kRowBlock, std::min(count, (b + 1) * kRowBlock));
+    };
+    parallel_for(blocks, count * dim, task);
+}
+
+// Whether `rows` reads any of `result`'s storage
+bool overlaps(const BatchView& rows, const VectorBatch& result) {
+    if (rows.count == 0 || result.size() == 0) {
+        return false;
+    }
+    std::less<const double*> before;
+    const double* first = rows.data;
+    const double* last = rows.row(rows.count - 1) + rows.dim;
+    const double* begin = result.data();
+    const double* end = begin + result.size() * result.dimensions();
+    return before(first, end) && before(begin, last);
+}
+
+double dot(const double* a, const double* b, size_t n) {
+    double sum = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+// Modified Gram-Schmidt, applied twice, on the `count` rows of q. Dependent
+// rows are replaced by random ones, so the result is always a full basis.
+void orthonormalize(double* q, size_t count, size_t n, std::mt19937_64& rng) {
+    std::normal_distribution<double> gaussian;
+    for (size_t j = 0; j < count; ++j) {
+        double* v = q + j * n;
+        while (true) {
+            double before = std::sqrt(dot(v, v, n));
+            for (int pass = 0; pass < 2; ++pass) {
+                for (size_t i = 0; i < j; ++i) {
+                    const double* u = q + i * n;
+                    double d = dot(u, v, n);
+                    for (size_t m = 0; m < n; ++m) {
+                        v[m] -= d * u[m];
+                    }
+                }
+            }
+            double norm = std::sqrt(dot(v, v, n));
+            if (norm > kDependentRow * before && norm > 0.0) {
+                for (size_t m = 0; m < n; ++m) {
+                    v[m] /= norm;
+                }
+                break;
+            }
+            for (size_t m = 0; m < n; ++m) {
+                v[m] = gaussian(rng);
+            }
+        }
+    }
+}
+
+// out = q * c for `count` rows q of length n and symmetric n x n c; row j of
+// the result is c * q_j
+void multiply_symmetric(const double* q, size_t count, const std::vector<double>& c, size_t n,
+                        double* out) {
+    parallel_for(count, count * n * n, [&](size_t j) {
+        const double* v = q + j * n;
+        double* y = out + j * n;
+        std::fill(y, y + n, 0.0);
+        for (size_t m = 0; m < n; ++m) {
+            const double x = v[m];
+            const double* row = c.data() + m * n;
+            for (size_t i = 0; i < n; ++i) {
+                y[i] += x * row[i];
+            }
+        }
+    });
+}
+
+// Eigen-decomposition of the symmetric n x n matrix a by cyclic Jacobi
+// rotations. On return the diagonal of a holds the eigenvalues and column i
+// of v the eigenvector of a(i, i).
+void jacobi_eigen(std::vector<double>& a, size_t n, std::vector<double>& v) {
+    v.assign(n * n, 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        v[i * n + i] = 1.0;
+    }
+    const double total = dot(a.data(), a.data(), n * n);
+    const double eps = std::numeric_limits<double>::epsilon();
+    for (size_t sweep = 0; sweep < kMaxJacobiSweeps; ++sweep) {
+        double off = 0.0;
+        for (size_t p = 0; p < n; ++p) {
+            for (size_t q = p + 1; q < n; ++q) {
+                off += a[p * n + q] * a[p * n + q];
+            }
+        }
+        if (off <= eps * eps * total) {
+            return;
+        }
+        for (size_t p = 0; p < n; ++p) {
+            for (size_t q = p + 1; q < n; ++q) {
+                const double apq = a[p * n + q];
+                if (apq == 0.0) {
+                    continue;
+                }
+                // Rotation that zeroes a(p, q), the smaller of the two angles
+                double theta = (a[q * n + q] - a[p * n + p]) / (2.0 * apq);
+                double t = (theta >= 0.0 ? 1.0 : -1.0) /
+                           (std::abs(theta) + std::sqrt(theta * theta + 1.0));
+                double c = 1.0 / std::sqrt(t * t + 1.0);
+                double s = t * c;
+                for (size_t k = 0; k < n; ++k) {
+                    double akp = a[k * n + p];
+                    double akq = a[k * n + q];
+                    a[k * n + p] = c * akp - s * akq;
+                    a[k * n + q] = s * akp + c * akq;
+                }
+                for (size_t k = 0; k < n; ++k) {
+                    double apk = a[p * n + k];
+                    double aqk = a[q * n + k];
+                    a[p * n + k] = c * apk - s * aqk;
+                    a[q * n + k] = s * apk + c * aqk;
+                }
+                for (size_t k = 0; k < n; ++k) {
+                    double vkp = v[k * n + p];
+                    double vkq = v[k * n + q];
+                    v[k * n + p] = c * vkp - s * vkq;
+                    v[k * n + q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+}
+
+// Approximate eigenpairs of a symmetric matrix C from an orthonormal basis
+// Q of a subspace and its image C * Q, as rows
+struct RitzPairs {
+    std::vector<double> values;
+    std::vector<double> vectors;   // unit rows in the subspace
+    std::vector<double> images;    // C times each vector
+    std::vector<size_t> order;     // by decreasing value
+
+    // Whether the leading `count` vectors have residuals |C v - value v|
+    // below the tolerance
+    bool converged(size_t count, size_t n) const {
+        const double limit = kRitzTolerance * std::max(0.0, values[order[0]]);
+        for (size_t c = 0; c < count; ++c) {
+            const size_t e = order[c];
+            double residual = 0.0;
+            for (size_t i = 0; i < n; ++i) {
+                double r = images[e * n + i] - values[e] * vectors[e * n + i];
+                residual += r * r;
+            }
+            if (std::sqrt(residual) > limit) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+// Solves the covariance restricted to the subspace, Q C Q^T, and rotates the
+// basis and its image onto the solution
+void rayleigh_ritz(const std::vector<double>& basis, const std::vector<double>& image, size_t l,
+                   size_t n, RitzPairs& ritz) {
+    std::vector<double> small(l * l);
+    for (size_t a = 0; a < l; ++a) {
+        for (size_t b = a; b < l; ++b) {
+            small[a * l + b] = small[b * l + a] =
+                dot(basis.data() + a * n, image.data() + b * n, n);
+        }
+    }
+    std::vector<double> rotation;
+    jacobi_eigen(small, l, rotation);
+
+    ritz.values.resize(l);
+    ritz.vectors.assign(l * n, 0.0);
+    ritz.images.assign(l * n, 0.0);
+    for (size_t e = 0; e < l; ++e) {
+        ritz.values[e] = small[e * l + e];
+        double* v = ritz.vectors.data() + e * n;
+        double* y = ritz.images.data() + e * n;
+        for (size_t m = 0; m < l; ++m) {
+            const double w = rotation[m * l + e];
+            const double* q = basis.data() + m * n;
+            const double* cq = image.data() + m * n;
+            for (size_t i = 0; i < n; ++i) {
+                v[i] += w * q[i];
+                y[i] += w * cq[i];
+            }
+        }
+    }
+    ritz.order.resize(l);
+    std::iota(ritz.order.begin(), ritz.order.end(), size_t(0));
+    std::stable_sort(ritz.order.begin(), ritz.order.end(), [&](size_t a, size_t b) {
+        return ritz.values[a] > ritz.values[b];
+    });
+}
+
+} // namespace
+
+// RandomProjection
+
+RandomProjection::RandomProjection(size_t input_dimensions, size_t output_dimensions,
+                                   ProjectionKind kind, double density, uint64_t seed)
+    : kind_(kind), density_(1.0), matrix_(output_dimensions, input_dimensions) {
+    if (input_dimensions == 0 || output_dimensions == 0) {
+        throw std::runtime_error("Projection dimensions must be positive");
+    }
+    std::mt19937_64 rng(seed);
+    if (kind == ProjectionKind::Gaussian) {
+        std::normal_distribution<double> gaussian(0.0, 1.0 / std::sqrt(double(output_dimensions)));
+        for (size_t i = 0; i < output_dimensions * input_dimensions; ++i) {
+            matrix_.data()[i] = gaussian(rng);
+        }
+        return;
+    }
+
+    density_ = density == 0.0 ? 1.0 / std::sqrt(double(input_dimensions)) : density;
+    if (!(density_ > 0.0 && density_ <= 1.0)) {
+        throw std::runtime_error("Projection density must be in (0, 1]");
+    }
+    const double scale = 1.0 / std::sqrt(density_ * double(output_dimensions));
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    for (size_t i = 0; i < output_dimensions * input_dimensions; ++i) {
+        double u = uniform(rng);
+        matrix_.data()[i] = u < 0.5 * density_ ? -scale : (u < density_ ? scale : 0.0);
+    }
+    starts_.assign(1, 0);
+    for (size_t d = 0; d < input_dimensions; ++d) {
+        for (size_t j = 0; j < output_dimensions; ++j) {
+            if (matrix_(j, d) != 0.0) {
+                outputs_.push_back(j);
+                values_.push_back(matrix_(j, d));
+            }
+        }
+        starts_.push_back(outputs_.size());
+    }
+}
+
+void RandomProjection::transform(const BatchView& rows, VectorBatch& result) const {
+    if (kind_ == ProjectionKind::Gaussian) {
+        vectors::transform(rows, matrix_, result);
+        return;
+    }
+    if (rows.dim != input_dimensions()) {
+        throw std::runtime_error(
+            "Dimension mismatch in random projection: " +
+            std::to_string(input_dimensions()) + " vs " + std::to_string(rows.dim)
+        );
+    }
+    // Outputs are accumulated in place, so they cannot share storage with
+    // the rows
+    const size_t k = output_dimensions();
+    if (result.size() != rows.count || result.dimensions() != k || overlaps(rows, result)) {
+        VectorBatch fresh(rows.count, k);
+        transform(rows, fresh);
+        result = std::move(fresh);
+        return;
+    }
+    for_each_row_block(rows.count, values_.size() + k, [&](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; ++r) {
+            const double* v = rows.row(r);
+            double* out = result.row(r);
+            std::fill(out, out + k, 0.0);
+            for (size_t d = 0; d < rows.dim; ++d) {
+                const double x = v[d];
+                for (size_t e = starts_[d]; e < starts_[d + 1]; ++e) {
+                    out[outputs_[e]] += values_[e] * x;
+                }
+            }
+        }
+    });
+}
+
+// Pca
+
+Pca::Pca(size_t dimensions, size_t components, uint64_t seed)
+    : dim_(dimensions),
+      components_count_(components),
+      seed_(seed),
+      count_(0),
+      mean_(dimensions, 0.0),
+      scatter_(dimensions * dimensions, 0.0),
+      fitted_(false),
+      components_(components, dimensions),
+      shift_(components),
+      variance_(components, 0.0) {
+    if (components == 0 || components > dimensions) {
+        throw std::runtime_error(
+            "PCA components must be between 1 and " + std::to_string(dimensions)
+        );
+    }
+}
+
+void Pca::check_dimensions(size_t dimensions, const char* operation) const {
+    if (dimensions != dim_) {
+        throw std::runtime_error(
+            std::string("Dimension mismatch in ") + operation + ": " +
+            std::to_string(dim_) + " vs " + std::to_string(dimensions)
+        );
+    }
+}
+
+void Pca::check_fitted() const {
+    if (!fitted_) {
+        throw std::runtime_error("PCA has not been fitted");
+    }
+}
+
+size_t Pca::count() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return count_;
+}
+
+bool Pca::fitted() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return fitted_;
+}
+
+void Pca::partial_fit(const BatchView& rows) {
+    check_dimensions(rows.dim, "PCA fit");
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    accumulate(rows);
+}
+
+void Pca::accumulate(const BatchView& rows) {
+    if (rows.count == 0) {
+        return;
+    }
+    const size_t n = dim_;
+    OnlineStats stats(n);
+    stats.add_batch(rows.data, rows.count, rows.stride);
+    const VectorND chunk_mean = stats.mean();
+
+    // Upper triangle of the scatter about the chunk mean. Every entry sums
+    // its rows in order, whichever thread owns its stripe.
+    std::vector<double> tile(kScatterTile * n);
+    const size_t stripes = (n + kScatterStripe - 1) / kScatterStripe;
+    for (size_t begin = 0; begin < rows.count; begin += kScatterTile) {
+        const size_t end = std::min(rows.count, begin + kScatterTile);
+        const size_t tile_rows = end - begin;
+        for (size_t r = 0; r < tile_rows; ++r) {
+            const double* v = rows.row(begin + r);
+            for (size_t d = 0; d < n; ++d) {
+                tile[r * n + d] = v[d] - chunk_mean[d];
+            }
+        }
+        parallel_for(stripes, tile_rows * n * n / 2, [&](size_t s) {
+            const size_t first = s * kScatterStripe;
+            const size_t last = std::min(n, first + kScatterStripe);
+            for (size_t r = 0; r < tile_rows; ++r) {
+                const double* x = tile.data() + r * n;
+                for (size_t i = first; i < last; ++i) {
+                    const double xi = x[i];
+                    double* out = scatter_.data() + i * n;
+                    for (size_t j = i; j < n; ++j) {
+                        out[j] += xi * x[j];
+                    }
+                }
+            }
+        });
+    }
+
+    // Chan's update moves the combined scatter to the combined mean
+    const double na = static_cast<double>(count_);
+    const double nb = static_cast<double>(rows.count);
+    const double weight = na * nb / (na + nb);
+    std::vector<double> delta(n);
+    for (size_t d = 0; d < n; ++d) {
+        delta[d] = chunk_mean[d] - mean_[d];
+    }
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = i; j < n; ++j) {
+            scatter_[i * n + j] += delta[i] * delta[j] * weight;
+        }
+        mean_[i] += delta[i] * (nb / (na + nb));
+    }
+    count_ += rows.count;
+}
+
+void Pca::fit() {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    solve();
+}
+
+void Pca::solve() {
+    if (count_ < 2) {
+        throw std::runtime_error("Cannot fit PCA to fewer than 2 vectors");
+    }
+    const size_t n = dim_;
+    const size_t k = components_count_;
+    std::vector<double> covariance(n * n);
+    const double scale = 1.0 / static_cast<double>(count_ - 1);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = i; j < n; ++j) {
+            covariance[i * n + j] = covariance[j * n + i] = scatter_[i * n + j] * scale;
+        }
+    }
+
+    // Orthonormal basis of the subspace to solve in, one row per direction,
+    // and the covariance applied to it
+    const size_t l = std::min(n, k + kOversample);
+    std::vector<double> basis(l * n);
+    std::vector<double> image(l * n);
+    RitzPairs ritz;
+    if (l == n) {
+        for (size_t i = 0; i < n; ++i) {
+            basis[i * n + i] = 1.0;
+        }
+        image = covariance;
+        rayleigh_ritz(basis, image, l, n, ritz);
+    } else {
+        std::mt19937_64 rng(seed_);
+        std::normal_distribution<double> gaussian;
+        for (double& x : basis) {
+            x = gaussian(rng);
+        }
+        orthonormalize(basis.data(), l, n, rng);
+        for (size_t it = 0; it < kMaxSubspaceIterations; ++it) {
+            multiply_symmetric(basis.data(), l, covariance, n, image.data());
+            rayleigh_ritz(basis, image, l, n, ritz);
+            if (ritz.converged(k, n)) {
+                break;
+            }
+            basis = ritz.images;
+            orthonormalize(basis.data(), l, n, rng);
+        }
+    }
+
+    for (size_t c = 0; c < k; ++c) {
+        const size_t e = ritz.order[c];
+        double* component = components_.data() + c * n;
+        std::copy(ritz.vectors.begin() + e * n, ritz.vectors.begin() + (e + 1) * n, component);
+        size_t largest = 0;
+        for (size_t i = 1; i < n; ++i) {
+            if (std::abs(component[i]) > std::abs(component[largest])) {
+                largest = i;
+            }
+        }
+        double norm = std::sqrt(dot(component, component, n));
+        double sign = component[largest] < 0.0 ? -1.0 : 1.0;
+        for (size_t i = 0; i < n; ++i) {
+            component[i] *= sign / norm;
+        }
+        variance_[c] = std::max(0.0, ritz.values[e]);
+        shift_[c] = -dot(component, mean_.data(), n);
+    }
+    fitted_ = true;
+}
+
+void Pca::fit(const BatchView& rows) {
+    check_dimensions(rows.dim, "PCA fit");
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    clear();
+    accumulate(rows);
+    solve();
+}
+
+void Pca::reset() {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    clear();
+}
+
+void Pca::clear() {
+    count_ = 0;
+    fitted_ = false;
+    std::fill(mean_.begin(), mean_.end(), 0.0);
+    std::fill(scatter_.begin(), scatter_.end(), 0.0);
+}
+
+VectorND Pca::mean() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return VectorND(mean_);
+}
+
+Matrix Pca::components() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    check_fitted();
+    return components_;
+}
+
+std::vector<double> Pca::explained_variance() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    check_fitted();
+    return variance_;
+}
+
+void Pca::transform(const BatchView& rows, VectorBatch& result) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    check_fitted();
+    check_dimensions(rows.dim, "PCA transform");
+    transform_affine(rows, components_, shift_, result);
+}
+
+void Pca::inverse_transform(const BatchView& coordinates, VectorBatch& result) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    check_fitted();
+    if (coordinates.dim != components_count_) {
+        throw std::runtime_error(
+            "Dimension mismatch in PCA inverse transform: " +
+            std::to_string(components_count_) + " vs " + std::to_string(coordinates.dim)
+        );
+    }
+    transform_affine(coordinates, components_.transpose(), VectorND(mean_), result);
+}
+
+} // namespace vectors
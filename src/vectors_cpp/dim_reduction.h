@@ -0,0 +1,123 @@
+#ifndef DIM_REDUCTION_H
+#define DIM_REDUCTION_H
+
+#include "matrix.h"
+#include "vector_batch.h"
+#include <cstdint>
+#include <shared_mutex>
+#include <vector>
+
+namespace vectors {
+
+// Entries of a RandomProjection matrix
+enum class ProjectionKind {
+    Gaussian,   // dense N(0, 1 / outputs)
+    Sparse      // +-sqrt(1 / (density * outputs)) with probability density, else 0
+};
+
+/**
+ * RandomProjection - Random linear map to fewer dimensions
+ *
+ * Both kinds preserve squared distances in expectation (Johnson-Lindenstrauss).
+ * Gaussian projections run through the dense transform() kernel. Sparse
+ * projections keep the non-zero entries grouped by input component and
+ * scatter each component into the few outputs it feeds, so they cost about
+ * `density` of a dense map; the default density is 1 / sqrt(inputs).
+ */
+class RandomProjection {
+public:
+    RandomProjection(size_t input_dimensions, size_t output_dimensions,
+                     ProjectionKind kind = ProjectionKind::Gaussian, double density = 0.0,
+                     uint64_t seed = 0);
+
+    size_t input_dimensions() const { return matrix_.cols(); }
+    size_t output_dimensions() const { return matrix_.rows(); }
+    ProjectionKind kind() const { return kind_; }
+    double density() const { return density_; }
+    // The map as an outputs x inputs matrix
+    const Matrix& matrix() const { return matrix_; }
+
+    // Row i of the result is matrix() * row_i. `result` is reused when it
+    // already has the output shape and may be the input batch itself.
+    void transform(const BatchView& rows, VectorBatch& result) const;
+
+private:
+    ProjectionKind kind_;
+    double density_;
+    Matrix matrix_;
+    // Sparse: entries of input component d are [starts_[d], starts_[d + 1])
+    std::vector<size_t> starts_;
+    std::vector<size_t> outputs_;
+    std::vector<double> values_;
+};
+
+/**
+ * Pca - Principal component analysis fitted from streamed batches
+ *
+ * partial_fit() folds rows into a running mean and scatter matrix, so a
+ * dataset can be fitted a chunk or a memory-mapped batch at a time. Each
+ * call centers its rows on their own mean and merges with Chan's update;
+ * the scatter is accumulated over tiles of rows with its rows split over
+ * the worker threads, in an order that does not depend on the thread count.
+ *
+ * fit() then finds the leading eigenvectors of the covariance. When they are
+ * a small part of the spectrum it runs randomized subspace iteration on a few
+ * more directions than requested, solving the small projected problem with
+ * Jacobi rotations after each step until the leading residuals are
+ * negligible; otherwise Jacobi runs on the whole covariance. Components
+ * are unit rows ordered by decreasing variance, with their largest entry
+ * positive.
+ *
+ * A Pca may be shared between threads: transforms and accessors hold a
+ * shared lock, fitting an exclusive one.
+ */
+class Pca {
+public:
+    Pca(size_t dimensions, size_t components, uint64_t seed = 0);
+
+    size_t dimensions() const { return dim_; }
+    size_t components_count() const { return components_count_; }
+    size_t count() const;
+    bool fitted() const;
+
+    void partial_fit(const BatchView& rows);
+    // Computes the components of everything folded in so far
+    void fit();
+    // Discards earlier data and fits `rows`
+    void fit(const BatchView& rows);
+    void reset();
+
+    VectorND mean() const;
+    // components_count() x dimensions()
+    Matrix components() const;
+    // Variance along each component (ddof = 1)
+    std::vector<double> explained_variance() const;
+
+    // Coordinates of (row - mean) along the components, and back
+    void transform(const BatchView& rows, VectorBatch& result) const;
+    void inverse_transform(const BatchView& coordinates, VectorBatch& result) const;
+
+private:
+    size_t dim_;
+    size_t components_count_;
+    uint64_t seed_;
+    size_t count_;
+    std::vector<double> mean_;
+    std::vector<double> scatter_;   // upper triangle, row-major dim x dim
+    bool fitted_;
+    Matrix components_;
+    VectorND shift_;                // -components * mean
+    std::vector<double> variance_;
+    mutable std::shared_mutex mutex_;
+
+    void check_dimensions(size_t dimensions, const char* operation) const;
+    void check_fitted() const;
+    // partial_fit(), fit() and reset() with the lock held
+    void accumulate(const BatchView& rows);
+    void solve();
+    void clear();
+};
+
+} // namespace vectors
+
+#endif // DIM_REDUCTION_H
@@ -0,0 +1,255 @@
+#include "elementwise.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace vectors {
+
+namespace {
+
+// Rows per task
+constexpr size_t kRowBlock = 4096;
+
+constexpr double kEpsilon = std::numeric_limits<double>::epsilon();
+
+// Length of one axis after broadcasting `a` against `b`
+size_t broadcast(size_t a, size_t b, const char* axis, const char* operation) {
+    if (a == b || b == 1) {
+        return a;
+    }
+    if (a == 1) {
+        return b;
+    }
+    throw std::runtime_error(
+        std::string(axis) + " mismatch in " + operation + ": " +
+        std::to_string(a) + " vs " + std::to_string(b)
+    );
+}
+
+// How an operand is read for a result row: `full` operands supply one value
+// per column, the others a single value for the whole row
+struct Source {
+    const double* data;
+    size_t row_step;
+    bool full;
+
+    const double* row(size_t r) const { return data + r * row_step; }
+};
+
+Source source(const BatchView& v, size_t dim) {
+    return Source{v.data, v.count == 1 ? 0 : v.stride, v.dim == dim};
+}
+
+// A broadcast value is copied out of the operand before the row is written,
+// so a result aliasing the operand cannot change it halfway through
+template <bool Full>
+const double* values(const double* row, double& local) {
+    if (Full) {
+        return row;
+    }
+    local = row[0];
+    return &local;
+}
+
+template <bool Full>
+double at(const double* values, size_t i) {
+    return Full ? values[i] : values[0];
+}
+
+// Calls body with std::true_type or std::false_type, so that every
+// broadcast pattern is compiled into its own loop
+template <typename Body>
+void dispatch(bool full, const Body& body) {
+    if (full) {
+        body(std::true_type{});
+    } else {
+        body(std::false_type{});
+    }
+}
+
+// Runs body(begin, end) over row blocks, in parallel for large batches
+template <typename Body>
+void for_each_row_block(size_t count, size_t dim, const Body& body) {
+    size_t blocks = (count + kRowBlock - 1) / kRowBlock;
+    auto task = [&](size_t b) {
+        body(b * kRowBlock, std::min(count, (b + 1) * kRowBlock));
+    };
+    parallel_for(blocks, count * dim, task);
+}
+
+// Each output element depends only on the inputs at the same position, so
+// the kernels can write over an input of the output shape; reshaping builds
+// the result aside
+template <typename Kernel>
+void into_result(size_t count, size_t dim, VectorBatch& result, const Kernel& kernel) {
+    if (result.size() != count || result.dimensions() != dim) {
+        VectorBatch reshaped(count, dim);
+        kernel(reshaped);
+        result = std::move(reshaped);
+        return;
+    }
+    kernel(result);
+}
+
+// Whether any element is within epsilon of zero. Counted without an early
+// exit so the loop vectorizes.
+bool has_zero(const BatchView& v) {
+    size_t blocks = (v.count + kRowBlock - 1) / kRowBlock;
+    int64_t zeros = parallel_reduce(blocks, v.count * v.dim, int64_t(0), [&](size_t b) {
+        int64_t found = 0;
+        size_t end = std::min(v.count, (b + 1) * kRowBlock);
+        for (size_t r = b * kRowBlock; r < end; ++r) {
+            const double* row = v.row(r);
+            for (size_t i = 0; i < v.dim; ++i) {
+                found += std::abs(row[i]) < kEpsilon;
+            }
+        }
+        return found;
+    }, [](int64_t x, int64_t y) { return x + y; });
+    return zeros != 0;
+}
+
+template <typename F>
+void run_unary(const F& f, const BatchView& a, VectorBatch& result) {
+    const size_t dim = a.dim;
+    into_result(a.count, dim, result, [&](VectorBatch& out) {
+        for_each_row_block(a.count, dim, [&](size_t begin, size_t end) {
+            for (size_t r = begin; r < end; ++r) {
+                const double* x = a.row(r);
+                double* o = out.row(r);
+                for (size_t i = 0; i < dim; ++i) {
+                    o[i] = f(x[i]);
+                }
+            }
+        });
+    });
+}
+
+template <typename F>
+void run_binary(const F& f, const BatchView& a, const BatchView& b, VectorBatch& result,
+                const char* operation) {
+    const size_t count = broadcast(a.count, b.count, "Batch size", operation);
+    const size_t dim = broadcast(a.dim, b.dim, "Dimension", operation);
+    const Source sa = source(a, dim);
+    const Source sb = source(b, dim);
+    into_result(count, dim, result, [&](VectorBatch& out) {
+        dispatch(sa.full, [&](auto fa) {
+            dispatch(sb.full, [&](auto fb) {
+                constexpr bool full_a = decltype(fa)::value;
+                constexpr bool full_b = decltype(fb)::value;
+                for_each_row_block(count, dim, [&](size_t begin, size_t end) {
+                    for (size_t r = begin; r < end; ++r) {
+                        double la, lb;
+                        const double* x = values<full_a>(sa.row(r), la);
+                        const double* y = values<full_b>(sb.row(r), lb);
+                        double* o = out.row(r);
+                        for (size_t i = 0; i < dim; ++i) {
+                            o[i] = f(at<full_a>(x, i), at<full_b>(y, i));
+                        }
+                    }
+                });
+            });
+        });
+    });
+}
+
+template <typename F>
+void run_ternary(const F& f, const BatchView& a, const BatchView& b, const BatchView& c,
+                 VectorBatch& result, const char* operation) {
+    const size_t count = broadcast(broadcast(a.count, b.count, "Batch size", operation),
+                                   c.count, "Batch size", operation);
+    const size_t dim = broadcast(broadcast(a.dim, b.dim, "Dimension", operation),
+                                 c.dim, "Dimension", operation);
+    const Source sa = source(a, dim);
+    const Source sb = source(b, dim);
+    const Source sc = source(c, dim);
+    into_result(count, dim, result, [&](VectorBatch& out) {
+        dispatch(sa.full, [&](auto fa) {
+            dispatch(sb.full, [&](auto fb) {
+                dispatch(sc.full, [&](auto fc) {
+                    constexpr bool full_a = decltype(fa)::value;
+                    constexpr bool full_b = decltype(fb)::value;
+                    constexpr bool full_c = decltype(fc)::value;
+                    for_each_row_block(count, dim, [&](size_t begin, size_t end) {
+                        for (size_t r = begin; r < end; ++r) {
+                            double la, lb, lc;
+                            const double* x = values<full_a>(sa.row(r), la);
+                            const double* y = values<full_b>(sb.row(r), lb);
+                            const double* z = values<full_c>(sc.row(r), lc);
+                            double* o = out.row(r);
+                            for (size_t i = 0; i < dim; ++i) {
+                                o[i] = f(at<full_a>(x, i), at<full_b>(y, i), at<full_c>(z, i));
+                            }
+                        }
+                    });
+                });
+            });
+        });
+    });
+}
+
+} // namespace
+
+void batch_elementwise(ElementwiseOp op, const BatchView& a, const BatchView& b,
+                       VectorBatch& result) {
+    switch (op) {
+        case ElementwiseOp::Add:
+            run_binary([](double x, double y) { return x + y; }, a, b, result, "batch add");
+            return;
+        case ElementwiseOp::Subtract:
+            run_binary([](double x, double y) { return x - y; }, a, b, result,
+                       "batch subtract");
+            return;
+        case ElementwiseOp::Multiply:
+            run_binary([](double x, double y) { return x * y; }, a, b, result,
+                       "batch multiply");
+            return;
+        case ElementwiseOp::Divide:
+            // Shapes are checked before the divisor is scanned
+            broadcast(a.count, b.count, "Batch size", "batch divide");
+            broadcast(a.dim, b.dim, "Dimension", "batch divide");
+            if (has_zero(b)) {
+                throw std::runtime_error("Division by zero in batch divide");
+            }
+            run_binary([](double x, double y) { return x / y; }, a, b, result, "batch divide");
+            return;
+        case ElementwiseOp::Minimum:
+            run_binary([](double x, double y) { return y < x ? y : x; }, a, b, result,
+                       "batch minimum");
+            return;
+        case ElementwiseOp::Maximum:
+            run_binary([](double x, double y) { return x < y ? y : x; }, a, b, result,
+                       "batch maximum");
+            return;
+    }
+}
+
+void batch_elementwise(ElementwiseFunction fn, const BatchView& a, VectorBatch& result) {
+    switch (fn) {
+        case ElementwiseFunction::Abs:
+            run_unary([](double x) { return std::abs(x); }, a, result);
+            return;
+        case ElementwiseFunction::Sqrt:
+            run_unary([](double x) { return std::sqrt(x); }, a, result);
+            return;
+        case ElementwiseFunction::Exp:
+            run_unary([](double x) { return std::exp(x); }, a, result);
+            return;
+        case ElementwiseFunction::Log:
+            run_unary([](double x) { return std::log(x); }, a, result);
+            return;
+    }
+}
+
+void batch_fma(const BatchView& a, const BatchView& b, const BatchView& c, VectorBatch& result) {
+    run_ternary([](double x, double y, double z) { return std::fma(x, y, z); }, a, b, c, result,
+                "batch fma");
+}
+
+} // namespace vectors
@@ -0,0 +1,56 @@
+#ifndef ELEMENTWISE_H
+#define ELEMENTWISE_H
+
+#include "vector_batch.h"
+
+namespace vectors {
+
+// Binary element-wise operations
+enum class ElementwiseOp {
+    Add,
+    Subtract,
+    Multiply,
+    Divide,
+    Minimum,
+    Maximum
+};
+
+// Unary element-wise functions
+enum class ElementwiseFunction {
+    Abs,
+    Sqrt,
+    Exp,
+    Log
+};
+
+/**
+ * Batched element-wise math.
+ *
+ * Operands broadcast like 2D NumPy arrays. Each operand has either the
+ * result's row count or a single row, which is used for every row. It also
+ * has either the result's dimension or a single column, whose value is used
+ * across the row. A 1 x 1 operand is a scalar, and a 1 x D operand applies
+ * one value per dimension. `result` is reused when it already has the output
+ * shape and may be any input of that shape.
+ *
+ * Each broadcast pattern gets its own inner loop over contiguous elements,
+ * which the compiler vectorizes, and row blocks are spread over the thread
+ * pool. Division checks the whole divisor for zeros in one vectorized pass
+ * before anything is written, using the same epsilon as
+ * element_wise_divide, so the division loop itself has no branch. Sqrt and
+ * Log of negative values give NaN, as in <cmath>.
+ */
+void batch_elementwise(ElementwiseOp op, const BatchView& a, const BatchView& b,
+                       VectorBatch& result);
+void batch_elementwise(ElementwiseFunction fn, const BatchView& a, VectorBatch& result);
+// a * b + c with a single rounding (std::fma)
+void batch_fma(const BatchView& a, const BatchView& b, const BatchView& c, VectorBatch& result);
+
+// A scalar as a 1 x 1 operand; `value` must outlive the view
+inline BatchView scalar_operand(const double& value) {
+    return BatchView{&value, 1, 1, 1};
+}
+
+} // namespace vectors
+
+#endif // ELEMENTWISE_H
@@ -0,0 +1,112 @@
+#include "file_io.h"
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+namespace vectors {
+
+// MappedFile
+
+MappedFile::MappedFile(const std::string& path) : base_(nullptr), length_(0) {
+#ifdef _WIN32
+    file_handle_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_handle_ == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Cannot open file: " + path);
+    }
+    LARGE_INTEGER file_size;
+    GetFileSizeEx(file_handle_, &file_size);
+    length_ = static_cast<size_t>(file_size.QuadPart);
+    mapping_handle_ = length_ > 0
+        ? CreateFileMappingA(file_handle_, nullptr, PAGE_READONLY, 0, 0, nullptr)
+        : nullptr;
+    base_ = mapping_handle_ ? MapViewOfFile(mapping_handle_, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!base_) {
+        if (mapping_handle_) CloseHandle(mapping_handle_);
+        CloseHandle(file_handle_);
+        throw std::runtime_error("Cannot map file: " + path);
+    }
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open file: " + path);
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot map file: " + path);
+    }
+    length_ = static_cast<size_t>(st.st_size);
+    base_ = ::mmap(nullptr, length_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base_ == MAP_FAILED) {
+        base_ = nullptr;
+        throw std::runtime_error("Cannot map file: " + path);
+    }
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifdef _WIN32
+    UnmapViewOfFile(base_);
+    CloseHandle(mapping_handle_);
+    CloseHandle(file_handle_);
+#else
+    ::munmap(base_, length_);
+#endif
+}
+
+void MappedFile::advise(MapAccess access) const {
+#ifndef _WIN32
+    int advice = MADV_NORMAL;
+    switch (access) {
+        case MapAccess::Normal: advice = MADV_NORMAL; break;
+        case MapAccess::Sequential: advice = MADV_SEQUENTIAL; break;
+        case MapAccess::Random: advice = MADV_RANDOM; break;
+        case MapAccess::WillNeed: advice = MADV_WILLNEED; break;
+    }
+    ::madvise(base_, length_, advice);
+#else
+    (void)access;
+#endif
+}
+
+// stdio helpers
+
+FilePtr open_file(const std::string& path, const char* mode) {
+    return FilePtr(std::fopen(path.c_str(), mode), &std::fclose);
+}
+
+void seek_file(std::FILE* file, uint64_t offset) {
+#ifdef _WIN32
+    _fseeki64(file, static_cast<__int64>(offset), SEEK_SET);
+#else
+    fseeko(file, static_cast<off_t>(offset), SEEK_SET);
+#endif
+}
+
+uint64_t file_size(std::FILE* file) {
+#ifdef _WIN32
+    __int64 position = _ftelli64(file);
+    _fseeki64(file, 0, SEEK_END);
+    __int64 size = _ftelli64(file);
+    _fseeki64(file, position, SEEK_SET);
+#else
+    off_t position = ftello(file);
+    fseeko(file, 0, SEEK_END);
+    off_t size = ftello(file);
+    fseeko(file, position, SEEK_SET);
+#endif
+    return size < 0 ? 0 : static_cast<uint64_t>(size);
+}
+
+} // namespace vectors
@@ -0,0 +1,55 @@
+#ifndef FILE_IO_H
+#define FILE_IO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+namespace vectors {
+
+// Expected access pattern of a mapping, forwarded to the OS as a hint
+enum class MapAccess {
+    Normal,
+    Sequential,
+    Random,
+    WillNeed
+};
+
+/**
+ * MappedFile - Read-only memory mapping of a whole file
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const unsigned char* data() const { return static_cast<const unsigned char*>(base_); }
+    size_t size() const { return length_; }
+
+    // No-op where the platform has no equivalent of madvise
+    void advise(MapAccess access) const;
+
+private:
+    void* base_;
+    size_t length_;
+#ifdef _WIN32
+    void* file_handle_;
+    void* mapping_handle_;
+#endif
+};
+
+// stdio helpers with 64-bit offsets on every platform
+using FilePtr = std::unique_ptr<std::FILE, int (*)(std::FILE*)>;
+
+FilePtr open_file(const std::string& path, const char* mode);  // null on failure
+void seek_file(std::FILE* file, uint64_t offset);
+uint64_t file_size(std::FILE* file);
+
+} // namespace vectors
+
+#endif // FILE_IO_H
@@ -0,0 +1,254 @@
+#include "geometry.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace vectors {
+
+namespace {
+
+// Rows per task
+constexpr size_t kRowBlock = 4096;
+
+// 3D rows split into coordinate arrays per tile. Zero vectors inside a tile
+// are counted rather than thrown on, so the loops stay vectorizable
+constexpr size_t kTile = 64;
+
+constexpr double kEpsilon = std::numeric_limits<double>::epsilon();
+
+struct Tile {
+    double x[kTile];
+    double y[kTile];
+    double z[kTile];
+};
+
+void load_tile(const BatchView& v, size_t begin, size_t n, Tile& t) {
+    for (size_t i = 0; i < n; ++i) {
+        const double* p = v.row(begin + i);
+        t.x[i] = p[0];
+        t.y[i] = p[1];
+        t.z[i] = p[2];
+    }
+}
+
+void store_tile(const Tile& t, size_t n, double* out) {
+    for (size_t i = 0; i < n; ++i) {
+        out[3 * i] = t.x[i];
+        out[3 * i + 1] = t.y[i];
+        out[3 * i + 2] = t.z[i];
+    }
+}
+
+// Checks that `b` pairs with `a` and returns it as a view of a.count rows,
+// repeating a single row
+BatchView paired(const BatchView& a, const BatchView& b, const char* operation) {
+    if (a.dim != b.dim) {
+        throw std::runtime_error(
+            std::string("Dimension mismatch in ") + operation + ": " +
+            std::to_string(a.dim) + " vs " + std::to_string(b.dim)
+        );
+    }
+    if (b.count == 1) {
+        return BatchView{b.data, a.count, b.dim, 0};
+    }
+    if (a.count != b.count) {
+        throw std::runtime_error(
+            std::string("Batch size mismatch in ") + operation + ": " +
+            std::to_string(a.count) + " vs " + std::to_string(b.count)
+        );
+    }
+    return b;
+}
+
+// Runs body(begin, end) over row blocks, in parallel for large batches
+template <typename Body>
+void for_each_row_block(size_t count, size_t dim, const Body& body) {
+    size_t blocks = (count + kRowBlock - 1) / kRowBlock;
+    auto task = [&](size_t b) {
+        body(b * kRowBlock, std::min(count, (b + 1) * kRowBlock));
+    };
+    parallel_for(blocks, count * dim, task);
+}
+
+// Runs kernel(ta, tb, n, first_row) over the 3D tiles of rows [begin, end)
+template <typename Kernel>
+void for_each_tile(const BatchView& a, const BatchView& b, size_t begin, size_t end,
+                   const Kernel& kernel) {
+    Tile ta;
+    Tile tb;
+    for (size_t first = begin; first < end; first += kTile) {
+        size_t n = std::min(kTile, end - first);
+        load_tile(a, first, n, ta);
+        load_tile(b, first, n, tb);
+        kernel(ta, tb, n, first);
+    }
+}
+
+double row_dot(const double* a, const double* b, size_t dim) {
+    double sum = 0.0;
+    for (size_t i = 0; i < dim; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+// Rows are read before the matching output row is written, so every kernel
+// here can write over either input; reshaping builds the result aside
+template <typename Kernel>
+void into_result(const BatchView& a, size_t dim, VectorBatch& result, const Kernel& kernel) {
+    if (result.size() != a.count || result.dimensions() != dim) {
+        VectorBatch reshaped(a.count, dim);
+        kernel(reshaped);
+        result = std::move(reshaped);
+        return;
+    }
+    kernel(result);
+}
+
+} // namespace
+
+void batch_cross(const BatchView& a, const BatchView& b, VectorBatch& result) {
+    if (a.dim != 3 || b.dim != 3) {
+        throw std::runtime_error("Cross product only defined for 3D vectors");
+    }
+    const BatchView rhs = paired(a, b, "batch cross product");
+    into_result(a, 3, result, [&](VectorBatch& out) {
+        for_each_row_block(a.count, 3, [&](size_t begin, size_t end) {
+            for_each_tile(a, rhs, begin, end, [&](const Tile& u, const Tile& v, size_t n,
+                                                  size_t first) {
+                Tile o;
+                for (size_t i = 0; i < n; ++i) {
+                    o.x[i] = u.y[i] * v.z[i] - u.z[i] * v.y[i];
+                    o.y[i] = u.z[i] * v.x[i] - u.x[i] * v.z[i];
+                    o.z[i] = u.x[i] * v.y[i] - u.y[i] * v.x[i];
+                }
+                store_tile(o, n, out.row(first));
+            });
+        });
+    });
+}
+
+void batch_project(const BatchView& vectors, const BatchView& onto, VectorBatch& result) {
+    const BatchView axes = paired(vectors, onto, "batch projection");
+    const size_t dim = vectors.dim;
+    into_result(vectors, dim, result, [&](VectorBatch& out) {
+        for_each_row_block(vectors.count, dim, [&](size_t begin, size_t end) {
+            if (dim != 3) {
+                for (size_t r = begin; r < end; ++r) {
+                    const double* v = vectors.row(r);
+                    const double* k = axes.row(r);
+                    double length_sq = row_dot(k, k, dim);
+                    if (length_sq < kEpsilon) {
+                        throw std::runtime_error("Cannot project onto zero vector");
+                    }
+                    double scale = row_dot(v, k, dim) / length_sq;
+                    double* o = out.row(r);
+                    for (size_t i = 0; i < dim; ++i) {
+                        o[i] = k[i] * scale;
+                    }
+                }
+                return;
+            }
+            for_each_tile(vectors, axes, begin, end, [&](const Tile& u, const Tile& v, size_t n,
+                                                        size_t first) {
+                Tile o;
+                int64_t zeros = 0;
+                for (size_t i = 0; i < n; ++i) {
+                    double d = u.x[i] * v.x[i] + u.y[i] * v.y[i] + u.z[i] * v.z[i];
+                    double length_sq = v.x[i] * v.x[i] + v.y[i] * v.y[i] + v.z[i] * v.z[i];
+                    zeros += length_sq < kEpsilon;
+                    double scale = d / length_sq;
+                    o.x[i] = v.x[i] * scale;
+                    o.y[i] = v.y[i] * scale;
+                    o.z[i] = v.z[i] * scale;
+                }
+                if (zeros != 0) {
+                    throw std::runtime_error("Cannot project onto zero vector");
+                }
+                store_tile(o, n, out.row(first));
+            });
+        });
+    });
+}
+
+void batch_reflect(const BatchView& vectors, const BatchView& normals, VectorBatch& result) {
+    const BatchView mirror = paired(vectors, normals, "batch reflection");
+    const size_t dim = vectors.dim;
+    into_result(vectors, dim, result, [&](VectorBatch& out) {
+        for_each_row_block(vectors.count, dim, [&](size_t begin, size_t end) {
+            if (dim != 3) {
+                for (size_t r = begin; r < end; ++r) {
+                    const double* v = vectors.row(r);
+                    const double* k = mirror.row(r);
+                    double twice = 2.0 * row_dot(v, k, dim);
+                    double* o = out.row(r);
+                    for (size_t i = 0; i < dim; ++i) {
+                        o[i] = v[i] - k[i] * twice;
+                    }
+                }
+                return;
+            }
+            for_each_tile(vectors, mirror, begin, end, [&](const Tile& u, const Tile& v, size_t n,
+                                                          size_t first) {
+                Tile o;
+                for (size_t i = 0; i < n; ++i) {
+                    double twice = 2.0 * (u.x[i] * v.x[i] + u.y[i] * v.y[i] + u.z[i] * v.z[i]);
+                    o.x[i] = u.x[i] - v.x[i] * twice;
+                    o.y[i] = u.y[i] - v.y[i] * twice;
+                    o.z[i] = u.z[i] - v.z[i] * twice;
+                }
+                store_tile(o, n, out.row(first));
+            });
+        });
+    });
+}
+
+void batch_angle_between(const BatchView& a, const BatchView& b, double* result) {
+    const BatchView rhs = paired(a, b, "batch angle calculation");
+    const size_t dim = a.dim;
+    for_each_row_block(a.count, dim, [&](size_t begin, size_t end) {
+        if (dim != 3) {
+            for (size_t r = begin; r < end; ++r) {
+                const double* u = a.row(r);
+                const double* v = rhs.row(r);
+                double mag_u = std::sqrt(row_dot(u, u, dim));
+                double mag_v = std::sqrt(row_dot(v, v, dim));
+                if (mag_u < kEpsilon || mag_v < kEpsilon) {
+                    throw std::runtime_error("Cannot calculate angle with zero vector");
+                }
+                double c = row_dot(u, v, dim) / (mag_u * mag_v);
+                result[r] = std::acos(std::max(-1.0, std::min(1.0, c)));
+            }
+            return;
+        }
+        for_each_tile(a, rhs, begin, end, [&](const Tile& u, const Tile& v, size_t n,
+                                              size_t first) {
+            // Products first, in a loop free of library calls; square roots
+            // and acos run in a second pass
+            double* out = result + first;
+            double lengths_sq[kTile];
+            int64_t zeros = 0;
+            for (size_t i = 0; i < n; ++i) {
+                double uu = u.x[i] * u.x[i] + u.y[i] * u.y[i] + u.z[i] * u.z[i];
+                double vv = v.x[i] * v.x[i] + v.y[i] * v.y[i] + v.z[i] * v.z[i];
+                zeros += (uu < kEpsilon * kEpsilon) | (vv < kEpsilon * kEpsilon);
+                lengths_sq[i] = uu * vv;
+                out[i] = u.x[i] * v.x[i] + u.y[i] * v.y[i] + u.z[i] * v.z[i];
+            }
+            if (zeros != 0) {
+                throw std::runtime_error("Cannot calculate angle with zero vector");
+            }
+            for (size_t i = 0; i < n; ++i) {
+                double c = out[i] / std::sqrt(lengths_sq[i]);
+                out[i] = std::acos(std::max(-1.0, std::min(1.0, c)));
+            }
+        });
+    });
+}
+
+} // namespace vectors
@@ -0,0 +1,29 @@
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+#include "vector_batch.h"
+
+namespace vectors {
+
+/**
+ * Batched versions of VectorND::cross, projection, reflection and
+ * angle_between.
+ *
+ * Row i of the result combines row i of `a` with row i of `b`; a `b` with a
+ * single row is applied to every row of `a`. Results follow the VectorND
+ * methods, including their errors for zero vectors. `result` is reused when
+ * it already has the output shape and may be either input.
+ *
+ * 3D rows are processed in tiles that are split into x, y and z arrays
+ * first, so each operation runs as plain loops over many vectors at once
+ * that the compiler vectorizes. Projection, reflection and angles also
+ * accept other dimensions through a row-by-row path.
+ */
+void batch_cross(const BatchView& a, const BatchView& b, VectorBatch& result);
+void batch_project(const BatchView& vectors, const BatchView& onto, VectorBatch& result);
+void batch_reflect(const BatchView& vectors, const BatchView& normals, VectorBatch& result);
+void batch_angle_between(const BatchView& a, const BatchView& b, double* result);
+
+} // namespace vectors
+
+#endif // GEOMETRY_H
@@ -0,0 +1,355 @@
+#include "loaders.h"
+#include "file_io.h"
+#include "parallel.h"
+#include "vector_store.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+namespace vectors {
+
+namespace {
+
+// Bytes per read chunk and rows per conversion task
+constexpr size_t kReadChunkBytes = size_t(1) << 22;
+constexpr size_t kRowBlock = 1024;
+
+// Where the records of a file are and what each one looks like
+struct RecordLayout {
+    const char* format;      // for error messages, e.g. ".fvecs"
+    uint64_t data_offset;    // byte offset of the first record
+    size_t record_bytes;     // bytes per vector, including any prefix
+    size_t prefix_bytes;     // int32 dimension prefix of the vecs formats
+    size_t total;            // vectors in the file
+    size_t dim;
+};
+
+// Converts `rows` consecutive records into float64 rows at `out`; `first` is
+// the index of the first record in the file, for error messages
+using ConvertFn = void (*)(const unsigned char* src, size_t first, size_t rows,
+                           const RecordLayout& layout, double* out);
+
+template <typename T>
+T load_scalar(const unsigned char* p) {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+template <typename T>
+void convert_rows(const unsigned char* src, size_t first, size_t rows,
+                  const RecordLayout& layout, double* out) {
+    for (size_t r = 0; r < rows; ++r) {
+        const unsigned char* record = src + r * layout.record_bytes;
+        if (layout.prefix_bytes > 0) {
+            int32_t dim = load_scalar<int32_t>(record);
+            if (dim < 0 || static_cast<size_t>(dim) != layout.dim) {
+                throw std::runtime_error(
+                    std::string("Inconsistent dimensions in ") + layout.format +
+                    " file at vector " + std::to_string(first + r) + ": " +
+                    std::to_string(layout.dim) + " vs " + std::to_string(dim)
+                );
+            }
+        }
+        const unsigned char* values = record + layout.prefix_bytes;
+        double* row = out + r * layout.dim;
+        for (size_t i = 0; i < layout.dim; ++i) {
+            row[i] = static_cast<double>(load_scalar<T>(values + i * sizeof(T)));
+        }
+    }
+}
+
+// Converts a run of records in row blocks, in parallel for large runs
+void convert_records(ConvertFn convert, const unsigned char* src, size_t first, size_t rows,
+                     const RecordLayout& layout, double* out) {
+    size_t blocks = (rows + kRowBlock - 1) / kRowBlock;
+    auto task = [&](size_t b) {
+        size_t begin = b * kRowBlock;
+        size_t end = std::min(rows, begin + kRowBlock);
+        convert(src + begin * layout.record_bytes, first + begin, end - begin, layout,
+                out + begin * layout.dim);
+    };
+    parallel_for(blocks, rows * layout.dim, task);
+}
+
+VectorBatch read_records(const std::string& path, const RecordLayout& layout,
+                         const LoadOptions& options, ConvertFn convert) {
+    size_t first = std::min(options.start, layout.total);
+    size_t rows = std::min(options.count, layout.total - first);
+    VectorBatch batch(rows, layout.dim);
+    if (rows == 0 || layout.record_bytes == 0) {
+        return batch;
+    }
+    uint64_t offset = layout.data_offset + uint64_t(first) * layout.record_bytes;
+
+    if (options.use_mmap) {
+        MappedFile file(path);
+        file.advise(MapAccess::Sequential);
+        convert_records(convert, file.data() + offset, first, rows, layout, batch.data());
+        return batch;
+    }
+
+    FilePtr file = open_file(path, "rb");
+    if (!file) {
+        throw std::runtime_error("Cannot open file: " + path);
+    }
+    seek_file(file.get(), offset);
+
+    // Double buffering: the next chunk is read while the current one converts
+    size_t chunk_rows = std::max<size_t>(1, kReadChunkBytes / layout.record_bytes);
+    std::vector<unsigned char> current(chunk_rows * layout.record_bytes);
+    std::vector<unsigned char> next(current.size());
+    auto read_chunk = [&](std::vector<unsigned char>& buffer, size_t n) {
+        if (std::fread(buffer.data(), layout.record_bytes, n, file.get()) != n) {
+            throw std::runtime_error(std::string("Truncated ") + layout.format + " file: " + path);
+        }
+    };
+
+    size_t done = 0;
+    size_t n = std::min(chunk_rows, rows);
+    read_chunk(current, n);
+    while (done < rows) {
+        size_t next_n = std::min(chunk_rows, rows - done - n);
+        std::future<void> pending;
+        if (next_n > 0) {
+            pending = std::async(std::launch::async, [&, next_n] { read_chunk(next, next_n); });
+        }
+        try {
+            convert_records(convert, current.data(), first + done, n, layout, batch.row(done));
+        } catch (...) {
+            if (pending.valid()) pending.wait();
+            throw;
+        }
+        if (pending.valid()) pending.get();
+        done += n;
+        n = next_n;
+        std::swap(current, next);
+    }
+    return batch;
+}
+
+// Layout of a .fvecs/.ivecs/.bvecs file with `value_bytes` per component
+RecordLayout vecs_layout(const std::string& path, const char* format, size_t value_bytes) {
+    FilePtr file = open_file(path, "rb");
+    if (!file) {
+        throw std::runtime_error("Cannot open file: " + path);
+    }
+    RecordLayout layout{format, 0, 0, sizeof(int32_t), 0, 0};
+    uint64_t size = file_size(file.get());
+    if (size == 0) {
+        return layout;
+    }
+    unsigned char prefix[sizeof(int32_t)];
+    if (std::fread(prefix, sizeof(prefix), 1, file.get()) != 1) {
+        throw std::runtime_error(std::string("Truncated ") + format + " file: " + path);
+    }
+    int32_t dim = load_scalar<int32_t>(prefix);
+    if (dim <= 0) {
+        throw std::runtime_error(std::string("Invalid dimension in ") + format + " file: " + path);
+    }
+    layout.dim = static_cast<size_t>(dim);
+    layout.record_bytes = sizeof(int32_t) + layout.dim * value_bytes;
+    if (size % layout.record_bytes != 0) {
+        throw std::runtime_error(std::string("Truncated ") + format + " file: " + path);
+    }
+    layout.total = static_cast<size_t>(size / layout.record_bytes);
+    return layout;
+}
+
+// .npy header fields needed to read the data
+struct NpyHeader {
+    char kind;          // 'f', 'i', 'u' or 'b'
+    size_t item_size;
+    bool fortran_order;
+    std::vector<size_t> shape;
+    uint64_t data_offset;
+};
+
+// Value of `key` in the header dict, positioned just after the colon
+size_t npy_find_value(const std::string& dict, const char* key, const std::string& path) {
+    size_t pos = dict.find(std::string("'") + key + "'");
+    if (pos == std::string::npos) {
+        throw std::runtime_error("Corrupt .npy header in " + path);
+    }
+    pos = dict.find(':', pos);
+    if (pos == std::string::npos) {
+        throw std::runtime_error("Corrupt .npy header in " + path);
+    }
+    pos = dict.find_first_not_of(' ', pos + 1);
+    if (pos == std::string::npos) {
+        throw std::runtime_error("Corrupt .npy header in " + path);
+    }
+    return pos;
+}
+
+NpyHeader read_npy_header(std::FILE* file, const std::string& path) {
+    unsigned char preamble[12];
+    if (std::fread(preamble, 1, 10, file) != 10 ||
+        std::memcmp(preamble, "\x93NUMPY", 6) != 0) {
+        throw std::runtime_error("Not a .npy file: " + path);
+    }
+    size_t header_len = 0;
+    uint64_t data_offset = 0;
+    if (preamble[6] == 1) {
+        header_len = preamble[8] | (size_t(preamble[9]) << 8);
+        data_offset = 10 + header_len;
+    } else if (preamble[6] == 2 || preamble[6] == 3) {
+        if (std::fread(preamble + 10, 1, 2, file) != 2) {
+            throw std::runtime_error("Truncated .npy header in " + path);
+        }
+        header_len = load_scalar<uint32_t>(preamble + 8);
+        data_offset = 12 + header_len;
+    } else {
+        throw std::runtime_error("Unsupported .npy format version in " + path);
+    }
+
+    std::string dict(header_len, '\0');
+    if (std::fread(&dict[0], 1, header_len, file) != header_len) {
+        throw std::runtime_error("Truncated .npy header in " + path);
+    }
+
+    NpyHeader header;
+    header.data_offset = data_offset;
+
+    size_t pos = npy_find_value(dict, "descr", path);
+    char quote = dict[pos];
+    size_t end = dict.find(quote, pos + 1);
+    if ((quote != '\'' && quote != '"') || end == std::string::npos || end - pos < 4) {
+        throw std::runtime_error("Unsupported .npy dtype in " + path);
+    }
+    std::string descr = dict.substr(pos + 1, end - pos - 1);
+    char order = descr[0];
+    header.kind = descr[1];
+    header.item_size = static_cast<size_t>(std::atoi(descr.c_str() + 2));
+    if (order == '>' && header.item_size > 1) {
+        throw std::runtime_error("Big-endian .npy files are not supported: " + path);
+    }
+
+    pos = npy_find_value(dict, "fortran_order", path);
+    header.fortran_order = dict.compare(pos, 4, "True") == 0;
+
+    pos = npy_find_value(dict, "shape", path);
+    end = dict.find(')', pos);
+    if (dict[pos] != '(' || end == std::string::npos) {
+        throw std::runtime_error("Corrupt .npy header in " + path);
+    }
+    for (size_t i = pos + 1; i < end; ++i) {
+        if (std::isdigit(static_cast<unsigned char>(dict[i]))) {
+            size_t digits = dict.find_first_not_of("0123456789", i);
+            header.shape.push_back(static_cast<size_t>(std::stoull(dict.substr(i, digits - i))));
+            i = digits;
+        }
+    }
+    return header;
+}
+
+ConvertFn npy_converter(const NpyHeader& header, const std::string& path) {
+    switch (header.kind) {
+        case 'f':
+            if (header.item_size == 4) return &convert_rows<float>;
+            if (header.item_size == 8) return &convert_rows<double>;
+            break;
+        case 'i':
+            if (header.item_size == 1) return &convert_rows<int8_t>;
+            if (header.item_size == 2) return &convert_rows<int16_t>;
+            if (header.item_size == 4) return &convert_rows<int32_t>;
+            if (header.item_size == 8) return &convert_rows<int64_t>;
+            break;
+        case 'u':
+        case 'b':
+            if (header.item_size == 1) return &convert_rows<uint8_t>;
+            if (header.item_size == 2) return &convert_rows<uint16_t>;
+            if (header.item_size == 4) return &convert_rows<uint32_t>;
+            if (header.item_size == 8) return &convert_rows<uint64_t>;
+            break;
+    }
+    throw std::runtime_error("Unsupported .npy dtype in " + path);
+}
+
+std::string lower_extension(const std::string& path) {
+    size_t dot = path.find_last_of('.');
+    size_t slash = path.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return "";
+    }
+    std::string ext = path.substr(dot);
+    std::transform(ext.begin(), ext.end(), ext.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return ext;
+}
+
+} // namespace
+
+VectorBatch load_fvecs(const std::string& path, const LoadOptions& options) {
+    return read_records(path, vecs_layout(path, ".fvecs", sizeof(float)), options,
+                        &convert_rows<float>);
+}
+
+VectorBatch load_ivecs(const std::string& path, const LoadOptions& options) {
+    return read_records(path, vecs_layout(path, ".ivecs", sizeof(int32_t)), options,
+                        &convert_rows<int32_t>);
+}
+
+VectorBatch load_bvecs(const std::string& path, const LoadOptions& options) {
+    return read_records(path, vecs_layout(path, ".bvecs", sizeof(uint8_t)), options,
+                        &convert_rows<uint8_t>);
+}
+
+VectorBatch load_npy(const std::string& path, const LoadOptions& options) {
+    FilePtr file = open_file(path, "rb");
+    if (!file) {
+        throw std::runtime_error("Cannot open file: " + path);
+    }
+    NpyHeader header = read_npy_header(file.get(), path);
+    ConvertFn convert = npy_converter(header, path);
+
+    RecordLayout layout{".npy", header.data_offset, 0, 0, 0, 0};
+    if (header.shape.size() == 1) {
+        // A single vector, as numpy.atleast_2d would see it
+        layout.total = 1;
+        layout.dim = header.shape[0];
+    } else if (header.shape.size() == 2) {
+        layout.total = header.shape[0];
+        layout.dim = header.shape[1];
+    } else {
+        throw std::runtime_error("Expected a 1D or 2D array in " + path);
+    }
+    if (header.fortran_order && header.shape.size() == 2 && layout.total > 1 && layout.dim > 1) {
+        throw std::runtime_error("Fortran-ordered .npy files are not supported: " + path);
+    }
+    // The shape comes from the file, so the sizes are checked by dividing
+    if (layout.dim > SIZE_MAX / header.item_size) {
+        throw std::runtime_error("Corrupt .npy header in " + path);
+    }
+    layout.record_bytes = layout.dim * header.item_size;
+    const uint64_t size = file_size(file.get());
+    if (header.data_offset > size ||
+        (layout.record_bytes != 0 &&
+         layout.total > (size - header.data_offset) / layout.record_bytes)) {
+        throw std::runtime_error("Truncated .npy file: " + path);
+    }
+    file.reset();
+    return read_records(path, layout, options, convert);
+}
+
+VectorBatch load_vectors(const std::string& path, const LoadOptions& options) {
+    std::string ext = lower_extension(path);
+    if (ext == ".fvecs") return load_fvecs(path, options);
+    if (ext == ".ivecs") return load_ivecs(path, options);
+    if (ext == ".bvecs") return load_bvecs(path, options);
+    if (ext == ".npy") return load_npy(path, options);
+    if (ext == ".vec") {
+        MappedVectorBatch mapped(path);
+        size_t first = std::min(options.start, mapped.size());
+        size_t rows = std::min(options.count, mapped.size() - first);
+        return VectorBatch(BatchView{mapped.row(first), rows, mapped.dimensions(), mapped.dimensions()});
+    }
+    throw std::runtime_error("Unknown vector file extension: " + path);
+}
+
+} // namespace vectors
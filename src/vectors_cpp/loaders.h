@@ -0,0 +1,38 @@
+#ifndef LOADERS_H
+#define LOADERS_H
+
+#include "vector_batch.h"
+#include <limits>
+#include <string>
+
+namespace vectors {
+
+/**
+ * Native readers for common vector dataset formats
+ *
+ *   .fvecs / .ivecs / .bvecs  per vector: int32 dimension, then that many
+ *                             float32 / int32 / uint8 values (little-endian)
+ *   .npy                      NumPy array format 1.0-3.0, 1D or 2D, C order,
+ *                             little-endian integer or floating-point dtype
+ *
+ * Every reader converts straight into a contiguous float64 VectorBatch. Files
+ * are read in chunks, the next chunk being read while the current one is
+ * converted on the worker threads, or mapped into memory when use_mmap is set.
+ */
+struct LoadOptions {
+    size_t start = 0;                                  // first vector to load
+    size_t count = std::numeric_limits<size_t>::max(); // at most this many vectors
+    bool use_mmap = false;
+};
+
+VectorBatch load_fvecs(const std::string& path, const LoadOptions& options = LoadOptions());
+VectorBatch load_ivecs(const std::string& path, const LoadOptions& options = LoadOptions());
+VectorBatch load_bvecs(const std::string& path, const LoadOptions& options = LoadOptions());
+VectorBatch load_npy(const std::string& path, const LoadOptions& options = LoadOptions());
+
+// Picks the reader from the file extension (.fvecs, .ivecs, .bvecs, .npy, .vec)
+VectorBatch load_vectors(const std::string& path, const LoadOptions& options = LoadOptions());
+
+} // namespace vectors
+
+#endif // LOADERS_H
@@ -0,0 +1,395 @@
+#include "lsh_index.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+namespace vectors {
+
+namespace {
+
+// Rows per task
+constexpr size_t kRowBlock = 4096;
+
+// Bits in one signature word
+constexpr size_t kWordBits = 64;
+
+// Euclidean hash values are clamped to this range before hashing
+constexpr double kMaxCell = 4611686018427387904.0;  // 2^62
+
+// Runs body(begin, end) over row blocks, in parallel for large batches
+template <typename Body>
+void for_each_row_block(size_t count, size_t dim, const Body& body) {
+    size_t blocks = (count + kRowBlock - 1) / kRowBlock;
+    auto task = [&](size_t b) {
+        body(b * kRowBlock, std::min(count, (b + 1) * kRowBlock));
+    };
+    parallel_for(blocks, count * dim, task);
+}
+
+// splitmix64 finalizer
+uint64_t mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+size_t popcount(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<size_t>(__builtin_popcountll(x));
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    return static_cast<size_t>((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+size_t hamming(const uint64_t* a, const uint64_t* b, size_t words) {
+    size_t distance = 0;
+    for (size_t w = 0; w < words; ++w) {
+        distance += popcount(a[w] ^ b[w]);
+    }
+    return distance;
+}
+
+double distance_squared(const double* a, const double* b, size_t dim) {
+    double sum = 0.0;
+    for (size_t i = 0; i < dim; ++i) {
+        double d = a[i] - b[i];
+        sum += d * d;
+    }
+    return sum;
+}
+
+void check_nonzero(double norm) {
+    if (norm < std::numeric_limits<double>::epsilon()) {
+        throw std::runtime_error("Cannot calculate cosine similarity with zero vector");
+    }
+}
+
+bool closer(const Neighbor& a, const Neighbor& b) {
+    return a.distance < b.distance || (a.distance == b.distance && a.index < b.index);
+}
+
+} // namespace
+
+LshIndex::LshIndex(size_t dimensions, LshMetric metric, size_t tables, size_t hashes,
+                   double bucket_width, uint64_t seed)
+    : dim_(dimensions),
+      metric_(metric),
+      tables_(tables),
+      hashes_(hashes),
+      bucket_width_(bucket_width),
+      words_(0),
+      rows_(dimensions),
+      buckets_(tables) {
+    if (tables == 0 || hashes == 0) {
+        throw std::runtime_error("LSH index needs at least one table and one hash");
+    }
+    if (metric == LshMetric::Cosine && hashes > kWordBits) {
+        throw std::runtime_error("Cosine LSH tables take at most 64 hashes");
+    }
+    if (metric == LshMetric::Euclidean && !(bucket_width > 0.0 && std::isfinite(bucket_width))) {
+        throw std::runtime_error("Bucket width must be positive");
+    }
+
+    const size_t projections = tables * hashes;
+    std::mt19937_64 rng(seed);
+    std::normal_distribution<double> gaussian;
+    const double scale = metric == LshMetric::Euclidean ? 1.0 / bucket_width : 1.0;
+    planes_.resize(dimensions * projections);
+    for (double& a : planes_) {
+        a = gaussian(rng) * scale;
+    }
+    offsets_.assign(projections, 0.0);
+    if (metric == LshMetric::Cosine) {
+        words_ = (projections + kWordBits - 1) / kWordBits;
+    } else {
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        for (double& b : offsets_) {
+            b = uniform(rng);
+        }
+    }
+}
+
+void LshIndex::check_dimensions(size_t dimensions, const char* operation) const {
+    if (dimensions != dim_) {
+        throw std::runtime_error(
+            std::string("Dimension mismatch in ") + operation + ": " +
+            std::to_string(dim_) + " vs " + std::to_string(dimensions)
+        );
+    }
+}
+
+size_t LshIndex::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return rows_.size();
+}
+
+LshIndex::Hashed LshIndex::scratch() const {
+    return Hashed{std::vector<double>(tables_ * hashes_), std::vector<uint64_t>(tables_),
+                  std::vector<uint64_t>(words_)};
+}
+
+void LshIndex::hash(const double* v, Hashed& out) const {
+    // Accumulating one input component at a time into all projections keeps
+    // the inner loop free of reductions, so it vectorizes
+    const size_t projections = tables_ * hashes_;
+    double* p = out.projections.data();
+    std::copy(offsets_.begin(), offsets_.end(), p);
+    for (size_t d = 0; d < dim_; ++d) {
+        const double x = v[d];
+        const double* plane = planes_.data() + d * projections;
+        for (size_t j = 0; j < projections; ++j) {
+            p[j] += x * plane[j];
+        }
+    }
+
+    if (metric_ == LshMetric::Cosine) {
+        std::fill(out.signature.begin(), out.signature.end(), 0);
+        for (size_t j = 0; j < projections; ++j) {
+            out.signature[j / kWordBits] |= uint64_t(p[j] > 0.0) << (j % kWordBits);
+        }
+        for (size_t t = 0; t < tables_; ++t) {
+            uint64_t key = 0;
+            for (size_t j = 0; j < hashes_; ++j) {
+                key |= uint64_t(p[t * hashes_ + j] > 0.0) << j;
+            }
+            out.keys[t] = key;
+        }
+        return;
+    }
+
+    for (size_t t = 0; t < tables_; ++t) {
+        uint64_t key = hashes_;
+        for (size_t j = 0; j < hashes_; ++j) {
+            double cell = std::max(-kMaxCell, std::min(kMaxCell, std::floor(p[t * hashes_ + j])));
+            key = mix(key ^ static_cast<uint64_t>(static_cast<int64_t>(cell)));
+        }
+        out.keys[t] = key;
+    }
+}
+
+size_t LshIndex::insert(const VectorND& v) {
+    check_dimensions(v.size(), "LSH insert");
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    return insert_rows(BatchView{v.data().data(), 1, dim_, dim_});
+}
+
+size_t LshIndex::insert_batch(const BatchView& rows) {
+    check_dimensions(rows.dim, "LSH insert");
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    return insert_rows(rows);
+}
+
+size_t LshIndex::insert_rows(const BatchView& rows) {
+    // Rows viewing the stored vectors would move when the storage grows
+    std::less<const double*> before;
+    if (rows.count > 0 && !before(rows.data, rows_.data()) &&
+        before(rows.data, rows_.data() + rows_.size() * dim_)) {
+        VectorBatch copy(rows);
+        return insert_rows(copy.view());
+    }
+
+    const size_t count = rows.count;
+    const size_t first = rows_.size();
+    const bool cosine = metric_ == LshMetric::Cosine;
+    std::vector<uint64_t> keys(count * tables_);
+    std::vector<uint64_t> signatures(count * words_);
+    std::vector<double> norms(cosine ? count : 0);
+    const ReductionMode mode = get_reduction_mode();
+    for_each_row_block(count, dim_ * tables_ * hashes_, [&](size_t begin, size_t end) {
+        Hashed hashed = scratch();
+        for (size_t r = begin; r < end; ++r) {
+            hash(rows.row(r), hashed);
+            std::copy(hashed.keys.begin(), hashed.keys.end(), keys.begin() + r * tables_);
+            std::copy(hashed.signature.begin(), hashed.signature.end(),
+                      signatures.begin() + r * words_);
+            if (cosine) {
+                norms[r] = std::sqrt(reduce_sum_squares(rows.row(r), dim_, mode));
+            }
+        }
+    });
+    for (double norm : norms) {
+        check_nonzero(norm);
+    }
+
+    rows_.resize(first + count);
+    for (size_t r = 0; r < count; ++r) {
+        std::copy(rows.row(r), rows.row(r) + dim_, rows_.row(first + r));
+    }
+    norms_.insert(norms_.end(), norms.begin(), norms.end());
+    signatures_.insert(signatures_.end(), signatures.begin(), signatures.end());
+
+    // Tables are independent, so each one is filled by its own task
+    parallel_for(tables_, count * tables_, [&](size_t t) {
+        auto& buckets = buckets_[t];
+        for (size_t r = 0; r < count; ++r) {
+            buckets[keys[r * tables_ + t]].push_back(first + r);
+        }
+    });
+    return first;
+}
+
+std::vector<size_t> LshIndex::candidates(const VectorND& query) const {
+    check_dimensions(query.size(), "LSH query");
+    Hashed hashed = scratch();
+    hash(query.data().data(), hashed);
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::vector<size_t> found;
+    for (size_t t = 0; t < tables_; ++t) {
+        auto it = buckets_[t].find(hashed.keys[t]);
+        if (it != buckets_[t].end()) {
+            found.insert(found.end(), it->second.begin(), it->second.end());
+        }
+    }
+    std::sort(found.begin(), found.end());
+    found.erase(std::unique(found.begin(), found.end()), found.end());
+    return found;
+}
+
+std::vector<Neighbor> LshIndex::search(const double* query, size_t k, size_t max_candidates,
+                                       Hashed& hashed) const {
+    const bool cosine = metric_ == LshMetric::Cosine;
+    const ReductionMode mode = get_reduction_mode();
+    double query_norm = 0.0;
+    if (cosine) {
+        query_norm = std::sqrt(reduce_sum_squares(query, dim_, mode));
+        check_nonzero(query_norm);
+    }
+    hash(query, hashed);
+
+    // Candidates ranked by the tables they miss the query in; ids in more
+    // buckets appear more often
+    std::vector<size_t> found;
+    for (size_t t = 0; t < tables_; ++t) {
+        auto it = buckets_[t].find(hashed.keys[t]);
+        if (it != buckets_[t].end()) {
+            found.insert(found.end(), it->second.begin(), it->second.end());
+        }
+    }
+    std::sort(found.begin(), found.end());
+    struct Candidate {
+        size_t id;
+        size_t rank;
+    };
+    std::vector<Candidate> candidates;
+    for (size_t i = 0; i < found.size();) {
+        size_t j = i + 1;
+        while (j < found.size() && found[j] == found[i]) {
+            ++j;
+        }
+        candidates.push_back(Candidate{found[i], tables_ - (j - i)});
+        i = j;
+    }
+
+    if (max_candidates > 0 && candidates.size() > max_candidates) {
+        if (cosine) {
+            for (Candidate& c : candidates) {
+                c.rank = hamming(hashed.signature.data(), signature(c.id), words_);
+            }
+        }
+        auto better = [](const Candidate& a, const Candidate& b) {
+            return a.rank < b.rank || (a.rank == b.rank && a.id < b.id);
+        };
+        std::nth_element(candidates.begin(), candidates.begin() + max_candidates,
+                         candidates.end(), better);
+        candidates.resize(max_candidates);
+    }
+
+    std::vector<Neighbor> result;
+    result.reserve(candidates.size());
+    for (const Candidate& c : candidates) {
+        const double* row = rows_.row(c.id);
+        double distance = cosine
+            ? 1.0 - reduce_dot(row, query, dim_, mode) / (norms_[c.id] * query_norm)
+            : std::sqrt(distance_squared(row, query, dim_));
+        result.push_back(Neighbor{c.id, distance});
+    }
+    k = std::min(k, result.size());
+    std::partial_sort(result.begin(), result.begin() + k, result.end(), closer);
+    result.resize(k);
+    return result;
+}
+
+std::vector<Neighbor> LshIndex::query(const VectorND& query, size_t k,
+                                      size_t max_candidates) const {
+    check_dimensions(query.size(), "LSH query");
+    Hashed hashed = scratch();
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return search(query.data().data(), k, max_candidates, hashed);
+}
+
+void LshIndex::query_batch(const BatchView& queries, size_t k, size_t max_candidates,
+                           int64_t* indices, double* distances) const {
+    check_dimensions(queries.dim, "LSH query");
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    const size_t work = queries.count * dim_ * tables_ * hashes_;
+    parallel_for(queries.count, work, [&](size_t i) {
+        Hashed hashed = scratch();
+        std::vector<Neighbor> found = search(queries.row(i), k, max_candidates, hashed);
+        for (size_t j = 0; j < k; ++j) {
+            bool hit = j < found.size();
+            indices[i * k + j] = hit ? static_cast<int64_t>(found[j].index) : -1;
+            distances[i * k + j] = hit ? found[j].distance
+                                       : std::numeric_limits<double>::quiet_NaN();
+        }
+    });
+}
+
+std::vector<uint64_t> LshIndex::signature_of(const VectorND& v) const {
+    check_dimensions(v.size(), "LSH signature");
+    if (metric_ != LshMetric::Cosine) {
+        throw std::runtime_error("Only cosine LSH indexes have signatures");
+    }
+    Hashed hashed = scratch();
+    hash(v.data().data(), hashed);
+    return hashed.signature;
+}
+
+std::vector<uint32_t> LshIndex::hamming_distances(const VectorND& query) const {
+    const std::vector<uint64_t> probe = signature_of(query);
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::vector<uint32_t> result(rows_.size());
+    for_each_row_block(result.size(), words_, [&](size_t begin, size_t end) {
+        for (size_t id = begin; id < end; ++id) {
+            result[id] = static_cast<uint32_t>(hamming(probe.data(), signature(id), words_));
+        }
+    });
+    return result;
+}
+
+VectorBatch LshIndex::to_batch() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return VectorBatch(rows_.view());
+}
+
+void LshIndex::reserve(size_t count) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    rows_.reserve(count);
+    if (metric_ == LshMetric::Cosine) {
+        norms_.reserve(count);
+        signatures_.reserve(count * words_);
+    }
+}
+
+void LshIndex::clear() {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    rows_.clear();
+    norms_.clear();
+    signatures_.clear();
+    for (auto& buckets : buckets_) {
+        buckets.clear();
+    }
+}
+
+} // namespace vectors
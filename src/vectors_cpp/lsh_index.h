@@ -0,0 +1,126 @@
+#ifndef LSH_INDEX_H
+#define LSH_INDEX_H
+
+#include "vector_batch.h"
+#include <cstdint>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace vectors {
+
+// Similarity an LshIndex approximates
+enum class LshMetric {
+    Cosine,     // random hyperplane signatures
+    Euclidean   // p-stable (Gaussian) projections
+};
+
+/**
+ * LshIndex - Locality-sensitive hashing index for approximate neighbors
+ *
+ * Every table hashes a vector with `hashes` random projections. For Cosine
+ * each projection contributes the sign of a dot product with a Gaussian
+ * hyperplane, so vectors at angle theta agree on a bit with probability
+ * 1 - theta / pi. For Euclidean each contributes floor((a . x + b) / w) for
+ * Gaussian a and b uniform in [0, w), so close points tend to share the
+ * integer. A table's bucket is the combination of its hashes; vectors sharing
+ * a bucket with the query in any table are the candidates, which are then
+ * ranked by their exact distance. More hashes per table make buckets smaller
+ * and more precise; more tables find more true neighbors.
+ *
+ * Cosine signatures of all tables are kept bit-packed per vector, so the
+ * Hamming distance between two of them, one popcount per 64 bits, estimates
+ * the angle as pi * hamming / (tables * hashes).
+ *
+ * Vectors are copied into the index and get ids in insertion order. Batch
+ * inserts hash rows in parallel and then fill each table in its own task;
+ * batch queries run one query per task. An index may be shared between
+ * threads: queries hold a shared lock and inserts an exclusive one.
+ */
+class LshIndex {
+public:
+    // Cosine allows at most 64 hashes per table. `bucket_width` is the w of
+    // the Euclidean hashes, in the units of the vectors.
+    LshIndex(size_t dimensions, LshMetric metric, size_t tables = 8, size_t hashes = 16,
+             double bucket_width = 4.0, uint64_t seed = 0);
+
+    size_t size() const;
+    size_t dimensions() const { return dim_; }
+    LshMetric metric() const { return metric_; }
+    size_t tables() const { return tables_; }
+    size_t hashes() const { return hashes_; }
+    double bucket_width() const { return bucket_width_; }
+
+    // Stored vectors, indexed by id. The view and signature() pointers move
+    // when vectors are inserted; use to_batch() while other threads insert.
+    BatchView view() const { return rows_.view(); }
+    VectorBatch to_batch() const;
+
+    // Adds the vectors with the next ids and returns the first of them.
+    // Cosine rejects zero vectors, leaving the index unchanged.
+    size_t insert(const VectorND& v);
+    size_t insert_batch(const BatchView& rows);
+
+    // Ids sharing a bucket with `query` in at least one table, ascending
+    std::vector<size_t> candidates(const VectorND& query) const;
+
+    // Up to k candidates closest to `query`, closest first (ties by id).
+    // Distances are Euclidean, or 1 - cosine similarity. A nonzero
+    // `max_candidates` scores only that many candidates exactly: those with
+    // the nearest signatures for Cosine, those sharing a bucket in the most
+    // tables for Euclidean.
+    std::vector<Neighbor> query(const VectorND& query, size_t k,
+                                size_t max_candidates = 0) const;
+    // Results of query i in indices and distances [i * k, (i + 1) * k),
+    // padded with -1 and NaN when fewer than k candidates are found
+    void query_batch(const BatchView& queries, size_t k, size_t max_candidates,
+                     int64_t* indices, double* distances) const;
+
+    // 64-bit words per Cosine signature (zero for Euclidean)
+    size_t signature_words() const { return words_; }
+    const uint64_t* signature(size_t id) const { return signatures_.data() + id * words_; }
+    // Signature of `v`, signature_words() words (Cosine only)
+    std::vector<uint64_t> signature_of(const VectorND& v) const;
+    // Hamming distance from the signature of `query` to every stored one
+    std::vector<uint32_t> hamming_distances(const VectorND& query) const;
+
+    void reserve(size_t count);
+    void clear();
+
+private:
+    size_t dim_;
+    LshMetric metric_;
+    size_t tables_;
+    size_t hashes_;
+    double bucket_width_;
+    size_t words_;
+
+    // Projection p of a vector x is offsets_[p] + sum_d x[d] * planes_[d * P + p]
+    // for P = tables * hashes; Euclidean projections are pre-scaled by 1 / w
+    std::vector<double> planes_;
+    std::vector<double> offsets_;
+
+    VectorBatch rows_;
+    std::vector<double> norms_;          // Cosine only
+    std::vector<uint64_t> signatures_;   // Cosine only, words_ per vector
+    std::vector<std::unordered_map<uint64_t, std::vector<size_t>>> buckets_;
+    mutable std::shared_mutex mutex_;
+
+    // Scratch for hashing one vector
+    struct Hashed {
+        std::vector<double> projections;
+        std::vector<uint64_t> keys;       // bucket per table
+        std::vector<uint64_t> signature;  // Cosine only
+    };
+
+    void check_dimensions(size_t dimensions, const char* operation) const;
+    size_t insert_rows(const BatchView& rows);
+    Hashed scratch() const;
+    void hash(const double* v, Hashed& out) const;
+    std::vector<Neighbor> search(const double* query, size_t k, size_t max_candidates,
+                                 Hashed& scratch) const;
+};
+
+} // namespace vectors
+
+#endif // LSH_INDEX_H
@@ -0,0 +1,117 @@
+#include "matrix.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+namespace vectors {
+
+Matrix::Matrix(size_t rows, size_t cols) : rows_(rows), cols_(cols), data_(rows * cols, 0.0) {}
+
+Matrix::Matrix(size_t rows, size_t cols, const double* data)
+    : rows_(rows), cols_(cols), data_(data, data + rows * cols) {}
+
+Matrix::Matrix(std::initializer_list<std::initializer_list<double>> rows)
+    : rows_(rows.size()), cols_(rows.size() > 0 ? rows.begin()->size() : 0) {
+    data_.reserve(rows_ * cols_);
+    for (const auto& row : rows) {
+        if (row.size() != cols_) {
+            throw std::runtime_error("Matrix rows must have equal length");
+        }
+        data_.insert(data_.end(), row.begin(), row.end());
+    }
+}
+
+Matrix Matrix::identity(size_t n) {
+    Matrix result(n, n);
+    for (size_t i = 0; i < n; ++i) {
+        result(i, i) = 1.0;
+    }
+    return result;
+}
+
+Matrix Matrix::rotation(const VectorND& axis, double angle) {
+    if (axis.size() != 3) {
+        throw std::runtime_error("Rotation only defined for 3D vectors");
+    }
+    // Rodrigues' formula in the form used by VectorND::rotate:
+    // v cos + (v x k) sin + k (k . v)(1 - cos)
+    double c = std::cos(angle);
+    double s = std::sin(angle);
+    double kx = axis[0], ky = axis[1], kz = axis[2];
+    return Matrix{
+        {c + kx * kx * (1 - c),  kz * s + kx * ky * (1 - c), -ky * s + kx * kz * (1 - c)},
+        {-kz * s + ky * kx * (1 - c), c + ky * ky * (1 - c),  kx * s + ky * kz * (1 - c)},
+        {ky * s + kz * kx * (1 - c), -kx * s + kz * ky * (1 - c), c + kz * kz * (1 - c)}
+    };
+}
+
+double Matrix::get(size_t r, size_t c) const {
+    if (r >= rows_ || c >= cols_) {
+        throw std::out_of_range("Matrix index out of range");
+    }
+    return (*this)(r, c);
+}
+
+void Matrix::set(size_t r, size_t c, double value) {
+    if (r >= rows_ || c >= cols_) {
+        throw std::out_of_range("Matrix index out of range");
+    }
+    (*this)(r, c) = value;
+}
+
+Matrix Matrix::transpose() const {
+    Matrix result(cols_, rows_);
+    for (size_t r = 0; r < rows_; ++r) {
+        for (size_t c = 0; c < cols_; ++c) {
+            result(c, r) = (*this)(r, c);
+        }
+    }
+    return result;
+}
+
+Matrix Matrix::operator*(const Matrix& other) const {
+    if (cols_ != other.rows_) {
+        throw std::runtime_error(
+            "Dimension mismatch in matrix multiply: " +
+            std::to_string(cols_) + " vs " + std::to_string(other.rows_)
+        );
+    }
+    Matrix result(rows_, other.cols_);
+    for (size_t r = 0; r < rows_; ++r) {
+        double* out = result.data() + r * other.cols_;
+        for (size_t k = 0; k < cols_; ++k) {
+            double a = (*this)(r, k);
+            const double* b = other.row(k);
+            for (size_t c = 0; c < other.cols_; ++c) {
+                out[c] += a * b[c];
+            }
+        }
+    }
+    return result;
+}
+
+VectorND Matrix::operator*(const VectorND& v) const {
+    if (cols_ != v.size()) {
+        throw std::runtime_error(
+            "Dimension mismatch in matrix-vector multiply: " +
+            std::to_string(cols_) + " vs " + std::to_string(v.size())
+        );
+    }
+    VectorND result(rows_);
+    for (size_t r = 0; r < rows_; ++r) {
+        const double* m = row(r);
+        double sum = 0.0;
+        for (size_t c = 0; c < cols_; ++c) {
+            sum += m[c] * v[c];
+        }
+        result[r] = sum;
+    }
+    return result;
+}
+
+bool Matrix::operator==(const Matrix& other) const {
+    return rows_ == other.rows_ && cols_ == other.cols_ && data_ == other.data_;
+}
+
+} // namespace vectors
@@ -0,0 +1,54 @@
+#ifndef MATRIX_H
+#define MATRIX_H
+
+#include "vector_core.h"
+#include <initializer_list>
+#include <vector>
+
+namespace vectors {
+
+/**
+ * Matrix - Dense row-major matrix of doubles
+ *
+ * Maps vectors of length cols() to vectors of length rows(); see transform.h
+ * for applying one to a whole batch.
+ */
+class Matrix {
+public:
+    Matrix(size_t rows, size_t cols);
+    Matrix(size_t rows, size_t cols, const double* data);
+    Matrix(std::initializer_list<std::initializer_list<double>> rows);
+
+    static Matrix identity(size_t n);
+    // 3x3 matrix with R * v == v.rotate(axis, angle)
+    static Matrix rotation(const VectorND& axis, double angle);
+
+    size_t rows() const { return rows_; }
+    size_t cols() const { return cols_; }
+    bool is_square() const { return rows_ == cols_; }
+
+    const double* data() const { return data_.data(); }
+    double* data() { return data_.data(); }
+    const double* row(size_t r) const { return data_.data() + r * cols_; }
+
+    double operator()(size_t r, size_t c) const { return data_[r * cols_ + c]; }
+    double& operator()(size_t r, size_t c) { return data_[r * cols_ + c]; }
+    double get(size_t r, size_t c) const;
+    void set(size_t r, size_t c, double value);
+
+    Matrix transpose() const;
+    Matrix operator*(const Matrix& other) const;
+    VectorND operator*(const VectorND& v) const;
+
+    bool operator==(const Matrix& other) const;
+    bool operator!=(const Matrix& other) const { return !(*this == other); }
+
+private:
+    size_t rows_;
+    size_t cols_;
+    std::vector<double> data_;
+};
+
+} // namespace vectors
+
+#endif // MATRIX_H
@@ -0,0 +1,224 @@
+#include "morton.h"
+#include "parallel.h"
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace vectors {
+
+namespace {
+
+// Rows per task
+constexpr size_t kRowBlock = 4096;
+
+// Keys per radix sort task; large enough that the 256-entry histograms are
+// cheap next to the keys they count
+constexpr size_t kSortBlock = size_t(1) << 16;
+
+constexpr size_t kRadixBits = 8;
+constexpr size_t kRadix = size_t(1) << kRadixBits;
+
+// Runs body(begin, end) over row blocks, in parallel for large batches
+template <typename Body>
+void for_each_row_block(size_t count, size_t dim, const Body& body) {
+    size_t blocks = (count + kRowBlock - 1) / kRowBlock;
+    auto task = [&](size_t b) {
+        body(b * kRowBlock, std::min(count, (b + 1) * kRowBlock));
+    };
+    parallel_for(blocks, count * dim, task);
+}
+
+// Bits of x moved to every second position (up to 32 bits)
+uint64_t spread2(uint64_t x) {
+    x &= 0xffffffffULL;
+    x = (x | (x << 16)) & 0x0000ffff0000ffffULL;
+    x = (x | (x << 8)) & 0x00ff00ff00ff00ffULL;
+    x = (x | (x << 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    x = (x | (x << 2)) & 0x3333333333333333ULL;
+    x = (x | (x << 1)) & 0x5555555555555555ULL;
+    return x;
+}
+
+// Bits of x moved to every third position (up to 21 bits)
+uint64_t spread3(uint64_t x) {
+    x &= 0x1fffffULL;
+    x = (x | (x << 32)) & 0x001f00000000ffffULL;
+    x = (x | (x << 16)) & 0x001f0000ff0000ffULL;
+    x = (x | (x << 8)) & 0x100f00f00f00f00fULL;
+    x = (x | (x << 4)) & 0x10c30c30c30c30c3ULL;
+    x = (x | (x << 2)) & 0x1249249249249249ULL;
+    return x;
+}
+
+struct Bounds {
+    double lo[3];
+    double hi[3];
+};
+
+// Per-axis bounds of the rows; NaN coordinates are ignored
+Bounds bounds_of(const BatchView& points) {
+    Bounds empty;
+    for (size_t d = 0; d < 3; ++d) {
+        empty.lo[d] = std::numeric_limits<double>::infinity();
+        empty.hi[d] = -std::numeric_limits<double>::infinity();
+    }
+    const size_t blocks = (points.count + kRowBlock - 1) / kRowBlock;
+    return parallel_reduce(blocks, points.count * points.dim, empty, [&](size_t b) {
+        Bounds part = empty;
+        const size_t end = std::min(points.count, (b + 1) * kRowBlock);
+        for (size_t r = b * kRowBlock; r < end; ++r) {
+            const double* p = points.row(r);
+            for (size_t d = 0; d < points.dim; ++d) {
+                part.lo[d] = std::min(part.lo[d], p[d]);
+                part.hi[d] = std::max(part.hi[d], p[d]);
+            }
+        }
+        return part;
+    }, [](Bounds a, const Bounds& b) {
+        for (size_t d = 0; d < 3; ++d) {
+            a.lo[d] = std::min(a.lo[d], b.lo[d]);
+            a.hi[d] = std::max(a.hi[d], b.hi[d]);
+        }
+        return a;
+    });
+}
+
+} // namespace
+
+void morton_codes(const BatchView& points, size_t bits, uint64_t* codes) {
+    if (points.dim != 2 && points.dim != 3) {
+        throw std::runtime_error(
+            "Morton codes need 2D or 3D points, got " + std::to_string(points.dim) + "D"
+        );
+    }
+    if (bits != 32 && bits != 64) {
+        throw std::runtime_error("Morton codes are 32 or 64 bits");
+    }
+    const size_t dim = points.dim;
+    const size_t axis_bits = bits / dim;
+    const double top = static_cast<double>((uint64_t(1) << axis_bits) - 1);
+
+    // Cell scale per axis; a flat or non-finite extent puts every point at 0
+    const Bounds bounds = bounds_of(points);
+    double lo[3] = {0.0, 0.0, 0.0};
+    double scale[3] = {0.0, 0.0, 0.0};
+    for (size_t d = 0; d < dim; ++d) {
+        double extent = bounds.hi[d] - bounds.lo[d];
+        if (extent > 0.0 && extent < std::numeric_limits<double>::infinity()) {
+            lo[d] = bounds.lo[d];
+            scale[d] = top / extent;
+        }
+    }
+
+    // The clamp sends NaN to the top of the axis
+    auto quantize = [&](const double* p, size_t d) {
+        double q = (p[d] - lo[d]) * scale[d];
+        return static_cast<uint64_t>(std::max(0.0, std::min(top, q)));
+    };
+    for_each_row_block(points.count, dim, [&](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; ++r) {
+            const double* p = points.row(r);
+            codes[r] = dim == 2
+                ? spread2(quantize(p, 0)) | (spread2(quantize(p, 1)) << 1)
+                : spread3(quantize(p, 0)) | (spread3(quantize(p, 1)) << 1) |
+                  (spread3(quantize(p, 2)) << 2);
+        }
+    });
+}
+
+void radix_argsort(const uint64_t* keys, size_t n, size_t* permutation) {
+    std::vector<uint64_t> key_in(keys, keys + n);
+    std::vector<uint64_t> key_out(n);
+    std::vector<size_t> index_in(n);
+    std::vector<size_t> index_out(n);
+    std::iota(index_in.begin(), index_in.end(), size_t(0));
+
+    const size_t blocks = (n + kSortBlock - 1) / kSortBlock;
+    std::vector<size_t> counts(blocks * kRadix);
+    for (size_t shift = 0; shift < 64; shift += kRadixBits) {
+        auto digit = [shift](uint64_t key) { return (key >> shift) & (kRadix - 1); };
+        parallel_for(blocks, n, [&](size_t b) {
+            size_t* count = counts.data() + b * kRadix;
+            std::fill(count, count + kRadix, 0);
+            const size_t end = std::min(n, (b + 1) * kSortBlock);
+            for (size_t i = b * kSortBlock; i < end; ++i) {
+                ++count[digit(key_in[i])];
+            }
+        });
+
+        // Offsets run over digits first and blocks second, which keeps equal
+        // digits in their current order
+        size_t running = 0;
+        bool uniform = false;
+        for (size_t d = 0; d < kRadix; ++d) {
+            size_t total = 0;
+            for (size_t b = 0; b < blocks; ++b) {
+                size_t c = counts[b * kRadix + d];
+                counts[b * kRadix + d] = running + total;
+                total += c;
+            }
+            uniform = uniform || total == n;
+            running += total;
+        }
+        if (uniform) {
+            continue;
+        }
+
+        parallel_for(blocks, n, [&](size_t b) {
+            size_t* offset = counts.data() + b * kRadix;
+            const size_t end = std::min(n, (b + 1) * kSortBlock);
+            for (size_t i = b * kSortBlock; i < end; ++i) {
+                size_t position = offset[digit(key_in[i])]++;
+                key_out[position] = key_in[i];
+                index_out[position] = index_in[i];
+            }
+        });
+        std::swap(key_in, key_out);
+        std::swap(index_in, index_out);
+    }
+    std::copy(index_in.begin(), index_in.end(), permutation);
+}
+
+std::vector<size_t> morton_order(const BatchView& points, size_t bits) {
+    std::vector<uint64_t> codes(points.count);
+    morton_codes(points, bits, codes.data());
+    std::vector<size_t> order(points.count);
+    radix_argsort(codes.data(), codes.size(), order.data());
+    return order;
+}
+
+void gather_rows(const BatchView& rows, const size_t* permutation, size_t count,
+                 VectorBatch& result) {
+    for (size_t i = 0; i < count; ++i) {
+        if (permutation[i] >= rows.count) {
+            throw std::out_of_range(
+                "Permutation index " + std::to_string(permutation[i]) +
+                " out of range for " + std::to_string(rows.count) + " rows"
+            );
+        }
+    }
+    // Gathering in place would overwrite rows still to be read
+    std::less<const double*> before;
+    const double* storage = result.data();
+    const bool shared = rows.count > 0 && result.size() > 0 &&
+        before(rows.data, storage + result.size() * result.dimensions()) &&
+        before(storage, rows.row(rows.count - 1) + rows.dim);
+    if (shared || result.size() != count || result.dimensions() != rows.dim) {
+        VectorBatch fresh(count, rows.dim);
+        gather_rows(rows, permutation, count, fresh);
+        result = std::move(fresh);
+        return;
+    }
+    for_each_row_block(count, rows.dim, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const double* source = rows.row(permutation[i]);
+            std::copy(source, source + rows.dim, result.row(i));
+        }
+    });
+}
+
+} // namespace vectors
@@ -0,0 +1,43 @@
+#ifndef MORTON_H
+#define MORTON_H
+
+#include "vector_batch.h"
+#include <cstdint>
+#include <vector>
+
+namespace vectors {
+
+/**
+ * Morton (Z-order) codes and spatial reordering of 2D and 3D point batches.
+ *
+ * Each coordinate is quantized within the batch's bounding box and the bits
+ * of the axes are interleaved, so points close in space mostly get close
+ * codes. 64-bit codes keep 32 bits per axis in 2D and 21 in 3D; 32-bit codes
+ * keep 16 and 10. NaN coordinates quantize to the top of their axis.
+ *
+ * Sorting rows by their codes and gathering them in that order lays out a
+ * batch so that neighbouring rows are near each other, which keeps the
+ * distance, transform and integrator kernels working within cache-resident
+ * regions when they visit points near one another.
+ */
+
+// `bits` is 32 or 64; codes of 32 bits are returned widened
+void morton_codes(const BatchView& points, size_t bits, uint64_t* codes);
+
+// Stable order of the keys: permutation[i] is the index of the i-th smallest.
+// LSD radix sort over 8-bit digits; each pass counts and scatters blocks of
+// keys in parallel, and passes whose digit is the same for every key are
+// skipped, so 32-bit codes cost at most four passes.
+void radix_argsort(const uint64_t* keys, size_t n, size_t* permutation);
+
+// Rows of `points` in Morton order, i.e. radix_argsort of morton_codes
+std::vector<size_t> morton_order(const BatchView& points, size_t bits = 64);
+
+// Row i of the result is rows.row(permutation[i]). `result` is reused when
+// it already has the output shape and may be the input batch itself.
+void gather_rows(const BatchView& rows, const size_t* permutation, size_t count,
+                 VectorBatch& result);
+
+} // namespace vectors
+
+#endif // MORTON_H
@@ -0,0 +1,118 @@
+#include "norm_cached_batch.h"
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <string>
+
+namespace vectors {
+
+namespace {
+
+// Placeholder for rows whose norm has not been computed yet
+constexpr double kUnknownNorm = std::numeric_limits<double>::infinity();
+
+bool is_zero_norm(double norm) {
+    return norm < std::numeric_limits<double>::epsilon();
+}
+
+} // namespace
+
+NormCachedBatch::NormCachedBatch(size_t dimensions) : rows_(dimensions), zero_rows_(0) {}
+
+NormCachedBatch::NormCachedBatch(const BatchView& rows)
+    : rows_(rows), norms_(rows.count, kUnknownNorm), zero_rows_(0) {
+    update_norms(0, rows.count);
+}
+
+void NormCachedBatch::update_norms(size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        if (is_zero_norm(norms_[i])) {
+            --zero_rows_;
+        }
+    }
+    BatchView changed{rows_.row(begin), end - begin, rows_.dimensions(), rows_.dimensions()};
+    batch_norms(changed, norms_.data() + begin);
+    for (size_t i = begin; i < end; ++i) {
+        if (is_zero_norm(norms_[i])) {
+            ++zero_rows_;
+        }
+    }
+}
+
+double NormCachedBatch::norm(size_t index) const {
+    if (index >= norms_.size()) {
+        throw std::out_of_range("Batch index out of range");
+    }
+    return norms_[index];
+}
+
+VectorND NormCachedBatch::get(size_t index) const {
+    return rows_.get(index);
+}
+
+void NormCachedBatch::set(size_t index, const VectorND& v) {
+    rows_.set(index, v);
+    update_norms(index, index + 1);
+}
+
+void NormCachedBatch::append(const VectorND& v) {
+    rows_.append(v);
+    norms_.push_back(kUnknownNorm);
+    update_norms(rows_.size() - 1, rows_.size());
+}
+
+void NormCachedBatch::append(const BatchView& rows) {
+    if (rows.dim != rows_.dimensions()) {
+        throw std::runtime_error(
+            "Dimension mismatch in batch append: " +
+            std::to_string(rows_.dimensions()) + " vs " + std::to_string(rows.dim)
+        );
+    }
+    // Rows viewing this batch would move when the storage grows
+    std::less<const double*> before;
+    if (rows.count > 0 && !before(rows.data, rows_.data()) &&
+        before(rows.data, rows_.data() + rows_.size() * rows_.dimensions())) {
+        VectorBatch copy(rows);
+        append(copy.view());
+        return;
+    }
+    size_t begin = rows_.size();
+    rows_.reserve(begin + rows.count);
+    for (size_t i = 0; i < rows.count; ++i) {
+        rows_.append(rows.row(i));
+    }
+    norms_.resize(rows_.size(), kUnknownNorm);
+    update_norms(begin, rows_.size());
+}
+
+void NormCachedBatch::reserve(size_t count) {
+    rows_.reserve(count);
+    norms_.reserve(count);
+}
+
+void NormCachedBatch::clear() {
+    rows_.clear();
+    norms_.clear();
+    zero_rows_ = 0;
+}
+
+void NormCachedBatch::cosine_similarity(const VectorND& query, double* result) const {
+    if (query.size() != rows_.dimensions()) {
+        throw std::runtime_error(
+            "Dimension mismatch in batch cosine similarity: " +
+            std::to_string(rows_.dimensions()) + " vs " + std::to_string(query.size())
+        );
+    }
+    double query_norm = query.magnitude();
+    if (zero_rows_ > 0 || is_zero_norm(query_norm)) {
+        throw std::runtime_error("Cannot calculate cosine similarity with zero vector");
+    }
+    // A stride-0 view repeats the query for every row
+    BatchView repeated{query.data().data(), size(), query.size(), 0};
+    batch_dot_product(view(), repeated, result);
+    for (size_t i = 0; i < norms_.size(); ++i) {
+        result[i] /= norms_[i] * query_norm;
+    }
+}
+
+} // namespace vectors
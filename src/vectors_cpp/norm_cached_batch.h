@@ -0,0 +1,52 @@
+#ifndef NORM_CACHED_BATCH_H
+#define NORM_CACHED_BATCH_H
+
+#include "vector_batch.h"
+#include <vector>
+
+namespace vectors {
+
+/**
+ * NormCachedBatch - Contiguous batch that keeps the norm of every row
+ *
+ * Norms are computed once when rows are added and recomputed for the rows a
+ * mutation touches, so cosine similarity against the batch costs one dot
+ * product per row. Rows can only be changed through this class, which is
+ * what keeps the cache valid.
+ */
+class NormCachedBatch {
+public:
+    explicit NormCachedBatch(size_t dimensions);
+    explicit NormCachedBatch(const BatchView& rows);
+
+    size_t size() const { return rows_.size(); }
+    size_t dimensions() const { return rows_.dimensions(); }
+
+    const double* data() const { return rows_.data(); }
+    const double* row(size_t i) const { return rows_.row(i); }
+    const double* norms() const { return norms_.data(); }
+    double norm(size_t index) const;
+
+    VectorND get(size_t index) const;
+    void set(size_t index, const VectorND& v);
+    void append(const VectorND& v);
+    void append(const BatchView& rows);
+    void reserve(size_t count);
+    void clear();
+
+    BatchView view() const { return rows_.view(); }
+
+    // Cosine similarity of every row with `query`
+    void cosine_similarity(const VectorND& query, double* result) const;
+
+private:
+    VectorBatch rows_;
+    std::vector<double> norms_;
+    size_t zero_rows_;  // rows whose norm is below epsilon
+
+    void update_norms(size_t begin, size_t end);
+};
+
+} // namespace vectors
+
+#endif // NORM_CACHED_BATCH_H
@@ -0,0 +1,191 @@
+#include "online_stats.h"
+#include "parallel.h"
+#include <algorithm>
+#include <limits>
+#include <string>
+
+namespace vectors {
+
+namespace {
+
+// Rows per block, sized so one block's rows stay resident in L2
+constexpr size_t kBlockElements = size_t(1) << 15;
+
+// Most partial accumulators per batch. Fixed rather than tied to the thread
+// count, so the merge order, and with it the result, is the same everywhere.
+constexpr size_t kMaxPartials = 64;
+
+} // namespace
+
+OnlineStats::OnlineStats(size_t dimensions)
+    : count_(0),
+      mean_(dimensions, 0.0),
+      m2_(dimensions, 0.0),
+      min_(dimensions, std::numeric_limits<double>::infinity()),
+      max_(dimensions, -std::numeric_limits<double>::infinity()) {}
+
+void OnlineStats::check_dimensions(size_t dimensions, const char* operation) const {
+    if (dimensions != mean_.size()) {
+        throw std::runtime_error(
+            std::string("Dimension mismatch in ") + operation +
+            ": " + std::to_string(mean_.size()) +
+            " vs " + std::to_string(dimensions)
+        );
+    }
+}
+
+void OnlineStats::check_not_empty() const {
+    if (count_ == 0) {
+        throw std::runtime_error("Cannot calculate statistics of empty accumulator");
+    }
+}
+
+void OnlineStats::add(const VectorND& v) {
+    check_dimensions(v.size(), "online stats");
+    add(v.data().data());
+}
+
+void OnlineStats::add(const double* row) {
+    ++count_;
+    const double n = static_cast<double>(count_);
+    for (size_t i = 0; i < mean_.size(); ++i) {
+        double delta = row[i] - mean_[i];
+        mean_[i] += delta / n;
+        m2_[i] += delta * (row[i] - mean_[i]);
+        min_[i] = std::min(min_[i], row[i]);
+        max_[i] = std::max(max_[i], row[i]);
+    }
+}
+
+void OnlineStats::add_batch(const VectorND* vectors, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        check_dimensions(vectors[i].size(), "online stats");
+    }
+    add_rows([vectors](size_t r) { return vectors[r].data().data(); }, count);
+}
+
+void OnlineStats::add_batch(const double* data, size_t count, size_t stride) {
+    add_rows([data, stride](size_t r) { return data + r * stride; }, count);
+}
+
+template <typename RowAt>
+void OnlineStats::add_rows(const RowAt& row_at, size_t count) {
+    const size_t dim = mean_.size();
+    if (count == 0) return;
+    if (dim == 0) {
+        count_ += count;
+        return;
+    }
+
+    // Each block gets an exact two-pass mean and M2. A task merges a run of
+    // consecutive blocks into its partial, and the partials are merged in
+    // order, so scratch memory stays at kMaxPartials accumulators.
+    const size_t block_rows = std::max<size_t>(1, kBlockElements / dim);
+    const size_t blocks = (count + block_rows - 1) / block_rows;
+    const size_t tasks = std::min(blocks, kMaxPartials);
+    std::vector<OnlineStats> partials(tasks, OnlineStats(dim));
+
+    auto add_block = [&](OnlineStats& part, size_t begin, size_t end) {
+        for (size_t r = begin; r < end; ++r) {
+            const double* row = row_at(r);
+            for (size_t i = 0; i < dim; ++i) {
+                part.mean_[i] += row[i];
+                part.min_[i] = std::min(part.min_[i], row[i]);
+                part.max_[i] = std::max(part.max_[i], row[i]);
+            }
+        }
+        part.count_ = end - begin;
+        const double n = static_cast<double>(part.count_);
+        for (size_t i = 0; i < dim; ++i) {
+            part.mean_[i] /= n;
+        }
+        for (size_t r = begin; r < end; ++r) {
+            const double* row = row_at(r);
+            for (size_t i = 0; i < dim; ++i) {
+                double delta = row[i] - part.mean_[i];
+                part.m2_[i] += delta * delta;
+            }
+        }
+    };
+    auto task = [&](size_t t) {
+        OnlineStats block(dim);
+        const size_t first = t * blocks / tasks;
+        const size_t last = (t + 1) * blocks / tasks;
+        for (size_t b = first; b < last; ++b) {
+            block.reset();
+            add_block(block, b * block_rows, std::min(count, (b + 1) * block_rows));
+            partials[t].merge(block);
+        }
+    };
+    parallel_for(tasks, count * dim, task);
+
+    for (const auto& part : partials) {
+        merge(part);
+    }
+}
+
+void OnlineStats::merge(const OnlineStats& other) {
+    check_dimensions(other.dimensions(), "online stats merge");
+    if (other.count_ == 0) return;
+    if (count_ == 0) {
+        *this = other;
+        return;
+    }
+
+    const double na = static_cast<double>(count_);
+    const double nb = static_cast<double>(other.count_);
+    const double n = na + nb;
+    for (size_t i = 0; i < mean_.size(); ++i) {
+        double delta = other.mean_[i] - mean_[i];
+        mean_[i] += delta * (nb / n);
+        m2_[i] += other.m2_[i] + delta * delta * (na * nb / n);
+        min_[i] = std::min(min_[i], other.min_[i]);
+        max_[i] = std::max(max_[i], other.max_[i]);
+    }
+    count_ += other.count_;
+}
+
+void OnlineStats::reset() {
+    count_ = 0;
+    std::fill(mean_.begin(), mean_.end(), 0.0);
+    std::fill(m2_.begin(), m2_.end(), 0.0);
+    std::fill(min_.begin(), min_.end(), std::numeric_limits<double>::infinity());
+    std::fill(max_.begin(), max_.end(), -std::numeric_limits<double>::infinity());
+}
+
+VectorND OnlineStats::mean() const {
+    check_not_empty();
+    return VectorND(mean_);
+}
+
+VectorND OnlineStats::variance(size_t ddof) const {
+    if (count_ <= ddof) {
+        throw std::runtime_error("Not enough samples for variance");
+    }
+    const double denom = static_cast<double>(count_ - ddof);
+    VectorND result(m2_.size());
+    for (size_t i = 0; i < m2_.size(); ++i) {
+        result[i] = m2_[i] / denom;
+    }
+    return result;
+}
+
+VectorND OnlineStats::covariance_diagonal() const {
+    return variance(1);
+}
+
+VectorND OnlineStats::min() const {
+    check_not_empty();
+    return VectorND(min_);
+}
+
+VectorND OnlineStats::max() const {
+    check_not_empty();
+    return VectorND(max_);
+}
+
+OnlineStats::Snapshot OnlineStats::snapshot(size_t ddof) const {
+    return Snapshot{count_, mean(), variance(ddof), min(), max()};
+}
+
+} // namespace vectors
@@ -0,0 +1,65 @@
+#ifndef ONLINE_STATS_H
+#define ONLINE_STATS_H
+
+#include "vector_core.h"
+#include <vector>
+
+namespace vectors {
+
+/**
+ * OnlineStats - Streaming per-dimension statistics over a sequence of vectors
+ *
+ * Keeps count, mean, sum of squared deviations (Welford), min and max for
+ * every dimension, so running centroids and variances never need the vectors
+ * themselves. Batches are folded in with Chan's parallel update, and
+ * accumulators filled on different threads can be merged.
+ */
+class OnlineStats {
+public:
+    struct Snapshot {
+        size_t count;
+        VectorND mean;
+        VectorND variance;
+        VectorND min;
+        VectorND max;
+    };
+
+    explicit OnlineStats(size_t dimensions);
+
+    size_t dimensions() const { return mean_.size(); }
+    size_t count() const { return count_; }
+
+    // Ingestion
+    void add(const VectorND& v);
+    void add(const double* row);
+    void add_batch(const VectorND* vectors, size_t count);
+    void add_batch(const double* data, size_t count, size_t stride);
+    void merge(const OnlineStats& other);
+    void reset();
+
+    // Statistics, each O(D)
+    VectorND mean() const;
+    VectorND variance(size_t ddof = 0) const;
+    VectorND covariance_diagonal() const;  // unbiased (ddof = 1)
+    VectorND min() const;
+    VectorND max() const;
+    Snapshot snapshot(size_t ddof = 0) const;
+
+private:
+    size_t count_;
+    std::vector<double> mean_;
+    std::vector<double> m2_;
+    std::vector<double> min_;
+    std::vector<double> max_;
+
+    void check_dimensions(size_t dimensions, const char* operation) const;
+    void check_not_empty() const;
+
+    // Folds rows [0, count) of a row-major block in with a two-pass update
+    template <typename RowAt>
+    void add_rows(const RowAt& row_at, size_t count);
+};
+
+} // namespace vectors
+
+#endif // ONLINE_STATS_H
@@ -0,0 +1,408 @@
+#include "parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+#if defined(VECTORS_WITH_OPENMP)
+#include <omp.h>
+#endif
+#if defined(VECTORS_WITH_TBB)
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#endif
+
+namespace vectors {
+
+namespace {
+
+std::atomic<size_t> g_num_threads{0};
+std::atomic<bool> g_pinning{false};
+std::atomic<size_t> g_threshold{size_t(1) << 18};
+std::atomic<ParallelBackend> g_backend{ParallelBackend::Native};
+
+// Ranges handed out per thread; more than one so uneven tasks still balance
+constexpr size_t kRangesPerThread = 8;
+
+size_t hardware_threads() {
+    size_t n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
+
+// One parallel_for call: the body, how many tasks are left, the first error
+struct Group {
+    const std::function<void(size_t)>* body;
+    size_t grain;
+    std::atomic<size_t> remaining;
+    std::mutex mutex;
+    std::condition_variable done;
+    std::exception_ptr error;
+
+    void run(size_t begin, size_t end) {
+        for (size_t t = begin; t < end; ++t) {
+            try {
+                (*body)(t);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error) error = std::current_exception();
+            }
+        }
+        // Decrement under the lock: the owner takes it once more before the
+        // group goes out of scope, so no finisher can still be touching it
+        std::lock_guard<std::mutex> lock(mutex);
+        if (remaining.fetch_sub(end - begin) == end - begin) {
+            done.notify_all();
+        }
+    }
+};
+
+struct Range {
+    Group* group;
+    size_t begin;
+    size_t end;
+};
+
+// The owner pushes and pops at the back; thieves take the oldest, largest
+// ranges from the front
+struct alignas(64) WorkQueue {
+    std::mutex mutex;
+    std::deque<Range> ranges;
+
+    void push(const Range& range) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ranges.push_back(range);
+    }
+
+    bool pop(Range& range) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (ranges.empty()) return false;
+        range = ranges.back();
+        ranges.pop_back();
+        return true;
+    }
+
+    bool steal(Range& range) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (ranges.empty()) return false;
+        range = ranges.front();
+        ranges.pop_front();
+        return true;
+    }
+};
+
+class Pool;
+
+// Pool and queue of the current thread when it is a pool worker
+thread_local Pool* tls_pool = nullptr;
+thread_local size_t tls_queue = 0;
+
+/**
+ * Pool - Work-stealing workers; `threads` counts the calling thread, which
+ * helps with its own parallel_for, so threads - 1 workers are started. The
+ * last queue is shared by callers from outside the pool.
+ */
+class Pool {
+public:
+    Pool(size_t threads, bool pinned)
+        : threads_(threads), pinned_(pinned), queues_(new WorkQueue[threads]) {
+        workers_.reserve(threads - 1);
+        for (size_t i = 0; i + 1 < threads; ++i) {
+            workers_.emplace_back([this, i] { work(i); });
+        }
+    }
+
+    ~Pool() {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    size_t threads() const { return threads_; }
+    bool pinned() const { return pinned_; }
+
+    void run(size_t tasks, const std::function<void(size_t)>& body) {
+        Group group;
+        group.body = &body;
+        group.grain = std::max<size_t>(1, tasks / (threads_ * kRangesPerThread));
+        group.remaining.store(tasks);
+        size_t self = tls_pool == this ? tls_queue : threads_ - 1;
+        push(self, Range{&group, 0, tasks});
+
+        // Help until this call's tasks are done; its last ranges may be
+        // running elsewhere, so sleep briefly between attempts
+        while (group.remaining.load() != 0) {
+            Range range;
+            if (take(self, range)) {
+                execute(self, range);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(group.mutex);
+            group.done.wait_for(lock, std::chrono::microseconds(200),
+                                [&] { return group.remaining.load() == 0; });
+        }
+        std::lock_guard<std::mutex> lock(group.mutex);
+        if (group.error) {
+            std::rethrow_exception(group.error);
+        }
+    }
+
+private:
+    size_t threads_;
+    bool pinned_;
+    std::unique_ptr<WorkQueue[]> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<int64_t> queued_{0};
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+    bool stop_ = false;
+
+    void push(size_t queue, const Range& range) {
+        queues_[queue].push(range);
+        queued_.fetch_add(1);
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+        }
+        wake_.notify_one();
+    }
+
+    bool take(size_t self, Range& range) {
+        if (queues_[self].pop(range)) {
+            queued_.fetch_sub(1);
+            return true;
+        }
+        for (size_t k = 1; k < threads_; ++k) {
+            if (queues_[(self + k) % threads_].steal(range)) {
+                queued_.fetch_sub(1);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Splits off the upper half for thieves until the range is one grain
+    void execute(size_t self, Range range) {
+        while (range.end - range.begin > range.group->grain) {
+            size_t mid = range.begin + (range.end - range.begin) / 2;
+            push(self, Range{range.group, mid, range.end});
+            range.end = mid;
+        }
+        range.group->run(range.begin, range.end);
+    }
+
+    void work(size_t index) {
+        tls_pool = this;
+        tls_queue = index;
+        if (pinned_) {
+            pin(index);
+        }
+        for (;;) {
+            Range range;
+            if (take(index, range)) {
+                execute(index, range);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            wake_.wait(lock, [&] { return stop_ || queued_.load() > 0; });
+            if (stop_ && queued_.load() <= 0) {
+                return;
+            }
+        }
+    }
+
+    // Workers take CPUs from 1 up, leaving CPU 0 to the calling thread
+    static void pin(size_t index) {
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(static_cast<int>((index + 1) % hardware_threads()), &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+        (void)index;
+#endif
+    }
+};
+
+std::mutex g_pool_mutex;
+std::shared_ptr<Pool> g_pool;
+#if !defined(_WIN32)
+pid_t g_pool_pid = 0;
+#endif
+
+// Pools are shut down when their last caller lets go. A worker cannot join
+// itself, so if that caller is one of the pool's own workers (a nested call
+// racing with set_num_threads) the shutdown moves to a helper thread.
+void destroy_pool(Pool* pool) {
+    if (tls_pool == pool) {
+        std::thread([pool] { delete pool; }).detach();
+    } else {
+        delete pool;
+    }
+}
+
+std::shared_ptr<Pool> current_pool() {
+    size_t threads = get_num_threads();
+    bool pinned = g_pinning.load();
+    std::lock_guard<std::mutex> lock(g_pool_mutex);
+#if !defined(_WIN32)
+    // A forked child inherits the pool but not its threads; abandon it
+    if (g_pool && g_pool_pid != getpid()) {
+        new std::shared_ptr<Pool>(std::move(g_pool));
+    }
+    g_pool_pid = getpid();
+#endif
+    if (!g_pool || g_pool->threads() != threads || g_pool->pinned() != pinned) {
+        g_pool = std::shared_ptr<Pool>(new Pool(threads, pinned), destroy_pool);
+    }
+    return g_pool;
+}
+
+// Kernels called from inside an OpenMP team stay serial instead of
+// multiplying the team's threads
+bool inside_external_team() {
+#if defined(VECTORS_WITH_OPENMP)
+    return omp_in_parallel() != 0;
+#else
+    return false;
+#endif
+}
+
+void run_serial(size_t tasks, const std::function<void(size_t)>& body) {
+    for (size_t t = 0; t < tasks; ++t) {
+        body(t);
+    }
+}
+
+#if defined(VECTORS_WITH_OPENMP)
+void run_openmp(size_t tasks, size_t threads, const std::function<void(size_t)>& body) {
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    const long long count = static_cast<long long>(tasks);
+    #pragma omp parallel for schedule(dynamic) num_threads(static_cast<int>(threads))
+    for (long long t = 0; t < count; ++t) {
+        try {
+            body(static_cast<size_t>(t));
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error) error = std::current_exception();
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+#endif
+
+#if defined(VECTORS_WITH_TBB)
+void run_tbb(size_t tasks, size_t threads, const std::function<void(size_t)>& body) {
+    tbb::task_arena arena(static_cast<int>(threads));
+    arena.execute([&] {
+        tbb::parallel_for(size_t(0), tasks, [&](size_t t) { body(t); });
+    });
+}
+#endif
+
+} // namespace
+
+size_t get_num_threads() {
+    size_t n = g_num_threads.load(std::memory_order_relaxed);
+    return n == 0 ? hardware_threads() : n;
+}
+
+void set_num_threads(size_t threads) {
+    g_num_threads.store(threads, std::memory_order_relaxed);
+}
+
+bool get_thread_pinning() {
+    return g_pinning.load(std::memory_order_relaxed);
+}
+
+void set_thread_pinning(bool enabled) {
+    g_pinning.store(enabled, std::memory_order_relaxed);
+}
+
+ParallelBackend get_parallel_backend() {
+    return g_backend.load(std::memory_order_relaxed);
+}
+
+bool parallel_backend_available(ParallelBackend backend) {
+    switch (backend) {
+        case ParallelBackend::OpenMP:
+#if defined(VECTORS_WITH_OPENMP)
+            return true;
+#else
+            return false;
+#endif
+        case ParallelBackend::TBB:
+#if defined(VECTORS_WITH_TBB)
+            return true;
+#else
+            return false;
+#endif
+        default:
+            return true;
+    }
+}
+
+void set_parallel_backend(ParallelBackend backend) {
+    if (!parallel_backend_available(backend)) {
+        throw std::runtime_error(backend == ParallelBackend::OpenMP
+                                     ? "OpenMP support was not compiled in"
+                                     : "TBB support was not compiled in");
+    }
+    g_backend.store(backend, std::memory_order_relaxed);
+}
+
+size_t get_parallel_threshold() {
+    return g_threshold.load(std::memory_order_relaxed);
+}
+
+void set_parallel_threshold(size_t work) {
+    g_threshold.store(work, std::memory_order_relaxed);
+}
+
+void parallel_for(size_t tasks, const std::function<void(size_t)>& body) {
+    size_t threads = get_num_threads();
+    ParallelBackend backend = get_parallel_backend();
+    if (std::min(threads, tasks) <= 1 || backend == ParallelBackend::Serial ||
+        inside_external_team()) {
+        run_serial(tasks, body);
+        return;
+    }
+    switch (backend) {
+#if defined(VECTORS_WITH_OPENMP)
+        case ParallelBackend::OpenMP:
+            run_openmp(tasks, threads, body);
+            return;
+#endif
+#if defined(VECTORS_WITH_TBB)
+        case ParallelBackend::TBB:
+            run_tbb(tasks, threads, body);
+            return;
+#endif
+        default:
+            current_pool()->run(tasks, body);
+            return;
+    }
+}
+
+} // namespace vectors
@@ -0,0 +1,76 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace vectors {
+
+/**
+ * Thread control for the batch kernels.
+ *
+ * Kernels split their input into a fixed number of tasks that depends only on
+ * the input size, so the result of a reduction never depends on how many
+ * threads happened to run it.
+ *
+ * Tasks run on one process-wide work-stealing pool that is started on first
+ * use: each worker splits ranges of tasks in half, keeps one half and leaves
+ * the other on its deque for idle workers to steal. The calling thread works
+ * too, and kernels called from inside a task run nested on the same pool.
+ */
+size_t get_num_threads();
+void set_num_threads(size_t threads);  // 0 restores the hardware default
+
+// Pins pool workers to one CPU each (Linux only; ignored elsewhere)
+bool get_thread_pinning();
+void set_thread_pinning(bool enabled);
+
+// Who runs parallel work. OpenMP and TBB are available when the core is built
+// with VECTORS_WITH_OPENMP / VECTORS_WITH_TBB and hand tasks to that runtime,
+// so kernels share its threads with the rest of the application. Serial runs
+// everything on the calling thread.
+enum class ParallelBackend { Native, OpenMP, TBB, Serial };
+ParallelBackend get_parallel_backend();
+void set_parallel_backend(ParallelBackend backend);
+bool parallel_backend_available(ParallelBackend backend);
+
+// Work size (roughly, elements touched) below which kernels stay on the
+// calling thread
+size_t get_parallel_threshold();
+void set_parallel_threshold(size_t work);
+
+// Runs body(task) for every task in [0, tasks), spreading tasks over threads.
+// The first exception thrown by any task is rethrown on the calling thread.
+void parallel_for(size_t tasks, const std::function<void(size_t)>& body);
+
+// As above, but inputs whose `work` is below the parallel threshold run
+// inline without touching the pool
+template <typename Body>
+void parallel_for(size_t tasks, size_t work, const Body& body) {
+    if (tasks < 2 || work < get_parallel_threshold()) {
+        for (size_t t = 0; t < tasks; ++t) {
+            body(t);
+        }
+        return;
+    }
+    parallel_for(tasks, std::function<void(size_t)>(std::cref(body)));
+}
+
+// Maps every task to a partial result and folds the partials in task order,
+// so the result is the same for any thread count
+template <typename T, typename Map, typename Combine>
+T parallel_reduce(size_t tasks, size_t work, T identity, const Map& map,
+                  const Combine& combine) {
+    std::vector<T> partials(tasks, identity);
+    parallel_for(tasks, work, [&](size_t t) { partials[t] = map(t); });
+    T result = identity;
+    for (T& partial : partials) {
+        result = combine(result, partial);
+    }
+    return result;
+}
+
+} // namespace vectors
+
+#endif // PARALLEL_H
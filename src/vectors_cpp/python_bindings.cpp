@@ -3,13 +3,463 @@
 #include <pybind11/numpy.h>
 #include <pybind11/operators.h>
 #include "vector_core.h"
+#include "allocator.h"
+#include "async_jobs.h"
+#include "bvh.h"
+#include "centroid_trackers.h"
+#include "concurrent_store.h"
+#include "dedup.h"
+#include "dim_reduction.h"
+#include "elementwise.h"
+#include "geometry.h"
+#include "loaders.h"
+#include "lsh_index.h"
+#include "matrix.h"
+#include "morton.h"
+#include "norm_cached_batch.h"
+#include "online_stats.h"
+#include "parallel.h"
+#include "reduction.h"
+#include "serialization.h"
+#include "shared_batch.h"
+#include "sparse_batch.h"
+#include "transform.h"
+#include "vector_batch.h"
+#include "vector_hash.h"
+#include "vector_set.h"
+#include "vector_store.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 namespace py = pybind11;
 using namespace vectors;
 
+// Row-major float64 block of vectors, one vector per row
+using RowArray = py::array_t<double, py::array::c_style | py::array::forcecast>;
+
+// Readers of each growable container's storage: NumPy views of its buffer
+// and calls working on its rows without the GIL. Pins taken by the running
+// call are also counted per thread, so the call may still resize an object
+// it was passed.
+static std::mutex pins_mutex;
+static std::unordered_map<const void*, size_t> pins;
+static thread_local std::unordered_map<const void*, size_t> local_pins;
+
+static void add_pin(const void* owner, bool local) {
+    std::lock_guard<std::mutex> lock(pins_mutex);
+    ++pins[owner];
+    if (local) {
+        ++local_pins[owner];
+    }
+}
+
+static void remove_pin(const void* owner, bool local) {
+    std::lock_guard<std::mutex> lock(pins_mutex);
+    if (--pins[owner] == 0) {
+        pins.erase(owner);
+    }
+    if (local && --local_pins[owner] == 0) {
+        local_pins.erase(owner);
+    }
+}
+
+// True when something besides the running call reads owner's storage
+static bool pinned_elsewhere(const void* owner) {
+    std::lock_guard<std::mutex> lock(pins_mutex);
+    auto all = pins.find(owner);
+    if (all == pins.end()) {
+        return false;
+    }
+    auto mine = local_pins.find(owner);
+    return all->second > (mine == local_pins.end() ? 0 : mine->second);
+}
+
+// Refuses to reallocate storage that is exported or read, as bytearray does
+static void check_resizable(const void* owner) {
+    if (pinned_elsewhere(owner)) {
+        throw py::buffer_error("Existing exports of data: object cannot be re-sized");
+    }
+}
+
+// Pins an object's storage for as long as it lives. Copies outlive the call
+// that took the pin (queued async jobs), so they count as foreign readers.
+class StoragePin {
+public:
+    StoragePin() = default;
+    explicit StoragePin(const void* owner) : owner_(owner), local_(true) {
+        add_pin(owner_, local_);
+    }
+    StoragePin(const StoragePin& other) : owner_(other.owner_), local_(false) {
+        if (owner_) {
+            add_pin(owner_, local_);
+        }
+    }
+    StoragePin(StoragePin&& other) noexcept : owner_(other.owner_), local_(other.local_) {
+        other.owner_ = nullptr;
+    }
+    StoragePin& operator=(StoragePin other) noexcept {
+        std::swap(owner_, other.owner_);
+        std::swap(local_, other.local_);
+        return *this;
+    }
+    ~StoragePin() {
+        if (owner_) {
+            remove_pin(owner_, local_);
+        }
+    }
+    
+private:
+    const void* owner_ = nullptr;
+    bool local_ = false;
+};
+
+// Counts buffer exports of a bound type as pins on its storage
+template <typename T>
+static void pin_exports(py::handle type) {
+    static getbufferproc get_buffer = nullptr;
+    static releasebufferproc release_buffer = nullptr;
+    PyBufferProcs* procs = reinterpret_cast<PyTypeObject*>(type.ptr())->tp_as_buffer;
+    get_buffer = procs->bf_getbuffer;
+    release_buffer = procs->bf_releasebuffer;
+    procs->bf_getbuffer = [](PyObject* obj, Py_buffer* view, int flags) -> int {
+        if (get_buffer(obj, view, flags) != 0) {
+            return -1;
+        }
+        try {
+            add_pin(&py::handle(obj).cast<const T&>(), false);
+        } catch (...) {
+            release_buffer(obj, view);
+            Py_CLEAR(view->obj);
+            PyErr_SetString(PyExc_BufferError, "Cannot export the object's storage");
+            return -1;
+        }
+        return 0;
+    };
+    procs->bf_releasebuffer = [](PyObject* obj, Py_buffer* view) {
+        try {
+            remove_pin(&py::handle(obj).cast<const T&>(), false);
+        } catch (...) {
+            PyErr_Clear();
+        }
+        release_buffer(obj, view);
+    };
+}
+
+// Any batch-like argument viewed as rows; `owner` keeps the rows alive and
+// `pin` keeps growable ones from reallocating
+struct BatchArg {
+    BatchView view;
+    py::object owner;
+    StoragePin pin;
+};
+
+// Operand of the element-wise kernels: a batch, a single row (VectorND or 1D
+// array) broadcast to every row, or a number broadcast everywhere
+struct OperandArg {
+    BatchView view;
+    py::object owner;
+    StoragePin pin;
+};
+
+namespace pybind11 { namespace detail {
+
+// Accepts VectorBatch, NormCachedBatch, MappedVectorBatch, SharedVectorBatch
+// and 2D NumPy arrays without copying
+// float64 C-contiguous data. Lists are rejected so that overloads taking
+// std::vector<VectorND> still handle them.
+template <> struct type_caster<BatchArg> {
+    PYBIND11_TYPE_CASTER(BatchArg, const_name("VectorBatchLike"));
+    
+    bool load(handle src, bool convert) {
+        if (isinstance<VectorBatch>(src)) {
+            const VectorBatch& batch = src.cast<const VectorBatch&>();
+            value = {batch.view(), reinterpret_borrow<object>(src), StoragePin(&batch)};
+            return true;
+        }
+        if (isinstance<NormCachedBatch>(src)) {
+            const NormCachedBatch& batch = src.cast<const NormCachedBatch&>();
+            value = {batch.view(), reinterpret_borrow<object>(src), StoragePin(&batch)};
+            return true;
+        }
+        if (isinstance<MappedVectorBatch>(src)) {
+            value = {src.cast<const MappedVectorBatch&>().view(), reinterpret_borrow<object>(src)};
+            return true;
+        }
+        if (isinstance<SharedVectorBatch>(src)) {
+            value = {src.cast<const SharedVectorBatch&>().view(), reinterpret_borrow<object>(src)};
+            return true;
+        }
+        if (!isinstance<array>(src) || (!convert && !RowArray::check_(src))) {
+            return false;
+        }
+        RowArray rows = RowArray::ensure(src);
+        if (!rows || rows.ndim() != 2) {
+            return false;
+        }
+        size_t dim = static_cast<size_t>(rows.shape(1));
+        value = {BatchView{rows.data(), static_cast<size_t>(rows.shape(0)), dim, dim}, rows};
+        return true;
+    }
+};
+
+template <> struct type_caster<OperandArg> {
+    PYBIND11_TYPE_CASTER(OperandArg, const_name("VectorBatchLike | VectorND | float"));
+    
+    bool load(handle src, bool convert) {
+        make_caster<BatchArg> batch;
+        if (batch.load(src, convert)) {
+            BatchArg& arg = cast_op<BatchArg&>(batch);
+            value = {arg.view, std::move(arg.owner), std::move(arg.pin)};
+            return true;
+        }
+        if (isinstance<VectorND>(src)) {
+            const VectorND& v = src.cast<const VectorND&>();
+            value = {BatchView{v.data().data(), 1, v.size(), v.size()},
+                     reinterpret_borrow<object>(src), StoragePin(&v)};
+            return true;
+        }
+        bool number = PyFloat_Check(src.ptr()) || PyLong_Check(src.ptr());
+        if (!number && (!isinstance<array>(src) || (!convert && !RowArray::check_(src)))) {
+            return false;
+        }
+        RowArray values = RowArray::ensure(src);
+        if (!values || values.ndim() > 1) {
+            return false;
+        }
+        size_t dim = values.ndim() == 0 ? 1 : static_cast<size_t>(values.shape(0));
+        value = {BatchView{values.data(), 1, dim, dim}, values};
+        return true;
+    }
+};
+
+}} // namespace pybind11::detail
+
+static void check_batch_dimensions(const BatchView& view, size_t dimensions) {
+    if (view.dim != dimensions) {
+        throw std::runtime_error(
+            "Dimension mismatch in batch: " + std::to_string(dimensions) +
+            " vs " + std::to_string(view.dim)
+        );
+    }
+}
+
+// Byte view of a contiguous buffer (bytes, bytearray, memoryview, mmap, ...)
+struct ByteBuffer {
+    py::buffer_info info;
+    const unsigned char* data;
+    size_t size;
+};
+
+static ByteBuffer contiguous_bytes(const py::buffer& buffer) {
+    py::buffer_info info = buffer.request();
+    size_t size = static_cast<size_t>(info.size) * static_cast<size_t>(info.itemsize);
+    py::ssize_t expected = info.itemsize;
+    for (py::ssize_t axis = info.ndim - 1; axis >= 0; --axis) {
+        if (info.shape[axis] > 1 && info.strides[axis] != expected) {
+            throw std::runtime_error("Expected a contiguous buffer");
+        }
+        expected *= info.shape[axis];
+    }
+    const unsigned char* data = static_cast<const unsigned char*>(info.ptr);
+    return ByteBuffer{std::move(info), data, size};
+}
+
+// Serializes into a new bytes object without an intermediate copy
+template <typename Value>
+static py::bytes serialized_bytes(const Value& value, size_t count, size_t dimensions) {
+    size_t size = serialized_size(count, dimensions);
+    auto out = py::reinterpret_steal<py::bytes>(
+        PyBytes_FromStringAndSize(nullptr, static_cast<py::ssize_t>(size)));
+    if (!out) {
+        throw py::error_already_set();
+    }
+    unsigned char* data = reinterpret_cast<unsigned char*>(PyBytes_AS_STRING(out.ptr()));
+    {
+        py::gil_scoped_release release;
+        serialize(value, data);
+    }
+    return out;
+}
+
+// Pickle payload for an object exposing its values through the buffer
+// protocol: a PickleBuffer under protocol 5, so the values can travel
+// out-of-band, and a bytes copy under older protocols
+static py::object pickle_payload(py::handle self, const double* values, size_t count,
+                                 int protocol) {
+    if (protocol >= 5) {
+        return py::module_::import("pickle").attr("PickleBuffer")(self);
+    }
+    return py::bytes(reinterpret_cast<const char*>(values), count * sizeof(double));
+}
+
+// Copies a pickled payload back into `count` values
+static void unpickle_values(const ByteBuffer& bytes, double* values, size_t count) {
+    if (bytes.size != count * sizeof(double)) {
+        throw std::runtime_error("Corrupt pickled vector data");
+    }
+    py::gil_scoped_release release;
+    std::memcpy(values, bytes.data, bytes.size);
+}
+
+// Search results as (int64 indices, distances) arrays
+static py::tuple neighbor_arrays(const std::vector<Neighbor>& neighbors) {
+    py::array_t<int64_t> indices(static_cast<py::ssize_t>(neighbors.size()));
+    py::array_t<double> distances(static_cast<py::ssize_t>(neighbors.size()));
+    for (size_t i = 0; i < neighbors.size(); ++i) {
+        indices.mutable_at(i) = static_cast<int64_t>(neighbors[i].index);
+        distances.mutable_at(i) = neighbors[i].distance;
+    }
+    return py::make_tuple(indices, distances);
+}
+
+// Single vector as a one-row batch, which the pairwise kernels broadcast
+static BatchView single_row(const VectorND& v) {
+    return BatchView{v.data().data(), 1, v.size(), v.size()};
+}
+
+// Runs a kernel with the GIL released into a new VectorBatch or into `out`.
+// The kernel works on storage taken out of `out`, so other threads never see
+// it mid-resize. Storage that something else reads must stay put, so the
+// result is then copied over it, which needs a matching shape.
+template <typename Kernel>
+static py::object run_into_batch(py::object out, size_t dimensions, const Kernel& kernel) {
+    VectorBatch result(dimensions);
+    if (out.is_none()) {
+        {
+            py::gil_scoped_release release;
+            kernel(result);
+        }
+        return py::cast(std::move(result));
+    }
+    VectorBatch& target = out.cast<VectorBatch&>();
+    bool pinned = pinned_elsewhere(&target);
+    if (!pinned) {
+        std::swap(result, target);
+    }
+    try {
+        py::gil_scoped_release release;
+        kernel(result);
+    } catch (...) {
+        if (!pinned) {
+            target = std::move(result);
+        }
+        throw;
+    }
+    if (!pinned) {
+        target = std::move(result);
+    } else if (result.size() == target.size() && result.dimensions() == target.dimensions()) {
+        std::copy(result.data(), result.data() + result.size() * result.dimensions(),
+                  target.data());
+    } else {
+        check_resizable(&target);
+        target = std::move(result);
+    }
+    return out;
+}
+
+// Runs a destination overload into a new VectorND or into `out`, which keeps
+// its storage when the size already matches. Single vectors are too small
+// for releasing the GIL to pay off. An exported `out` must keep its storage,
+// so the result is copied over it and has to match its size.
+template <typename Kernel>
+static py::object run_into_vector(py::object out, const Kernel& kernel) {
+    VectorND result(size_t(0));
+    if (out.is_none()) {
+        kernel(result);
+        return py::cast(std::move(result));
+    }
+    VectorND& target = out.cast<VectorND&>();
+    if (!pinned_elsewhere(&target)) {
+        kernel(target);
+        return out;
+    }
+    kernel(result);
+    if (result.size() != target.size()) {
+        check_resizable(&target);
+    }
+    std::copy(result.data().begin(), result.data().end(), target.data().begin());
+    return out;
+}
+
+// Binds name(a, b, out=None) for a batch-to-batch pairwise kernel, with `b`
+// either a batch of matching rows or a single VectorND applied to every row
+static void def_pairwise(py::module &m, const char* name,
+                         void (*kernel)(const BatchView&, const BatchView&, VectorBatch&),
+                         const char* doc) {
+    m.def(name, [kernel](const BatchArg& a, const BatchArg& b, py::object out) {
+        return run_into_batch(out, a.view.dim, [&](VectorBatch& result) {
+            kernel(a.view, b.view, result);
+        });
+    }, py::arg("a"), py::arg("b"), py::arg("out") = py::none(), doc);
+    m.def(name, [kernel](const BatchArg& a, const VectorND& b, py::object out) {
+        StoragePin pin(&b);
+        return run_into_batch(out, a.view.dim, [&](VectorBatch& result) {
+            kernel(a.view, single_row(b), result);
+        });
+    }, py::arg("a"), py::arg("b"), py::arg("out") = py::none(), doc);
+}
+
+// Binds name(a, b, out=None) for a binary element-wise operation
+static void def_elementwise(py::module &m, const char* name, ElementwiseOp op, const char* doc) {
+    m.def(name, [op](const OperandArg& a, const OperandArg& b, py::object out) {
+        return run_into_batch(out, a.view.dim, [&](VectorBatch& result) {
+            batch_elementwise(op, a.view, b.view, result);
+        });
+    }, py::arg("a"), py::arg("b"), py::arg("out") = py::none(), doc);
+}
+
+// Binds name(a, out=None) for a unary element-wise function
+static void def_elementwise(py::module &m, const char* name, ElementwiseFunction fn,
+                            const char* doc) {
+    m.def(name, [fn](const BatchArg& a, py::object out) {
+        return run_into_batch(out, a.view.dim, [&](VectorBatch& result) {
+            batch_elementwise(fn, a.view, result);
+        });
+    }, py::arg("a"), py::arg("out") = py::none(), doc);
+}
+
 void init_vector_module(py::module &m) {
+    // Reduction settings
+    py::enum_<ReductionMode>(m, "ReductionMode")
+        .value("FAST", ReductionMode::Fast)
+        .value("COMPENSATED", ReductionMode::Compensated);
+    
+    m.def("set_reduction_mode", &set_reduction_mode,
+          "Set the default summation mode used by reductions");
+    m.def("get_reduction_mode", &get_reduction_mode,
+          "Get the default summation mode used by reductions");
+    m.def("set_num_threads", &set_num_threads, py::arg("threads"),
+          "Set the number of threads used by batch kernels (0 = hardware default)");
+    m.def("get_num_threads", &get_num_threads,
+          "Get the number of threads used by batch kernels");
+    m.def("set_thread_pinning", &set_thread_pinning, py::arg("enabled"),
+          "Pin pool workers to one CPU each (Linux only)");
+    m.def("get_thread_pinning", &get_thread_pinning,
+          "Get whether pool workers are pinned to CPUs");
+    m.def("set_parallel_threshold", &set_parallel_threshold, py::arg("work"),
+          "Set the work size below which batch kernels stay on the calling thread");
+    m.def("get_parallel_threshold", &get_parallel_threshold,
+          "Get the work size below which batch kernels stay on the calling thread");
+
+    py::enum_<ParallelBackend>(m, "ParallelBackend")
+        .value("NATIVE", ParallelBackend::Native)
+        .value("OPENMP", ParallelBackend::OpenMP)
+        .value("TBB", ParallelBackend::TBB)
+        .value("SERIAL", ParallelBackend::Serial);
+
+    m.def("set_parallel_backend", &set_parallel_backend, py::arg("backend"),
+          "Set the runtime that runs batch kernels in parallel");
+    m.def("get_parallel_backend", &get_parallel_backend,
+          "Get the runtime that runs batch kernels in parallel");
+    m.def("parallel_backend_available", &parallel_backend_available, py::arg("backend"),
+          "Check whether a parallel backend was compiled in");
+
     // VectorND class binding
-    py::class_<VectorND>(m, "VectorND")
+    py::class_<VectorND>(m, "VectorND", py::buffer_protocol())
         // Constructors
         .def(py::init<>())
         .def(py::init<size_t>())
@@ -60,6 +510,30 @@ void init_vector_module(py::module &m) {
                 return py::cast(v.data());
             }, 
             py::return_value_policy::reference_internal)
+        // While a view is alive, resizing raises BufferError
+        .def_buffer([](VectorND& v) -> py::buffer_info {
+            return py::buffer_info(v.data().data(), static_cast<py::ssize_t>(v.size()));
+        })
+        
+        // Serialization
+        .def("to_bytes", [](const VectorND& v) {
+            return serialized_bytes(v, 1, v.size());
+        }, "Serializes to the compact binary vector format")
+        .def_static("from_bytes", [](const py::buffer& data) {
+            ByteBuffer bytes = contiguous_bytes(data);
+            return vector_from_bytes(bytes.data, bytes.size);
+        }, py::arg("data"))
+        .def("__reduce_ex__", [](py::object self, int protocol) {
+            const VectorND& v = self.cast<const VectorND&>();
+            return py::make_tuple(py::type::of<VectorND>(), py::tuple(),
+                                  pickle_payload(self, v.data().data(), v.size(), protocol));
+        })
+        .def("__setstate__", [](VectorND& v, const py::buffer& payload) {
+            ByteBuffer bytes = contiguous_bytes(payload);
+            check_resizable(&v);
+            v.data().resize(bytes.size / sizeof(double));
+            unpickle_values(bytes, v.data().data(), v.size());
+        })
         
         // Operators (using pybind11::operators)
         .def(py::self + py::self)
@@ -68,15 +542,21 @@ void init_vector_module(py::module &m) {
         .def(double() * py::self)
         .def(py::self / double())
         .def(-py::self)
+        // Unhashable: no hash agrees with tolerance equality, so sets and
+        // dicts keyed by vectors are VectorSet and VectorMap
         .def(py::self == py::self)
         .def(py::self != py::self)
         
         // Vector operations
         .def("magnitude", &VectorND::magnitude)
         .def("magnitude_squared", &VectorND::magnitude_squared)
-        .def("normalize", &VectorND::normalize)
+        .def("normalize", [](const VectorND& v, py::object out) {
+            return run_into_vector(out, [&](VectorND& r) { normalize(v, r); });
+        }, py::arg("out") = py::none())
         .def("dot", &VectorND::dot)
-        .def("cross", &VectorND::cross)
+        .def("cross", [](const VectorND& v, const VectorND& other, py::object out) {
+            return run_into_vector(out, [&](VectorND& r) { cross(v, other, r); });
+        }, py::arg("other"), py::arg("out") = py::none())
         .def("is_3d", &VectorND::is_3d)
         
         // Distance and angle
@@ -85,18 +565,31 @@ void init_vector_module(py::module &m) {
         .def("angle_between", &VectorND::angle_between)
         
         // Advanced operations
-        .def("projection", &VectorND::projection)
-        .def("reflection", &VectorND::reflection)
-        .def("rotate", &VectorND::rotate)
+        .def("projection", [](const VectorND& v, const VectorND& onto, py::object out) {
+            return run_into_vector(out, [&](VectorND& r) { projection(v, onto, r); });
+        }, py::arg("onto"), py::arg("out") = py::none())
+        .def("reflection", [](const VectorND& v, const VectorND& normal, py::object out) {
+            return run_into_vector(out, [&](VectorND& r) { reflection(v, normal, r); });
+        }, py::arg("normal"), py::arg("out") = py::none())
+        .def("rotate", [](const VectorND& v, const VectorND& axis, double angle,
+                          py::object out) {
+            return run_into_vector(out, [&](VectorND& r) { rotate(v, axis, angle, r); });
+        }, py::arg("axis"), py::arg("angle"), py::arg("out") = py::none())
         
         // N-dimensional operations
-        .def("lerp", &VectorND::lerp)
+        .def("lerp", [](const VectorND& v, const VectorND& other, double t, py::object out) {
+            return run_into_vector(out, [&](VectorND& r) { lerp(v, other, t, r); });
+        }, py::arg("other"), py::arg("t"), py::arg("out") = py::none())
         .def("cosine_similarity", &VectorND::cosine_similarity)
-        .def("clamp", &VectorND::clamp)
+        .def("clamp", [](const VectorND& v, double min_val, double max_val, py::object out) {
+            return run_into_vector(out, [&](VectorND& r) { clamp(v, min_val, max_val, r); });
+        }, py::arg("min_val"), py::arg("max_val"), py::arg("out") = py::none())
         
         // Resize
-        .def("resize", py::overload_cast<size_t>(&VectorND::resize))
-        .def("resize", py::overload_cast<size_t, double>(&VectorND::resize))
+        .def("resize", [](VectorND& v, size_t size, double value) {
+            check_resizable(&v);
+            v.resize(size, value);
+        }, py::arg("size"), py::arg("value") = 0.0)
         
         // String representation
         .def("__repr__", [](const VectorND& v) {
@@ -123,8 +616,218 @@ void init_vector_module(py::module &m) {
             result += ")";
             return result;
         });
+    pin_exports<VectorND>(m.attr("VectorND"));
+    
+    // Batch operations over contiguous batches (VectorBatch, MappedVectorBatch, 2D arrays)
+    m.def("batch_add", [](const OperandArg& a, const OperandArg& b, py::object out) {
+        return run_into_batch(out, a.view.dim, [&](VectorBatch& result) {
+            batch_elementwise(ElementwiseOp::Add, a.view, b.view, result);
+        });
+    }, py::arg("a"), py::arg("b"), py::arg("out") = py::none(),
+       "Adds corresponding rows of two batches, broadcasting single rows, columns and scalars");
+    
+    m.def("batch_dot_product", [](const BatchArg& v1, const BatchArg& v2) {
+        py::array_t<double> result(static_cast<py::ssize_t>(v1.view.count));
+        double* out = result.mutable_data();
+        py::gil_scoped_release release;
+        batch_dot_product(v1.view, v2.view, out);
+        return result;
+    }, "Calculates dot products for corresponding rows of two batches");
+    
+    m.def("batch_distance", [](const BatchArg& vectors, const VectorND& query) {
+        StoragePin pin(&query);
+        py::array_t<double> result(static_cast<py::ssize_t>(vectors.view.count));
+        double* out = result.mutable_data();
+        py::gil_scoped_release release;
+        batch_distance(vectors.view, query, out);
+        return result;
+    }, py::arg("vectors"), py::arg("query"),
+       "Calculates the Euclidean distance from every row to the query");
+    
+    m.def("batch_norms", [](const BatchArg& vectors) {
+        py::array_t<double> result(static_cast<py::ssize_t>(vectors.view.count));
+        double* out = result.mutable_data();
+        py::gil_scoped_release release;
+        batch_norms(vectors.view, out);
+        return result;
+    }, py::arg("vectors"), "Calculates the magnitude of every row");
+    
+    m.def("batch_cosine_similarity", [](const BatchArg& vectors, const VectorND& query) {
+        StoragePin pin(&query);
+        py::array_t<double> result(static_cast<py::ssize_t>(vectors.view.count));
+        double* out = result.mutable_data();
+        py::gil_scoped_release release;
+        batch_cosine_similarity(vectors.view, query, out);
+        return result;
+    }, py::arg("vectors"), py::arg("query"),
+       "Calculates the cosine similarity of every row with the query");
+    
+    m.def("batch_normalize", [](const BatchArg& vectors, py::object out) {
+        return run_into_batch(out, vectors.view.dim, [&](VectorBatch& result) {
+            batch_normalize(vectors.view, result);
+        });
+    }, py::arg("vectors"), py::arg("out") = py::none(),
+       "Scales every row to unit length into a new batch or into `out`; "
+       "pass the same VectorBatch as `out` to normalize in place");
+    
+    m.def("k_nearest", [](const BatchArg& vectors, const VectorND& query, size_t k) {
+        StoragePin pin(&query);
+        std::vector<Neighbor> neighbors;
+        {
+            py::gil_scoped_release release;
+            neighbors = k_nearest(vectors.view, query, k);
+        }
+        return neighbor_arrays(neighbors);
+    }, py::arg("vectors"), py::arg("query"), py::arg("k"),
+       "Exact k nearest rows to the query; returns (indices, distances), closest first");
+    
+    // Pairwise geometry over rows; `b` may also be a single vector
+    def_pairwise(m, "batch_cross", &batch_cross,
+                 "Cross product of every 3D row of `a` with the matching row of `b`");
+    def_pairwise(m, "batch_project", &batch_project,
+                 "Projection of every row of `a` onto the matching row of `b`");
+    def_pairwise(m, "batch_reflect", &batch_reflect,
+                 "Reflection of every row of `a` about the matching normal in `b`");
+    
+    m.def("batch_angle_between", [](const BatchArg& a, const BatchArg& b) {
+        py::array_t<double> result(static_cast<py::ssize_t>(a.view.count));
+        double* out = result.mutable_data();
+        py::gil_scoped_release release;
+        batch_angle_between(a.view, b.view, out);
+        return result;
+    }, py::arg("a"), py::arg("b"), "Angle in radians between matching rows of `a` and `b`");
+    m.def("batch_angle_between", [](const BatchArg& a, const VectorND& b) {
+        StoragePin pin(&b);
+        py::array_t<double> result(static_cast<py::ssize_t>(a.view.count));
+        double* out = result.mutable_data();
+        py::gil_scoped_release release;
+        batch_angle_between(a.view, single_row(b), out);
+        return result;
+    }, py::arg("a"), py::arg("b"), "Angle in radians between every row of `a` and `b`");
+    
+    // Element-wise math over rows; operands broadcast like 2D NumPy arrays
+    def_elementwise(m, "batch_subtract", ElementwiseOp::Subtract, "Element-wise a - b");
+    def_elementwise(m, "batch_multiply", ElementwiseOp::Multiply, "Element-wise a * b");
+    def_elementwise(m, "batch_divide", ElementwiseOp::Divide,
+                    "Element-wise a / b; raises if any divisor is zero");
+    def_elementwise(m, "batch_minimum", ElementwiseOp::Minimum, "Element-wise minimum");
+    def_elementwise(m, "batch_maximum", ElementwiseOp::Maximum, "Element-wise maximum");
+    def_elementwise(m, "batch_abs", ElementwiseFunction::Abs, "Element-wise absolute value");
+    def_elementwise(m, "batch_sqrt", ElementwiseFunction::Sqrt, "Element-wise square root");
+    def_elementwise(m, "batch_exp", ElementwiseFunction::Exp, "Element-wise exponential");
+    def_elementwise(m, "batch_log", ElementwiseFunction::Log, "Element-wise natural logarithm");
+    m.def("batch_fma", [](const OperandArg& a, const OperandArg& b, const OperandArg& c,
+                          py::object out) {
+        return run_into_batch(out, a.view.dim, [&](VectorBatch& result) {
+            batch_fma(a.view, b.view, c.view, result);
+        });
+    }, py::arg("a"), py::arg("b"), py::arg("c"), py::arg("out") = py::none(),
+       "Element-wise a * b + c with a single rounding");
+    
+    // Epsilon equality over rows, with the per-component test of VectorND ==
+    m.def("batch_isclose", [](const BatchArg& a, const BatchArg& b, double tolerance) {
+        py::array_t<bool> result(static_cast<py::ssize_t>(a.view.count));
+        uint8_t* out = reinterpret_cast<uint8_t*>(result.mutable_data());
+        py::gil_scoped_release release;
+        batch_isclose(a.view, b.view, tolerance, out);
+        return result;
+    }, py::arg("a"), py::arg("b"), py::arg("tolerance") = kEqualityTolerance,
+       "Whether each row of `a` is within `tolerance` of the matching row of `b`");
+    m.def("batch_isclose", [](const BatchArg& a, const VectorND& b, double tolerance) {
+        StoragePin pin(&b);
+        py::array_t<bool> result(static_cast<py::ssize_t>(a.view.count));
+        uint8_t* out = reinterpret_cast<uint8_t*>(result.mutable_data());
+        py::gil_scoped_release release;
+        batch_isclose(a.view, single_row(b), tolerance, out);
+        return result;
+    }, py::arg("a"), py::arg("b"), py::arg("tolerance") = kEqualityTolerance,
+       "Whether each row of `a` is within `tolerance` of `b`");
+    m.def("batch_allclose", [](const BatchArg& a, const BatchArg& b, double tolerance) {
+        py::gil_scoped_release release;
+        return batch_allclose(a.view, b.view, tolerance);
+    }, py::arg("a"), py::arg("b"), py::arg("tolerance") = kEqualityTolerance,
+       "Whether every row of `a` is within `tolerance` of the matching row of `b`");
+    m.def("batch_allclose", [](const BatchArg& a, const VectorND& b, double tolerance) {
+        StoragePin pin(&b);
+        py::gil_scoped_release release;
+        return batch_allclose(a.view, single_row(b), tolerance);
+    }, py::arg("a"), py::arg("b"), py::arg("tolerance") = kEqualityTolerance,
+       "Whether every row of `a` is within `tolerance` of `b`");
+    m.def("find_near_duplicates", [](const BatchArg& vectors, double tolerance) {
+        py::gil_scoped_release release;
+        return find_near_duplicates(vectors.view, tolerance);
+    }, py::arg("vectors"), py::arg("tolerance") = kEqualityTolerance,
+       "Groups of row indices linked by near-duplicate pairs, each sorted, "
+       "ordered by first index; rows with NaN or inf are never grouped");
+    
+    m.def("morton_codes", [](const BatchArg& points, size_t bits) -> py::object {
+        std::vector<uint64_t> codes(points.view.count);
+        {
+            py::gil_scoped_release release;
+            morton_codes(points.view, bits, codes.data());
+        }
+        if (bits == 32) {
+            py::array_t<uint32_t> result(static_cast<py::ssize_t>(codes.size()));
+            std::copy(codes.begin(), codes.end(), result.mutable_data());
+            return result;
+        }
+        return py::array_t<uint64_t>(static_cast<py::ssize_t>(codes.size()), codes.data());
+    }, py::arg("points"), py::arg("bits") = 64,
+       "Z-order codes of 2D or 3D rows within their bounding box, as uint32 or uint64");
+    m.def("morton_order", [](const BatchArg& points, size_t bits) {
+        std::vector<size_t> order;
+        {
+            py::gil_scoped_release release;
+            order = morton_order(points.view, bits);
+        }
+        py::array_t<int64_t> result(static_cast<py::ssize_t>(order.size()));
+        std::copy(order.begin(), order.end(), result.mutable_data());
+        return result;
+    }, py::arg("points"), py::arg("bits") = 64,
+       "Permutation that sorts 2D or 3D rows by Morton code");
+    using KeyArray = py::array_t<uint64_t, py::array::c_style | py::array::forcecast>;
+    using IndexArray = py::array_t<int64_t, py::array::c_style | py::array::forcecast>;
+    m.def("radix_argsort", [](KeyArray keys) {
+        if (keys.ndim() != 1) {
+            throw std::runtime_error("Keys must be a 1D array");
+        }
+        const size_t n = static_cast<size_t>(keys.shape(0));
+        std::vector<size_t> order(n);
+        {
+            py::gil_scoped_release release;
+            radix_argsort(keys.data(), n, order.data());
+        }
+        py::array_t<int64_t> result(static_cast<py::ssize_t>(n));
+        std::copy(order.begin(), order.end(), result.mutable_data());
+        return result;
+    }, py::arg("keys"), "Stable argsort of unsigned 64-bit keys by parallel radix sort");
+    m.def("gather_rows", [](const BatchArg& rows, IndexArray permutation, py::object out) {
+        if (permutation.ndim() != 1) {
+            throw std::runtime_error("Permutation must be a 1D array");
+        }
+        const int64_t* indices = permutation.data();
+        std::vector<size_t> order(indices, indices + permutation.shape(0));
+        return run_into_batch(out, rows.view.dim, [&](VectorBatch& result) {
+            gather_rows(rows.view, order.data(), order.size(), result);
+        });
+    }, py::arg("rows"), py::arg("permutation"), py::arg("out") = py::none(),
+       "Rows in the order of `permutation`, e.g. from morton_order");
+    
+    m.def("centroid", [](const BatchArg& vectors, std::optional<ReductionMode> mode) {
+        py::gil_scoped_release release;
+        return centroid(vectors.view, mode.value_or(get_reduction_mode()));
+    }, py::arg("vectors"), py::arg("mode") = py::none(),
+       "Calculates the centroid of the rows of a batch");
+    
+    m.def("weighted_average", [](const BatchArg& vectors, const std::vector<double>& weights) {
+        if (vectors.view.count != weights.size()) {
+            throw std::runtime_error("Vectors and weights must have the same size");
+        }
+        py::gil_scoped_release release;
+        return weighted_average(vectors.view, weights.data());
+    }, "Calculates weighted average of the rows of a batch");
     
-    // Batch operations
+    // Batch operations over lists of VectorND
     m.def("batch_add", [](const std::vector<VectorND>& v1, 
                           const std::vector<VectorND>& v2) {
         if (v1.size() != v2.size()) {
@@ -147,9 +850,12 @@ void init_vector_module(py::module &m) {
         return result;
     }, "Calculates dot products for corresponding vector pairs");
     
-    m.def("centroid", [](const std::vector<VectorND>& vectors) {
-        return centroid(vectors.data(), vectors.size());
-    }, "Calculates the centroid of a list of vectors");
+    m.def("centroid", [](const std::vector<VectorND>& vectors,
+                         std::optional<ReductionMode> mode) {
+        py::gil_scoped_release release;
+        return centroid(vectors.data(), vectors.size(), mode.value_or(get_reduction_mode()));
+    }, py::arg("vectors"), py::arg("mode") = py::none(),
+       "Calculates the centroid of a list of vectors");
     
     m.def("weighted_average", [](const std::vector<VectorND>& vectors, 
                                 const std::vector<double>& weights) {
@@ -159,25 +865,1263 @@ void init_vector_module(py::module &m) {
         return weighted_average(vectors.data(), weights.data(), vectors.size());
     }, "Calculates weighted average of vectors");
     
+    // Arithmetic with an optional destination
+    m.def("add", [](const VectorND& a, const VectorND& b, py::object out) {
+        return run_into_vector(out, [&](VectorND& r) { add(a, b, r); });
+    }, py::arg("a"), py::arg("b"), py::arg("out") = py::none(),
+       "Adds two vectors, into `out` when given");
+    m.def("subtract", [](const VectorND& a, const VectorND& b, py::object out) {
+        return run_into_vector(out, [&](VectorND& r) { subtract(a, b, r); });
+    }, py::arg("a"), py::arg("b"), py::arg("out") = py::none(),
+       "Subtracts two vectors, into `out` when given");
+    m.def("scale", [](const VectorND& a, double scalar, py::object out) {
+        return run_into_vector(out, [&](VectorND& r) { scale(a, scalar, r); });
+    }, py::arg("a"), py::arg("scalar"), py::arg("out") = py::none(),
+       "Multiplies a vector by a scalar, into `out` when given");
+    m.def("divide", [](const VectorND& a, double scalar, py::object out) {
+        return run_into_vector(out, [&](VectorND& r) { divide(a, scalar, r); });
+    }, py::arg("a"), py::arg("scalar"), py::arg("out") = py::none(),
+       "Divides a vector by a scalar, into `out` when given");
+    
     // Element-wise operations
-    m.def("element_wise_multiply", &element_wise_multiply,
-          "Multiply two vectors element-wise");
-    m.def("element_wise_divide", &element_wise_divide,
-          "Divide two vectors element-wise");
+    m.def("element_wise_multiply", [](const VectorND& a, const VectorND& b, py::object out) {
+        return run_into_vector(out, [&](VectorND& r) { element_wise_multiply(a, b, r); });
+    }, py::arg("v1"), py::arg("v2"), py::arg("out") = py::none(),
+       "Multiply two vectors element-wise");
+    m.def("element_wise_divide", [](const VectorND& a, const VectorND& b, py::object out) {
+        return run_into_vector(out, [&](VectorND& r) { element_wise_divide(a, b, r); });
+    }, py::arg("v1"), py::arg("v2"), py::arg("out") = py::none(),
+       "Divide two vectors element-wise");
     
     // Statistical operations
-    m.def("sum", [](const VectorND& v) { return sum(v); },
+    m.def("sum", [](const VectorND& v, std::optional<ReductionMode> mode) {
+              StoragePin pin(&v);
+              py::gil_scoped_release release;
+              return sum(v, mode.value_or(get_reduction_mode()));
+          }, py::arg("v"), py::arg("mode") = py::none(),
           "Calculate sum of vector elements");
     m.def("max", [](const VectorND& v) { return max(v); },
           "Find maximum element");
     m.def("min", [](const VectorND& v) { return min(v); },
           "Find minimum element");
-    m.def("mean", [](const VectorND& v) { return mean(v); },
+    m.def("mean", [](const VectorND& v, std::optional<ReductionMode> mode) {
+              StoragePin pin(&v);
+              py::gil_scoped_release release;
+              return mean(v, mode.value_or(get_reduction_mode()));
+          }, py::arg("v"), py::arg("mode") = py::none(),
           "Calculate mean of vector elements");
 }
 
+void init_stats_module(py::module &m) {
+    py::class_<OnlineStats::Snapshot>(m, "StatsSnapshot")
+        .def_readonly("count", &OnlineStats::Snapshot::count)
+        .def_readonly("mean", &OnlineStats::Snapshot::mean)
+        .def_readonly("variance", &OnlineStats::Snapshot::variance)
+        .def_readonly("min", &OnlineStats::Snapshot::min)
+        .def_readonly("max", &OnlineStats::Snapshot::max);
+    
+    py::class_<OnlineStats>(m, "OnlineStats")
+        .def(py::init<size_t>(), py::arg("dimensions"))
+        .def_property_readonly("dimensions", &OnlineStats::dimensions)
+        .def_property_readonly("count", &OnlineStats::count)
+        .def("__len__", &OnlineStats::count)
+        
+        // Ingestion
+        .def("add", py::overload_cast<const VectorND&>(&OnlineStats::add),
+             "Adds a single vector")
+        .def("add_batch", [](OnlineStats& stats, const BatchArg& batch) {
+            // Keeps the GIL, which guards the accumulator against concurrent readers
+            check_batch_dimensions(batch.view, stats.dimensions());
+            stats.add_batch(batch.view.data, batch.view.count, batch.view.stride);
+        }, "Adds the rows of a batch or 2D NumPy array")
+        .def("add_batch", [](OnlineStats& stats, const std::vector<VectorND>& vectors) {
+            stats.add_batch(vectors.data(), vectors.size());
+        }, "Adds a list of vectors")
+        .def("merge", &OnlineStats::merge,
+             "Merges an accumulator filled elsewhere, e.g. on another thread")
+        .def("reset", &OnlineStats::reset)
+        .def("copy", [](const OnlineStats& stats) { return OnlineStats(stats); })
+        
+        // Statistics
+        .def("mean", &OnlineStats::mean)
+        .def("variance", &OnlineStats::variance, py::arg("ddof") = 0)
+        .def("covariance_diagonal", &OnlineStats::covariance_diagonal)
+        .def("min", &OnlineStats::min)
+        .def("max", &OnlineStats::max)
+        .def("snapshot", &OnlineStats::snapshot, py::arg("ddof") = 0,
+             "Returns count, mean, variance, min and max in one O(D) call");
+}
+
+// Shared batch ingestion for the centroid trackers
+template <typename Tracker>
+static void tracker_add_vectors(Tracker& tracker, const std::vector<VectorND>& vectors,
+                                const std::optional<std::vector<double>>& weights) {
+    if (weights && weights->size() != vectors.size()) {
+        throw std::runtime_error("Vectors and weights must have the same size");
+    }
+    for (size_t i = 0; i < vectors.size(); ++i) {
+        tracker.add(vectors[i], weights ? (*weights)[i] : 1.0);
+    }
+}
+
+template <typename Tracker>
+static void tracker_add_rows(Tracker& tracker, const BatchArg& batch,
+                             const std::optional<std::vector<double>>& weights) {
+    check_batch_dimensions(batch.view, tracker.dimensions());
+    if (weights && weights->size() != batch.view.count) {
+        throw std::runtime_error("Vectors and weights must have the same size");
+    }
+    // Keeps the GIL: the trackers have no lock of their own
+    tracker.add_batch(batch.view.data, batch.view.count, batch.view.stride,
+                      weights ? weights->data() : nullptr);
+}
+
+void init_tracker_module(py::module &m) {
+    py::class_<SlidingWindowCentroid>(m, "SlidingWindowCentroid")
+        .def(py::init<size_t, size_t>(), py::arg("dimensions"), py::arg("window"))
+        .def_property_readonly("dimensions", &SlidingWindowCentroid::dimensions)
+        .def_property_readonly("window", &SlidingWindowCentroid::window)
+        .def_property_readonly("total_weight", &SlidingWindowCentroid::total_weight)
+        .def("__len__", &SlidingWindowCentroid::size)
+        .def("full", &SlidingWindowCentroid::full)
+        .def("add", py::overload_cast<const VectorND&, double>(&SlidingWindowCentroid::add),
+             py::arg("v"), py::arg("weight") = 1.0)
+        .def("add_batch", &tracker_add_rows<SlidingWindowCentroid>,
+             py::arg("vectors"), py::arg("weights") = py::none())
+        .def("add_batch", &tracker_add_vectors<SlidingWindowCentroid>,
+             py::arg("vectors"), py::arg("weights") = py::none())
+        .def("clear", &SlidingWindowCentroid::clear)
+        .def("centroid", &SlidingWindowCentroid::centroid,
+             "Weighted centroid of the vectors currently in the window");
+    
+    py::class_<DecayedCentroid>(m, "DecayedCentroid")
+        .def(py::init<size_t, double>(), py::arg("dimensions"), py::arg("decay"))
+        .def_property_readonly("dimensions", &DecayedCentroid::dimensions)
+        .def_property_readonly("decay", &DecayedCentroid::decay)
+        .def_property_readonly("count", &DecayedCentroid::count)
+        .def_property_readonly("total_weight", &DecayedCentroid::total_weight)
+        .def("add", py::overload_cast<const VectorND&, double>(&DecayedCentroid::add),
+             py::arg("v"), py::arg("weight") = 1.0)
+        .def("add_batch", &tracker_add_rows<DecayedCentroid>,
+             py::arg("vectors"), py::arg("weights") = py::none())
+        .def("add_batch", &tracker_add_vectors<DecayedCentroid>,
+             py::arg("vectors"), py::arg("weights") = py::none())
+        .def("clear", &DecayedCentroid::clear)
+        .def("centroid", &DecayedCentroid::centroid,
+             "Exponentially decayed weighted mean of all vectors added so far");
+}
+
+void init_batch_module(py::module &m) {
+    py::class_<VectorBatch>(m, "VectorBatch", py::buffer_protocol())
+        .def(py::init<size_t>(), py::arg("dimensions"))
+        .def(py::init([](const BatchArg& batch) {
+            return VectorBatch(batch.view);
+        }), "Copies a batch or 2D NumPy array into a new batch")
+        .def(py::init([](const std::vector<VectorND>& vectors) {
+            return VectorBatch(vectors.data(), vectors.size());
+        }), "Packs a list of equal-length vectors into a contiguous batch")
+        
+        // Exposes rows as a (count, dimensions) float64 buffer; while a view
+        // is alive, calls that would reallocate the rows raise BufferError
+        .def_buffer([](VectorBatch& b) -> py::buffer_info {
+            return py::buffer_info(
+                b.data(), sizeof(double), py::format_descriptor<double>::format(), 2,
+                {b.size(), b.dimensions()},
+                {sizeof(double) * b.dimensions(), sizeof(double)}
+            );
+        })
+        
+        .def_property_readonly("dimensions", &VectorBatch::dimensions)
+        .def("__len__", &VectorBatch::size)
+        .def("__getitem__", [](const VectorBatch& b, size_t i) {
+            if (i >= b.size()) {
+                throw py::index_error("Index out of range");
+            }
+            return b.get(i);
+        })
+        .def("__setitem__", [](VectorBatch& b, size_t i, const VectorND& v) {
+            if (i >= b.size()) {
+                throw py::index_error("Index out of range");
+            }
+            b.set(i, v);
+        })
+        .def("append", [](VectorBatch& b, const VectorND& v) {
+            check_resizable(&b);
+            b.append(v);
+        })
+        .def("reserve", [](VectorBatch& b, size_t count) {
+            check_resizable(&b);
+            b.reserve(count);
+        })
+        .def("resize", [](VectorBatch& b, size_t count) {
+            check_resizable(&b);
+            b.resize(count);
+        })
+        .def("clear", [](VectorBatch& b) {
+            check_resizable(&b);
+            b.clear();
+        })
+        
+        // Serialization
+        .def("to_bytes", [](const VectorBatch& b) {
+            return serialized_bytes(b.view(), b.size(), b.dimensions());
+        }, "Serializes to the compact binary vector format")
+        .def_static("from_bytes", [](const py::buffer& data) {
+            ByteBuffer bytes = contiguous_bytes(data);
+            py::gil_scoped_release release;
+            return batch_from_bytes(bytes.data, bytes.size);
+        }, py::arg("data"), "Reads a serialized batch or vector")
+        .def("__reduce_ex__", [](py::object self, int protocol) {
+            const VectorBatch& b = self.cast<const VectorBatch&>();
+            size_t values = b.size() * b.dimensions();
+            return py::make_tuple(
+                py::type::of<VectorBatch>(), py::make_tuple(b.dimensions()),
+                py::make_tuple(b.size(), pickle_payload(self, b.data(), values, protocol)));
+        })
+        .def("__setstate__", [](VectorBatch& b, const py::tuple& state) {
+            if (state.size() != 2) {
+                throw std::runtime_error("Corrupt pickled vector data");
+            }
+            ByteBuffer bytes = contiguous_bytes(state[1].cast<py::buffer>());
+            check_resizable(&b);
+            b.resize(state[0].cast<size_t>());
+            unpickle_values(bytes, b.data(), b.size() * b.dimensions());
+        });
+    pin_exports<VectorBatch>(m.attr("VectorBatch"));
+}
+
+// Binds a loader as name(path, start=0, count=None, mmap=False) -> VectorBatch
+static void def_loader(py::module &m, const char* name,
+                       VectorBatch (*load)(const std::string&, const LoadOptions&),
+                       const char* doc) {
+    m.def(name, [load](const std::string& path, size_t start, std::optional<size_t> count,
+                       bool mmap) {
+        LoadOptions options;
+        options.start = start;
+        if (count) {
+            options.count = *count;
+        }
+        options.use_mmap = mmap;
+        py::gil_scoped_release release;
+        return load(path, options);
+    }, py::arg("path"), py::arg("start") = 0, py::arg("count") = py::none(),
+       py::arg("mmap") = false, doc);
+}
+
+void init_norm_cache_module(py::module &m) {
+    py::class_<NormCachedBatch>(m, "NormCachedBatch", py::buffer_protocol())
+        .def(py::init<size_t>(), py::arg("dimensions"))
+        .def(py::init([](const BatchArg& batch) {
+            py::gil_scoped_release release;
+            return NormCachedBatch(batch.view);
+        }), "Copies a batch or 2D NumPy array and computes its norms")
+        
+        // Read-only: writes must go through __setitem__ to keep the norms valid
+        .def_buffer([](NormCachedBatch& b) -> py::buffer_info {
+            return py::buffer_info(
+                const_cast<double*>(b.data()), sizeof(double),
+                py::format_descriptor<double>::format(), 2,
+                {b.size(), b.dimensions()},
+                {sizeof(double) * b.dimensions(), sizeof(double)},
+                true
+            );
+        })
+        
+        .def_property_readonly("dimensions", &NormCachedBatch::dimensions)
+        .def_property_readonly("norms", [](const NormCachedBatch& b) {
+            return py::array_t<double>(static_cast<py::ssize_t>(b.size()), b.norms());
+        }, "Copy of the cached row norms")
+        .def("__len__", &NormCachedBatch::size)
+        .def("__getitem__", [](const NormCachedBatch& b, size_t i) {
+            if (i >= b.size()) {
+                throw py::index_error("Index out of range");
+            }
+            return b.get(i);
+        })
+        .def("__setitem__", [](NormCachedBatch& b, size_t i, const VectorND& v) {
+            if (i >= b.size()) {
+                throw py::index_error("Index out of range");
+            }
+            b.set(i, v);
+        })
+        .def("norm", &NormCachedBatch::norm, py::arg("index"))
+        .def("append", [](NormCachedBatch& b, const VectorND& v) {
+            check_resizable(&b);
+            b.append(v);
+        })
+        .def("extend", [](NormCachedBatch& b, const BatchArg& rows) {
+            // Keeps the GIL like VectorBatch.append: growing moves the rows
+            check_resizable(&b);
+            b.append(rows.view);
+        }, "Appends the rows of a batch or 2D NumPy array")
+        .def("reserve", [](NormCachedBatch& b, size_t count) {
+            check_resizable(&b);
+            b.reserve(count);
+        })
+        .def("clear", [](NormCachedBatch& b) {
+            check_resizable(&b);
+            b.clear();
+        })
+        .def("cosine_similarity", [](const NormCachedBatch& b, const VectorND& query) {
+            StoragePin pin(&query);
+            py::array_t<double> result(static_cast<py::ssize_t>(b.size()));
+            double* out = result.mutable_data();
+            py::gil_scoped_release release;
+            b.cosine_similarity(query, out);
+            return result;
+        }, py::arg("query"), "Cosine similarity of every row with the query");
+    pin_exports<NormCachedBatch>(m.attr("NormCachedBatch"));
+}
+
+using PyVectorMap = VectorMap<py::object>;
+
+void init_hash_module(py::module &m) {
+    py::class_<VectorSet>(m, "VectorSet")
+        .def(py::init<size_t, double>(), py::arg("dimensions"),
+             py::arg("tolerance") = kEqualityTolerance)
+        .def(py::init([](const BatchArg& rows, double tolerance) {
+            auto set = std::make_unique<VectorSet>(rows.view.dim, tolerance);
+            py::gil_scoped_release release;
+            set->insert_batch(rows.view, nullptr);
+            return set;
+        }), py::arg("rows"), py::arg("tolerance") = kEqualityTolerance,
+           "Set of the distinct rows of a batch or 2D NumPy array")
+        .def_property_readonly("dimensions", &VectorSet::dimensions)
+        .def_property_readonly("tolerance", &VectorSet::tolerance)
+        .def("__len__", &VectorSet::size)
+        .def("__contains__", &VectorSet::contains)
+        .def("add", &VectorSet::insert, py::arg("vector"),
+             "Adds the vector; returns False if an equal one was already present")
+        .def("discard", &VectorSet::erase, py::arg("vector"),
+             "Removes the equal vector; returns False if there was none")
+        .def("add_batch", [](VectorSet& set, const BatchArg& rows) {
+            py::array_t<bool> result(static_cast<py::ssize_t>(rows.view.count));
+            uint8_t* out = reinterpret_cast<uint8_t*>(result.mutable_data());
+            py::gil_scoped_release release;
+            set.insert_batch(rows.view, out);
+            return result;
+        }, py::arg("rows"), "Adds every row; returns whether each one was new")
+        .def("contains_batch", [](const VectorSet& set, const BatchArg& rows) {
+            py::array_t<bool> result(static_cast<py::ssize_t>(rows.view.count));
+            uint8_t* out = reinterpret_cast<uint8_t*>(result.mutable_data());
+            py::gil_scoped_release release;
+            set.contains_batch(rows.view, out);
+            return result;
+        }, py::arg("rows"), "Whether each row is in the set")
+        .def("to_batch", &VectorSet::to_batch, "Copy of the stored vectors")
+        .def("reserve", &VectorSet::reserve, py::arg("count"))
+        .def("clear", &VectorSet::clear);
+    
+    py::class_<PyVectorMap>(m, "VectorMap")
+        .def(py::init<size_t, double>(), py::arg("dimensions"),
+             py::arg("tolerance") = kEqualityTolerance)
+        .def_property_readonly("dimensions", &PyVectorMap::dimensions)
+        .def_property_readonly("tolerance", &PyVectorMap::tolerance)
+        .def("__len__", &PyVectorMap::size)
+        .def("__contains__", &PyVectorMap::contains)
+        .def("__getitem__", [](const PyVectorMap& map, const VectorND& key) {
+            const py::object* value = map.find(key);
+            if (!value) {
+                throw py::key_error("Vector not in map");
+            }
+            return *value;
+        })
+        .def("__setitem__", [](PyVectorMap& map, const VectorND& key, py::object value) {
+            map.insert_or_assign(key, std::move(value));
+        })
+        .def("__delitem__", [](PyVectorMap& map, const VectorND& key) {
+            if (!map.erase(key)) {
+                throw py::key_error("Vector not in map");
+            }
+        })
+        .def("get", [](const PyVectorMap& map, const VectorND& key, py::object fallback) {
+            const py::object* value = map.find(key);
+            return value ? *value : fallback;
+        }, py::arg("key"), py::arg("default") = py::none())
+        .def("get_batch", [](const PyVectorMap& map, const BatchArg& rows, py::object fallback) {
+            // Keeps the GIL: the map's mutators hold it, so the positions stay
+            // valid until the values are read
+            std::vector<size_t> positions(rows.view.count);
+            map.find_batch(rows.view, positions.data());
+            py::list result(positions.size());
+            for (size_t i = 0; i < positions.size(); ++i) {
+                result[i] = positions[i] == VectorTable::npos ? fallback
+                                                               : map.values()[positions[i]];
+            }
+            return result;
+        }, py::arg("rows"), py::arg("default") = py::none(),
+           "Value for every row, or `default` where the row is not a key")
+        .def("keys", [](const PyVectorMap& map) { return VectorBatch(map.keys()); },
+             "Copy of the keys, in the order of values()")
+        .def("values", [](const PyVectorMap& map) {
+            py::list result;
+            for (const py::object& value : map.values()) {
+                result.append(value);
+            }
+            return result;
+        })
+        .def("reserve", &PyVectorMap::reserve, py::arg("count"))
+        .def("clear", &PyVectorMap::clear);
+}
+
+void init_index_module(py::module &m) {
+    py::enum_<LshMetric>(m, "LshMetric")
+        .value("COSINE", LshMetric::Cosine)
+        .value("EUCLIDEAN", LshMetric::Euclidean);
+    
+    py::class_<LshIndex>(m, "LshIndex")
+        .def(py::init<size_t, LshMetric, size_t, size_t, double, uint64_t>(),
+             py::arg("dimensions"), py::arg("metric") = LshMetric::Cosine,
+             py::arg("tables") = 8, py::arg("hashes") = 16, py::arg("bucket_width") = 4.0,
+             py::arg("seed") = 0)
+        .def_property_readonly("dimensions", &LshIndex::dimensions)
+        .def_property_readonly("metric", &LshIndex::metric)
+        .def_property_readonly("tables", &LshIndex::tables)
+        .def_property_readonly("hashes", &LshIndex::hashes)
+        .def_property_readonly("bucket_width", &LshIndex::bucket_width)
+        .def("__len__", &LshIndex::size)
+        .def("add", &LshIndex::insert, py::arg("vector"), "Adds the vector; returns its id")
+        .def("add_batch", [](LshIndex& index, const BatchArg& rows) {
+            py::gil_scoped_release release;
+            return index.insert_batch(rows.view);
+        }, py::arg("rows"), "Adds every row in parallel; returns the id of the first")
+        .def("candidates", [](const LshIndex& index, const VectorND& query) {
+            StoragePin pin(&query);
+            std::vector<size_t> ids;
+            {
+                py::gil_scoped_release release;
+                ids = index.candidates(query);
+            }
+            py::array_t<int64_t> result(static_cast<py::ssize_t>(ids.size()));
+            std::copy(ids.begin(), ids.end(), result.mutable_data());
+            return result;
+        }, py::arg("query"), "Ids sharing a bucket with the query in any table")
+        .def("query", [](const LshIndex& index, const VectorND& query, size_t k,
+                         size_t max_candidates) {
+            StoragePin pin(&query);
+            std::vector<Neighbor> neighbors;
+            {
+                py::gil_scoped_release release;
+                neighbors = index.query(query, k, max_candidates);
+            }
+            return neighbor_arrays(neighbors);
+        }, py::arg("query"), py::arg("k"), py::arg("max_candidates") = 0,
+           "Approximate k nearest ids; returns (indices, distances), closest first")
+        .def("query_batch", [](const LshIndex& index, const BatchArg& queries, size_t k,
+                               size_t max_candidates) {
+            const py::ssize_t rows = static_cast<py::ssize_t>(queries.view.count);
+            py::array_t<int64_t> indices({rows, static_cast<py::ssize_t>(k)});
+            py::array_t<double> distances({rows, static_cast<py::ssize_t>(k)});
+            int64_t* index_out = indices.mutable_data();
+            double* distance_out = distances.mutable_data();
+            py::gil_scoped_release release;
+            index.query_batch(queries.view, k, max_candidates, index_out, distance_out);
+            return py::make_tuple(indices, distances);
+        }, py::arg("queries"), py::arg("k"), py::arg("max_candidates") = 0,
+           "query() for every row; returns (n, k) indices and distances padded with -1 and NaN")
+        .def("signature", [](const LshIndex& index, const VectorND& vector) {
+            std::vector<uint64_t> words = index.signature_of(vector);
+            py::array_t<uint64_t> result(static_cast<py::ssize_t>(words.size()));
+            std::copy(words.begin(), words.end(), result.mutable_data());
+            return result;
+        }, py::arg("vector"), "Bit-packed hyperplane signature of a vector (cosine only)")
+        .def("hamming_distances", [](const LshIndex& index, const VectorND& query) {
+            StoragePin pin(&query);
+            std::vector<uint32_t> distances;
+            {
+                py::gil_scoped_release release;
+                distances = index.hamming_distances(query);
+            }
+            py::array_t<uint32_t> result(static_cast<py::ssize_t>(distances.size()));
+            std::copy(distances.begin(), distances.end(), result.mutable_data());
+            return result;
+        }, py::arg("query"), "Signature Hamming distance from the query to every id (cosine only)")
+        .def("to_batch", &LshIndex::to_batch, "Copy of the indexed vectors, by id")
+        .def("reserve", &LshIndex::reserve, py::arg("count"))
+        .def("clear", &LshIndex::clear);
+    
+    py::enum_<BvhPrimitive>(m, "BvhPrimitive")
+        .value("TRIANGLE", BvhPrimitive::Triangle)
+        .value("BOX", BvhPrimitive::Box);
+    
+    py::class_<Bvh>(m, "Bvh")
+        .def_static("from_triangles", [](const BatchArg& triangles) {
+            py::gil_scoped_release release;
+            return Bvh::from_triangles(triangles.view);
+        }, py::arg("triangles"), "BVH over rows of 9 values: three xyz vertices")
+        .def_static("from_boxes", [](const BatchArg& boxes) {
+            py::gil_scoped_release release;
+            return Bvh::from_boxes(boxes.view);
+        }, py::arg("boxes"), "BVH over rows of 6 values: xyz minimum, then xyz maximum")
+        .def_property_readonly("primitive", &Bvh::primitive)
+        .def_property_readonly("node_count", [](const Bvh& bvh) { return bvh.nodes().size(); })
+        .def("__len__", &Bvh::size)
+        .def("intersect", [](const Bvh& bvh, const BatchArg& origins,
+                             const OperandArg& directions, double t_max) {
+            const py::ssize_t rows = static_cast<py::ssize_t>(origins.view.count);
+            py::array_t<int64_t> indices(rows);
+            py::array_t<double> t(rows);
+            int64_t* index_out = indices.mutable_data();
+            double* t_out = t.mutable_data();
+            py::gil_scoped_release release;
+            bvh.intersect(origins.view, directions.view, t_max, index_out, t_out);
+            return py::make_tuple(indices, t);
+        }, py::arg("origins"), py::arg("directions"),
+           py::arg("t_max") = std::numeric_limits<double>::infinity(),
+           "Nearest hit per ray; returns (indices, t) with -1 and NaN for misses")
+        .def("intersect_segments", [](const Bvh& bvh, const BatchArg& starts,
+                                      const OperandArg& ends) {
+            const py::ssize_t rows = static_cast<py::ssize_t>(starts.view.count);
+            py::array_t<int64_t> indices(rows);
+            py::array_t<double> t(rows);
+            int64_t* index_out = indices.mutable_data();
+            double* t_out = t.mutable_data();
+            py::gil_scoped_release release;
+            bvh.intersect_segments(starts.view, ends.view, index_out, t_out);
+            return py::make_tuple(indices, t);
+        }, py::arg("starts"), py::arg("ends"),
+           "Nearest hit per segment; returns (indices, t) with t in [0, 1], -1 and NaN for misses")
+        .def("closest_points", [](const Bvh& bvh, const BatchArg& points, double max_distance) {
+            const py::ssize_t rows = static_cast<py::ssize_t>(points.view.count);
+            py::array_t<int64_t> indices(rows);
+            py::array_t<double> distances(rows);
+            py::array_t<double> closest({rows, static_cast<py::ssize_t>(3)});
+            int64_t* index_out = indices.mutable_data();
+            double* distance_out = distances.mutable_data();
+            double* closest_out = closest.mutable_data();
+            py::gil_scoped_release release;
+            bvh.closest_points(points.view, max_distance, index_out, distance_out, closest_out);
+            return py::make_tuple(indices, distances, closest);
+        }, py::arg("points"), py::arg("max_distance") = std::numeric_limits<double>::infinity(),
+           "Nearest primitive per point; returns (indices, distances, (n, 3) points), "
+           "-1 and NaN beyond max_distance");
+}
+
+void init_store_module(py::module &m) {
+    py::class_<MappedVectorBatch> mapped(m, "MappedVectorBatch", py::buffer_protocol());
+    
+    py::enum_<MappedVectorBatch::Access>(mapped, "Access")
+        .value("NORMAL", MappedVectorBatch::Access::Normal)
+        .value("SEQUENTIAL", MappedVectorBatch::Access::Sequential)
+        .value("RANDOM", MappedVectorBatch::Access::Random)
+        .value("WILLNEED", MappedVectorBatch::Access::WillNeed);
+    
+    mapped
+        .def(py::init<const std::string&>(), py::arg("path"))
+        .def_buffer([](MappedVectorBatch& b) -> py::buffer_info {
+            return py::buffer_info(
+                const_cast<double*>(b.data()), sizeof(double),
+                py::format_descriptor<double>::format(), 2,
+                {b.size(), b.dimensions()},
+                {sizeof(double) * b.dimensions(), sizeof(double)},
+                true
+            );
+        })
+        .def_property_readonly("dimensions", &MappedVectorBatch::dimensions)
+        .def_property_readonly("path", &MappedVectorBatch::path)
+        .def("__len__", &MappedVectorBatch::size)
+        .def("__getitem__", [](const MappedVectorBatch& b, size_t i) {
+            if (i >= b.size()) {
+                throw py::index_error("Index out of range");
+            }
+            return b.get(i);
+        })
+        .def("advise", &MappedVectorBatch::advise, py::arg("access"),
+             "Hints the expected access pattern to the OS")
+        .def("to_bytes", [](const MappedVectorBatch& b) {
+            return serialized_bytes(b.view(), b.size(), b.dimensions());
+        }, "Copies the rows into the compact binary vector format")
+        // Pickles by path; the receiving process maps the same file
+        .def("__reduce__", [](const MappedVectorBatch& b) {
+            return py::make_tuple(py::type::of<MappedVectorBatch>(), py::make_tuple(b.path()));
+        });
+    
+    py::class_<VectorFileWriter>(m, "VectorFileWriter")
+        .def(py::init<const std::string&, size_t, bool, size_t>(),
+             py::arg("path"), py::arg("dimensions"), py::arg("append") = false,
+             py::arg("alignment") = kDefaultFileAlignment)
+        .def_property_readonly("dimensions", &VectorFileWriter::dimensions)
+        .def_property_readonly("count", &VectorFileWriter::count)
+        .def("write", py::overload_cast<const VectorND&>(&VectorFileWriter::write))
+        .def("write_batch", [](VectorFileWriter& w, const BatchArg& batch) {
+            // Keeps the GIL, which orders it with write, flush and close
+            w.write(batch.view);
+        }, "Appends the rows of a batch or 2D NumPy array")
+        .def("write_batch", [](VectorFileWriter& w, const std::vector<VectorND>& vectors) {
+            for (const auto& v : vectors) {
+                w.write(v);
+            }
+        }, "Appends a list of vectors")
+        .def("flush", &VectorFileWriter::flush)
+        .def("close", &VectorFileWriter::close)
+        .def("__enter__", [](VectorFileWriter& w) -> VectorFileWriter& { return w; },
+             py::return_value_policy::reference)
+        .def("__exit__", [](VectorFileWriter& w, py::args) { w.close(); });
+    
+    def_loader(m, "load_fvecs", &load_fvecs, "Reads a .fvecs file into a VectorBatch");
+    def_loader(m, "load_ivecs", &load_ivecs, "Reads an .ivecs file into a VectorBatch");
+    def_loader(m, "load_bvecs", &load_bvecs, "Reads a .bvecs file into a VectorBatch");
+    def_loader(m, "load_npy", &load_npy, "Reads a 1D or 2D .npy array into a VectorBatch");
+    def_loader(m, "load_vectors", &load_vectors,
+               "Reads .fvecs, .ivecs, .bvecs, .npy or .vec files, chosen by extension");
+}
+
+void init_shared_module(py::module &m) {
+    py::class_<SharedVectorBatch>(m, "SharedVectorBatch", py::buffer_protocol())
+        .def(py::init(&SharedVectorBatch::attach), py::arg("name"), py::arg("read_only") = true,
+             "Attaches to a segment created by SharedVectorBatch.create in any process")
+        .def_static("create", &SharedVectorBatch::create,
+                    py::arg("name"), py::arg("count"), py::arg("dimensions"),
+                    "Creates a new zero-filled segment; fails if the name exists")
+        .def_buffer([](SharedVectorBatch& b) -> py::buffer_info {
+            return py::buffer_info(
+                const_cast<double*>(b.data()), sizeof(double),
+                py::format_descriptor<double>::format(), 2,
+                {b.size(), b.dimensions()},
+                {sizeof(double) * b.dimensions(), sizeof(double)},
+                b.read_only()
+            );
+        })
+        .def_property_readonly("name", &SharedVectorBatch::name)
+        .def_property_readonly("dimensions", &SharedVectorBatch::dimensions)
+        .def_property_readonly("read_only", &SharedVectorBatch::read_only)
+        .def("__len__", &SharedVectorBatch::size)
+        .def("__getitem__", [](const SharedVectorBatch& b, size_t i) {
+            if (i >= b.size()) {
+                throw py::index_error("Index out of range");
+            }
+            return b.get(i);
+        })
+        .def("__setitem__", [](SharedVectorBatch& b, size_t i, const VectorND& v) {
+            if (i >= b.size()) {
+                throw py::index_error("Index out of range");
+            }
+            b.set(i, v);
+        })
+        .def("assign", [](SharedVectorBatch& b, const BatchArg& batch, size_t offset) {
+            // Keeps the GIL like item assignment; other processes synchronize themselves
+            b.assign(batch.view, offset);
+        }, py::arg("batch"), py::arg("offset") = 0,
+           "Copies the rows of a batch or 2D NumPy array starting at row `offset`")
+        .def("unlink", [](const SharedVectorBatch& b) { SharedVectorBatch::unlink(b.name()); },
+             "Removes the segment name; attached processes keep their mappings")
+        // Pickles by name, so pool workers attach to the same segment
+        .def("__reduce__", [](const SharedVectorBatch& b) {
+            return py::make_tuple(py::type::of<SharedVectorBatch>(),
+                                  py::make_tuple(b.name(), b.read_only()));
+        });
+}
+
+// Context manager around PoolScope; the scope must open and close on the
+// same thread, which a `with` block guarantees
+class PythonPoolScope {
+public:
+    void enter() {
+        if (!scope_) {
+            scope_.reset(new PoolScope());
+        }
+    }
+    void exit() { scope_.reset(); }
+
+private:
+    std::unique_ptr<PoolScope> scope_;
+};
+
+void init_memory_module(py::module &m) {
+    py::class_<AllocatorStats>(m, "AllocatorStats")
+        .def_readonly("allocations", &AllocatorStats::allocations)
+        .def_readonly("pool_hits", &AllocatorStats::pool_hits)
+        .def_readonly("system_allocations", &AllocatorStats::system_allocations)
+        .def_readonly("system_frees", &AllocatorStats::system_frees)
+        .def_readonly("pooled_bytes", &AllocatorStats::pooled_bytes)
+        .def("__repr__", [](const AllocatorStats& s) {
+            return "AllocatorStats(allocations=" + std::to_string(s.allocations) +
+                   ", pool_hits=" + std::to_string(s.pool_hits) +
+                   ", system_allocations=" + std::to_string(s.system_allocations) +
+                   ", system_frees=" + std::to_string(s.system_frees) +
+                   ", pooled_bytes=" + std::to_string(s.pooled_bytes) + ")";
+        });
+    
+    py::class_<PythonPoolScope>(m, "PoolScope")
+        .def(py::init<>())
+        .def("__enter__", [](PythonPoolScope& s) -> PythonPoolScope& {
+            s.enter();
+            return s;
+        }, py::return_value_policy::reference)
+        .def("__exit__", [](PythonPoolScope& s, py::args) { s.exit(); });
+    
+    m.def("arena", []() { return PythonPoolScope(); },
+          "Context manager pooling VectorND storage on the calling thread");
+    m.def("allocator_stats", &allocator_stats,
+          "Allocation counters of the calling thread");
+    m.def("reset_allocator_stats", &reset_allocator_stats);
+    m.def("release_pooled_memory", &release_pooled_memory,
+          "Frees the blocks cached by the calling thread's pool");
+}
+
+void init_transform_module(py::module &m) {
+    py::class_<Matrix>(m, "Matrix", py::buffer_protocol())
+        .def(py::init<size_t, size_t>(), py::arg("rows"), py::arg("cols"),
+             "Zero matrix of the given shape")
+        .def(py::init([](const RowArray& values) {
+            if (values.ndim() != 2) {
+                throw std::runtime_error("Matrix requires a 2D array or nested list");
+            }
+            return Matrix(values.shape(0), values.shape(1), values.data());
+        }), py::arg("values"), "Copies a 2D NumPy array or nested list of rows")
+        
+        .def_buffer([](Matrix& mat) -> py::buffer_info {
+            return py::buffer_info(
+                mat.data(), sizeof(double), py::format_descriptor<double>::format(), 2,
+                {mat.rows(), mat.cols()},
+                {sizeof(double) * mat.cols(), sizeof(double)}
+            );
+        })
+        
+        .def_static("identity", &Matrix::identity, py::arg("n"))
+        .def_static("rotation", &Matrix::rotation, py::arg("axis"), py::arg("angle"),
+                    "3x3 matrix rotating like VectorND.rotate(axis, angle)")
+        .def_property_readonly("rows", &Matrix::rows)
+        .def_property_readonly("cols", &Matrix::cols)
+        .def("__getitem__", [](const Matrix& mat, std::pair<size_t, size_t> index) {
+            if (index.first >= mat.rows() || index.second >= mat.cols()) {
+                throw py::index_error("Matrix index out of range");
+            }
+            return mat(index.first, index.second);
+        })
+        .def("__setitem__", [](Matrix& mat, std::pair<size_t, size_t> index, double value) {
+            if (index.first >= mat.rows() || index.second >= mat.cols()) {
+                throw py::index_error("Matrix index out of range");
+            }
+            mat(index.first, index.second) = value;
+        })
+        .def("transpose", &Matrix::transpose)
+        .def("__matmul__", py::overload_cast<const Matrix&>(&Matrix::operator*, py::const_),
+             py::is_operator())
+        .def("__matmul__", py::overload_cast<const VectorND&>(&Matrix::operator*, py::const_),
+             py::is_operator())
+        .def(py::self == py::self)
+        .def(py::self != py::self)
+        .def("__repr__", [](const Matrix& mat) {
+            return "Matrix(" + std::to_string(mat.rows()) + "x" + std::to_string(mat.cols()) + ")";
+        });
+    
+    py::implicitly_convertible<py::array, Matrix>();
+    py::implicitly_convertible<py::list, Matrix>();
+    
+    m.def("transform", [](const BatchArg& vectors, const Matrix& mat, py::object out) {
+        return run_into_batch(out, mat.rows(), [&](VectorBatch& result) {
+            transform(vectors.view, mat, result);
+        });
+    }, py::arg("vectors"), py::arg("m"), py::arg("out") = py::none(),
+       "Applies M to every row (rows @ M.T) into a new batch or into `out`");
+    
+    m.def("transform_affine", [](const BatchArg& vectors, const Matrix& mat,
+                                 std::optional<VectorND> t, py::object out) {
+        return run_into_batch(out, vectors.view.dim, [&](VectorBatch& result) {
+            if (t) {
+                transform_affine(vectors.view, mat, *t, result);
+            } else {
+                transform_affine(vectors.view, mat, result);
+            }
+        });
+    }, py::arg("vectors"), py::arg("m"), py::arg("t") = py::none(), py::arg("out") = py::none(),
+       "Applies M * row + t to every row; without `t`, `m` is a homogeneous "
+       "(d+1)x(d+1) matrix such as a 4x4 transform of 3D points");
+    
+    py::enum_<ProjectionKind>(m, "ProjectionKind")
+        .value("GAUSSIAN", ProjectionKind::Gaussian)
+        .value("SPARSE", ProjectionKind::Sparse);
+    
+    py::class_<RandomProjection>(m, "RandomProjection")
+        .def(py::init<size_t, size_t, ProjectionKind, double, uint64_t>(),
+             py::arg("input_dimensions"), py::arg("output_dimensions"),
+             py::arg("kind") = ProjectionKind::Gaussian, py::arg("density") = 0.0,
+             py::arg("seed") = 0)
+        .def_property_readonly("input_dimensions", &RandomProjection::input_dimensions)
+        .def_property_readonly("output_dimensions", &RandomProjection::output_dimensions)
+        .def_property_readonly("kind", &RandomProjection::kind)
+        .def_property_readonly("density", &RandomProjection::density)
+        .def_property_readonly("matrix", &RandomProjection::matrix)
+        .def("transform", [](const RandomProjection& projection, const BatchArg& rows,
+                             py::object out) {
+            return run_into_batch(out, projection.output_dimensions(), [&](VectorBatch& result) {
+                projection.transform(rows.view, result);
+            });
+        }, py::arg("rows"), py::arg("out") = py::none(),
+           "Projects every row into a new batch or into `out`");
+    
+    py::class_<Pca>(m, "Pca")
+        .def(py::init<size_t, size_t, uint64_t>(), py::arg("dimensions"), py::arg("components"),
+             py::arg("seed") = 0)
+        .def_property_readonly("dimensions", &Pca::dimensions)
+        .def_property_readonly("components_count", &Pca::components_count)
+        .def_property_readonly("count", &Pca::count)
+        .def_property_readonly("fitted", &Pca::fitted)
+        .def_property_readonly("mean", &Pca::mean)
+        .def_property_readonly("components", &Pca::components)
+        .def_property_readonly("explained_variance", [](const Pca& pca) {
+            const std::vector<double>& variance = pca.explained_variance();
+            return py::array_t<double>(static_cast<py::ssize_t>(variance.size()),
+                                       variance.data());
+        })
+        .def("partial_fit", [](Pca& pca, const BatchArg& rows) {
+            py::gil_scoped_release release;
+            pca.partial_fit(rows.view);
+        }, py::arg("rows"), "Folds rows into the mean and covariance; call fit() to update")
+        .def("fit", [](Pca& pca) {
+            py::gil_scoped_release release;
+            pca.fit();
+        }, "Computes the components of all rows folded in so far")
+        .def("fit", [](Pca& pca, const BatchArg& rows) {
+            py::gil_scoped_release release;
+            pca.fit(rows.view);
+        }, py::arg("rows"), "Discards earlier rows and fits these")
+        .def("transform", [](const Pca& pca, const BatchArg& rows, py::object out) {
+            return run_into_batch(out, pca.components_count(), [&](VectorBatch& result) {
+                pca.transform(rows.view, result);
+            });
+        }, py::arg("rows"), py::arg("out") = py::none(),
+           "Coordinates of every row along the components")
+        .def("inverse_transform", [](const Pca& pca, const BatchArg& coordinates,
+                                     py::object out) {
+            return run_into_batch(out, pca.dimensions(), [&](VectorBatch& result) {
+                pca.inverse_transform(coordinates.view, result);
+            });
+        }, py::arg("coordinates"), py::arg("out") = py::none(),
+           "Rows rebuilt from their component coordinates")
+        .def("reset", &Pca::reset);
+}
+
+// Index and value arrays for the sparse types
+using IndexArray = py::array_t<int64_t, py::array::c_style | py::array::forcecast>;
+
+static std::vector<SparseIndex> sparse_indices(const IndexArray& array) {
+    std::vector<SparseIndex> indices(static_cast<size_t>(array.size()));
+    const int64_t* data = array.data();
+    for (size_t k = 0; k < indices.size(); ++k) {
+        if (data[k] < 0 || data[k] > std::numeric_limits<SparseIndex>::max()) {
+            throw std::out_of_range("Sparse index out of range");
+        }
+        indices[k] = static_cast<SparseIndex>(data[k]);
+    }
+    return indices;
+}
+
+static std::vector<double> sparse_values(const RowArray& array) {
+    return std::vector<double>(array.data(), array.data() + array.size());
+}
+
+template <typename T>
+static py::array_t<T> array_copy(const std::vector<T>& values) {
+    return py::array_t<T>(static_cast<py::ssize_t>(values.size()), values.data());
+}
+
+// Runs a per-row scan into a new NumPy array with the GIL released
+template <typename Scan>
+static py::array_t<double> scan_rows(const SparseBatch& batch, const Scan& scan) {
+    py::array_t<double> result(static_cast<py::ssize_t>(batch.size()));
+    double* out = result.mutable_data();
+    py::gil_scoped_release release;
+    scan(out);
+    return result;
+}
+
+void init_sparse_module(py::module &m) {
+    py::class_<SparseVectorND>(m, "SparseVectorND")
+        .def(py::init<size_t>(), py::arg("dimensions"))
+        .def(py::init([](size_t dimensions, const IndexArray& indices, const RowArray& values) {
+            return SparseVectorND(dimensions, sparse_indices(indices), sparse_values(values));
+        }), py::arg("dimensions"), py::arg("indices"), py::arg("values"),
+           "Entries may be given in any order; repeated indices are summed")
+        .def_static("from_dense", &SparseVectorND::from_dense, py::arg("dense"))
+        
+        .def_property_readonly("dimensions", &SparseVectorND::dimensions)
+        .def_property_readonly("nnz", &SparseVectorND::nnz)
+        .def_property_readonly("indices", [](const SparseVectorND& v) {
+            return array_copy(v.indices());
+        }, "Copy of the stored indices, ascending")
+        .def_property_readonly("values", [](const SparseVectorND& v) {
+            return array_copy(v.values());
+        }, "Copy of the stored values")
+        .def("__getitem__", &SparseVectorND::get)
+        .def("to_dense", &SparseVectorND::to_dense)
+        
+        // Operators
+        .def("__add__", py::overload_cast<const SparseVectorND&>(
+            &SparseVectorND::operator+, py::const_), py::is_operator())
+        .def("__add__", py::overload_cast<const VectorND&>(
+            &SparseVectorND::operator+, py::const_), py::is_operator())
+        .def(py::self - py::self)
+        .def(py::self * double())
+        .def("__rmul__", [](const SparseVectorND& v, double scalar) {
+            return v * scalar;
+        }, py::is_operator())
+        .def(py::self == py::self)
+        .def(py::self != py::self)
+        
+        // Vector operations
+        .def("magnitude", &SparseVectorND::magnitude)
+        .def("magnitude_squared", &SparseVectorND::magnitude_squared)
+        .def("dot", py::overload_cast<const SparseVectorND&>(&SparseVectorND::dot, py::const_))
+        .def("dot", py::overload_cast<const VectorND&>(&SparseVectorND::dot, py::const_))
+        .def("cosine_similarity", py::overload_cast<const SparseVectorND&>(
+            &SparseVectorND::cosine_similarity, py::const_))
+        .def("cosine_similarity", py::overload_cast<const VectorND&>(
+            &SparseVectorND::cosine_similarity, py::const_))
+        .def("__repr__", [](const SparseVectorND& v) {
+            return "SparseVectorND(dimensions=" + std::to_string(v.dimensions()) +
+                   ", nnz=" + std::to_string(v.nnz()) + ")";
+        });
+    
+    py::class_<SparseBatch>(m, "SparseBatch")
+        .def(py::init<size_t>(), py::arg("dimensions"))
+        .def(py::init([](size_t dimensions, const IndexArray& indptr, const IndexArray& indices,
+                         const RowArray& values) {
+            std::vector<uint64_t> pointers(static_cast<size_t>(indptr.size()));
+            for (size_t r = 0; r < pointers.size(); ++r) {
+                if (indptr.data()[r] < 0) {
+                    throw std::runtime_error("Invalid CSR row pointers");
+                }
+                pointers[r] = static_cast<uint64_t>(indptr.data()[r]);
+            }
+            return SparseBatch(dimensions, std::move(pointers), sparse_indices(indices),
+                               sparse_values(values));
+        }), py::arg("dimensions"), py::arg("indptr"), py::arg("indices"), py::arg("values"),
+           "Builds a batch from CSR arrays, e.g. "
+           "SparseBatch(m.shape[1], m.indptr, m.indices, m.data) for a scipy.sparse.csr_matrix")
+        
+        .def_property_readonly("dimensions", &SparseBatch::dimensions)
+        .def_property_readonly("nnz", &SparseBatch::nnz)
+        .def_property_readonly("indptr", [](const SparseBatch& b) {
+            return array_copy(b.indptr());
+        })
+        .def_property_readonly("indices", [](const SparseBatch& b) {
+            return array_copy(b.indices());
+        })
+        .def_property_readonly("values", [](const SparseBatch& b) {
+            return array_copy(b.values());
+        })
+        .def("__len__", &SparseBatch::size)
+        .def("__getitem__", &SparseBatch::get)
+        .def("append", &SparseBatch::append)
+        .def("reserve", &SparseBatch::reserve, py::arg("rows"), py::arg("nnz"))
+        .def("clear", &SparseBatch::clear)
+        .def("to_dense", &SparseBatch::to_dense, py::call_guard<py::gil_scoped_release>())
+        
+        // Corpus scans
+        .def("dot", [](const SparseBatch& b, const SparseVectorND& query) {
+            return scan_rows(b, [&](double* out) { sparse_batch_dot(b, query, out); });
+        }, py::arg("query"), "Dot product of every row with the query")
+        .def("dot", [](const SparseBatch& b, const VectorND& query) {
+            return scan_rows(b, [&](double* out) { sparse_batch_dot(b, query, out); });
+        }, py::arg("query"))
+        .def("cosine_similarity", [](const SparseBatch& b, const SparseVectorND& query) {
+            return scan_rows(b, [&](double* out) {
+                sparse_batch_cosine_similarity(b, query, out);
+            });
+        }, py::arg("query"), "Cosine similarity of every row with the query")
+        .def("cosine_similarity", [](const SparseBatch& b, const VectorND& query) {
+            StoragePin pin(&query);
+            return scan_rows(b, [&](double* out) {
+                sparse_batch_cosine_similarity(b, query, out);
+            });
+        }, py::arg("query"));
+}
+
+void init_concurrent_module(py::module &m) {
+    py::class_<ConcurrentVectorStore>(m, "ConcurrentVectorStore")
+        .def(py::init<size_t, size_t>(), py::arg("dimensions"), py::arg("segment_rows") = 4096)
+        .def_property_readonly("dimensions", &ConcurrentVectorStore::dimensions)
+        .def_property_readonly("segment_rows", &ConcurrentVectorStore::segment_rows)
+        .def("__len__", &ConcurrentVectorStore::size)
+        .def("append", [](ConcurrentVectorStore& store, const VectorND& vector) {
+            StoragePin pin(&vector);
+            py::gil_scoped_release release;
+            return store.append(vector);
+        }, py::arg("vector"), "Appends a vector and returns its index")
+        .def("extend", [](ConcurrentVectorStore& store, const BatchArg& rows) {
+            py::gil_scoped_release release;
+            return store.append(rows.view);
+        }, py::arg("rows"), "Appends the rows of a batch or 2D NumPy array and returns the "
+           "index of the first one")
+        .def("remove", &ConcurrentVectorStore::remove, py::arg("index"),
+             py::call_guard<py::gil_scoped_release>(),
+             "Marks a row deleted; returns False if it already was")
+        .def("collect", &ConcurrentVectorStore::collect, py::call_guard<py::gil_scoped_release>(),
+             "Frees deleted segments that no snapshot can still read")
+        .def("snapshot", &ConcurrentVectorStore::snapshot, py::keep_alive<0, 1>(),
+             "Consistent view of the rows committed so far");
+    
+    py::class_<StoreSnapshot>(m, "StoreSnapshot")
+        .def_property_readonly("dimensions", &StoreSnapshot::dimensions)
+        .def("__len__", &StoreSnapshot::size)
+        .def("__getitem__", &StoreSnapshot::get)
+        .def("is_deleted", &StoreSnapshot::is_deleted, py::arg("index"))
+        .def("k_nearest", [](const StoreSnapshot& snapshot, const VectorND& query, size_t k) {
+            StoragePin pin(&query);
+            std::vector<Neighbor> neighbors;
+            {
+                py::gil_scoped_release release;
+                neighbors = k_nearest(snapshot, query, k);
+            }
+            return neighbor_arrays(neighbors);
+        }, py::arg("query"), py::arg("k"),
+           "Exact k nearest live rows; returns (indices, distances), closest first")
+        .def("to_batch", [](const StoreSnapshot& snapshot) {
+            std::vector<size_t> indices;
+            VectorBatch rows(snapshot.dimensions());
+            {
+                py::gil_scoped_release release;
+                rows = snapshot.to_batch(indices);
+            }
+            py::array_t<int64_t> positions(static_cast<py::ssize_t>(indices.size()));
+            std::copy(indices.begin(), indices.end(), positions.mutable_data());
+            return py::make_tuple(positions, std::move(rows));
+        }, "Copies the live rows; returns (indices, VectorBatch)")
+        .def("release", &StoreSnapshot::release)
+        .def("__enter__", [](StoreSnapshot& snapshot) -> StoreSnapshot& {
+            return snapshot;
+        }, py::return_value_policy::reference)
+        .def("__exit__", [](StoreSnapshot& snapshot, py::args) { snapshot.release(); });
+}
+
+// Python handle of an AsyncJob: owns the inputs the job reads without the
+// GIL, pins their storage until the job is drained, and converts its output
+// once, when first asked for
+struct PyAsyncJob {
+    std::shared_ptr<AsyncJob> job;
+    py::object inputs;
+    std::vector<StoragePin> pins;
+    std::function<py::object()> output;
+    py::object value;
+
+    py::object result() {
+        switch (job->state()) {
+            case JobState::Done:
+                if (!value) {
+                    value = output();
+                }
+                return value;
+            case JobState::Failed:
+                job->rethrow();
+                break;
+            case JobState::Cancelled:
+                throw std::runtime_error("Job was cancelled");
+            default:
+                break;
+        }
+        throw std::runtime_error("Job has not finished");
+    }
+};
+
+// AsyncExecutor plus the handles of its undrained jobs, so job inputs stay
+// alive until the job is reported finished
+struct PyAsyncExecutor {
+    std::unique_ptr<AsyncExecutor> executor;
+    std::unordered_map<uint64_t, std::shared_ptr<PyAsyncJob>> pending;
+
+    PyAsyncExecutor(size_t max_in_flight, size_t dispatchers)
+        : executor(new AsyncExecutor(max_in_flight, dispatchers)) {}
+
+    ~PyAsyncExecutor() {
+        py::gil_scoped_release release;
+        executor->close();
+    }
+
+    std::shared_ptr<PyAsyncJob> submit(py::object inputs, std::vector<StoragePin> pins,
+                                       std::function<py::object()> output,
+                                       AsyncJob::Work work) {
+        auto handle = std::make_shared<PyAsyncJob>();
+        handle->job = executor->submit(std::move(work));
+        handle->inputs = std::move(inputs);
+        handle->pins = std::move(pins);
+        handle->output = std::move(output);
+        pending.emplace(handle->job->id(), handle);
+        return handle;
+    }
+
+    std::vector<std::shared_ptr<PyAsyncJob>> drain() {
+        std::vector<std::shared_ptr<PyAsyncJob>> handles;
+        for (const auto& job : executor->drain()) {
+            auto it = pending.find(job->id());
+            if (it != pending.end()) {
+                it->second->pins.clear();
+                handles.push_back(std::move(it->second));
+                pending.erase(it);
+            }
+        }
+        return handles;
+    }
+    
+    // Cancels queued jobs and waits for running ones, after which nothing
+    // reads the inputs of the undrained jobs
+    void close() {
+        {
+            py::gil_scoped_release release;
+            executor->close();
+        }
+        for (auto& entry : pending) {
+            entry.second->pins.clear();
+        }
+    }
+};
+
+static void check_same_rows(const BatchView& a, const BatchView& b, const char* operation) {
+    if (a.count != b.count) {
+        throw std::runtime_error(
+            std::string("Batch size mismatch in ") + operation + ": " +
+            std::to_string(a.count) + " vs " + std::to_string(b.count)
+        );
+    }
+    if (a.dim != b.dim) {
+        throw std::runtime_error(
+            std::string("Dimension mismatch in ") + operation + ": " +
+            std::to_string(a.dim) + " vs " + std::to_string(b.dim)
+        );
+    }
+}
+
+// Submits a row-wise kernel writing one double per row; the rows are
+// processed in chunks so a cancelled job stops early
+template <typename Kernel>
+static std::shared_ptr<PyAsyncJob> submit_per_row(PyAsyncExecutor& self, py::object inputs,
+                                                  std::vector<StoragePin> pins,
+                                                  const BatchView& rows, const Kernel& kernel) {
+    py::array_t<double> result(static_cast<py::ssize_t>(rows.count));
+    double* out = result.mutable_data();
+    return self.submit(std::move(inputs), std::move(pins),
+                       [result] { return py::object(result); },
+                       [rows, out, kernel](const AsyncJob& job) {
+        for_each_job_chunk(job, rows.count, rows.dim, [&](size_t begin, size_t end) {
+            kernel(begin, end, out + begin);
+        });
+    });
+}
+
+void init_async_module(py::module &m) {
+    py::enum_<JobState>(m, "JobState")
+        .value("PENDING", JobState::Pending)
+        .value("RUNNING", JobState::Running)
+        .value("DONE", JobState::Done)
+        .value("FAILED", JobState::Failed)
+        .value("CANCELLED", JobState::Cancelled);
+    
+    py::class_<PyAsyncJob, std::shared_ptr<PyAsyncJob>>(m, "AsyncJob")
+        .def_property_readonly("id", [](const PyAsyncJob& self) { return self.job->id(); })
+        .def_property_readonly("state", [](const PyAsyncJob& self) { return self.job->state(); })
+        .def("done", [](const PyAsyncJob& self) { return self.job->finished(); })
+        .def("cancel", [](PyAsyncJob& self) { self.job->cancel(); },
+             "Keeps a pending job from starting and stops a running one at its next chunk")
+        .def("wait", [](const PyAsyncJob& self) {
+            py::gil_scoped_release release;
+            self.job->wait();
+        }, "Blocks until the job has finished")
+        .def("result", &PyAsyncJob::result,
+             "Output of a finished job; raises the job's error if it failed");
+    
+    py::class_<PyAsyncExecutor>(m, "AsyncExecutor")
+        .def(py::init<size_t, size_t>(), py::arg("max_in_flight") = 64,
+             py::arg("dispatchers") = 1)
+        .def_property_readonly("max_in_flight", [](const PyAsyncExecutor& self) {
+            return self.executor->max_in_flight();
+        })
+        .def_property_readonly("in_flight", [](const PyAsyncExecutor& self) {
+            return self.executor->in_flight();
+        })
+        .def_property_readonly("notify_fd", [](const PyAsyncExecutor& self) {
+            return self.executor->notify_fd();
+        }, "File descriptor that is readable while finished jobs wait to be drained; "
+           "-1 if the platform has none")
+        .def("drain", &PyAsyncExecutor::drain, "Jobs finished since the last call")
+        .def("close", &PyAsyncExecutor::close, "Cancels queued jobs and waits for running ones")
+        .def("submit_batch_dot_product", [](PyAsyncExecutor& self, const BatchArg& a,
+                                            const BatchArg& b) {
+            check_same_rows(a.view, b.view, "batch dot product");
+            BatchView va = a.view, vb = b.view;
+            return submit_per_row(self, py::make_tuple(a.owner, b.owner), {a.pin, b.pin}, va,
+                                  [va, vb](size_t begin, size_t end, double* out) {
+                batch_dot_product(va.rows(begin, end), vb.rows(begin, end), out);
+            });
+        }, py::arg("a"), py::arg("b"))
+        .def("submit_batch_distance", [](PyAsyncExecutor& self, const BatchArg& vectors,
+                                         const VectorND& query) {
+            check_batch_dimensions(vectors.view, query.size());
+            BatchView rows = vectors.view;
+            return submit_per_row(self, vectors.owner, {vectors.pin}, rows,
+                                  [rows, query](size_t begin, size_t end, double* out) {
+                batch_distance(rows.rows(begin, end), query, out);
+            });
+        }, py::arg("vectors"), py::arg("query"))
+        .def("submit_batch_cosine_similarity", [](PyAsyncExecutor& self, const BatchArg& vectors,
+                                                  const VectorND& query) {
+            check_batch_dimensions(vectors.view, query.size());
+            BatchView rows = vectors.view;
+            return submit_per_row(self, vectors.owner, {vectors.pin}, rows,
+                                  [rows, query](size_t begin, size_t end, double* out) {
+                batch_cosine_similarity(rows.rows(begin, end), query, out);
+            });
+        }, py::arg("vectors"), py::arg("query"))
+        .def("submit_batch_norms", [](PyAsyncExecutor& self, const BatchArg& vectors) {
+            BatchView rows = vectors.view;
+            return submit_per_row(self, vectors.owner, {vectors.pin}, rows,
+                                  [rows](size_t begin, size_t end, double* out) {
+                batch_norms(rows.rows(begin, end), out);
+            });
+        }, py::arg("vectors"))
+        .def("submit_batch_add", [](PyAsyncExecutor& self, const BatchArg& a, const BatchArg& b) {
+            check_same_rows(a.view, b.view, "batch add");
+            auto result = std::make_shared<VectorBatch>(a.view.dim);
+            BatchView va = a.view, vb = b.view;
+            return self.submit(py::make_tuple(a.owner, b.owner), {a.pin, b.pin},
+                               [result] { return py::cast(std::move(*result)); },
+                               [va, vb, result](const AsyncJob&) {
+                batch_add(va, vb, *result);
+            });
+        }, py::arg("a"), py::arg("b"))
+        .def("submit_centroid", [](PyAsyncExecutor& self, const BatchArg& vectors,
+                                   std::optional<ReductionMode> mode) {
+            auto result = std::make_shared<VectorND>();
+            BatchView rows = vectors.view;
+            ReductionMode reduction = mode.value_or(get_reduction_mode());
+            return self.submit(vectors.owner, {vectors.pin},
+                               [result] { return py::cast(*result); },
+                               [rows, reduction, result](const AsyncJob&) {
+                *result = centroid(rows, reduction);
+            });
+        }, py::arg("vectors"), py::arg("mode") = py::none())
+        .def("submit_k_nearest", [](PyAsyncExecutor& self, const BatchArg& vectors,
+                                    const VectorND& query, size_t k) {
+            check_batch_dimensions(vectors.view, query.size());
+            auto result = std::make_shared<std::vector<Neighbor>>();
+            BatchView rows = vectors.view;
+            return self.submit(vectors.owner, {vectors.pin},
+                               [result] { return neighbor_arrays(*result); },
+                               [rows, query, k, result](const AsyncJob&) {
+                *result = k_nearest(rows, query, k);
+            });
+        }, py::arg("vectors"), py::arg("query"), py::arg("k"));
+}
+
+// Defined in ufuncs.cpp, which builds against the NumPy C API
+void init_ufunc_module(py::module &m);
+
 PYBIND11_MODULE(_vectors_core, m) {
     m.doc() = "Vector Library - High-performance n-dimensional vector operations (C++ core)";
     m.attr("__version__") = "0.2.0";
     init_vector_module(m);
+    init_memory_module(m);
+    init_batch_module(m);
+    init_norm_cache_module(m);
+    init_hash_module(m);
+    init_index_module(m);
+    init_store_module(m);
+    init_concurrent_module(m);
+    init_async_module(m);
+    init_ufunc_module(m);
+    init_shared_module(m);
+    init_transform_module(m);
+    init_sparse_module(m);
+    init_stats_module(m);
+    init_tracker_module(m);
 }
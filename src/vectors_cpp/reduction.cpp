@@ -0,0 +1,242 @@
+#include "reduction.h"
+#include "parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+namespace vectors {
+
+namespace {
+
+// Independent accumulators per block; wide enough for AVX-512 on doubles.
+// The compensated path has a longer dependency chain, so it keeps more lanes
+// in flight to hide the add latency.
+constexpr size_t kLanes = 8;
+constexpr size_t kCompensatedLanes = 32;
+
+// Elements per task. Fixed so that the combination tree depends on n only.
+constexpr size_t kChunk = size_t(1) << 15;
+
+// Row reductions: rows per task are bounded so partial buffers stay small
+constexpr size_t kMinRowChunk = 256;
+constexpr size_t kMaxRowChunks = 512;
+constexpr size_t kColumnBlock = 1024;
+
+std::atomic<ReductionMode> g_mode{ReductionMode::Compensated};
+
+inline double sum_of(double value) { return value; }
+
+// Neumaier's variant of Kahan summation: the running error is kept in c
+inline void neumaier_add(double& s, double& c, double x) {
+    double t = s + x;
+    c += std::abs(s) >= std::abs(x) ? (s - t) + x : (x - t) + s;
+    s = t;
+}
+
+// Block result: the rounded sum plus the error it has not absorbed yet
+struct Partial {
+    double sum;
+    double err;
+};
+
+inline double sum_of(const Partial& p) { return p.sum; }
+
+template <typename Value>
+double pairwise(const Value* values, size_t n) {
+    if (n <= 8) {
+        double s = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            s += sum_of(values[i]);
+        }
+        return s;
+    }
+    size_t half = n / 2;
+    return pairwise(values, half) + pairwise(values + half, n - half);
+}
+
+template <typename Term>
+Partial block_fast(const Term& term, size_t begin, size_t end) {
+    if (end - begin < kLanes) {
+        // No full lane group: the lanes would stay zero, so skip them.
+        // 0.0 + tail matches the lane path, including the sign of zero.
+        double tail = 0.0;
+        for (size_t i = begin; i < end; ++i) {
+            tail += term(i);
+        }
+        return {0.0 + tail, 0.0};
+    }
+    double acc[kLanes] = {};
+    size_t i = begin;
+    for (; i + kLanes <= end; i += kLanes) {
+        for (size_t l = 0; l < kLanes; ++l) {
+            acc[l] += term(i + l);
+        }
+    }
+    double tail = 0.0;
+    for (; i < end; ++i) {
+        tail += term(i);
+    }
+    return {pairwise(acc, kLanes) + tail, 0.0};
+}
+
+template <typename Term>
+Partial block_compensated(const Term& term, size_t begin, size_t end) {
+    if (end - begin < kCompensatedLanes) {
+        // Short inputs (typical vector dimensions): folding in all-zero lanes
+        // leaves the sum and error unchanged, so go straight to the tail
+        double s = 0.0;
+        double c = 0.0;
+        for (size_t i = begin; i < end; ++i) {
+            neumaier_add(s, c, term(i));
+        }
+        return {s, c};
+    }
+    double acc[kCompensatedLanes] = {};
+    double comp[kCompensatedLanes] = {};
+    size_t i = begin;
+    for (; i + kCompensatedLanes <= end; i += kCompensatedLanes) {
+        for (size_t l = 0; l < kCompensatedLanes; ++l) {
+            neumaier_add(acc[l], comp[l], term(i + l));
+        }
+    }
+    double s = 0.0;
+    double c = 0.0;
+    for (; i < end; ++i) {
+        neumaier_add(s, c, term(i));
+    }
+    for (size_t l = 0; l < kCompensatedLanes; ++l) {
+        neumaier_add(s, c, acc[l]);
+        c += comp[l];
+    }
+    return {s, c};
+}
+
+// Fixed-order combination of block partials
+double combine(const Partial* partials, size_t n, ReductionMode mode) {
+    if (mode == ReductionMode::Fast) {
+        return pairwise(partials, n);
+    }
+    double s = 0.0;
+    double c = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        neumaier_add(s, c, partials[i].sum);
+        c += partials[i].err;
+    }
+    return s + c;
+}
+
+template <typename Term>
+double reduce(const Term& term, size_t n, ReductionMode mode) {
+    auto block = [&](size_t begin, size_t end) {
+        return mode == ReductionMode::Compensated ? block_compensated(term, begin, end)
+                                                  : block_fast(term, begin, end);
+    };
+    if (n <= kChunk) {
+        Partial p = block(0, n);
+        return p.sum + p.err;
+    }
+
+    size_t chunks = (n + kChunk - 1) / kChunk;
+    std::vector<Partial> partials(chunks);
+    auto task = [&](size_t c) {
+        partials[c] = block(c * kChunk, std::min(n, (c + 1) * kChunk));
+    };
+    parallel_for(chunks, n, task);
+    return combine(partials.data(), chunks, mode);
+}
+
+template <typename RowAt>
+void sum_row_block(const RowAt& row_at, size_t row_begin, size_t row_end,
+                   size_t col_begin, size_t col_end, Partial* out, ReductionMode mode) {
+    double acc[kColumnBlock];
+    double comp[kColumnBlock];
+    size_t width = col_end - col_begin;
+    std::fill(acc, acc + width, 0.0);
+    std::fill(comp, comp + width, 0.0);
+
+    for (size_t r = row_begin; r < row_end; ++r) {
+        const double* row = row_at(r) + col_begin;
+        if (mode == ReductionMode::Compensated) {
+            for (size_t c = 0; c < width; ++c) {
+                neumaier_add(acc[c], comp[c], row[c]);
+            }
+        } else {
+            for (size_t c = 0; c < width; ++c) {
+                acc[c] += row[c];
+            }
+        }
+    }
+    for (size_t c = 0; c < width; ++c) {
+        out[c] = {acc[c], comp[c]};
+    }
+}
+
+template <typename RowAt>
+void reduce_rows_impl(const RowAt& row_at, size_t count, size_t dim,
+                      double* out, ReductionMode mode) {
+    if (dim == 0) return;
+    if (count == 0) {
+        std::fill(out, out + dim, 0.0);
+        return;
+    }
+
+    size_t row_chunk = std::max(kMinRowChunk, (count + kMaxRowChunks - 1) / kMaxRowChunks);
+    size_t row_chunks = (count + row_chunk - 1) / row_chunk;
+    size_t col_blocks = (dim + kColumnBlock - 1) / kColumnBlock;
+    std::vector<Partial> partials(row_chunks * dim);
+
+    auto task = [&](size_t t) {
+        size_t rc = t / col_blocks;
+        size_t cb = t % col_blocks;
+        size_t col_begin = cb * kColumnBlock;
+        size_t col_end = std::min(dim, col_begin + kColumnBlock);
+        sum_row_block(row_at, rc * row_chunk, std::min(count, (rc + 1) * row_chunk),
+                      col_begin, col_end, partials.data() + rc * dim + col_begin, mode);
+    };
+    size_t tasks = row_chunks * col_blocks;
+    parallel_for(tasks, count * dim, task);
+
+    std::vector<Partial> column(row_chunks);
+    for (size_t c = 0; c < dim; ++c) {
+        for (size_t rc = 0; rc < row_chunks; ++rc) {
+            column[rc] = partials[rc * dim + c];
+        }
+        out[c] = combine(column.data(), row_chunks, mode);
+    }
+}
+
+} // namespace
+
+void set_reduction_mode(ReductionMode mode) {
+    g_mode.store(mode, std::memory_order_relaxed);
+}
+
+ReductionMode get_reduction_mode() {
+    return g_mode.load(std::memory_order_relaxed);
+}
+
+double reduce_sum(const double* data, size_t n, ReductionMode mode) {
+    return reduce([data](size_t i) { return data[i]; }, n, mode);
+}
+
+double reduce_sum_squares(const double* data, size_t n, ReductionMode mode) {
+    return reduce([data](size_t i) { return data[i] * data[i]; }, n, mode);
+}
+
+double reduce_dot(const double* a, const double* b, size_t n, ReductionMode mode) {
+    return reduce([a, b](size_t i) { return a[i] * b[i]; }, n, mode);
+}
+
+void reduce_rows(const double* const* rows, size_t count, size_t dim,
+                 double* out, ReductionMode mode) {
+    reduce_rows_impl([rows](size_t r) { return rows[r]; }, count, dim, out, mode);
+}
+
+void reduce_rows(const double* base, size_t count, size_t dim, size_t stride,
+                 double* out, ReductionMode mode) {
+    reduce_rows_impl([base, stride](size_t r) { return base + r * stride; },
+                     count, dim, out, mode);
+}
+
+} // namespace vectors
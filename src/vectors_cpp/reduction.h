@@ -0,0 +1,39 @@
+#ifndef REDUCTION_H
+#define REDUCTION_H
+
+#include <cstddef>
+
+namespace vectors {
+
+/**
+ * Summation strategy used by the reduction kernels.
+ *
+ * Fast keeps independent lane accumulators per block and combines block
+ * partials pairwise. Compensated carries a Neumaier (improved Kahan) error term
+ * per lane and through the combination step. Blocks are fixed by the input
+ * size and combined in index order, so results are reproducible for any
+ * thread count.
+ */
+enum class ReductionMode {
+    Fast,
+    Compensated
+};
+
+// Process-wide default used when no mode is given explicitly
+void set_reduction_mode(ReductionMode mode);
+ReductionMode get_reduction_mode();
+
+// Scalar reductions over contiguous data
+double reduce_sum(const double* data, size_t n, ReductionMode mode);
+double reduce_sum_squares(const double* data, size_t n, ReductionMode mode);
+double reduce_dot(const double* a, const double* b, size_t n, ReductionMode mode);
+
+// Column-wise sum of `count` rows of length `dim` into out[0..dim)
+void reduce_rows(const double* const* rows, size_t count, size_t dim,
+                 double* out, ReductionMode mode);
+void reduce_rows(const double* base, size_t count, size_t dim, size_t stride,
+                 double* out, ReductionMode mode);
+
+} // namespace vectors
+
+#endif // REDUCTION_H
@@ -0,0 +1,119 @@
+#include "serialization.h"
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace vectors {
+
+namespace {
+
+const char kMagic[4] = {'V', 'N', 'D', 'B'};
+constexpr uint16_t kSerializedVersion = 1;
+
+static_assert(sizeof(SerializedHeader) == 24, "serialized header must be 24 bytes");
+
+void write_header(SerializedKind kind, size_t count, size_t dimensions, unsigned char* out) {
+    SerializedHeader header;
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kSerializedVersion;
+    header.kind = static_cast<uint16_t>(kind);
+    header.dimensions = dimensions;
+    header.count = count;
+    std::memcpy(out, &header, sizeof(header));
+}
+
+// Values start right after the header; the memcpy keeps unaligned buffers safe
+void read_values(const unsigned char* data, const SerializedHeader& header, double* out) {
+    std::memcpy(out, data + sizeof(SerializedHeader),
+                static_cast<size_t>(header.count * header.dimensions) * sizeof(double));
+}
+
+} // namespace
+
+size_t serialized_size(size_t count, size_t dimensions) {
+    return sizeof(SerializedHeader) + count * dimensions * sizeof(double);
+}
+
+void serialize(const VectorND& v, unsigned char* out) {
+    write_header(SerializedKind::Vector, 1, v.size(), out);
+    std::memcpy(out + sizeof(SerializedHeader), v.data().data(), v.size() * sizeof(double));
+}
+
+void serialize(const BatchView& batch, unsigned char* out) {
+    write_header(SerializedKind::Batch, batch.count, batch.dim, out);
+    unsigned char* rows = out + sizeof(SerializedHeader);
+    size_t row_bytes = batch.dim * sizeof(double);
+    if (batch.stride == batch.dim) {
+        std::memcpy(rows, batch.data, batch.count * row_bytes);
+        return;
+    }
+    for (size_t i = 0; i < batch.count; ++i) {
+        std::memcpy(rows + i * row_bytes, batch.row(i), row_bytes);
+    }
+}
+
+std::vector<unsigned char> to_bytes(const VectorND& v) {
+    std::vector<unsigned char> out(serialized_size(1, v.size()));
+    serialize(v, out.data());
+    return out;
+}
+
+std::vector<unsigned char> to_bytes(const BatchView& batch) {
+    std::vector<unsigned char> out(serialized_size(batch.count, batch.dim));
+    serialize(batch, out.data());
+    return out;
+}
+
+SerializedHeader read_serialized_header(const unsigned char* data, size_t size) {
+    SerializedHeader header;
+    if (size < sizeof(header)) {
+        throw std::runtime_error("Truncated serialized vector data");
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error("Not serialized vector data");
+    }
+    if (header.version != kSerializedVersion) {
+        throw std::runtime_error("Unsupported serialized vector version: " +
+                                 std::to_string(header.version));
+    }
+    if (header.dimensions != 0 &&
+        header.count > (size - sizeof(header)) / sizeof(double) / header.dimensions) {
+        throw std::runtime_error("Truncated serialized vector data");
+    }
+    if (size != serialized_size(static_cast<size_t>(header.count),
+                                static_cast<size_t>(header.dimensions))) {
+        throw std::runtime_error("Trailing bytes after serialized vector data");
+    }
+    return header;
+}
+
+BatchView serialized_view(const unsigned char* data, size_t size) {
+    SerializedHeader header = read_serialized_header(data, size);
+    if (reinterpret_cast<uintptr_t>(data) % alignof(double) != 0) {
+        throw std::runtime_error("Serialized vector data must be 8-byte aligned to view in place");
+    }
+    size_t dim = static_cast<size_t>(header.dimensions);
+    return BatchView{reinterpret_cast<const double*>(data + sizeof(header)),
+                     static_cast<size_t>(header.count), dim, dim};
+}
+
+VectorND vector_from_bytes(const unsigned char* data, size_t size) {
+    SerializedHeader header = read_serialized_header(data, size);
+    if (header.kind != static_cast<uint16_t>(SerializedKind::Vector) || header.count != 1) {
+        throw std::runtime_error("Serialized data does not hold a single vector");
+    }
+    VectorND result(static_cast<size_t>(header.dimensions));
+    read_values(data, header, result.data().data());
+    return result;
+}
+
+VectorBatch batch_from_bytes(const unsigned char* data, size_t size) {
+    SerializedHeader header = read_serialized_header(data, size);
+    // A serialized vector is a valid batch of one
+    VectorBatch result(static_cast<size_t>(header.count), static_cast<size_t>(header.dimensions));
+    read_values(data, header, result.data());
+    return result;
+}
+
+} // namespace vectors
@@ -0,0 +1,57 @@
+#ifndef SERIALIZATION_H
+#define SERIALIZATION_H
+
+#include "vector_batch.h"
+#include <cstdint>
+#include <vector>
+
+namespace vectors {
+
+/**
+ * Compact binary format for vectors and batches (little-endian)
+ *
+ *   offset  size  field
+ *        0     4  magic "VNDB"
+ *        4     2  format version
+ *        6     2  kind (1 = vector, 2 = batch)
+ *        8     8  dimensions
+ *       16     8  vector count (1 for a vector)
+ *       24     -  count * dimensions float64 values, row-major
+ *
+ * The header keeps the values 8-byte aligned, so a buffer holding a
+ * serialized batch can be viewed in place with serialized_view().
+ */
+enum class SerializedKind : uint16_t {
+    Vector = 1,
+    Batch = 2
+};
+
+struct SerializedHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t kind;
+    uint64_t dimensions;
+    uint64_t count;
+};
+
+size_t serialized_size(size_t count, size_t dimensions);
+
+// Write the serialized form into `out`, which must hold serialized_size() bytes
+void serialize(const VectorND& v, unsigned char* out);
+void serialize(const BatchView& batch, unsigned char* out);
+
+std::vector<unsigned char> to_bytes(const VectorND& v);
+std::vector<unsigned char> to_bytes(const BatchView& batch);
+
+// Validates the header and length of a serialized buffer
+SerializedHeader read_serialized_header(const unsigned char* data, size_t size);
+
+// Rows of a serialized buffer without copying; `data` must be 8-byte aligned
+BatchView serialized_view(const unsigned char* data, size_t size);
+
+VectorND vector_from_bytes(const unsigned char* data, size_t size);
+VectorBatch batch_from_bytes(const unsigned char* data, size_t size);
+
+} // namespace vectors
+
+#endif // SERIALIZATION_H
@@ -0,0 +1,211 @@
+#include "shared_batch.h"
+#include "vector_store.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace vectors {
+
+namespace {
+
+#ifndef _WIN32
+// POSIX shared memory names start with a single slash
+std::string posix_name(const std::string& name) {
+    return (name.empty() || name[0] != '/') ? "/" + name : name;
+}
+#endif
+
+} // namespace
+
+SharedVectorBatch::SharedVectorBatch(const std::string& name, bool read_only)
+    : name_(name), base_(nullptr), length_(0), count_(0), dim_(0), rows_(nullptr),
+      read_only_(read_only) {
+#ifdef _WIN32
+    mapping_handle_ = nullptr;
+#endif
+}
+
+std::unique_ptr<SharedVectorBatch> SharedVectorBatch::create(const std::string& name,
+                                                             size_t count, size_t dimensions) {
+    if (dimensions == 0) {
+        throw std::runtime_error("Shared vector batch dimensions must be positive");
+    }
+    VectorFileHeader header = make_vector_file_header(dimensions);
+    header.count = count;
+
+    std::unique_ptr<SharedVectorBatch> batch(new SharedVectorBatch(name, false));
+    batch->map_segment(true, header.data_offset + count * dimensions * sizeof(double));
+    std::memcpy(batch->base_, &header, sizeof(header));
+    batch->read_header();
+    return batch;
+}
+
+std::unique_ptr<SharedVectorBatch> SharedVectorBatch::attach(const std::string& name,
+                                                             bool read_only) {
+    std::unique_ptr<SharedVectorBatch> batch(new SharedVectorBatch(name, read_only));
+    batch->map_segment(false, 0);
+    batch->read_header();
+    return batch;
+}
+
+void SharedVectorBatch::unlink(const std::string& name) {
+#ifndef _WIN32
+    if (::shm_unlink(posix_name(name).c_str()) != 0 && errno != ENOENT) {
+        throw std::runtime_error("Cannot unlink shared memory segment " + name + ": " +
+                                 std::strerror(errno));
+    }
+#else
+    (void)name;
+#endif
+}
+
+SharedVectorBatch::~SharedVectorBatch() {
+#ifdef _WIN32
+    if (base_) UnmapViewOfFile(base_);
+    if (mapping_handle_) CloseHandle(mapping_handle_);
+#else
+    if (base_) ::munmap(base_, length_);
+#endif
+}
+
+void SharedVectorBatch::map_segment(bool create, size_t length) {
+#ifdef _WIN32
+    DWORD access = read_only_ ? FILE_MAP_READ : FILE_MAP_ALL_ACCESS;
+    if (create) {
+        uint64_t size = length;
+        mapping_handle_ = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                             static_cast<DWORD>(size >> 32),
+                                             static_cast<DWORD>(size & 0xffffffffu),
+                                             name_.c_str());
+        if (mapping_handle_ && GetLastError() == ERROR_ALREADY_EXISTS) {
+            CloseHandle(mapping_handle_);
+            mapping_handle_ = nullptr;
+        }
+    } else {
+        mapping_handle_ = OpenFileMappingA(access, FALSE, name_.c_str());
+    }
+    if (!mapping_handle_) {
+        throw std::runtime_error((create ? "Cannot create shared memory segment: "
+                                         : "Cannot open shared memory segment: ") + name_);
+    }
+    base_ = MapViewOfFile(mapping_handle_, access, 0, 0, create ? length : 0);
+    if (!base_) {
+        throw std::runtime_error("Cannot map shared memory segment: " + name_);
+    }
+    if (!create) {
+        MEMORY_BASIC_INFORMATION info;
+        VirtualQuery(base_, &info, sizeof(info));
+        length = static_cast<size_t>(info.RegionSize);
+    }
+    length_ = length;
+#else
+    std::string shm_name = posix_name(name_);
+    int flags = create ? (O_CREAT | O_EXCL | O_RDWR) : (read_only_ ? O_RDONLY : O_RDWR);
+    int fd = ::shm_open(shm_name.c_str(), flags, 0600);
+    if (fd < 0) {
+        throw std::runtime_error(std::string(create ? "Cannot create shared memory segment "
+                                                    : "Cannot open shared memory segment ") +
+                                 name_ + ": " + std::strerror(errno));
+    }
+    if (create) {
+        if (::ftruncate(fd, static_cast<off_t>(length)) != 0) {
+            int error = errno;
+            ::close(fd);
+            ::shm_unlink(shm_name.c_str());
+            throw std::runtime_error("Cannot size shared memory segment " + name_ + ": " +
+                                     std::strerror(error));
+        }
+    } else {
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Cannot open shared memory segment: " + name_);
+        }
+        length = static_cast<size_t>(st.st_size);
+    }
+    if (length < sizeof(VectorFileHeader)) {
+        ::close(fd);
+        throw std::runtime_error("Truncated shared vector batch header in " + name_);
+    }
+    int protection = read_only_ ? PROT_READ : (PROT_READ | PROT_WRITE);
+    void* base = ::mmap(nullptr, length, protection, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        if (create) ::shm_unlink(shm_name.c_str());
+        throw std::runtime_error("Cannot map shared memory segment: " + name_);
+    }
+    base_ = base;
+    length_ = length;
+#endif
+}
+
+void SharedVectorBatch::read_header() {
+    VectorFileHeader header;
+    std::memcpy(&header, base_, sizeof(header));
+    validate_vector_file_header(header, "shared memory segment " + name_);
+    dim_ = static_cast<size_t>(header.dimensions);
+    count_ = static_cast<size_t>(header.count);
+    // Another process may have written the header, so nothing in it can be
+    // trusted not to overflow
+    if (header.data_offset > length_ ||
+        (dim_ != 0 && count_ > (length_ - header.data_offset) / sizeof(double) / dim_)) {
+        throw std::runtime_error("Truncated shared vector batch data in " + name_);
+    }
+    rows_ = reinterpret_cast<double*>(static_cast<char*>(base_) + header.data_offset);
+}
+
+double* SharedVectorBatch::mutable_data() {
+    if (read_only_) {
+        throw std::runtime_error("Shared vector batch is attached read-only: " + name_);
+    }
+    return rows_;
+}
+
+VectorND SharedVectorBatch::get(size_t index) const {
+    if (index >= count_) {
+        throw std::out_of_range("Batch index out of range");
+    }
+    return VectorND(std::vector<double>(row(index), row(index) + dim_));
+}
+
+void SharedVectorBatch::set(size_t index, const VectorND& v) {
+    if (index >= count_) {
+        throw std::out_of_range("Batch index out of range");
+    }
+    if (v.size() != dim_) {
+        throw std::runtime_error(
+            "Dimension mismatch in shared batch set: " +
+            std::to_string(dim_) + " vs " + std::to_string(v.size())
+        );
+    }
+    std::copy(v.data().begin(), v.data().end(), mutable_data() + index * dim_);
+}
+
+void SharedVectorBatch::assign(const BatchView& batch, size_t offset) {
+    if (batch.dim != dim_) {
+        throw std::runtime_error(
+            "Dimension mismatch in shared batch assign: " +
+            std::to_string(dim_) + " vs " + std::to_string(batch.dim)
+        );
+    }
+    if (offset > count_ || batch.count > count_ - offset) {
+        throw std::out_of_range("Batch index out of range");
+    }
+    double* out = mutable_data() + offset * dim_;
+    for (size_t i = 0; i < batch.count; ++i) {
+        std::copy(batch.row(i), batch.row(i) + dim_, out + i * dim_);
+    }
+}
+
+} // namespace vectors
@@ -0,0 +1,74 @@
+#ifndef SHARED_BATCH_H
+#define SHARED_BATCH_H
+
+#include "vector_batch.h"
+#include <memory>
+#include <string>
+
+namespace vectors {
+
+/**
+ * SharedVectorBatch - Fixed-size batch in named shared memory
+ *
+ * One process creates the segment and fills it; any number of processes then
+ * attach by name and run the batch kernels over view() against the same
+ * physical pages. The segment uses the vector file layout (vector_store.h),
+ * so the header is validated on attach like a file would be.
+ *
+ * On POSIX the name lives in the shm_open namespace until unlink() is called,
+ * even after every process has detached. On Windows the segment disappears
+ * when the last handle is closed and unlink() does nothing.
+ */
+class SharedVectorBatch {
+public:
+    // Creates a new zero-filled segment; fails if the name already exists
+    static std::unique_ptr<SharedVectorBatch> create(const std::string& name, size_t count,
+                                                     size_t dimensions);
+    // Attaches to a segment created by any process
+    static std::unique_ptr<SharedVectorBatch> attach(const std::string& name,
+                                                     bool read_only = true);
+    // Removes the name; existing mappings stay valid until they are closed
+    static void unlink(const std::string& name);
+
+    ~SharedVectorBatch();
+
+    SharedVectorBatch(const SharedVectorBatch&) = delete;
+    SharedVectorBatch& operator=(const SharedVectorBatch&) = delete;
+
+    const std::string& name() const { return name_; }
+    size_t size() const { return count_; }
+    size_t dimensions() const { return dim_; }
+    bool read_only() const { return read_only_; }
+
+    const double* data() const { return rows_; }
+    double* mutable_data();
+    const double* row(size_t i) const { return rows_ + i * dim_; }
+
+    VectorND get(size_t index) const;
+    void set(size_t index, const VectorND& v);
+    // Copies `batch` into rows [offset, offset + batch.count)
+    void assign(const BatchView& batch, size_t offset = 0);
+
+    BatchView view() const { return BatchView{rows_, count_, dim_, dim_}; }
+
+private:
+    SharedVectorBatch(const std::string& name, bool read_only);
+
+    std::string name_;
+    void* base_;
+    size_t length_;
+    size_t count_;
+    size_t dim_;
+    double* rows_;
+    bool read_only_;
+#ifdef _WIN32
+    void* mapping_handle_;
+#endif
+
+    void map_segment(bool create, size_t length);
+    void read_header();
+};
+
+} // namespace vectors
+
+#endif // SHARED_BATCH_H
@@ -0,0 +1,203 @@
+#include "sparse_batch.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <utility>
+
+namespace vectors {
+
+namespace {
+
+// Rows per task; scans count stored entries as their work size
+constexpr size_t kRowBlock = 1024;
+
+// Runs body(begin, end) over row blocks, in parallel for large batches
+template <typename Body>
+void for_each_row_block(const SparseBatch& batch, const Body& body) {
+    size_t count = batch.size();
+    size_t blocks = (count + kRowBlock - 1) / kRowBlock;
+    auto task = [&](size_t b) {
+        body(b * kRowBlock, std::min(count, (b + 1) * kRowBlock));
+    };
+    parallel_for(blocks, batch.nnz(), task);
+}
+
+void check_query(const SparseBatch& batch, size_t dimensions, const char* operation) {
+    if (batch.dimensions() != dimensions) {
+        throw std::runtime_error(
+            std::string("Dimension mismatch in ") + operation + ": " +
+            std::to_string(batch.dimensions()) + " vs " + std::to_string(dimensions)
+        );
+    }
+}
+
+void check_nonzero(double norm) {
+    if (norm < std::numeric_limits<double>::epsilon()) {
+        throw std::runtime_error("Cannot calculate cosine similarity with zero vector");
+    }
+}
+
+double row_norm(const SparseRow& row, ReductionMode mode) {
+    return std::sqrt(reduce_sum_squares(row.values, row.nnz, mode));
+}
+
+bool rows_sorted(const std::vector<uint64_t>& indptr, const std::vector<SparseIndex>& indices) {
+    for (size_t r = 0; r + 1 < indptr.size(); ++r) {
+        for (uint64_t k = indptr[r] + 1; k < indptr[r + 1]; ++k) {
+            if (indices[k - 1] >= indices[k]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+// Constructors
+SparseBatch::SparseBatch(size_t dimensions) : dim_(dimensions), indptr_(1, 0) {
+    check_sparse_dimensions(dimensions);
+}
+
+SparseBatch::SparseBatch(size_t dimensions, std::vector<uint64_t> indptr,
+                         std::vector<SparseIndex> indices, std::vector<double> values)
+    : dim_(dimensions), indptr_(std::move(indptr)), indices_(std::move(indices)),
+      values_(std::move(values)) {
+    check_sparse_dimensions(dimensions);
+    if (indices_.size() != values_.size()) {
+        throw std::runtime_error("Sparse indices and values must have the same length");
+    }
+    if (indptr_.empty() || indptr_.front() != 0 || indptr_.back() != indices_.size() ||
+        !std::is_sorted(indptr_.begin(), indptr_.end())) {
+        throw std::runtime_error("Invalid CSR row pointers");
+    }
+    for (SparseIndex index : indices_) {
+        if (index >= dim_) {
+            throw std::out_of_range("Sparse index out of range");
+        }
+    }
+    if (rows_sorted(indptr_, indices_)) {
+        return;
+    }
+    SparseBatch sorted(dimensions);
+    sorted.reserve(size(), nnz());
+    for (size_t r = 0; r < size(); ++r) {
+        SparseRow entries = row(r);
+        std::vector<SparseIndex> row_indices(entries.indices, entries.indices + entries.nnz);
+        std::vector<double> row_values(entries.values, entries.values + entries.nnz);
+        canonicalize_sparse(row_indices, row_values);
+        sorted.indices_.insert(sorted.indices_.end(), row_indices.begin(), row_indices.end());
+        sorted.values_.insert(sorted.values_.end(), row_values.begin(), row_values.end());
+        sorted.indptr_.push_back(sorted.indices_.size());
+    }
+    *this = std::move(sorted);
+}
+
+// Accessors
+SparseVectorND SparseBatch::get(size_t index) const {
+    if (index >= size()) {
+        throw std::out_of_range("Index out of range");
+    }
+    SparseRow entries = row(index);
+    return SparseVectorND(dim_,
+                          std::vector<SparseIndex>(entries.indices, entries.indices + entries.nnz),
+                          std::vector<double>(entries.values, entries.values + entries.nnz));
+}
+
+void SparseBatch::append(const SparseVectorND& v) {
+    check_query(*this, v.dimensions(), "sparse batch");
+    indices_.insert(indices_.end(), v.indices().begin(), v.indices().end());
+    values_.insert(values_.end(), v.values().begin(), v.values().end());
+    indptr_.push_back(indices_.size());
+}
+
+void SparseBatch::reserve(size_t rows, size_t nnz) {
+    indptr_.reserve(rows + 1);
+    indices_.reserve(nnz);
+    values_.reserve(nnz);
+}
+
+void SparseBatch::clear() {
+    indptr_.assign(1, 0);
+    indices_.clear();
+    values_.clear();
+}
+
+VectorBatch SparseBatch::to_dense() const {
+    VectorBatch result(size(), dim_);
+    for (size_t r = 0; r < size(); ++r) {
+        SparseRow entries = row(r);
+        double* out = result.row(r);
+        for (size_t k = 0; k < entries.nnz; ++k) {
+            out[entries.indices[k]] = entries.values[k];
+        }
+    }
+    return result;
+}
+
+// Corpus scans
+void sparse_batch_dot(const SparseBatch& batch, const SparseVectorND& query, double* result) {
+    check_query(batch, query.dimensions(), "sparse batch dot product");
+    const SparseIndex* qi = query.indices().data();
+    const double* qv = query.values().data();
+    const size_t qn = query.nnz();
+    for_each_row_block(batch, [&](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; ++r) {
+            SparseRow entries = batch.row(r);
+            result[r] = sparse_dot(entries.indices, entries.values, entries.nnz, qi, qv, qn);
+        }
+    });
+}
+
+void sparse_batch_dot(const SparseBatch& batch, const VectorND& query, double* result) {
+    check_query(batch, query.size(), "sparse batch dot product");
+    const double* q = query.data().data();
+    for_each_row_block(batch, [&](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; ++r) {
+            SparseRow entries = batch.row(r);
+            result[r] = sparse_dense_dot(entries.indices, entries.values, entries.nnz, q);
+        }
+    });
+}
+
+void sparse_batch_cosine_similarity(const SparseBatch& batch, const SparseVectorND& query,
+                                    double* result) {
+    check_query(batch, query.dimensions(), "sparse batch cosine similarity");
+    const ReductionMode mode = get_reduction_mode();
+    double query_norm = query.magnitude();
+    check_nonzero(query_norm);
+    const SparseIndex* qi = query.indices().data();
+    const double* qv = query.values().data();
+    const size_t qn = query.nnz();
+    for_each_row_block(batch, [&](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; ++r) {
+            SparseRow entries = batch.row(r);
+            double norm = row_norm(entries, mode);
+            check_nonzero(norm);
+            double dot = sparse_dot(entries.indices, entries.values, entries.nnz, qi, qv, qn);
+            result[r] = dot / (norm * query_norm);
+        }
+    });
+}
+
+void sparse_batch_cosine_similarity(const SparseBatch& batch, const VectorND& query,
+                                    double* result) {
+    check_query(batch, query.size(), "sparse batch cosine similarity");
+    const ReductionMode mode = get_reduction_mode();
+    double query_norm = query.magnitude();
+    check_nonzero(query_norm);
+    const double* q = query.data().data();
+    for_each_row_block(batch, [&](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; ++r) {
+            SparseRow entries = batch.row(r);
+            double norm = row_norm(entries, mode);
+            check_nonzero(norm);
+            result[r] = sparse_dense_dot(entries.indices, entries.values, entries.nnz, q) /
+                        (norm * query_norm);
+        }
+    });
+}
+
+} // namespace vectors
@@ -0,0 +1,71 @@
+#ifndef SPARSE_BATCH_H
+#define SPARSE_BATCH_H
+
+#include "sparse_vector.h"
+#include "vector_batch.h"
+#include <cstdint>
+#include <vector>
+
+namespace vectors {
+
+// Entries of one row of a SparseBatch, sorted by index
+struct SparseRow {
+    const SparseIndex* indices;
+    const double* values;
+    size_t nnz;
+};
+
+/**
+ * SparseBatch - Sparse vectors of equal dimension in compressed sparse row
+ * (CSR) form
+ *
+ * Row i holds entries [indptr[i], indptr[i + 1]) of the shared index and
+ * value arrays, the same layout as scipy.sparse.csr_matrix.
+ */
+class SparseBatch {
+public:
+    explicit SparseBatch(size_t dimensions);
+    // Takes CSR arrays as-is; rows with unsorted or repeated indices are
+    // sorted and summed like SparseVectorND entries
+    SparseBatch(size_t dimensions, std::vector<uint64_t> indptr,
+                std::vector<SparseIndex> indices, std::vector<double> values);
+
+    size_t size() const { return indptr_.size() - 1; }
+    size_t dimensions() const { return dim_; }
+    size_t nnz() const { return indices_.size(); }
+
+    const std::vector<uint64_t>& indptr() const { return indptr_; }
+    const std::vector<SparseIndex>& indices() const { return indices_; }
+    const std::vector<double>& values() const { return values_; }
+
+    SparseRow row(size_t i) const {
+        size_t begin = static_cast<size_t>(indptr_[i]);
+        return SparseRow{indices_.data() + begin, values_.data() + begin,
+                         static_cast<size_t>(indptr_[i + 1]) - begin};
+    }
+
+    SparseVectorND get(size_t index) const;
+    void append(const SparseVectorND& v);
+    void reserve(size_t rows, size_t nnz);
+    void clear();
+
+    VectorBatch to_dense() const;
+
+private:
+    size_t dim_;
+    std::vector<uint64_t> indptr_;
+    std::vector<SparseIndex> indices_;
+    std::vector<double> values_;
+};
+
+// Corpus scans: one result per row, split over threads by row blocks
+void sparse_batch_dot(const SparseBatch& batch, const SparseVectorND& query, double* result);
+void sparse_batch_dot(const SparseBatch& batch, const VectorND& query, double* result);
+void sparse_batch_cosine_similarity(const SparseBatch& batch, const SparseVectorND& query,
+                                    double* result);
+void sparse_batch_cosine_similarity(const SparseBatch& batch, const VectorND& query,
+                                    double* result);
+
+} // namespace vectors
+
+#endif // SPARSE_BATCH_H
@@ -0,0 +1,315 @@
+#include "sparse_vector.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <string>
+#include <utility>
+
+namespace vectors {
+
+namespace {
+
+// Length ratio above which the shorter list gallops instead of merging
+constexpr size_t kGallopRatio = 32;
+
+// Merge of similar-length lists: both cursors advance on comparisons rather
+// than branches, so mispredictions do not dominate on random overlaps
+double merge_dot(const SparseIndex* ai, const double* av, size_t an,
+                 const SparseIndex* bi, const double* bv, size_t bn) {
+    double sum = 0.0;
+    size_t i = 0;
+    size_t j = 0;
+    while (i < an && j < bn) {
+        SparseIndex x = ai[i];
+        SparseIndex y = bi[j];
+        sum += x == y ? av[i] * bv[j] : 0.0;
+        i += x <= y;
+        j += y <= x;
+    }
+    return sum;
+}
+
+// Each entry of the short list is found in the long one by doubling the step
+// from the previous match, then binary searching the last step
+double gallop_dot(const SparseIndex* si, const double* sv, size_t sn,
+                  const SparseIndex* li, const double* lv, size_t ln) {
+    double sum = 0.0;
+    size_t pos = 0;
+    for (size_t k = 0; k < sn && pos < ln; ++k) {
+        SparseIndex target = si[k];
+        size_t step = 1;
+        while (pos + step < ln && li[pos + step] < target) {
+            step *= 2;
+        }
+        size_t end = std::min(ln, pos + step + 1);
+        pos = static_cast<size_t>(std::lower_bound(li + pos, li + end, target) - li);
+        if (pos < ln && li[pos] == target) {
+            sum += sv[k] * lv[pos];
+        }
+    }
+    return sum;
+}
+
+// Removes entries whose value is exactly zero, so each vector has one form
+void drop_zeros(std::vector<SparseIndex>& indices, std::vector<double>& values) {
+    size_t kept = 0;
+    for (size_t k = 0; k < values.size(); ++k) {
+        if (values[k] != 0.0) {
+            indices[kept] = indices[k];
+            values[kept] = values[k];
+            ++kept;
+        }
+    }
+    indices.resize(kept);
+    values.resize(kept);
+}
+
+} // namespace
+
+void check_sparse_dimensions(size_t dimensions) {
+    if (dimensions > size_t(std::numeric_limits<SparseIndex>::max()) + 1) {
+        throw std::runtime_error("Sparse dimensions exceed the 32-bit index range");
+    }
+}
+
+void canonicalize_sparse(std::vector<SparseIndex>& indices, std::vector<double>& values) {
+    bool sorted = true;
+    for (size_t k = 1; k < indices.size() && sorted; ++k) {
+        sorted = indices[k - 1] < indices[k];
+    }
+    if (sorted) {
+        return;
+    }
+    std::vector<size_t> order(indices.size());
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return indices[a] < indices[b];
+    });
+    std::vector<SparseIndex> merged_indices;
+    std::vector<double> merged_values;
+    merged_indices.reserve(indices.size());
+    merged_values.reserve(values.size());
+    for (size_t k : order) {
+        if (!merged_indices.empty() && merged_indices.back() == indices[k]) {
+            merged_values.back() += values[k];
+        } else {
+            merged_indices.push_back(indices[k]);
+            merged_values.push_back(values[k]);
+        }
+    }
+    indices = std::move(merged_indices);
+    values = std::move(merged_values);
+}
+
+double sparse_dot(const SparseIndex* a_indices, const double* a_values, size_t a_nnz,
+                  const SparseIndex* b_indices, const double* b_values, size_t b_nnz) {
+    if (a_nnz > b_nnz) {
+        std::swap(a_indices, b_indices);
+        std::swap(a_values, b_values);
+        std::swap(a_nnz, b_nnz);
+    }
+    if (a_nnz == 0) {
+        return 0.0;
+    }
+    if (a_nnz * kGallopRatio < b_nnz) {
+        return gallop_dot(a_indices, a_values, a_nnz, b_indices, b_values, b_nnz);
+    }
+    return merge_dot(a_indices, a_values, a_nnz, b_indices, b_values, b_nnz);
+}
+
+double sparse_dense_dot(const SparseIndex* indices, const double* values, size_t nnz,
+                        const double* dense) {
+    double sum = 0.0;
+    for (size_t k = 0; k < nnz; ++k) {
+        sum += values[k] * dense[indices[k]];
+    }
+    return sum;
+}
+
+// Constructors
+SparseVectorND::SparseVectorND(size_t dimensions) : dim_(dimensions) {
+    check_sparse_dimensions(dimensions);
+}
+
+SparseVectorND::SparseVectorND(size_t dimensions, std::vector<SparseIndex> indices,
+                               std::vector<double> values)
+    : dim_(dimensions), indices_(std::move(indices)), values_(std::move(values)) {
+    check_sparse_dimensions(dimensions);
+    if (indices_.size() != values_.size()) {
+        throw std::runtime_error("Sparse indices and values must have the same length");
+    }
+    for (SparseIndex index : indices_) {
+        if (index >= dim_) {
+            throw std::out_of_range("Sparse index out of range");
+        }
+    }
+    canonicalize_sparse(indices_, values_);
+    drop_zeros(indices_, values_);
+}
+
+SparseVectorND SparseVectorND::from_dense(const VectorND& dense) {
+    SparseVectorND result(dense.size());
+    for (size_t i = 0; i < dense.size(); ++i) {
+        if (dense[i] != 0.0) {
+            result.indices_.push_back(static_cast<SparseIndex>(i));
+            result.values_.push_back(dense[i]);
+        }
+    }
+    return result;
+}
+
+void SparseVectorND::check_dimensions(size_t dimensions, const char* operation) const {
+    if (dim_ != dimensions) {
+        throw std::runtime_error(
+            std::string("Dimension mismatch in ") + operation +
+            ": " + std::to_string(dim_) + " vs " + std::to_string(dimensions)
+        );
+    }
+}
+
+// Accessors
+double SparseVectorND::get(size_t index) const {
+    if (index >= dim_) {
+        throw std::out_of_range("Index out of range");
+    }
+    auto it = std::lower_bound(indices_.begin(), indices_.end(), index);
+    if (it == indices_.end() || *it != index) {
+        return 0.0;
+    }
+    return values_[static_cast<size_t>(it - indices_.begin())];
+}
+
+VectorND SparseVectorND::to_dense() const {
+    VectorND result(dim_);
+    for (size_t k = 0; k < indices_.size(); ++k) {
+        result[indices_[k]] = values_[k];
+    }
+    return result;
+}
+
+// Arithmetic operations
+SparseVectorND SparseVectorND::merge(const SparseVectorND& other, double sign) const {
+    SparseVectorND result(dim_);
+    result.indices_.reserve(indices_.size() + other.indices_.size());
+    result.values_.reserve(indices_.size() + other.indices_.size());
+    size_t i = 0;
+    size_t j = 0;
+    while (i < indices_.size() || j < other.indices_.size()) {
+        SparseIndex index;
+        double value;
+        if (j == other.indices_.size() ||
+            (i < indices_.size() && indices_[i] < other.indices_[j])) {
+            index = indices_[i];
+            value = values_[i++];
+        } else if (i == indices_.size() || other.indices_[j] < indices_[i]) {
+            index = other.indices_[j];
+            value = sign * other.values_[j++];
+        } else {
+            index = indices_[i];
+            value = values_[i++] + sign * other.values_[j++];
+        }
+        if (value != 0.0) {
+            result.indices_.push_back(index);
+            result.values_.push_back(value);
+        }
+    }
+    return result;
+}
+
+SparseVectorND SparseVectorND::operator+(const SparseVectorND& other) const {
+    check_dimensions(other.dim_, "sparse addition");
+    return merge(other, 1.0);
+}
+
+SparseVectorND SparseVectorND::operator-(const SparseVectorND& other) const {
+    check_dimensions(other.dim_, "sparse subtraction");
+    return merge(other, -1.0);
+}
+
+VectorND SparseVectorND::operator+(const VectorND& other) const {
+    check_dimensions(other.size(), "sparse addition");
+    VectorND result(other);
+    for (size_t k = 0; k < indices_.size(); ++k) {
+        result[indices_[k]] += values_[k];
+    }
+    return result;
+}
+
+SparseVectorND SparseVectorND::operator*(double scalar) const {
+    SparseVectorND result(*this);
+    for (double& value : result.values_) {
+        value *= scalar;
+    }
+    drop_zeros(result.indices_, result.values_);
+    return result;
+}
+
+// Same rule as VectorND::operator==, with missing entries read as zeros
+bool SparseVectorND::operator==(const SparseVectorND& other) const {
+    if (dim_ != other.dim_) {
+        return false;
+    }
+    size_t i = 0;
+    size_t j = 0;
+    while (i < indices_.size() || j < other.indices_.size()) {
+        double a = 0.0;
+        double b = 0.0;
+        if (j == other.indices_.size() ||
+            (i < indices_.size() && indices_[i] < other.indices_[j])) {
+            a = values_[i++];
+        } else if (i == indices_.size() || other.indices_[j] < indices_[i]) {
+            b = other.values_[j++];
+        } else {
+            a = values_[i++];
+            b = other.values_[j++];
+        }
+        if (std::abs(a - b) >= kEqualityTolerance) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Vector operations
+double SparseVectorND::magnitude_squared() const {
+    return reduce_sum_squares(values_.data(), values_.size(), get_reduction_mode());
+}
+
+double SparseVectorND::magnitude() const {
+    return std::sqrt(magnitude_squared());
+}
+
+double SparseVectorND::dot(const SparseVectorND& other) const {
+    check_dimensions(other.dim_, "sparse dot product");
+    return sparse_dot(indices_.data(), values_.data(), indices_.size(),
+                      other.indices_.data(), other.values_.data(), other.indices_.size());
+}
+
+double SparseVectorND::dot(const VectorND& other) const {
+    check_dimensions(other.size(), "sparse dot product");
+    return sparse_dense_dot(indices_.data(), values_.data(), indices_.size(),
+                            other.data().data());
+}
+
+double SparseVectorND::cosine_similarity(const SparseVectorND& other) const {
+    double mag1 = magnitude();
+    double mag2 = other.magnitude();
+    if (mag1 < std::numeric_limits<double>::epsilon() ||
+        mag2 < std::numeric_limits<double>::epsilon()) {
+        throw std::runtime_error("Cannot calculate cosine similarity with zero vector");
+    }
+    return dot(other) / (mag1 * mag2);
+}
+
+double SparseVectorND::cosine_similarity(const VectorND& other) const {
+    double mag1 = magnitude();
+    double mag2 = other.magnitude();
+    if (mag1 < std::numeric_limits<double>::epsilon() ||
+        mag2 < std::numeric_limits<double>::epsilon()) {
+        throw std::runtime_error("Cannot calculate cosine similarity with zero vector");
+    }
+    return dot(other) / (mag1 * mag2);
+}
+
+} // namespace vectors
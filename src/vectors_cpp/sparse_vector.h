@@ -0,0 +1,81 @@
+#ifndef SPARSE_VECTOR_H
+#define SPARSE_VECTOR_H
+
+#include "vector_core.h"
+#include <cstdint>
+#include <vector>
+
+namespace vectors {
+
+// Position of a stored entry; 32 bits keep index arrays half the size of
+// size_t for the very wide feature spaces sparse vectors are used for
+using SparseIndex = uint32_t;
+
+/**
+ * SparseVectorND - n-dimensional vector storing only its non-zero entries
+ *
+ * Entries are kept as parallel index/value arrays sorted by index with no
+ * repeated indices and no zeros. Operations mirror VectorND and combine with both sparse
+ * and dense operands.
+ */
+class SparseVectorND {
+public:
+    explicit SparseVectorND(size_t dimensions);
+    // Entries may come in any order; repeated indices are summed and zeros
+    // dropped
+    SparseVectorND(size_t dimensions, std::vector<SparseIndex> indices,
+                   std::vector<double> values);
+
+    static SparseVectorND from_dense(const VectorND& dense);
+
+    size_t dimensions() const { return dim_; }
+    size_t nnz() const { return indices_.size(); }
+    const std::vector<SparseIndex>& indices() const { return indices_; }
+    const std::vector<double>& values() const { return values_; }
+
+    double get(size_t index) const;
+    VectorND to_dense() const;
+
+    // Sums and differences drop entries that cancel to zero
+    SparseVectorND operator+(const SparseVectorND& other) const;
+    SparseVectorND operator-(const SparseVectorND& other) const;
+    VectorND operator+(const VectorND& other) const;
+    SparseVectorND operator*(double scalar) const;
+
+    // Equal when every component differs by less than kEqualityTolerance
+    bool operator==(const SparseVectorND& other) const;
+    bool operator!=(const SparseVectorND& other) const { return !(*this == other); }
+
+    double magnitude() const;
+    double magnitude_squared() const;
+    double dot(const SparseVectorND& other) const;
+    double dot(const VectorND& other) const;
+    double cosine_similarity(const SparseVectorND& other) const;
+    double cosine_similarity(const VectorND& other) const;
+
+private:
+    size_t dim_;
+    std::vector<SparseIndex> indices_;
+    std::vector<double> values_;
+
+    void check_dimensions(size_t dimensions, const char* operation) const;
+    SparseVectorND merge(const SparseVectorND& other, double sign) const;
+};
+
+// Throws unless `dimensions` fits the SparseIndex range
+void check_sparse_dimensions(size_t dimensions);
+
+// Sorts entries by index and sums repeated indices, in place
+void canonicalize_sparse(std::vector<SparseIndex>& indices, std::vector<double>& values);
+
+// Dot product of two sorted entry lists. Lists of similar length are merged
+// without branches; a much shorter list gallops through the longer one.
+double sparse_dot(const SparseIndex* a_indices, const double* a_values, size_t a_nnz,
+                  const SparseIndex* b_indices, const double* b_values, size_t b_nnz);
+// Dot product of a sorted entry list with a dense array
+double sparse_dense_dot(const SparseIndex* indices, const double* values, size_t nnz,
+                        const double* dense);
+
+} // namespace vectors
+
+#endif // SPARSE_VECTOR_H
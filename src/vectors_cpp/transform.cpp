@@ -0,0 +1,210 @@
+#include "transform.h"
+#include "parallel.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace vectors {
+
+namespace {
+
+// Rows per task
+constexpr size_t kRowBlock = 1024;
+
+// Square matrices up to this size use the fixed-size kernels
+constexpr size_t kMaxFixedDim = 8;
+
+// Register blocking of the generic kernel: rows updated together, and the
+// width of the output tile kept hot while they are
+constexpr size_t kRowTile = 4;
+constexpr size_t kColumnTile = 256;
+
+struct Affine {
+    const Matrix& m;
+    const double* t;  // null for a linear map
+};
+
+// Output rows [begin, end) for D x D matrices, matrix held in locals
+template <size_t D>
+void transform_fixed(const BatchView& in, const Affine& map, double* out, size_t begin,
+                     size_t end) {
+    double a[D][D];
+    double b[D];
+    for (size_t i = 0; i < D; ++i) {
+        for (size_t k = 0; k < D; ++k) {
+            a[i][k] = map.m(i, k);
+        }
+        b[i] = map.t ? map.t[i] : 0.0;
+    }
+    for (size_t r = begin; r < end; ++r) {
+        const double* v = in.row(r);
+        double x[D];
+        for (size_t k = 0; k < D; ++k) {
+            x[k] = v[k];
+        }
+        double* o = out + r * D;
+        for (size_t i = 0; i < D; ++i) {
+            double sum = b[i];
+            for (size_t k = 0; k < D; ++k) {
+                sum += a[i][k] * x[k];
+            }
+            o[i] = sum;
+        }
+    }
+}
+
+// Output rows [begin, end) for any shape; `mt` is M transposed (K x N), so
+// each input component scales one contiguous row of it into the outputs
+void transform_generic(const BatchView& in, const Affine& map, const double* mt, double* out,
+                       size_t begin, size_t end) {
+    const size_t k_dim = in.dim;
+    const size_t n = map.m.rows();
+    for (size_t r = begin; r < end; r += kRowTile) {
+        size_t rows = std::min(kRowTile, end - r);
+        for (size_t j0 = 0; j0 < n; j0 += kColumnTile) {
+            size_t j1 = std::min(n, j0 + kColumnTile);
+            for (size_t q = 0; q < rows; ++q) {
+                double* o = out + (r + q) * n;
+                for (size_t j = j0; j < j1; ++j) {
+                    o[j] = map.t ? map.t[j] : 0.0;
+                }
+            }
+            if (rows == kRowTile) {
+                const double* a0 = in.row(r);
+                const double* a1 = in.row(r + 1);
+                const double* a2 = in.row(r + 2);
+                const double* a3 = in.row(r + 3);
+                double* o0 = out + r * n;
+                double* o1 = o0 + n;
+                double* o2 = o1 + n;
+                double* o3 = o2 + n;
+                for (size_t k = 0; k < k_dim; ++k) {
+                    const double x0 = a0[k], x1 = a1[k], x2 = a2[k], x3 = a3[k];
+                    const double* w = mt + k * n;
+                    for (size_t j = j0; j < j1; ++j) {
+                        o0[j] += x0 * w[j];
+                        o1[j] += x1 * w[j];
+                        o2[j] += x2 * w[j];
+                        o3[j] += x3 * w[j];
+                    }
+                }
+            } else {
+                for (size_t q = 0; q < rows; ++q) {
+                    const double* a = in.row(r + q);
+                    double* o = out + (r + q) * n;
+                    for (size_t k = 0; k < k_dim; ++k) {
+                        const double* w = mt + k * n;
+                        for (size_t j = j0; j < j1; ++j) {
+                            o[j] += a[k] * w[j];
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+void transform_fixed_dispatch(const BatchView& in, const Affine& map, double* out,
+                              size_t begin, size_t end) {
+    switch (map.m.rows()) {
+        case 2: transform_fixed<2>(in, map, out, begin, end); break;
+        case 3: transform_fixed<3>(in, map, out, begin, end); break;
+        case 4: transform_fixed<4>(in, map, out, begin, end); break;
+        case 5: transform_fixed<5>(in, map, out, begin, end); break;
+        case 6: transform_fixed<6>(in, map, out, begin, end); break;
+        case 7: transform_fixed<7>(in, map, out, begin, end); break;
+        case 8: transform_fixed<8>(in, map, out, begin, end); break;
+    }
+}
+
+bool overlaps(const BatchView& in, const VectorBatch& out) {
+    if (in.count == 0 || out.size() == 0) {
+        return false;
+    }
+    const double* in_end = in.row(in.count - 1) + in.dim;
+    const double* out_end = out.data() + out.size() * out.dimensions();
+    return in.data < out_end && out.data() < in_end;
+}
+
+void apply(const BatchView& vectors, const Affine& map, VectorBatch& result) {
+    const Matrix& m = map.m;
+    if (m.cols() != vectors.dim) {
+        throw std::runtime_error(
+            "Dimension mismatch in transform: " +
+            std::to_string(m.cols()) + " vs " + std::to_string(vectors.dim)
+        );
+    }
+    const bool fixed = m.is_square() && m.rows() >= 2 && m.rows() <= kMaxFixedDim;
+    // The fixed path reads a whole row before writing it, so it can run in
+    // place; the generic path accumulates into the output and cannot
+    if (result.size() != vectors.count || result.dimensions() != m.rows() ||
+        (!fixed && overlaps(vectors, result))) {
+        VectorBatch fresh(vectors.count, m.rows());
+        apply(vectors, map, fresh);
+        result = std::move(fresh);
+        return;
+    }
+
+    std::vector<double> mt;
+    if (!fixed) {
+        Matrix transposed = m.transpose();
+        mt.assign(transposed.data(), transposed.data() + m.rows() * m.cols());
+    }
+    double* out = result.data();
+    size_t blocks = (vectors.count + kRowBlock - 1) / kRowBlock;
+    auto task = [&](size_t b) {
+        size_t begin = b * kRowBlock;
+        size_t end = std::min(vectors.count, begin + kRowBlock);
+        if (fixed) {
+            transform_fixed_dispatch(vectors, map, out, begin, end);
+        } else {
+            transform_generic(vectors, map, mt.data(), out, begin, end);
+        }
+    };
+    parallel_for(blocks, vectors.count * m.rows() * m.cols(), task);
+}
+
+} // namespace
+
+void transform(const BatchView& vectors, const Matrix& m, VectorBatch& result) {
+    apply(vectors, Affine{m, nullptr}, result);
+}
+
+void transform_affine(const BatchView& vectors, const Matrix& m, const VectorND& t,
+                      VectorBatch& result) {
+    if (t.size() != m.rows()) {
+        throw std::runtime_error(
+            "Dimension mismatch in affine transform: " +
+            std::to_string(m.rows()) + " vs " + std::to_string(t.size())
+        );
+    }
+    apply(vectors, Affine{m, t.data().data()}, result);
+}
+
+void transform_affine(const BatchView& vectors, const Matrix& homogeneous, VectorBatch& result) {
+    size_t n = homogeneous.rows();
+    if (!homogeneous.is_square() || n != vectors.dim + 1) {
+        throw std::runtime_error(
+            "Homogeneous transform must be " + std::to_string(vectors.dim + 1) + "x" +
+            std::to_string(vectors.dim + 1)
+        );
+    }
+    for (size_t c = 0; c < n; ++c) {
+        if (homogeneous(n - 1, c) != (c + 1 == n ? 1.0 : 0.0)) {
+            throw std::runtime_error("Projective transforms are not supported; "
+                                     "the last row must be [0 ... 0 1]");
+        }
+    }
+    size_t d = vectors.dim;
+    Matrix linear(d, d);
+    VectorND t(d);
+    for (size_t r = 0; r < d; ++r) {
+        std::copy(homogeneous.row(r), homogeneous.row(r) + d, linear.data() + r * d);
+        t[r] = homogeneous(r, d);
+    }
+    transform_affine(vectors, linear, t, result);
+}
+
+} // namespace vectors
@@ -0,0 +1,32 @@
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include "matrix.h"
+#include "vector_batch.h"
+
+namespace vectors {
+
+/**
+ * Linear and affine maps over batches.
+ *
+ * Row i of the result is M * row_i (+ t). M has one column per input
+ * dimension and one row per output dimension, so non-square matrices
+ * project to a different dimension. `result` is reused when it already has
+ * the output shape and may be the input batch itself.
+ *
+ * Square matrices from 2x2 to 8x8 (3x3 and 4x4 included) run on a fixed-size
+ * path that keeps the matrix in registers; other shapes use a register-blocked
+ * kernel over the transposed matrix that the compiler vectorizes along the
+ * output dimension. Large batches are split over the worker threads.
+ */
+void transform(const BatchView& vectors, const Matrix& m, VectorBatch& result);
+void transform_affine(const BatchView& vectors, const Matrix& m, const VectorND& t,
+                      VectorBatch& result);
+
+// Homogeneous form: a (d+1)x(d+1) matrix whose last row is [0 ... 0 1]
+// applied to d-dimensional rows, e.g. a 4x4 transform applied to 3D points
+void transform_affine(const BatchView& vectors, const Matrix& homogeneous, VectorBatch& result);
+
+} // namespace vectors
+
+#endif // TRANSFORM_H
@@ -0,0 +1,165 @@
+#define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
+#include <pybind11/pybind11.h>
+#include <numpy/ndarraytypes.h>
+#include <numpy/ufuncobject.h>
+#include "reduction.h"
+#include <cmath>
+#include <vector>
+
+namespace py = pybind11;
+using namespace vectors;
+
+// NumPy generalized ufuncs over the core kernels. Each loop gets the outer
+// (broadcast) length in dimensions[0] and the core length in dimensions[1];
+// steps holds one outer byte stride per operand followed by the core
+// strides. Reductions go through the same kernels and default mode as
+// VectorND, so results match it bit for bit. Zero vectors are not rejected:
+// the division yields NaN and NumPy reports it as an invalid value.
+
+namespace {
+
+// Core dimension of one operand as contiguous doubles; strided operands are
+// gathered into `buffer`
+const double* gather(const char* p, npy_intp n, npy_intp step, std::vector<double>& buffer) {
+    if (step == static_cast<npy_intp>(sizeof(double))) {
+        return reinterpret_cast<const double*>(p);
+    }
+    buffer.resize(static_cast<size_t>(n));
+    for (npy_intp i = 0; i < n; ++i) {
+        buffer[i] = *reinterpret_cast<const double*>(p + i * step);
+    }
+    return buffer.data();
+}
+
+double& at(char* p, npy_intp i, npy_intp step) {
+    return *reinterpret_cast<double*>(p + i * step);
+}
+
+// (n),(n)->()
+void dot_loop(char** args, npy_intp const* dimensions, npy_intp const* steps, void*) {
+    const ReductionMode mode = get_reduction_mode();
+    const npy_intp count = dimensions[0], n = dimensions[1];
+    std::vector<double> a_buffer, b_buffer;
+    for (npy_intp k = 0; k < count; ++k) {
+        const double* a = gather(args[0] + k * steps[0], n, steps[3], a_buffer);
+        const double* b = gather(args[1] + k * steps[1], n, steps[4], b_buffer);
+        at(args[2], k, steps[2]) = reduce_dot(a, b, static_cast<size_t>(n), mode);
+    }
+}
+
+// (n),(n)->()
+void cosine_similarity_loop(char** args, npy_intp const* dimensions, npy_intp const* steps,
+                            void*) {
+    const ReductionMode mode = get_reduction_mode();
+    const npy_intp count = dimensions[0], n = dimensions[1];
+    const size_t len = static_cast<size_t>(n);
+    std::vector<double> a_buffer, b_buffer;
+    for (npy_intp k = 0; k < count; ++k) {
+        const double* a = gather(args[0] + k * steps[0], n, steps[3], a_buffer);
+        const double* b = gather(args[1] + k * steps[1], n, steps[4], b_buffer);
+        double norms = std::sqrt(reduce_sum_squares(a, len, mode)) *
+                       std::sqrt(reduce_sum_squares(b, len, mode));
+        at(args[2], k, steps[2]) = reduce_dot(a, b, len, mode) / norms;
+    }
+}
+
+// (n),(n)->()
+void distance_loop(char** args, npy_intp const* dimensions, npy_intp const* steps, void*) {
+    const ReductionMode mode = get_reduction_mode();
+    const npy_intp count = dimensions[0], n = dimensions[1];
+    std::vector<double> diff(static_cast<size_t>(n));
+    for (npy_intp k = 0; k < count; ++k) {
+        const char* a = args[0] + k * steps[0];
+        const char* b = args[1] + k * steps[1];
+        for (npy_intp i = 0; i < n; ++i) {
+            diff[i] = *reinterpret_cast<const double*>(a + i * steps[3]) -
+                      *reinterpret_cast<const double*>(b + i * steps[4]);
+        }
+        at(args[2], k, steps[2]) = std::sqrt(reduce_sum_squares(diff.data(), diff.size(), mode));
+    }
+}
+
+// (n)->()
+void magnitude_loop(char** args, npy_intp const* dimensions, npy_intp const* steps, void*) {
+    const ReductionMode mode = get_reduction_mode();
+    const npy_intp count = dimensions[0], n = dimensions[1];
+    std::vector<double> buffer;
+    for (npy_intp k = 0; k < count; ++k) {
+        const double* a = gather(args[0] + k * steps[0], n, steps[2], buffer);
+        at(args[1], k, steps[1]) = std::sqrt(reduce_sum_squares(a, static_cast<size_t>(n), mode));
+    }
+}
+
+// (n)->(n)
+void normalize_loop(char** args, npy_intp const* dimensions, npy_intp const* steps, void*) {
+    const ReductionMode mode = get_reduction_mode();
+    const npy_intp count = dimensions[0], n = dimensions[1];
+    std::vector<double> buffer;
+    for (npy_intp k = 0; k < count; ++k) {
+        const double* a = gather(args[0] + k * steps[0], n, steps[2], buffer);
+        double mag = std::sqrt(reduce_sum_squares(a, static_cast<size_t>(n), mode));
+        char* out = args[1] + k * steps[1];
+        for (npy_intp i = 0; i < n; ++i) {
+            at(out, i, steps[3]) = a[i] / mag;
+        }
+    }
+}
+
+// (3),(3)->(3)
+void cross_loop(char** args, npy_intp const* dimensions, npy_intp const* steps, void*) {
+    const npy_intp count = dimensions[0];
+    for (npy_intp k = 0; k < count; ++k) {
+        char* a = args[0] + k * steps[0];
+        char* b = args[1] + k * steps[1];
+        char* out = args[2] + k * steps[2];
+        double ax = at(a, 0, steps[3]), ay = at(a, 1, steps[3]), az = at(a, 2, steps[3]);
+        double bx = at(b, 0, steps[4]), by = at(b, 1, steps[4]), bz = at(b, 2, steps[4]);
+        at(out, 0, steps[5]) = ay * bz - az * by;
+        at(out, 1, steps[5]) = az * bx - ax * bz;
+        at(out, 2, steps[5]) = ax * by - ay * bx;
+    }
+}
+
+PyUFuncGenericFunction dot_loops[] = {&dot_loop};
+PyUFuncGenericFunction cosine_similarity_loops[] = {&cosine_similarity_loop};
+PyUFuncGenericFunction distance_loops[] = {&distance_loop};
+PyUFuncGenericFunction magnitude_loops[] = {&magnitude_loop};
+PyUFuncGenericFunction normalize_loops[] = {&normalize_loop};
+PyUFuncGenericFunction cross_loops[] = {&cross_loop};
+
+// One float64 loop per ufunc; other dtypes are cast to float64 by NumPy
+void* loop_data[] = {nullptr};
+char unary_types[] = {NPY_DOUBLE, NPY_DOUBLE};
+char binary_types[] = {NPY_DOUBLE, NPY_DOUBLE, NPY_DOUBLE};
+
+void add_gufunc(py::module& m, const char* name, PyUFuncGenericFunction* loops, int nin,
+                const char* signature, const char* doc) {
+    char* types = nin == 1 ? unary_types : binary_types;
+    PyObject* ufunc = PyUFunc_FromFuncAndDataAndSignature(
+        loops, loop_data, types, 1, nin, 1, PyUFunc_None, name, doc, 0, signature);
+    if (!ufunc) {
+        throw py::error_already_set();
+    }
+    m.add_object(name, py::reinterpret_steal<py::object>(ufunc));
+}
+
+} // namespace
+
+void init_ufunc_module(py::module &m) {
+    if (_import_umath() < 0) {
+        throw py::error_already_set();
+    }
+    py::module ufuncs = m.def_submodule("ufuncs", "NumPy generalized ufuncs over the core kernels");
+    add_gufunc(ufuncs, "dot", dot_loops, 2, "(n),(n)->()",
+               "Dot product over the last axis, broadcasting the others");
+    add_gufunc(ufuncs, "cross", cross_loops, 2, "(3),(3)->(3)",
+               "Cross product of 3-vectors over the last axis, broadcasting the others");
+    add_gufunc(ufuncs, "normalize", normalize_loops, 1, "(n)->(n)",
+               "Scales vectors along the last axis to unit length");
+    add_gufunc(ufuncs, "magnitude", magnitude_loops, 1, "(n)->()",
+               "Euclidean norm over the last axis");
+    add_gufunc(ufuncs, "distance", distance_loops, 2, "(n),(n)->()",
+               "Euclidean distance over the last axis, broadcasting the others");
+    add_gufunc(ufuncs, "cosine_similarity", cosine_similarity_loops, 2, "(n),(n)->()",
+               "Cosine similarity over the last axis, broadcasting the others");
+}
@@ -0,0 +1,325 @@
+#include "vector_batch.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <utility>
+
+namespace vectors {
+
+namespace {
+
+// Rows per task
+constexpr size_t kRowBlock = 4096;
+
+void check_same_shape(const BatchView& v1, const BatchView& v2, const char* operation) {
+    if (v1.count != v2.count) {
+        throw std::runtime_error(
+            std::string("Batch size mismatch in ") + operation + ": " +
+            std::to_string(v1.count) + " vs " + std::to_string(v2.count)
+        );
+    }
+    if (v1.dim != v2.dim) {
+        throw std::runtime_error(
+            std::string("Dimension mismatch in ") + operation + ": " +
+            std::to_string(v1.dim) + " vs " + std::to_string(v2.dim)
+        );
+    }
+}
+
+// Runs body(begin, end) over row blocks, in parallel for large batches
+template <typename Body>
+void for_each_row_block(size_t count, size_t dim, const Body& body) {
+    size_t blocks = (count + kRowBlock - 1) / kRowBlock;
+    auto task = [&](size_t b) {
+        body(b * kRowBlock, std::min(count, (b + 1) * kRowBlock));
+    };
+    parallel_for(blocks, count * dim, task);
+}
+
+void check_query(const BatchView& vectors, const VectorND& query, const char* operation) {
+    if (query.size() != vectors.dim) {
+        throw std::runtime_error(
+            std::string("Dimension mismatch in ") + operation + ": " +
+            std::to_string(vectors.dim) + " vs " + std::to_string(query.size())
+        );
+    }
+}
+
+double distance_squared(const double* a, const double* b, size_t dim) {
+    double sum = 0.0;
+    for (size_t i = 0; i < dim; ++i) {
+        double d = a[i] - b[i];
+        sum += d * d;
+    }
+    return sum;
+}
+
+double row_norm(const double* row, size_t dim, ReductionMode mode) {
+    return std::sqrt(reduce_sum_squares(row, dim, mode));
+}
+
+void check_nonzero(double norm, const char* message) {
+    if (norm < std::numeric_limits<double>::epsilon()) {
+        throw std::runtime_error(message);
+    }
+}
+
+bool closer(const Neighbor& a, const Neighbor& b) {
+    return a.distance < b.distance || (a.distance == b.distance && a.index < b.index);
+}
+
+// Values in `count` rows of `dim`; throws instead of letting the product wrap
+size_t batch_values(size_t count, size_t dim) {
+    if (dim != 0 && count > std::vector<double>().max_size() / dim) {
+        throw std::runtime_error(
+            "Batch too large: " + std::to_string(count) + " rows of " + std::to_string(dim)
+        );
+    }
+    return count * dim;
+}
+
+} // namespace
+
+// VectorBatch
+
+VectorBatch::VectorBatch(size_t dimensions) : dim_(dimensions), count_(0) {}
+
+VectorBatch::VectorBatch(size_t count, size_t dimensions)
+    : dim_(dimensions), count_(count), data_(batch_values(count, dimensions), 0.0) {}
+
+VectorBatch::VectorBatch(const VectorND* vectors, size_t count)
+    : dim_(count > 0 ? vectors[0].size() : 0), count_(0) {
+    reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        append(vectors[i]);
+    }
+}
+
+VectorBatch::VectorBatch(const BatchView& view)
+    : dim_(view.dim), count_(view.count), data_(view.count * view.dim) {
+    for (size_t i = 0; i < view.count; ++i) {
+        std::copy(view.row(i), view.row(i) + dim_, row(i));
+    }
+}
+
+void VectorBatch::check_dimensions(size_t dimensions, const char* operation) const {
+    if (dimensions != dim_) {
+        throw std::runtime_error(
+            std::string("Dimension mismatch in ") + operation +
+            ": " + std::to_string(dim_) + " vs " + std::to_string(dimensions)
+        );
+    }
+}
+
+VectorND VectorBatch::get(size_t index) const {
+    if (index >= count_) {
+        throw std::out_of_range("Batch index out of range");
+    }
+    return VectorND(std::vector<double>(row(index), row(index) + dim_));
+}
+
+void VectorBatch::set(size_t index, const VectorND& v) {
+    if (index >= count_) {
+        throw std::out_of_range("Batch index out of range");
+    }
+    check_dimensions(v.size(), "batch set");
+    std::copy(v.data().begin(), v.data().end(), row(index));
+}
+
+void VectorBatch::append(const VectorND& v) {
+    check_dimensions(v.size(), "batch append");
+    append(v.data().data());
+}
+
+void VectorBatch::append(const double* row) {
+    data_.insert(data_.end(), row, row + dim_);
+    ++count_;
+}
+
+void VectorBatch::reserve(size_t count) {
+    data_.reserve(count * dim_);
+}
+
+void VectorBatch::resize(size_t count) {
+    data_.resize(batch_values(count, dim_), 0.0);
+    count_ = count;
+}
+
+void VectorBatch::clear() {
+    data_.clear();
+    count_ = 0;
+}
+
+// Batch kernels
+
+void batch_add(const BatchView& v1, const BatchView& v2, VectorBatch& result) {
+    check_same_shape(v1, v2, "batch add");
+    // Built aside and moved in last, since v1 or v2 may view `result`
+    VectorBatch sum(v1.count, v1.dim);
+    for_each_row_block(v1.count, v1.dim, [&](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; ++r) {
+            const double* a = v1.row(r);
+            const double* b = v2.row(r);
+            double* out = sum.row(r);
+            for (size_t i = 0; i < v1.dim; ++i) {
+                out[i] = a[i] + b[i];
+            }
+        }
+    });
+    result = std::move(sum);
+}
+
+void batch_dot_product(const BatchView& v1, const BatchView& v2, double* result) {
+    check_same_shape(v1, v2, "batch dot product");
+    const ReductionMode mode = get_reduction_mode();
+    for_each_row_block(v1.count, v1.dim, [&](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; ++r) {
+            result[r] = reduce_dot(v1.row(r), v2.row(r), v1.dim, mode);
+        }
+    });
+}
+
+void batch_distance(const BatchView& vectors, const VectorND& query, double* result) {
+    check_query(vectors, query, "batch distance");
+    const double* q = query.data().data();
+    for_each_row_block(vectors.count, vectors.dim, [&](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; ++r) {
+            result[r] = std::sqrt(distance_squared(vectors.row(r), q, vectors.dim));
+        }
+    });
+}
+
+void batch_norms(const BatchView& vectors, double* result) {
+    const ReductionMode mode = get_reduction_mode();
+    for_each_row_block(vectors.count, vectors.dim, [&](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; ++r) {
+            result[r] = row_norm(vectors.row(r), vectors.dim, mode);
+        }
+    });
+}
+
+void batch_cosine_similarity(const BatchView& vectors, const VectorND& query, double* result) {
+    check_query(vectors, query, "batch cosine similarity");
+    const ReductionMode mode = get_reduction_mode();
+    const double* q = query.data().data();
+    double query_norm = row_norm(q, vectors.dim, mode);
+    check_nonzero(query_norm, "Cannot calculate cosine similarity with zero vector");
+    for_each_row_block(vectors.count, vectors.dim, [&](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; ++r) {
+            const double* row = vectors.row(r);
+            double norm = row_norm(row, vectors.dim, mode);
+            check_nonzero(norm, "Cannot calculate cosine similarity with zero vector");
+            result[r] = reduce_dot(row, q, vectors.dim, mode) / (norm * query_norm);
+        }
+    });
+}
+
+void batch_normalize(VectorBatch& vectors) {
+    const BatchView view = vectors.view();
+    batch_normalize(view, vectors);
+}
+
+void batch_normalize(const BatchView& vectors, VectorBatch& result) {
+    // Writes go row by row after that row's norm is known, so `vectors` may
+    // alias `result`; a reshaped result is built aside for the same reason
+    if (result.size() != vectors.count || result.dimensions() != vectors.dim) {
+        VectorBatch reshaped(vectors.count, vectors.dim);
+        batch_normalize(vectors, reshaped);
+        result = std::move(reshaped);
+        return;
+    }
+    const ReductionMode mode = get_reduction_mode();
+    for_each_row_block(vectors.count, vectors.dim, [&](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; ++r) {
+            const double* row = vectors.row(r);
+            double norm = row_norm(row, vectors.dim, mode);
+            check_nonzero(norm, "Cannot normalize zero vector");
+            double* out = result.row(r);
+            for (size_t i = 0; i < vectors.dim; ++i) {
+                out[i] = row[i] / norm;
+            }
+        }
+    });
+}
+
+std::vector<Neighbor> k_nearest(const BatchView& vectors, const VectorND& query, size_t k) {
+    check_query(vectors, query, "nearest neighbor search");
+    k = std::min(k, vectors.count);
+    if (k == 0) {
+        return {};
+    }
+
+    // Each block keeps its own k best in a max-heap; the blocks are merged after
+    const double* q = query.data().data();
+    size_t blocks = (vectors.count + kRowBlock - 1) / kRowBlock;
+    std::vector<std::vector<Neighbor>> candidates(blocks);
+    for_each_row_block(vectors.count, vectors.dim, [&](size_t begin, size_t end) {
+        std::vector<Neighbor>& heap = candidates[begin / kRowBlock];
+        heap.reserve(std::min(k, end - begin));
+        for (size_t r = begin; r < end; ++r) {
+            Neighbor n{r, distance_squared(vectors.row(r), q, vectors.dim)};
+            if (heap.size() < k) {
+                heap.push_back(n);
+                std::push_heap(heap.begin(), heap.end(), closer);
+            } else if (closer(n, heap.front())) {
+                std::pop_heap(heap.begin(), heap.end(), closer);
+                heap.back() = n;
+                std::push_heap(heap.begin(), heap.end(), closer);
+            }
+        }
+    });
+
+    std::vector<Neighbor> result;
+    for (const auto& heap : candidates) {
+        result.insert(result.end(), heap.begin(), heap.end());
+    }
+    std::partial_sort(result.begin(), result.begin() + k, result.end(), closer);
+    result.resize(k);
+    for (auto& n : result) {
+        n.distance = std::sqrt(n.distance);
+    }
+    return result;
+}
+
+VectorND centroid(const BatchView& vectors) {
+    return centroid(vectors, get_reduction_mode());
+}
+
+VectorND centroid(const BatchView& vectors, ReductionMode mode) {
+    if (vectors.count == 0) {
+        throw std::runtime_error("Cannot calculate centroid of empty array");
+    }
+    VectorND result(vectors.dim);
+    reduce_rows(vectors.data, vectors.count, vectors.dim, vectors.stride,
+                result.data().data(), mode);
+    for (size_t i = 0; i < vectors.dim; ++i) {
+        result[i] /= static_cast<double>(vectors.count);
+    }
+    return result;
+}
+
+VectorND weighted_average(const BatchView& vectors, const double* weights) {
+    if (vectors.count == 0) {
+        throw std::runtime_error("Cannot calculate weighted average of empty array");
+    }
+
+    VectorND sum(vectors.dim);
+    double total_weight = 0.0;
+    for (size_t r = 0; r < vectors.count; ++r) {
+        const double* row = vectors.row(r);
+        for (size_t i = 0; i < vectors.dim; ++i) {
+            sum[i] += row[i] * weights[r];
+        }
+        total_weight += weights[r];
+    }
+
+    if (total_weight < std::numeric_limits<double>::epsilon()) {
+        throw std::runtime_error("Total weight cannot be zero");
+    }
+
+    return sum / total_weight;
+}
+
+} // namespace vectors
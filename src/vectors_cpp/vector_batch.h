@@ -0,0 +1,88 @@
+#ifndef VECTOR_BATCH_H
+#define VECTOR_BATCH_H
+
+#include "vector_core.h"
+#include <vector>
+
+namespace vectors {
+
+/**
+ * BatchView - Non-owning view of `count` vectors of length `dim`
+ *
+ * Row i starts at data + i * stride (in elements). Every batch kernel takes a
+ * view, so the same code runs over owned batches, memory-mapped files and
+ * NumPy arrays without copying.
+ */
+struct BatchView {
+    const double* data;
+    size_t count;
+    size_t dim;
+    size_t stride;
+
+    const double* row(size_t i) const { return data + i * stride; }
+    // Rows [begin, end) as a view of their own
+    BatchView rows(size_t begin, size_t end) const {
+        return BatchView{row(begin), end - begin, dim, stride};
+    }
+};
+
+/**
+ * VectorBatch - Owning, contiguous row-major batch of equal-length vectors
+ */
+class VectorBatch {
+public:
+    explicit VectorBatch(size_t dimensions);
+    VectorBatch(size_t count, size_t dimensions);
+    VectorBatch(const VectorND* vectors, size_t count);
+    explicit VectorBatch(const BatchView& view);
+
+    size_t size() const { return count_; }
+    size_t dimensions() const { return dim_; }
+
+    const double* data() const { return data_.data(); }
+    double* data() { return data_.data(); }
+    const double* row(size_t i) const { return data_.data() + i * dim_; }
+    double* row(size_t i) { return data_.data() + i * dim_; }
+
+    VectorND get(size_t index) const;
+    void set(size_t index, const VectorND& v);
+    void append(const VectorND& v);
+    void append(const double* row);
+    void reserve(size_t count);
+    void resize(size_t count);
+    void clear();
+
+    BatchView view() const { return BatchView{data_.data(), count_, dim_, dim_}; }
+
+private:
+    size_t dim_;
+    size_t count_;
+    std::vector<double> data_;
+
+    void check_dimensions(size_t dimensions, const char* operation) const;
+};
+
+// Row of a batch and its distance to a query
+struct Neighbor {
+    size_t index;
+    double distance;
+};
+
+// Batch kernels over views
+void batch_add(const BatchView& v1, const BatchView& v2, VectorBatch& result);
+void batch_dot_product(const BatchView& v1, const BatchView& v2, double* result);
+void batch_distance(const BatchView& vectors, const VectorND& query, double* result);
+void batch_norms(const BatchView& vectors, double* result);
+void batch_cosine_similarity(const BatchView& vectors, const VectorND& query, double* result);
+// Scales every row to unit length, in place or into `result`
+void batch_normalize(VectorBatch& vectors);
+void batch_normalize(const BatchView& vectors, VectorBatch& result);
+// Exact k nearest rows by Euclidean distance, closest first (ties by index)
+std::vector<Neighbor> k_nearest(const BatchView& vectors, const VectorND& query, size_t k);
+VectorND centroid(const BatchView& vectors);
+VectorND centroid(const BatchView& vectors, ReductionMode mode);
+VectorND weighted_average(const BatchView& vectors, const double* weights);
+
+} // namespace vectors
+
+#endif // VECTOR_BATCH_H
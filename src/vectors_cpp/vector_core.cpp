@@ -1,35 +1,55 @@
 #include "vector_core.h"
+#include "allocator.h"
+#include "parallel.h"
 #include <limits>
 #include <algorithm>
-#include <numeric>
 
 namespace vectors {
 
-// Constructors
-VectorND::VectorND() : data_(3, 0.0) {}
+// Constructors; storage comes from the thread's pool (see allocator.h)
+VectorND::VectorND() : data_(detail::pool_acquire(3, 0.0)) {}
 
-VectorND::VectorND(size_t dimensions) : data_(dimensions, 0.0) {}
+VectorND::VectorND(size_t dimensions) : data_(detail::pool_acquire(dimensions, 0.0)) {}
 
-VectorND::VectorND(size_t dimensions, double value) : data_(dimensions, value) {}
+VectorND::VectorND(size_t dimensions, double value)
+    : data_(detail::pool_acquire(dimensions, value)) {}
 
-VectorND::VectorND(const std::vector<double>& data) : data_(data) {}
+VectorND::VectorND(const std::vector<double>& data)
+    : data_(detail::pool_acquire(data.size(), 0.0)) {
+    std::copy(data.begin(), data.end(), data_.begin());
+}
 
-VectorND::VectorND(std::initializer_list<double> data) : data_(data) {}
+VectorND::VectorND(std::initializer_list<double> data)
+    : data_(detail::pool_acquire(data.size(), 0.0)) {
+    std::copy(data.begin(), data.end(), data_.begin());
+}
 
-VectorND::VectorND(const VectorND& other) : data_(other.data_) {}
+VectorND::VectorND(const VectorND& other) : data_(detail::pool_acquire(other.size(), 0.0)) {
+    std::copy(other.data_.begin(), other.data_.end(), data_.begin());
+}
 
 VectorND::VectorND(VectorND&& other) noexcept : data_(std::move(other.data_)) {}
 
+VectorND::~VectorND() {
+    detail::pool_release(data_);
+}
+
 // Assignment operators
 VectorND& VectorND::operator=(const VectorND& other) {
     if (this != &other) {
-        data_ = other.data_;
+        if (data_.size() != other.data_.size()) {
+            std::vector<double> storage = detail::pool_acquire(other.size(), 0.0);
+            detail::pool_release(data_);
+            data_ = std::move(storage);
+        }
+        std::copy(other.data_.begin(), other.data_.end(), data_.begin());
     }
     return *this;
 }
 
 VectorND& VectorND::operator=(VectorND&& other) noexcept {
     if (this != &other) {
+        detail::pool_release(data_);
         data_ = std::move(other.data_);
     }
     return *this;
@@ -50,14 +70,6 @@ void VectorND::set(size_t index, double value) {
     data_[index] = value;
 }
 
-double VectorND::operator[](size_t index) const {
-    return data_[index];
-}
-
-double& VectorND::operator[](size_t index) {
-    return data_[index];
-}
-
 // Convenience accessors for 2D/3D
 double VectorND::x() const { return data_.size() > 0 ? data_[0] : 0.0; }
 double VectorND::y() const { return data_.size() > 1 ? data_[1] : 0.0; }
@@ -76,67 +88,82 @@ void VectorND::set_z(double z) {
 }
 
 // Dimension checking
-void VectorND::check_dimensions(const VectorND& other, const char* operation) const {
-    if (data_.size() != other.data_.size()) {
-        throw std::runtime_error(
-            std::string("Dimension mismatch in ") + operation + 
-            ": " + std::to_string(data_.size()) + 
-            " vs " + std::to_string(other.data_.size())
-        );
+void VectorND::dimension_mismatch(const VectorND& other, const char* operation) const {
+    throw std::runtime_error(
+        std::string("Dimension mismatch in ") + operation + 
+        ": " + std::to_string(data_.size()) + 
+        " vs " + std::to_string(other.data_.size())
+    );
+}
+
+void check_batch_dimensions(const VectorND* vectors, size_t count, size_t dimensions,
+                            const char* operation) {
+    for (size_t i = 0; i < count; ++i) {
+        if (vectors[i].size() != dimensions) {
+            throw std::runtime_error(
+                std::string("Dimension mismatch in ") + operation + ": " +
+                std::to_string(dimensions) + " vs " + std::to_string(vectors[i].size())
+            );
+        }
     }
 }
 
-// Arithmetic operations
+// Arithmetic operations; the returning forms fill a new vector through the
+// destination overloads below
 VectorND VectorND::operator+(const VectorND& other) const {
-    check_dimensions(other, "addition");
     VectorND result(data_.size());
-    for (size_t i = 0; i < data_.size(); ++i) {
-        result.data_[i] = data_[i] + other.data_[i];
-    }
+    add(*this, other, result);
     return result;
 }
 
 VectorND VectorND::operator-(const VectorND& other) const {
-    check_dimensions(other, "subtraction");
     VectorND result(data_.size());
-    for (size_t i = 0; i < data_.size(); ++i) {
-        result.data_[i] = data_[i] - other.data_[i];
-    }
+    subtract(*this, other, result);
     return result;
 }
 
 VectorND VectorND::operator*(double scalar) const {
     VectorND result(data_.size());
-    for (size_t i = 0; i < data_.size(); ++i) {
-        result.data_[i] = data_[i] * scalar;
-    }
+    scale(*this, scalar, result);
     return result;
 }
 
 VectorND VectorND::operator/(double scalar) const {
-    if (scalar == 0.0) {
-        throw std::runtime_error("Division by zero");
-    }
     VectorND result(data_.size());
-    for (size_t i = 0; i < data_.size(); ++i) {
-        result.data_[i] = data_[i] / scalar;
-    }
+    divide(*this, scalar, result);
     return result;
 }
 
 VectorND VectorND::operator-() const {
     VectorND result(data_.size());
-    for (size_t i = 0; i < data_.size(); ++i) {
-        result.data_[i] = -data_[i];
-    }
+    negate(*this, result);
     return result;
 }
 
+VectorND& VectorND::operator+=(const VectorND& other) {
+    add(*this, other, *this);
+    return *this;
+}
+
+VectorND& VectorND::operator-=(const VectorND& other) {
+    subtract(*this, other, *this);
+    return *this;
+}
+
+VectorND& VectorND::operator*=(double scalar) {
+    scale(*this, scalar, *this);
+    return *this;
+}
+
+VectorND& VectorND::operator/=(double scalar) {
+    divide(*this, scalar, *this);
+    return *this;
+}
+
 bool VectorND::operator==(const VectorND& other) const {
     if (data_.size() != other.data_.size()) return false;
-    const double eps = 1e-9;
     for (size_t i = 0; i < data_.size(); ++i) {
-        if (std::abs(data_[i] - other.data_[i]) >= eps) {
+        if (std::abs(data_[i] - other.data_[i]) >= kEqualityTolerance) {
             return false;
         }
     }
@@ -149,49 +176,27 @@ bool VectorND::operator!=(const VectorND& other) const {
 
 // Vector operations
 double VectorND::magnitude() const {
-    if (data_.empty()) return 0.0;
-    double sum_sq = 0.0;
-    for (double val : data_) {
-        sum_sq += val * val;
-    }
-    return std::sqrt(sum_sq);
+    return std::sqrt(magnitude_squared());
 }
 
 double VectorND::magnitude_squared() const {
-    if (data_.empty()) return 0.0;
-    double sum_sq = 0.0;
-    for (double val : data_) {
-        sum_sq += val * val;
-    }
-    return sum_sq;
+    return reduce_sum_squares(data_.data(), data_.size(), get_reduction_mode());
 }
 
 VectorND VectorND::normalize() const {
-    double mag = magnitude();
-    if (mag < std::numeric_limits<double>::epsilon()) {
-        throw std::runtime_error("Cannot normalize zero vector");
-    }
-    return *this / mag;
+    VectorND result(data_.size());
+    vectors::normalize(*this, result);
+    return result;
 }
 
 double VectorND::dot(const VectorND& other) const {
     check_dimensions(other, "dot product");
-    double result = 0.0;
-    for (size_t i = 0; i < data_.size(); ++i) {
-        result += data_[i] * other.data_[i];
-    }
-    return result;
+    return reduce_dot(data_.data(), other.data_.data(), data_.size(), get_reduction_mode());
 }
 
 VectorND VectorND::cross(const VectorND& other) const {
-    if (data_.size() != 3 || other.data_.size() != 3) {
-        throw std::runtime_error("Cross product only defined for 3D vectors");
-    }
-    
     VectorND result(3);
-    result[0] = data_[1] * other.data_[2] - data_[2] * other.data_[1];
-    result[1] = data_[2] * other.data_[0] - data_[0] * other.data_[2];
-    result[2] = data_[0] * other.data_[1] - data_[1] * other.data_[0];
+    vectors::cross(*this, other, result);
     return result;
 }
 
@@ -222,41 +227,27 @@ double VectorND::angle_between(const VectorND& other) const {
 }
 
 VectorND VectorND::projection(const VectorND& onto) const {
-    check_dimensions(onto, "projection");
-    double mag2_sq = onto.magnitude_squared();
-    
-    if (mag2_sq < std::numeric_limits<double>::epsilon()) {
-        throw std::runtime_error("Cannot project onto zero vector");
-    }
-    
-    double scalar = this->dot(onto) / mag2_sq;
-    return onto * scalar;
+    VectorND result(data_.size());
+    vectors::projection(*this, onto, result);
+    return result;
 }
 
 VectorND VectorND::reflection(const VectorND& normal) const {
-    check_dimensions(normal, "reflection");
-    return *this - normal * (2.0 * this->dot(normal));
+    VectorND result(data_.size());
+    vectors::reflection(*this, normal, result);
+    return result;
 }
 
 VectorND VectorND::rotate(const VectorND& axis, double angle) const {
-    if (data_.size() != 3) {
-        throw std::runtime_error("Rotation only defined for 3D vectors");
-    }
-    
-    // Rodrigues' rotation formula
-    double cos_a = std::cos(angle);
-    double sin_a = std::sin(angle);
-    
-    VectorND term1 = *this * cos_a;
-    VectorND term2 = this->cross(axis) * sin_a;
-    VectorND term3 = axis * (axis.dot(*this) * (1.0 - cos_a));
-    
-    return term1 + term2 + term3;
+    VectorND result(data_.size());
+    vectors::rotate(*this, axis, angle, result);
+    return result;
 }
 
 VectorND VectorND::lerp(const VectorND& other, double t) const {
-    check_dimensions(other, "lerp");
-    return *this + (other - *this) * t;
+    VectorND result(data_.size());
+    vectors::lerp(*this, other, t, result);
+    return result;
 }
 
 double VectorND::cosine_similarity(const VectorND& other) const {
@@ -272,14 +263,8 @@ double VectorND::cosine_similarity(const VectorND& other) const {
 }
 
 VectorND VectorND::clamp(double min_val, double max_val) const {
-    if (min_val > max_val) {
-        throw std::runtime_error("Invalid clamp range");
-    }
-    
     VectorND result(data_.size());
-    for (size_t i = 0; i < data_.size(); ++i) {
-        result.data_[i] = std::max(min_val, std::min(max_val, data_[i]));
-    }
+    vectors::clamp(*this, min_val, max_val, result);
     return result;
 }
 
@@ -291,29 +276,203 @@ void VectorND::resize(size_t new_size, double value) {
     data_.resize(new_size, value);
 }
 
+// Destination overloads. Every check runs before `out` is resized or
+// written, and each element is read before it is overwritten, so `out` may
+// alias an input.
+void add(const VectorND& a, const VectorND& b, VectorND& out) {
+    a.check_dimensions(b, "addition");
+    out.resize(a.size());
+    add_unchecked(a.data().data(), b.data().data(), out.data().data(), a.size());
+}
+
+void subtract(const VectorND& a, const VectorND& b, VectorND& out) {
+    a.check_dimensions(b, "subtraction");
+    out.resize(a.size());
+    subtract_unchecked(a.data().data(), b.data().data(), out.data().data(), a.size());
+}
+
+void scale(const VectorND& a, double scalar, VectorND& out) {
+    out.resize(a.size());
+    scale_unchecked(a.data().data(), scalar, out.data().data(), a.size());
+}
+
+void divide(const VectorND& a, double scalar, VectorND& out) {
+    if (scalar == 0.0) {
+        throw std::runtime_error("Division by zero");
+    }
+    out.resize(a.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+        out[i] = a[i] / scalar;
+    }
+}
+
+void negate(const VectorND& a, VectorND& out) {
+    out.resize(a.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+        out[i] = -a[i];
+    }
+}
+
+void normalize(const VectorND& a, VectorND& out) {
+    double mag = a.magnitude();
+    if (mag < std::numeric_limits<double>::epsilon()) {
+        throw std::runtime_error("Cannot normalize zero vector");
+    }
+    divide(a, mag, out);
+}
+
+void cross(const VectorND& a, const VectorND& b, VectorND& out) {
+    if (a.size() != 3 || b.size() != 3) {
+        throw std::runtime_error("Cross product only defined for 3D vectors");
+    }
+    double x = a[1] * b[2] - a[2] * b[1];
+    double y = a[2] * b[0] - a[0] * b[2];
+    double z = a[0] * b[1] - a[1] * b[0];
+    out.resize(3);
+    out[0] = x;
+    out[1] = y;
+    out[2] = z;
+}
+
+void projection(const VectorND& a, const VectorND& onto, VectorND& out) {
+    a.check_dimensions(onto, "projection");
+    double mag2_sq = onto.magnitude_squared();
+    
+    if (mag2_sq < std::numeric_limits<double>::epsilon()) {
+        throw std::runtime_error("Cannot project onto zero vector");
+    }
+    
+    double scalar = a.dot(onto) / mag2_sq;
+    scale(onto, scalar, out);
+}
+
+void reflection(const VectorND& a, const VectorND& normal, VectorND& out) {
+    a.check_dimensions(normal, "reflection");
+    double k = 2.0 * a.dot(normal);
+    out.resize(a.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+        out[i] = a[i] - normal[i] * k;
+    }
+}
+
+void rotate(const VectorND& a, const VectorND& axis, double angle, VectorND& out) {
+    if (a.size() != 3) {
+        throw std::runtime_error("Rotation only defined for 3D vectors");
+    }
+    if (axis.size() != 3) {
+        throw std::runtime_error("Cross product only defined for 3D vectors");
+    }
+    
+    // Rodrigues' rotation formula, summed per component in the same order
+    // as term1 + term2 + term3
+    double cos_a = std::cos(angle);
+    double sin_a = std::sin(angle);
+    double k = axis.dot(a) * (1.0 - cos_a);
+    double c[3] = {
+        a[1] * axis[2] - a[2] * axis[1],
+        a[2] * axis[0] - a[0] * axis[2],
+        a[0] * axis[1] - a[1] * axis[0],
+    };
+    
+    out.resize(3);
+    for (size_t i = 0; i < 3; ++i) {
+        out[i] = (a[i] * cos_a + c[i] * sin_a) + axis[i] * k;
+    }
+}
+
+void lerp(const VectorND& a, const VectorND& b, double t, VectorND& out) {
+    a.check_dimensions(b, "lerp");
+    out.resize(a.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+        out[i] = a[i] + (b[i] - a[i]) * t;
+    }
+}
+
+void clamp(const VectorND& a, double min_val, double max_val, VectorND& out) {
+    if (min_val > max_val) {
+        throw std::runtime_error("Invalid clamp range");
+    }
+    
+    out.resize(a.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+        out[i] = std::max(min_val, std::min(max_val, a[i]));
+    }
+}
+
+namespace {
+
+// Rows per task
+constexpr size_t kRowBlock = 4096;
+
+// Runs body(i) for every row, in row blocks spread over the pool when the
+// batch is above the parallel threshold, like the VectorBatch kernels
+template <typename Body>
+void for_each_row(size_t count, size_t dim, const Body& body) {
+    size_t blocks = (count + kRowBlock - 1) / kRowBlock;
+    parallel_for(blocks, count * dim, [&](size_t b) {
+        size_t end = std::min(count, (b + 1) * kRowBlock);
+        for (size_t i = b * kRowBlock; i < end; ++i) {
+            body(i);
+        }
+    });
+}
+
+} // namespace
+
 // Non-member batch operations
 void batch_add(VectorND* v1, VectorND* v2, VectorND* result, size_t count) {
-    for (size_t i = 0; i < count; ++i) {
-        result[i] = v1[i] + v2[i];
+    if (count == 0) {
+        return;
     }
+    size_t dim = v1[0].size();
+    check_batch_dimensions(v1, count, dim, "addition");
+    check_batch_dimensions(v2, count, dim, "addition");
+    for_each_row(count, dim, [&](size_t i) {
+        result[i].resize(dim);
+        add_into(v1[i], v2[i], result[i]);
+    });
 }
 
 void batch_dot_product(const VectorND* v1, const VectorND* v2, double* result, size_t count) {
-    for (size_t i = 0; i < count; ++i) {
-        result[i] = v1[i].dot(v2[i]);
+    if (count == 0) {
+        return;
     }
+    size_t dim = v1[0].size();
+    check_batch_dimensions(v1, count, dim, "dot product");
+    check_batch_dimensions(v2, count, dim, "dot product");
+    const ReductionMode mode = get_reduction_mode();
+    for_each_row(count, dim, [&](size_t i) {
+        result[i] = reduce_dot(v1[i].data().data(), v2[i].data().data(), dim, mode);
+    });
 }
 
 VectorND centroid(const VectorND* vectors, size_t count) {
+    return centroid(vectors, count, get_reduction_mode());
+}
+
+VectorND centroid(const VectorND* vectors, size_t count, ReductionMode mode) {
     if (count == 0) {
         throw std::runtime_error("Cannot calculate centroid of empty array");
     }
     
-    VectorND sum = vectors[0];
-    for (size_t i = 1; i < count; ++i) {
-        sum = sum + vectors[i];
+    size_t dim = vectors[0].size();
+    std::vector<const double*> rows(count);
+    for (size_t i = 0; i < count; ++i) {
+        if (vectors[i].size() != dim) {
+            throw std::runtime_error(
+                "Dimension mismatch in centroid: " + std::to_string(dim) +
+                " vs " + std::to_string(vectors[i].size())
+            );
+        }
+        rows[i] = vectors[i].data().data();
+    }
+    
+    VectorND result(dim);
+    reduce_rows(rows.data(), count, dim, result.data().data(), mode);
+    for (size_t i = 0; i < dim; ++i) {
+        result[i] /= static_cast<double>(count);
     }
-    return sum / static_cast<double>(count);
+    return result;
 }
 
 VectorND weighted_average(const VectorND* vectors, const double* weights, size_t count) {
@@ -321,11 +480,15 @@ VectorND weighted_average(const VectorND* vectors, const double* weights, size_t
         throw std::runtime_error("Cannot calculate weighted average of empty array");
     }
     
+    size_t dim = vectors[0].size();
+    check_batch_dimensions(vectors, count, dim, "weighted average");
     VectorND sum = vectors[0] * weights[0];
+    VectorND term(dim);
     double total_weight = weights[0];
     
     for (size_t i = 1; i < count; ++i) {
-        sum = sum + vectors[i] * weights[i];
+        scale_into(vectors[i], weights[i], term);
+        add_into(sum, term, sum);
         total_weight += weights[i];
     }
     
@@ -338,34 +501,50 @@ VectorND weighted_average(const VectorND* vectors, const double* weights, size_t
 
 // Element-wise operations
 VectorND element_wise_multiply(const VectorND& v1, const VectorND& v2) {
+    VectorND result(v1.size());
+    element_wise_multiply(v1, v2, result);
+    return result;
+}
+
+VectorND element_wise_divide(const VectorND& v1, const VectorND& v2) {
+    VectorND result(v1.size());
+    element_wise_divide(v1, v2, result);
+    return result;
+}
+
+void element_wise_multiply(const VectorND& v1, const VectorND& v2, VectorND& out) {
     if (v1.size() != v2.size()) {
         throw std::runtime_error("Dimension mismatch in element-wise multiply");
     }
     
-    VectorND result(v1.size());
+    out.resize(v1.size());
     for (size_t i = 0; i < v1.size(); ++i) {
-        result[i] = v1[i] * v2[i];
+        out[i] = v1[i] * v2[i];
     }
-    return result;
 }
 
-VectorND element_wise_divide(const VectorND& v1, const VectorND& v2) {
+void element_wise_divide(const VectorND& v1, const VectorND& v2, VectorND& out) {
     if (v1.size() != v2.size()) {
         throw std::runtime_error("Dimension mismatch in element-wise divide");
     }
-    
-    VectorND result(v1.size());
-    for (size_t i = 0; i < v1.size(); ++i) {
+    for (size_t i = 0; i < v2.size(); ++i) {
         if (std::abs(v2[i]) < std::numeric_limits<double>::epsilon()) {
             throw std::runtime_error("Division by zero in element-wise divide");
         }
-        result[i] = v1[i] / v2[i];
     }
-    return result;
+    
+    out.resize(v1.size());
+    for (size_t i = 0; i < v1.size(); ++i) {
+        out[i] = v1[i] / v2[i];
+    }
 }
 
 double sum(const VectorND& v) {
-    return std::accumulate(v.data().begin(), v.data().end(), 0.0);
+    return sum(v, get_reduction_mode());
+}
+
+double sum(const VectorND& v, ReductionMode mode) {
+    return reduce_sum(v.data().data(), v.size(), mode);
 }
 
 double max(const VectorND& v) {
@@ -383,10 +562,14 @@ double min(const VectorND& v) {
 }
 
 double mean(const VectorND& v) {
+    return mean(v, get_reduction_mode());
+}
+
+double mean(const VectorND& v, ReductionMode mode) {
     if (v.size() == 0) {
         throw std::runtime_error("Cannot find mean of empty vector");
     }
-    return sum(v) / v.size();
+    return sum(v, mode) / v.size();
 }
 
 } // namespace vectors
@@ -5,9 +5,14 @@
 #include <cmath>
 #include <stdexcept>
 #include <initializer_list>
+#include "reduction.h"
 
 namespace vectors {
 
+// Per-component tolerance of VectorND::operator==: vectors are equal when
+// every component differs by less than this
+constexpr double kEqualityTolerance = 1e-9;
+
 /**
  * VectorND - Core n-dimensional vector implementation for high-performance operations
  * 
@@ -30,7 +35,8 @@ public:
     VectorND& operator=(VectorND&& other) noexcept;
     
     // Destructor
-    ~VectorND() = default;
+    // Hands the storage back to the thread's pool (see allocator.h)
+    ~VectorND();
     
     // Accessors
     size_t size() const { return data_.size(); }
@@ -38,8 +44,9 @@ public:
     
     double get(size_t index) const;
     void set(size_t index, double value);
-    double operator[](size_t index) const;
-    double& operator[](size_t index);
+    // Unchecked element access, inline for inner loops; get/set bounds-check
+    double operator[](size_t index) const { return data_[index]; }
+    double& operator[](size_t index) { return data_[index]; }
     
     // Convenience accessors for 2D/3D vectors (for backward compatibility)
     double x() const;
@@ -60,6 +67,12 @@ public:
     VectorND operator/(double scalar) const;
     VectorND operator-() const; // Negation
     
+    // Compound assignment, in place without allocating
+    VectorND& operator+=(const VectorND& other);
+    VectorND& operator-=(const VectorND& other);
+    VectorND& operator*=(double scalar);
+    VectorND& operator/=(double scalar);
+    
     bool operator==(const VectorND& other) const;
     bool operator!=(const VectorND& other) const;
     
@@ -94,26 +107,108 @@ public:
     void resize(size_t new_size);
     void resize(size_t new_size, double value);
     
+    // Helper to check dimension compatibility; the message is only built on
+    // the cold failure path
+    void check_dimensions(const VectorND& other, const char* operation) const {
+        if (data_.size() != other.data_.size()) {
+            dimension_mismatch(other, operation);
+        }
+    }
+    
 private:
     std::vector<double> data_;
     
-    // Helper to check dimension compatibility
-    void check_dimensions(const VectorND& other, const char* operation) const;
+    [[noreturn]] void dimension_mismatch(const VectorND& other, const char* operation) const;
 };
 
-// Non-member functions for batch operations
+// Destination overloads
+//
+// Checked like the operations that return a new VectorND, but the result is
+// written to `out`, which is resized to fit. A destination that already has
+// the right size keeps its storage, so loops that reuse one run without
+// allocating. `out` may be one of the inputs. If an operation throws, `out`
+// is left unchanged.
+void add(const VectorND& a, const VectorND& b, VectorND& out);
+void subtract(const VectorND& a, const VectorND& b, VectorND& out);
+void scale(const VectorND& a, double scalar, VectorND& out);
+void divide(const VectorND& a, double scalar, VectorND& out);
+void negate(const VectorND& a, VectorND& out);
+void normalize(const VectorND& a, VectorND& out);
+void cross(const VectorND& a, const VectorND& b, VectorND& out);
+void projection(const VectorND& a, const VectorND& onto, VectorND& out);
+void reflection(const VectorND& a, const VectorND& normal, VectorND& out);
+void rotate(const VectorND& a, const VectorND& axis, double angle, VectorND& out);
+void lerp(const VectorND& a, const VectorND& b, double t, VectorND& out);
+void clamp(const VectorND& a, double min_val, double max_val, VectorND& out);
+
+// Unchecked fast paths
+//
+// No dimension or bounds validation: callers guarantee that all operands
+// have the same length (and, for the _into forms, that `out` already has
+// it). Meant for inner loops whose shapes were validated once up front.
+// Results are identical to the checked operations.
+
+inline void add_unchecked(const double* a, const double* b, double* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = a[i] + b[i];
+    }
+}
+
+inline void subtract_unchecked(const double* a, const double* b, double* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = a[i] - b[i];
+    }
+}
+
+inline void scale_unchecked(const double* a, double scalar, double* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = a[i] * scalar;
+    }
+}
+
+inline double dot_unchecked(const double* a, const double* b, size_t n) {
+    return reduce_dot(a, b, n, get_reduction_mode());
+}
+
+inline double dot_unchecked(const VectorND& a, const VectorND& b) {
+    return dot_unchecked(a.data().data(), b.data().data(), a.size());
+}
+
+inline void add_into(const VectorND& a, const VectorND& b, VectorND& out) {
+    add_unchecked(a.data().data(), b.data().data(), out.data().data(), a.size());
+}
+
+inline void subtract_into(const VectorND& a, const VectorND& b, VectorND& out) {
+    subtract_unchecked(a.data().data(), b.data().data(), out.data().data(), a.size());
+}
+
+inline void scale_into(const VectorND& a, double scalar, VectorND& out) {
+    scale_unchecked(a.data().data(), scalar, out.data().data(), a.size());
+}
+
+// Throws unless every vector in [vectors, vectors + count) has `dimensions`
+void check_batch_dimensions(const VectorND* vectors, size_t count, size_t dimensions,
+                            const char* operation);
+
+// Non-member functions for batch operations; shapes are validated once per
+// call, then every pair runs unchecked
 void batch_add(VectorND* v1, VectorND* v2, VectorND* result, size_t count);
 void batch_dot_product(const VectorND* v1, const VectorND* v2, double* result, size_t count);
 VectorND centroid(const VectorND* vectors, size_t count);
+VectorND centroid(const VectorND* vectors, size_t count, ReductionMode mode);
 VectorND weighted_average(const VectorND* vectors, const double* weights, size_t count);
 
 // Element-wise operations
 VectorND element_wise_multiply(const VectorND& v1, const VectorND& v2);
 VectorND element_wise_divide(const VectorND& v1, const VectorND& v2);
+void element_wise_multiply(const VectorND& v1, const VectorND& v2, VectorND& out);
+void element_wise_divide(const VectorND& v1, const VectorND& v2, VectorND& out);
 double sum(const VectorND& v);
+double sum(const VectorND& v, ReductionMode mode);
 double max(const VectorND& v);
 double min(const VectorND& v);
 double mean(const VectorND& v);
+double mean(const VectorND& v, ReductionMode mode);
 
 } // namespace vectors
 
@@ -0,0 +1,88 @@
+#include "vector_hash.h"
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace vectors {
+
+namespace {
+
+// Cell indices below this magnitude are exact in a double, and adding it
+// rounds to an integer
+constexpr double kExactCells = 4503599627370496.0;  // 2^52
+
+// splitmix64 finalizer
+uint64_t mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// A component's cell: the nearest integer to x / tolerance where that is
+// exact, otherwise the component itself. `exact` keeps the two kinds apart,
+// so a huge component never matches an index of the same value. Adding and
+// subtracting 2^52 rounds to the nearest integer without a branch or a
+// library call, so the loops vectorize, and yields +0.0 for -0.0.
+struct Cell {
+    double value;
+    bool exact;
+};
+
+Cell cell_of(double x, double inv_width) {
+    double u = x * inv_width;
+    double magic = std::copysign(kExactCells, u);
+    bool exact = std::abs(u) < kExactCells;
+    return Cell{exact ? (u + magic) - magic : x, exact};
+}
+
+// Accumulation as in xxh3: each cell is keyed by its index and its two
+// 32-bit halves are multiplied, which vectorizes to one 32x32->64 multiply
+// per component. The raw cells are summed as well, so that a zero half does
+// not erase the other one.
+struct HashState {
+    uint64_t products = 0;
+    uint64_t cells = 0;
+
+    void add(size_t i, Cell cell) {
+        uint64_t bits;
+        std::memcpy(&bits, &cell.value, sizeof(bits));
+        bits ^= cell.exact ? 0 : 0xc2b2ae3d27d4eb4fULL;
+        uint64_t keyed = bits ^ (0x165667b19e3779f9ULL + i * 0x9e3779b97f4a7c15ULL);
+        products += (keyed & 0xffffffffULL) * (keyed >> 32);
+        cells += bits;
+    }
+};
+
+bool differ(Cell a, Cell b) {
+    return (a.value != b.value) | (a.exact != b.exact);
+}
+
+} // namespace
+
+QuantizedGrid::QuantizedGrid(double tolerance)
+    : tolerance_(tolerance), inv_width_(1.0 / tolerance) {
+    if (!(tolerance > 0.0) || !std::isfinite(inv_width_)) {
+        throw std::runtime_error("Tolerance must be positive");
+    }
+}
+
+uint64_t QuantizedGrid::hash(const double* data, size_t n) const {
+    HashState state;
+    for (size_t i = 0; i < n; ++i) {
+        state.add(i, cell_of(data[i], inv_width_));
+    }
+    return mix(state.products + mix(state.cells ^ n));
+}
+
+bool QuantizedGrid::equal(const double* a, const double* b, size_t n) const {
+    size_t different = 0;
+    for (size_t i = 0; i < n; ++i) {
+        different += differ(cell_of(a[i], inv_width_), cell_of(b[i], inv_width_));
+    }
+    return different == 0;
+}
+
+} // namespace vectors
@@ -0,0 +1,42 @@
+#ifndef VECTOR_HASH_H
+#define VECTOR_HASH_H
+
+#include "vector_core.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace vectors {
+
+/**
+ * QuantizedGrid - Cells `tolerance` wide along every axis
+ *
+ * VectorND::operator== accepts components that differ by less than
+ * kEqualityTolerance. That relation is not transitive, so no hash can agree
+ * with it. Vectors that share a cell in every component are equal in a
+ * transitive sense, differing by at most `tolerance` per component, and
+ * hash() is consistent with equal(). VectorSet and VectorMap key on it.
+ *
+ * A component's cell is x / tolerance rounded to the nearest integer.
+ * Components too large for the cell index to be exact (2^52 cells and
+ * beyond) and infinities are their own cells, so they match only an
+ * identical value. NaN matches nothing.
+ * hash() and equal() have no data-dependent branches, so both loops
+ * vectorize.
+ */
+class QuantizedGrid {
+public:
+    explicit QuantizedGrid(double tolerance);
+
+    double tolerance() const { return tolerance_; }
+
+    uint64_t hash(const double* data, size_t n) const;
+    bool equal(const double* a, const double* b, size_t n) const;
+
+private:
+    double tolerance_;
+    double inv_width_;
+};
+
+} // namespace vectors
+
+#endif // VECTOR_HASH_H
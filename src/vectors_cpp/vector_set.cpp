@@ -0,0 +1,238 @@
+#include "vector_set.h"
+#include "parallel.h"
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+namespace vectors {
+
+namespace {
+
+// Rows per task
+constexpr size_t kRowBlock = 4096;
+
+constexpr size_t kMinCapacity = 16;
+
+// Runs body(begin, end) over row blocks, in parallel for large batches
+template <typename Body>
+void for_each_row_block(size_t count, size_t dim, const Body& body) {
+    size_t blocks = (count + kRowBlock - 1) / kRowBlock;
+    auto task = [&](size_t b) {
+        body(b * kRowBlock, std::min(count, (b + 1) * kRowBlock));
+    };
+    parallel_for(blocks, count * dim, task);
+}
+
+} // namespace
+
+VectorTable::VectorTable(size_t dimensions, double tolerance)
+    : dim_(dimensions),
+      grid_(tolerance),
+      slots_(kMinCapacity, Slot{0, npos}),
+      mask_(kMinCapacity - 1) {}
+
+void VectorTable::check_dimensions(size_t dimensions, const char* operation) const {
+    if (dimensions != dim_) {
+        throw std::runtime_error(
+            std::string("Dimension mismatch in ") + operation + ": " +
+            std::to_string(dim_) + " vs " + std::to_string(dimensions)
+        );
+    }
+}
+
+size_t VectorTable::probe(const double* v, uint64_t hash) const {
+    size_t i = hash & mask_;
+    while (true) {
+        const Slot& slot = slots_[i];
+        if (slot.position == npos ||
+            (slot.hash == hash && grid_.equal(key(slot.position), v, dim_))) {
+            return i;
+        }
+        i = (i + 1) & mask_;
+    }
+}
+
+size_t VectorTable::find(const double* v) const {
+    return slots_[probe(v, grid_.hash(v, dim_))].position;
+}
+
+std::pair<size_t, bool> VectorTable::insert(const double* v) {
+    return insert_hashed(v, grid_.hash(v, dim_));
+}
+
+std::pair<size_t, bool> VectorTable::insert_hashed(const double* v, uint64_t hash) {
+    // A key that never matches itself (NaN) can be inserted again from the
+    // table's own storage, which growing would free
+    std::less<const double*> before;
+    if (!before(v, keys_.data()) && before(v, keys_.data() + keys_.size())) {
+        std::vector<double> copy(v, v + dim_);
+        return insert_hashed(copy.data(), hash);
+    }
+    if ((size() + 1) * 2 > slots_.size()) {
+        rehash(slots_.size() * 2);
+    }
+    size_t s = probe(v, hash);
+    if (slots_[s].position != npos) {
+        return {slots_[s].position, false};
+    }
+    size_t position = size();
+    hashes_.push_back(hash);
+    try {
+        keys_.insert(keys_.end(), v, v + dim_);
+    } catch (...) {
+        hashes_.pop_back();
+        throw;
+    }
+    slots_[s] = Slot{hash, position};
+    return {position, true};
+}
+
+size_t VectorTable::erase(const double* v) {
+    size_t s = probe(v, grid_.hash(v, dim_));
+    size_t position = slots_[s].position;
+    if (position == npos) {
+        return npos;
+    }
+
+    // Shift later slots of the cluster back into the hole when the hole lies
+    // on their probe path
+    size_t hole = s;
+    for (size_t i = (s + 1) & mask_; slots_[i].position != npos; i = (i + 1) & mask_) {
+        size_t home = slots_[i].hash & mask_;
+        if (((i - home) & mask_) >= ((i - hole) & mask_)) {
+            slots_[hole] = slots_[i];
+            hole = i;
+        }
+    }
+    slots_[hole].position = npos;
+
+    size_t last = size() - 1;
+    if (position != last) {
+        size_t i = hashes_[last] & mask_;
+        while (slots_[i].position != last) {
+            i = (i + 1) & mask_;
+        }
+        slots_[i].position = position;
+        std::copy(key(last), key(last) + dim_, keys_.begin() + position * dim_);
+        hashes_[position] = hashes_[last];
+    }
+    keys_.resize(last * dim_);
+    hashes_.pop_back();
+    return position;
+}
+
+void VectorTable::find_batch(const BatchView& rows, size_t* positions) const {
+    check_dimensions(rows.dim, "VectorTable find");
+    for_each_row_block(rows.count, dim_, [&](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; ++r) {
+            positions[r] = find(rows.row(r));
+        }
+    });
+}
+
+void VectorTable::insert_batch(const BatchView& rows, size_t* positions, uint8_t* inserted) {
+    check_dimensions(rows.dim, "VectorTable insert");
+    std::vector<uint64_t> hashes(rows.count);
+    for_each_row_block(rows.count, dim_, [&](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; ++r) {
+            hashes[r] = grid_.hash(rows.row(r), dim_);
+        }
+    });
+    for (size_t r = 0; r < rows.count; ++r) {
+        auto result = insert_hashed(rows.row(r), hashes[r]);
+        positions[r] = result.first;
+        if (inserted) {
+            inserted[r] = result.second;
+        }
+    }
+}
+
+void VectorTable::rehash(size_t capacity) {
+    std::vector<Slot> slots(capacity, Slot{0, npos});
+    size_t mask = capacity - 1;
+    for (size_t position = 0; position < size(); ++position) {
+        size_t i = hashes_[position] & mask;
+        while (slots[i].position != npos) {
+            i = (i + 1) & mask;
+        }
+        slots[i] = Slot{hashes_[position], position};
+    }
+    slots_ = std::move(slots);
+    mask_ = mask;
+}
+
+void VectorTable::reserve(size_t count) {
+    size_t capacity = slots_.size();
+    while (count * 2 > capacity) {
+        capacity *= 2;
+    }
+    if (capacity != slots_.size()) {
+        rehash(capacity);
+    }
+    keys_.reserve(count * dim_);
+    hashes_.reserve(count);
+}
+
+void VectorTable::clear() {
+    keys_.clear();
+    hashes_.clear();
+    std::fill(slots_.begin(), slots_.end(), Slot{0, npos});
+}
+
+size_t VectorSet::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return table_.size();
+}
+
+bool VectorSet::insert(const VectorND& v) {
+    table_.check_dimensions(v.size(), "VectorSet insert");
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    return table_.insert(v.data().data()).second;
+}
+
+bool VectorSet::contains(const VectorND& v) const {
+    table_.check_dimensions(v.size(), "VectorSet contains");
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return table_.find(v.data().data()) != VectorTable::npos;
+}
+
+bool VectorSet::erase(const VectorND& v) {
+    table_.check_dimensions(v.size(), "VectorSet erase");
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    return table_.erase(v.data().data()) != VectorTable::npos;
+}
+
+void VectorSet::insert_batch(const BatchView& rows, uint8_t* inserted) {
+    std::vector<size_t> positions(rows.count);
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    table_.insert_batch(rows, positions.data(), inserted);
+}
+
+void VectorSet::contains_batch(const BatchView& rows, uint8_t* result) const {
+    std::vector<size_t> positions(rows.count);
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        table_.find_batch(rows, positions.data());
+    }
+    for (size_t r = 0; r < rows.count; ++r) {
+        result[r] = positions[r] != VectorTable::npos;
+    }
+}
+
+VectorBatch VectorSet::to_batch() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return VectorBatch(table_.keys());
+}
+
+void VectorSet::reserve(size_t count) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    table_.reserve(count);
+}
+
+void VectorSet::clear() {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    table_.clear();
+}
+
+} // namespace vectors
@@ -0,0 +1,229 @@
+#ifndef VECTOR_SET_H
+#define VECTOR_SET_H
+
+#include "vector_batch.h"
+#include "vector_hash.h"
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+#include <vector>
+
+namespace vectors {
+
+/**
+ * VectorTable - Open-addressing index of distinct vector keys
+ *
+ * Keys are equal when they share a QuantizedGrid cell in every component.
+ * The first key inserted for a cell is the one stored. Keys are kept
+ * contiguously in insertion order and addressed by position; erasing a key
+ * moves the last key into its position. Slots hold a key's hash next to its
+ * position and are probed linearly, so most misses and hits touch one cache
+ * line before the single key comparison. The table doubles before it is half
+ * full, and erasing shifts later slots back instead of leaving tombstones.
+ *
+ * Batch lookups hash and probe rows in parallel. Batch inserts hash in
+ * parallel and then insert in row order, so positions are deterministic.
+ */
+class VectorTable {
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    explicit VectorTable(size_t dimensions, double tolerance = kEqualityTolerance);
+
+    size_t size() const { return hashes_.size(); }
+    size_t dimensions() const { return dim_; }
+    double tolerance() const { return grid_.tolerance(); }
+
+    const double* key(size_t position) const { return keys_.data() + position * dim_; }
+    BatchView keys() const { return BatchView{keys_.data(), size(), dim_, dim_}; }
+
+    // `v` points to dimensions() components; use the batch forms or
+    // VectorSet/VectorMap for checked access
+
+    // Position of the key matching `v`, or npos
+    size_t find(const double* v) const;
+    // Position of the key matching `v` and whether it was inserted now
+    std::pair<size_t, bool> insert(const double* v);
+    // Removes the key matching `v` and returns the position it had, or npos.
+    // The last key takes over that position.
+    size_t erase(const double* v);
+
+    // positions[i] is find(rows.row(i))
+    void find_batch(const BatchView& rows, size_t* positions) const;
+    // positions[i] and inserted[i] are the results of insert(rows.row(i));
+    // `inserted` may be null. `rows` must not view this table's keys.
+    void insert_batch(const BatchView& rows, size_t* positions, uint8_t* inserted);
+
+    void reserve(size_t count);
+    void clear();
+
+    // Throws unless `dimensions` matches the keys
+    void check_dimensions(size_t dimensions, const char* operation) const;
+
+private:
+    struct Slot {
+        uint64_t hash;
+        size_t position;  // npos when the slot is empty
+    };
+
+    size_t dim_;
+    QuantizedGrid grid_;
+    std::vector<double> keys_;
+    std::vector<uint64_t> hashes_;  // per position
+    std::vector<Slot> slots_;
+    size_t mask_;
+
+    // Slot holding the key matching `v`, or the empty slot that ends its probe
+    size_t probe(const double* v, uint64_t hash) const;
+    std::pair<size_t, bool> insert_hashed(const double* v, uint64_t hash);
+    void rehash(size_t capacity);
+};
+
+/**
+ * VectorSet - Set of vectors under quantized equality
+ *
+ * A set may be shared between threads: lookups hold a shared lock and
+ * changes an exclusive one.
+ */
+class VectorSet {
+public:
+    explicit VectorSet(size_t dimensions, double tolerance = kEqualityTolerance)
+        : table_(dimensions, tolerance) {}
+
+    size_t size() const;
+    size_t dimensions() const { return table_.dimensions(); }
+    double tolerance() const { return table_.tolerance(); }
+
+    // Whether `v` was added, i.e. no equal vector was present
+    bool insert(const VectorND& v);
+    bool contains(const VectorND& v) const;
+    // Whether an equal vector was present and removed
+    bool erase(const VectorND& v);
+
+    // Per row, whether it was added or is present
+    void insert_batch(const BatchView& rows, uint8_t* inserted);
+    void contains_batch(const BatchView& rows, uint8_t* result) const;
+
+    // Stored vectors, in insertion order until something is erased. The
+    // view moves when vectors are added; use to_batch() while other threads
+    // change the set.
+    BatchView view() const { return table_.keys(); }
+    VectorBatch to_batch() const;
+
+    void reserve(size_t count);
+    void clear();
+
+private:
+    VectorTable table_;
+    mutable std::shared_mutex mutex_;
+};
+
+/**
+ * VectorMap - Map from vectors to values under quantized equality
+ *
+ * Values are stored in a vector parallel to the keys. Like VectorSet, a map
+ * may be shared between threads; values are destroyed after the lock is
+ * released, so a value's destructor may use the map.
+ */
+template <typename Value>
+class VectorMap {
+public:
+    explicit VectorMap(size_t dimensions, double tolerance = kEqualityTolerance)
+        : table_(dimensions, tolerance) {}
+
+    size_t size() const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return table_.size();
+    }
+    size_t dimensions() const { return table_.dimensions(); }
+    double tolerance() const { return table_.tolerance(); }
+
+    // Value for `key`, or null. The pointer is valid until the map changes.
+    Value* find(const VectorND& key) {
+        const double* data = checked(key);
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        size_t position = table_.find(data);
+        return position == VectorTable::npos ? nullptr : &values_[position];
+    }
+    const Value* find(const VectorND& key) const {
+        const double* data = checked(key);
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        size_t position = table_.find(data);
+        return position == VectorTable::npos ? nullptr : &values_[position];
+    }
+
+    bool contains(const VectorND& key) const { return find(key) != nullptr; }
+
+    // Sets the value for `key`; returns whether the key is new
+    bool insert_or_assign(const VectorND& key, Value value) {
+        const double* data = checked(key);
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        auto result = table_.insert(data);
+        if (result.second) {
+            try {
+                values_.push_back(std::move(value));
+            } catch (...) {
+                table_.erase(data);
+                throw;
+            }
+        } else {
+            // The replaced value is destroyed with the parameter
+            std::swap(values_[result.first], value);
+        }
+        return result.second;
+    }
+
+    // Whether `key` was present and removed
+    bool erase(const VectorND& key) {
+        const double* data = checked(key);
+        Value removed;
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        size_t position = table_.erase(data);
+        if (position == VectorTable::npos) {
+            return false;
+        }
+        std::swap(removed, values_[position]);
+        if (position + 1 != values_.size()) {
+            values_[position] = std::move(values_.back());
+        }
+        values_.pop_back();
+        return true;
+    }
+
+    // positions[i] indexes values() for row i, or is VectorTable::npos
+    void find_batch(const BatchView& rows, size_t* positions) const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        table_.find_batch(rows, positions);
+    }
+
+    // The keys and values, which move when the map changes
+    BatchView keys() const { return table_.keys(); }
+    const std::vector<Value>& values() const { return values_; }
+
+    void reserve(size_t count) {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        table_.reserve(count);
+        values_.reserve(count);
+    }
+    void clear() {
+        std::vector<Value> removed;
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        table_.clear();
+        removed.swap(values_);
+    }
+
+private:
+    VectorTable table_;
+    std::vector<Value> values_;
+    mutable std::shared_mutex mutex_;
+
+    const double* checked(const VectorND& key) const {
+        table_.check_dimensions(key.size(), "VectorMap");
+        return key.data().data();
+    }
+};
+
+} // namespace vectors
+
+#endif // VECTOR_SET_H
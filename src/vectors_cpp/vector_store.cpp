@@ -0,0 +1,237 @@
+#include "vector_store.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+namespace vectors {
+
+namespace {
+
+const char kMagic[8] = {'V', 'E', 'C', 'T', 'R', 'A', '\0', '\1'};
+
+// Bytes buffered by the writer before a chunk is written out
+constexpr size_t kWriteChunkBytes = size_t(1) << 20;
+
+static_assert(sizeof(VectorFileHeader) == 64, "vector file header must be 64 bytes");
+
+size_t round_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+void validate_vector_file_header(const VectorFileHeader& header, const std::string& source) {
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error("Not a vector file: " + source);
+    }
+    if (header.version != kVectorFileVersion) {
+        throw std::runtime_error("Unsupported vector file version in " + source);
+    }
+    if (header.dtype != static_cast<uint32_t>(VectorDType::Float64)) {
+        throw std::runtime_error("Unsupported vector file dtype in " + source);
+    }
+    if (header.data_offset < sizeof(VectorFileHeader) ||
+        header.data_offset % sizeof(double) != 0) {
+        throw std::runtime_error("Corrupt vector file header in " + source);
+    }
+}
+
+VectorFileHeader make_vector_file_header(size_t dimensions, size_t alignment) {
+    VectorFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVectorFileVersion;
+    header.dtype = static_cast<uint32_t>(VectorDType::Float64);
+    header.dimensions = dimensions;
+    header.count = 0;
+    header.alignment = alignment;
+    header.data_offset = round_up(sizeof(VectorFileHeader), alignment);
+    return header;
+}
+
+VectorFileHeader read_vector_file_header(const std::string& path) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        throw std::runtime_error("Cannot open vector file: " + path);
+    }
+    VectorFileHeader header;
+    size_t read = std::fread(&header, sizeof(header), 1, file);
+    std::fclose(file);
+    if (read != 1) {
+        throw std::runtime_error("Truncated vector file header in " + path);
+    }
+    validate_vector_file_header(header, path);
+    return header;
+}
+
+// MappedVectorBatch
+
+MappedVectorBatch::MappedVectorBatch(const std::string& path)
+    : path_(path), file_(path), count_(0), dim_(0), rows_(nullptr) {
+    if (file_.size() < sizeof(VectorFileHeader)) {
+        throw std::runtime_error("Truncated vector file header in " + path);
+    }
+    VectorFileHeader header;
+    std::memcpy(&header, file_.data(), sizeof(header));
+    validate_vector_file_header(header, path);
+    dim_ = static_cast<size_t>(header.dimensions);
+    count_ = static_cast<size_t>(header.count);
+    // Divides rather than multiplies, so a corrupt count cannot overflow
+    if (header.data_offset > file_.size() ||
+        (dim_ != 0 &&
+         count_ > (file_.size() - header.data_offset) / sizeof(double) / dim_)) {
+        throw std::runtime_error("Truncated vector file data in " + path);
+    }
+    rows_ = reinterpret_cast<const double*>(file_.data() + header.data_offset);
+}
+
+VectorND MappedVectorBatch::get(size_t index) const {
+    if (index >= count_) {
+        throw std::out_of_range("Batch index out of range");
+    }
+    return VectorND(std::vector<double>(row(index), row(index) + dim_));
+}
+
+// VectorFileWriter
+
+VectorFileWriter::VectorFileWriter(const std::string& path, size_t dimensions, bool append,
+                                   size_t alignment)
+    : file_(nullptr), dim_(dimensions), data_offset_(0), written_(0), chunk_rows_(0) {
+    if (dimensions == 0) {
+        throw std::runtime_error("Vector file dimensions must be positive");
+    }
+    if (alignment < sizeof(double) || (alignment & (alignment - 1)) != 0) {
+        throw std::runtime_error("Vector file alignment must be a power of two >= 8");
+    }
+
+    VectorFileHeader header;
+    file_ = append ? std::fopen(path.c_str(), "r+b") : nullptr;
+    if (file_) {
+        if (std::fread(&header, sizeof(header), 1, file_) != 1) {
+            std::fclose(file_);
+            throw std::runtime_error("Truncated vector file header in " + path);
+        }
+        try {
+            validate_vector_file_header(header, path);
+        } catch (...) {
+            std::fclose(file_);
+            throw;
+        }
+        if (header.dimensions != dimensions) {
+            std::fclose(file_);
+            throw std::runtime_error(
+                "Dimension mismatch in vector file append: " +
+                std::to_string(header.dimensions) + " vs " + std::to_string(dimensions)
+            );
+        }
+        written_ = static_cast<size_t>(header.count);
+    } else {
+        file_ = std::fopen(path.c_str(), "w+b");
+        if (!file_) {
+            throw std::runtime_error("Cannot create vector file: " + path);
+        }
+        header = make_vector_file_header(dimensions, alignment);
+        std::vector<char> prefix(header.data_offset, 0);
+        std::memcpy(prefix.data(), &header, sizeof(header));
+        if (std::fwrite(prefix.data(), 1, prefix.size(), file_) != prefix.size()) {
+            std::fclose(file_);
+            throw std::runtime_error("Cannot write vector file: " + path);
+        }
+    }
+    data_offset_ = header.data_offset;
+    // Rows past the recorded count (e.g. from an interrupted write) get overwritten
+    seek_file(file_, data_end());
+
+    chunk_rows_ = std::max<size_t>(1, kWriteChunkBytes / (dim_ * sizeof(double)));
+    buffer_.reserve(chunk_rows_ * dim_);
+}
+
+VectorFileWriter::~VectorFileWriter() {
+    try {
+        close();
+    } catch (...) {
+        // Destructors must not throw; callers that care call close() themselves
+    }
+}
+
+void VectorFileWriter::write(const VectorND& v) {
+    if (v.size() != dim_) {
+        throw std::runtime_error(
+            "Dimension mismatch in vector file write: " +
+            std::to_string(dim_) + " vs " + std::to_string(v.size())
+        );
+    }
+    write(v.data().data(), 1);
+}
+
+void VectorFileWriter::write(const double* rows, size_t count) {
+    if (!file_) {
+        throw std::runtime_error("Vector file writer is closed");
+    }
+    // Large writes go straight to the file once the pending chunk is out
+    if (count >= chunk_rows_) {
+        flush();
+        write_rows(rows, count);
+        update_count();
+        return;
+    }
+    buffer_.insert(buffer_.end(), rows, rows + count * dim_);
+    if (buffered_rows() >= chunk_rows_) {
+        flush();
+    }
+}
+
+void VectorFileWriter::write(const BatchView& batch) {
+    if (batch.dim != dim_) {
+        throw std::runtime_error(
+            "Dimension mismatch in vector file write: " +
+            std::to_string(dim_) + " vs " + std::to_string(batch.dim)
+        );
+    }
+    if (batch.stride == batch.dim) {
+        write(batch.data, batch.count);
+        return;
+    }
+    for (size_t i = 0; i < batch.count; ++i) {
+        write(batch.row(i), 1);
+    }
+}
+
+void VectorFileWriter::write_rows(const double* rows, size_t count) {
+    size_t elements = count * dim_;
+    if (std::fwrite(rows, sizeof(double), elements, file_) != elements) {
+        throw std::runtime_error("Failed to write vector file");
+    }
+    written_ += count;
+}
+
+void VectorFileWriter::update_count() {
+    uint64_t count = written_;
+    seek_file(file_, offsetof(VectorFileHeader, count));
+    bool ok = std::fwrite(&count, sizeof(count), 1, file_) == 1;
+    ok = std::fflush(file_) == 0 && ok;
+    seek_file(file_, data_end());
+    if (!ok) {
+        throw std::runtime_error("Failed to write vector file");
+    }
+}
+
+void VectorFileWriter::flush() {
+    if (!file_) return;
+    if (!buffer_.empty()) {
+        size_t rows = buffered_rows();
+        write_rows(buffer_.data(), rows);
+        buffer_.clear();
+    }
+    update_count();
+}
+
+void VectorFileWriter::close() {
+    if (!file_) return;
+    flush();
+    std::fclose(file_);
+    file_ = nullptr;
+}
+
+} // namespace vectors
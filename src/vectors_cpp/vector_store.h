@@ -0,0 +1,131 @@
+#ifndef VECTOR_STORE_H
+#define VECTOR_STORE_H
+
+#include "file_io.h"
+#include "vector_batch.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace vectors {
+
+/**
+ * On-disk vector file format (little-endian)
+ *
+ *   offset  size  field
+ *        0     8  magic "VECTRA\0\1"
+ *        8     4  format version
+ *       12     4  dtype code
+ *       16     8  dimensions
+ *       24     8  vector count
+ *       32     8  alignment of the data section in bytes
+ *       40     8  data offset in bytes
+ *       48    16  reserved, zero
+ *
+ * Rows follow the header back to back starting at the data offset, so a
+ * mapping of the file can be used as a row-major batch without copying.
+ */
+enum class VectorDType : uint32_t {
+    Float64 = 1
+};
+
+struct VectorFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t dtype;
+    uint64_t dimensions;
+    uint64_t count;
+    uint64_t alignment;
+    uint64_t data_offset;
+    uint64_t reserved[2];
+};
+
+constexpr uint32_t kVectorFileVersion = 1;
+constexpr size_t kDefaultFileAlignment = 64;
+
+// Header for an empty vector file; rows start at the first aligned offset
+VectorFileHeader make_vector_file_header(size_t dimensions, size_t alignment = kDefaultFileAlignment);
+
+// Throws if the header is not a supported vector file header; `source` names
+// the file or segment in the error message
+void validate_vector_file_header(const VectorFileHeader& header, const std::string& source);
+
+// Reads and validates the header of a vector file
+VectorFileHeader read_vector_file_header(const std::string& path);
+
+/**
+ * MappedVectorBatch - Read-only memory mapping of a vector file
+ *
+ * The kernels in vector_batch.h run straight over view(); pages are loaded
+ * on demand by the OS, so files larger than RAM can be scanned. The count is
+ * fixed when the file is mapped; rows appended later need a new mapping.
+ */
+class MappedVectorBatch {
+public:
+    using Access = MapAccess;
+
+    explicit MappedVectorBatch(const std::string& path);
+
+    size_t size() const { return count_; }
+    size_t dimensions() const { return dim_; }
+    const std::string& path() const { return path_; }
+
+    const double* data() const { return rows_; }
+    const double* row(size_t i) const { return rows_ + i * dim_; }
+    VectorND get(size_t index) const;
+
+    BatchView view() const { return BatchView{rows_, count_, dim_, dim_}; }
+
+    // Hint the expected access pattern to the OS (no-op where unsupported)
+    void advise(Access access) const { file_.advise(access); }
+
+private:
+    std::string path_;
+    MappedFile file_;
+    size_t count_;
+    size_t dim_;
+    const double* rows_;
+};
+
+/**
+ * VectorFileWriter - Appends vectors to a vector file in chunks
+ *
+ * Rows are buffered and written once a chunk fills up; the header count is
+ * updated on every flush, so the file is always a valid, readable prefix.
+ */
+class VectorFileWriter {
+public:
+    VectorFileWriter(const std::string& path, size_t dimensions, bool append = false,
+                     size_t alignment = kDefaultFileAlignment);
+    ~VectorFileWriter();
+
+    VectorFileWriter(const VectorFileWriter&) = delete;
+    VectorFileWriter& operator=(const VectorFileWriter&) = delete;
+
+    size_t dimensions() const { return dim_; }
+    size_t count() const { return written_ + buffered_rows(); }
+
+    void write(const VectorND& v);
+    void write(const double* rows, size_t count);
+    void write(const BatchView& batch);
+    void flush();
+    void close();
+
+private:
+    std::FILE* file_;
+    size_t dim_;
+    uint64_t data_offset_;
+    size_t written_;
+    size_t chunk_rows_;
+    std::vector<double> buffer_;
+
+    size_t buffered_rows() const { return buffer_.size() / dim_; }
+    uint64_t data_end() const { return data_offset_ + uint64_t(written_) * dim_ * sizeof(double); }
+    void write_rows(const double* rows, size_t count);
+    void update_count();
+};
+
+} // namespace vectors
+
+#endif // VECTOR_STORE_H
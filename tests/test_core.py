@@ -0,0 +1,411 @@
+"""
+Tests for the C++ core module
+"""
+
+import pytest
+import vectors
+
+core = pytest.importorskip("vectors._vectors_core")
+
+
+class TestReductions:
+    """Test compensated and fast reduction kernels."""
+
+    def test_sum_modes_agree_on_exact_values(self):
+        """Test that both modes return exact sums for small integers."""
+        v = core.VectorND([1.0, 2.0, 3.0, 4.0])
+        assert core.sum(v, mode=core.ReductionMode.FAST) == 10.0
+        assert core.sum(v, mode=core.ReductionMode.COMPENSATED) == 10.0
+
+    def test_compensated_sum_is_accurate(self):
+        """Test that the compensated sum recovers small terms."""
+        v = core.VectorND([1e16] + [1.0] * 1000 + [-1e16])
+        assert core.sum(v, mode=core.ReductionMode.COMPENSATED) == 1000.0
+
+    def test_sum_independent_of_thread_count(self):
+        """Test that large reductions are deterministic across thread counts."""
+        values = [((i * 7919) % 1000) / 7.0 for i in range(1 << 19)]
+        v = core.VectorND(values)
+        previous = core.get_num_threads()
+        try:
+            core.set_num_threads(1)
+            serial = core.sum(v)
+            core.set_num_threads(4)
+            parallel = core.sum(v)
+        finally:
+            core.set_num_threads(previous)
+        assert serial == parallel
+
+    def test_default_mode(self):
+        """Test switching the process-wide default mode."""
+        previous = core.get_reduction_mode()
+        try:
+            core.set_reduction_mode(core.ReductionMode.FAST)
+            assert core.get_reduction_mode() == core.ReductionMode.FAST
+        finally:
+            core.set_reduction_mode(previous)
+
+    def test_mean_and_magnitude(self):
+        """Test mean, magnitude and dot through the reduction kernels."""
+        v = core.VectorND([3.0, 4.0])
+        assert core.mean(v) == 3.5
+        assert v.magnitude() == 5.0
+        assert v.dot(core.VectorND([1.0, 1.0])) == 7.0
+
+    def test_centroid(self):
+        """Test centroid over many vectors."""
+        vectors = [core.VectorND([float(i), 1.0, 2.0]) for i in range(1001)]
+        center = core.centroid(vectors)
+        assert center[0] == 500.0
+        assert center[1] == 1.0
+        assert center[2] == 2.0
+
+    def test_centroid_dimension_mismatch(self):
+        """Test centroid with vectors of different dimensions."""
+        with pytest.raises(RuntimeError):
+            core.centroid([core.VectorND([1.0, 2.0]), core.VectorND([1.0])])
+
+    def test_short_input_is_compensated(self):
+        """Test that inputs shorter than one lane group still carry the error term."""
+        v = core.VectorND([1e16, 1.0, -1e16])
+        assert core.sum(v, mode=core.ReductionMode.COMPENSATED) == 1.0
+        assert core.sum(v, mode=core.ReductionMode.FAST) == 0.0
+
+
+class TestBatchValidation:
+    """Test list batch entry points that validate shapes once per call."""
+
+    def test_batch_add_matches_operator(self):
+        """Test that the unchecked batch path matches VectorND addition."""
+        a = [core.VectorND([float(i), 0.5, -1.0]) for i in range(50)]
+        b = [core.VectorND([1.0, float(i) / 3.0, 2.0]) for i in range(50)]
+        for result, x, y in zip(core.batch_add(a, b), a, b):
+            assert list(result) == list(x + y)
+
+    def test_batch_dot_product_matches_dot(self):
+        """Test that the unchecked batch path matches VectorND.dot."""
+        a = [core.VectorND([float(i), 0.1, -3.0, 7.0]) for i in range(50)]
+        b = [core.VectorND([0.3, float(i), 1.0, 1e-3]) for i in range(50)]
+        assert core.batch_dot_product(a, b) == [x.dot(y) for x, y in zip(a, b)]
+
+    def test_mixed_dimensions_rejected(self):
+        """Test that a mismatch anywhere in the batch is reported up front."""
+        a = [core.VectorND([1.0, 2.0]), core.VectorND([1.0, 2.0])]
+        b = [core.VectorND([1.0, 2.0]), core.VectorND([1.0, 2.0, 3.0])]
+        with pytest.raises(RuntimeError, match="Dimension mismatch in addition: 2 vs 3"):
+            core.batch_add(a, b)
+        with pytest.raises(RuntimeError, match="Dimension mismatch in dot product"):
+            core.batch_dot_product(a, b)
+        with pytest.raises(RuntimeError, match="Dimension mismatch in weighted average"):
+            core.weighted_average(b, [1.0, 1.0])
+
+
+class TestParallel:
+    """Test the thread pool settings shared by all batch kernels."""
+
+    @pytest.fixture(autouse=True)
+    def restore_settings(self):
+        """Restore the process-wide settings after each test."""
+        threads = core.get_num_threads()
+        threshold = core.get_parallel_threshold()
+        backend = core.get_parallel_backend()
+        pinning = core.get_thread_pinning()
+        yield
+        core.set_num_threads(threads)
+        core.set_parallel_threshold(threshold)
+        core.set_parallel_backend(backend)
+        core.set_thread_pinning(pinning)
+
+    def test_threshold_round_trip(self):
+        """Test setting and reading the parallel threshold."""
+        core.set_parallel_threshold(1024)
+        assert core.get_parallel_threshold() == 1024
+
+    def test_results_independent_of_pool_settings(self):
+        """Test that results match across thread counts, backends and pinning."""
+        vectors = [core.VectorND([float(i % 13), i / 7.0, 1.0]) for i in range(20000)]
+        values = core.VectorND([((i * 7919) % 1000) / 7.0 for i in range(1 << 16)])
+        core.set_parallel_threshold(0)
+        expected = None
+        for backend in core.ParallelBackend.__members__.values():
+            if not core.parallel_backend_available(backend):
+                continue
+            core.set_parallel_backend(backend)
+            for threads in (1, 3, 8):
+                core.set_num_threads(threads)
+                core.set_thread_pinning(threads == 8)
+                result = (list(core.centroid(vectors)), core.sum(values))
+                if expected is None:
+                    expected = result
+                assert result == expected
+
+    def test_unavailable_backend(self):
+        """Test that selecting a backend that was not compiled in raises."""
+        assert core.parallel_backend_available(core.ParallelBackend.NATIVE)
+        assert core.parallel_backend_available(core.ParallelBackend.SERIAL)
+        for backend in (core.ParallelBackend.OPENMP, core.ParallelBackend.TBB):
+            if not core.parallel_backend_available(backend):
+                with pytest.raises(RuntimeError):
+                    core.set_parallel_backend(backend)
+                assert core.get_parallel_backend() != backend
+
+
+class TestOnlineStats:
+    """Test the streaming statistics accumulator."""
+
+    def test_mean_variance_min_max(self):
+        """Test statistics over single-vector ingestion."""
+        stats = core.OnlineStats(2)
+        for values in ([1.0, 10.0], [2.0, 20.0], [3.0, 30.0]):
+            stats.add(core.VectorND(values))
+        assert stats.count == 3
+        assert stats.mean()[0] == 2.0
+        assert abs(stats.variance()[1] - 200.0 / 3.0) < 1e-9
+        assert abs(stats.covariance_diagonal()[1] - 100.0) < 1e-9
+        assert stats.min()[0] == 1.0
+        assert stats.max()[1] == 30.0
+
+    def test_batch_matches_single(self):
+        """Test that batch ingestion agrees with one-at-a-time ingestion."""
+        vectors = [core.VectorND([float(i % 17), float(i) / 3.0]) for i in range(5000)]
+        single = core.OnlineStats(2)
+        for v in vectors:
+            single.add(v)
+        batch = core.OnlineStats(2)
+        batch.add_batch(vectors)
+        for i in range(2):
+            assert abs(single.mean()[i] - batch.mean()[i]) < 1e-9
+            assert abs(single.variance()[i] - batch.variance()[i]) < 1e-6
+
+    def test_merge(self):
+        """Test merging partial accumulators."""
+        left = core.OnlineStats(1)
+        right = core.OnlineStats(1)
+        left.add_batch([core.VectorND([1.0]), core.VectorND([2.0])])
+        right.add_batch([core.VectorND([3.0]), core.VectorND([4.0])])
+        left.merge(right)
+        snapshot = left.snapshot()
+        assert snapshot.count == 4
+        assert snapshot.mean[0] == 2.5
+        assert abs(snapshot.variance[0] - 1.25) < 1e-12
+
+    def test_empty_and_mismatch(self):
+        """Test errors for empty accumulators and wrong dimensions."""
+        stats = core.OnlineStats(3)
+        with pytest.raises(RuntimeError):
+            stats.mean()
+        with pytest.raises(RuntimeError):
+            stats.add(core.VectorND([1.0, 2.0]))
+
+
+class TestCentroidTrackers:
+    """Test sliding-window and exponentially decayed centroids."""
+
+    def test_sliding_window_keeps_last_vectors(self):
+        """Test that only the last W vectors contribute."""
+        tracker = core.SlidingWindowCentroid(2, 3)
+        for i in range(10):
+            tracker.add(core.VectorND([float(i), 1.0]))
+        assert len(tracker) == 3
+        assert tracker.full()
+        assert tracker.centroid()[0] == 8.0
+
+    def test_sliding_window_weights(self):
+        """Test weighted_average semantics inside the window."""
+        tracker = core.SlidingWindowCentroid(1, 4)
+        tracker.add_batch([core.VectorND([0.0]), core.VectorND([2.0])], weights=[1.0, 3.0])
+        assert tracker.centroid()[0] == 1.5
+
+    def test_zero_total_weight(self):
+        """Test that a zero total weight is rejected like weighted_average."""
+        tracker = core.SlidingWindowCentroid(1, 2)
+        tracker.add(core.VectorND([1.0]), weight=0.0)
+        with pytest.raises(RuntimeError):
+            tracker.centroid()
+
+    def test_decayed_centroid(self):
+        """Test exponential decay of older vectors."""
+        tracker = core.DecayedCentroid(1, 0.5)
+        tracker.add(core.VectorND([0.0]))
+        tracker.add(core.VectorND([3.0]))
+        assert abs(tracker.centroid()[0] - 2.0) < 1e-12
+
+    def test_invalid_parameters(self):
+        """Test constructor validation."""
+        with pytest.raises(RuntimeError):
+            core.SlidingWindowCentroid(3, 0)
+        with pytest.raises(RuntimeError):
+            core.DecayedCentroid(3, 1.5)
+
+
+class TestAllocatorPool:
+    """Test pooled VectorND storage."""
+
+    def test_pool_reuses_storage(self):
+        """Test that temporaries inside an arena stop hitting malloc."""
+        a = core.VectorND([1.0, 2.0, 3.0])
+        b = core.VectorND([0.5, 0.5, 0.5])
+        with vectors.arena():
+            core.reset_allocator_stats()
+            for _ in range(1000):
+                a + b
+            stats = vectors.allocator_stats()
+        assert stats.allocations >= 1000
+        assert stats.pool_hits >= 990
+        assert stats.system_allocations < 10
+
+    def test_vectors_outlive_arena(self):
+        """Test that results created inside an arena stay valid."""
+        with vectors.arena():
+            kept = core.VectorND([1.0, 2.0]) * 2.0
+        assert kept[1] == 4.0
+
+    def test_pool_released_on_exit(self):
+        """Test that cached blocks are released when the block exits."""
+        with vectors.arena():
+            core.VectorND(16) + core.VectorND(16)
+            assert vectors.allocator_stats().pooled_bytes > 0
+        assert vectors.allocator_stats().pooled_bytes == 0
+
+
+class TestDestinationOverloads:
+    """Test out= variants of the VectorND-returning operations."""
+
+    def test_results_match_returning_forms(self):
+        """Test that writing into out gives the same values and returns out."""
+        a = core.VectorND([1.0, -2.0, 3.0])
+        b = core.VectorND([0.5, 4.0, -1.5])
+        out = core.VectorND(3)
+        cases = [
+            (lambda o: core.add(a, b, out=o), a + b),
+            (lambda o: core.subtract(a, b, out=o), a - b),
+            (lambda o: core.scale(a, 2.5, out=o), a * 2.5),
+            (lambda o: core.divide(a, 4.0, out=o), a / 4.0),
+            (lambda o: a.normalize(out=o), a.normalize()),
+            (lambda o: a.cross(b, out=o), a.cross(b)),
+            (lambda o: a.projection(b, out=o), a.projection(b)),
+            (lambda o: a.reflection(b, out=o), a.reflection(b)),
+            (lambda o: a.rotate(b.normalize(), 0.3, out=o), a.rotate(b.normalize(), 0.3)),
+            (lambda o: a.lerp(b, 0.25, out=o), a.lerp(b, 0.25)),
+            (lambda o: a.clamp(-1.0, 1.0, out=o), a.clamp(-1.0, 1.0)),
+            (lambda o: core.element_wise_multiply(a, b, out=o), core.element_wise_multiply(a, b)),
+            (lambda o: core.element_wise_divide(a, b, out=o), core.element_wise_divide(a, b)),
+        ]
+        for into, expected in cases:
+            assert into(out) is out
+            assert list(out) == list(expected)
+
+    def test_out_may_alias_input(self):
+        """Test that the destination can be one of the operands."""
+        a = core.VectorND([1.0, 2.0, 3.0])
+        b = core.VectorND([4.0, 5.0, 6.0])
+        expected = a.cross(b)
+        a.cross(b, out=a)
+        assert list(a) == list(expected)
+
+    def test_out_is_resized(self):
+        """Test that a destination of another size is resized to fit."""
+        out = core.VectorND(7)
+        core.add(core.VectorND([1.0, 2.0]), core.VectorND([3.0, 4.0]), out=out)
+        assert list(out) == [4.0, 6.0]
+
+    def test_exported_out_cannot_resize(self):
+        """Test that a live view keeps the destination's storage in place."""
+        out = core.VectorND(3)
+        view = memoryview(out)
+        core.add(core.VectorND([1.0, 2.0, 3.0]), core.VectorND([1.0, 1.0, 1.0]), out=out)
+        assert view.tolist() == [2.0, 3.0, 4.0]
+        with pytest.raises(BufferError):
+            core.add(core.VectorND([1.0, 2.0]), core.VectorND([3.0, 4.0]), out=out)
+        with pytest.raises(BufferError):
+            out.resize(10)
+        view.release()
+        out.resize(10)
+        assert len(out) == 10
+
+    def test_augmented_assignment_rebinds(self):
+        """Test that += makes a new vector instead of changing aliases."""
+        a = core.VectorND([1.0, 2.0])
+        alias = a
+        a += core.VectorND([1.0, 1.0])
+        assert a is not alias
+        assert list(a) == [2.0, 3.0]
+        assert list(alias) == [1.0, 2.0]
+
+    def test_failure_leaves_out_unchanged(self):
+        """Test that a rejected operation does not touch the destination."""
+        out = core.VectorND([9.0, 9.0, 9.0])
+        with pytest.raises(RuntimeError):
+            core.VectorND([0.0, 0.0, 0.0]).normalize(out=out)
+        with pytest.raises(RuntimeError):
+            core.element_wise_divide(core.VectorND([1.0, 1.0]), core.VectorND([1.0, 0.0]), out=out)
+        assert list(out) == [9.0, 9.0, 9.0]
+
+    def test_steady_state_loop_does_not_allocate(self):
+        """Test that a loop reusing its destinations makes no storage requests."""
+        position = core.VectorND([0.0, 0.0, 0.0])
+        velocity = core.VectorND([1.0, 2.0, 3.0])
+        gravity = core.VectorND([0.0, -9.8, 0.0])
+        step = core.VectorND(3)
+        core.reset_allocator_stats()
+        for _ in range(100):
+            core.scale(gravity, 0.01, out=step)
+            core.add(velocity, step, out=velocity)
+            core.scale(velocity, 0.01, out=step)
+            core.add(position, step, out=position)
+            position.clamp(-100.0, 100.0, out=position)
+        assert core.allocator_stats().allocations == 0
+        assert position[1] < 0.0
+
+
+class TestVectorHashing:
+    """Test the quantized native hash tables keyed by vectors."""
+
+    def test_vector_nd_is_unhashable(self):
+        """Test that VectorND, whose == uses a tolerance, has no hash."""
+        v = core.VectorND([1.0, 2.0, 3.0])
+        assert v == core.VectorND([1.0 + 1e-10, 2.0, 3.0])
+        with pytest.raises(TypeError):
+            hash(v)
+
+    def test_vector_set_dedups_near_vectors(self):
+        """Test that vectors within a grid cell count once."""
+        v = core.VectorND([1.0, 2.0, 3.0])
+        s = core.VectorSet(3)
+        for u in (v, core.VectorND([1.0 + 1e-10, 2.0, 3.0]), core.VectorND([0.0, 0.0, 0.0])):
+            s.add(u)
+        assert len(s) == 2
+        assert core.VectorND([1.0 + 2e-9, 2.0, 3.0]) not in s
+
+    def test_vector_set(self):
+        """Test membership, insertion results and removal."""
+        s = core.VectorSet(2, tolerance=0.5)
+        assert s.add(core.VectorND([1.0, 1.0]))
+        assert not s.add(core.VectorND([1.2, 0.9]))
+        assert s.add(core.VectorND([2.0, 1.0]))
+        assert core.VectorND([0.8, 1.1]) in s
+        assert len(s) == 2
+        assert s.discard(core.VectorND([1.0, 1.0]))
+        assert not s.discard(core.VectorND([1.0, 1.0]))
+        assert core.VectorND([2.1, 1.0]) in s
+        assert len(s) == 1
+        with pytest.raises(RuntimeError, match="Dimension mismatch"):
+            s.add(core.VectorND([1.0, 2.0, 3.0]))
+
+    def test_vector_map(self):
+        """Test dict-style access with vector keys."""
+        m = core.VectorMap(3)
+        m[core.VectorND([1.0, 2.0, 3.0])] = "a"
+        m[core.VectorND([1.0, 2.0, 3.0 + 1e-12])] = "b"
+        m[core.VectorND([0.0, 0.0, 0.0])] = "c"
+        assert len(m) == 2
+        assert m[core.VectorND([1.0, 2.0, 3.0])] == "b"
+        assert m.get(core.VectorND([5.0, 5.0, 5.0]), 7) == 7
+        del m[core.VectorND([1.0, 2.0, 3.0])]
+        assert m.values() == ["c"]
+        with pytest.raises(KeyError):
+            m[core.VectorND([1.0, 2.0, 3.0])]
+
+
+if __name__ == "__main__":
+    pytest.main([__file__])
@@ -0,0 +1,1151 @@
+"""
+Tests for contiguous batches and on-disk vector storage
+"""
+
+import asyncio
+import pickle
+import threading
+import uuid
+import pytest
+import numpy as np
+
+core = pytest.importorskip("vectors._vectors_core")
+
+
+@pytest.fixture
+def rows():
+    """Fixture for a small 2D array of vectors."""
+    return np.arange(30, dtype=np.float64).reshape(10, 3)
+
+
+class TestVectorBatch:
+    """Test the owning contiguous batch."""
+
+    def test_from_numpy_and_back(self, rows):
+        """Test round trip through the buffer protocol."""
+        batch = core.VectorBatch(rows)
+        assert len(batch) == 10
+        assert batch.dimensions == 3
+        np.testing.assert_array_equal(np.asarray(batch), rows)
+
+    def test_from_vectors(self):
+        """Test packing a list of VectorND."""
+        batch = core.VectorBatch([core.VectorND([1.0, 2.0]), core.VectorND([3.0, 4.0])])
+        assert batch[1][0] == 3.0
+
+    def test_kernels_accept_batches_and_arrays(self, rows):
+        """Test batch kernels over batches and plain arrays."""
+        batch = core.VectorBatch(rows)
+        dots = core.batch_dot_product(batch, rows)
+        np.testing.assert_allclose(dots, np.einsum("ij,ij->i", rows, rows))
+        center = core.centroid(batch)
+        np.testing.assert_allclose([center[i] for i in range(3)], rows.mean(axis=0))
+        summed = core.batch_add(rows, rows)
+        np.testing.assert_array_equal(np.asarray(summed), rows * 2)
+
+    def test_exported_batch_cannot_resize(self, rows):
+        """Test that live views block reallocation, as on a bytearray."""
+        batch = core.VectorBatch(rows)
+        view = np.asarray(batch)
+        for grow in (lambda: batch.append(core.VectorND([1.0, 2.0, 3.0])),
+                     lambda: batch.reserve(1000), lambda: batch.resize(20), batch.clear):
+            with pytest.raises(BufferError):
+                grow()
+        core.batch_add(batch, batch, out=batch)
+        np.testing.assert_array_equal(view, rows * 2)
+        with pytest.raises(BufferError):
+            core.batch_add(rows[:5], rows[:5], out=batch)
+        del view
+        batch.append(core.VectorND([1.0, 2.0, 3.0]))
+        assert len(batch) == 11
+
+    def test_distance_and_nearest(self, rows):
+        """Test brute-force distances and k-nearest search."""
+        query = core.VectorND([3.0, 4.0, 5.0])
+        expected = np.linalg.norm(rows - np.array([3.0, 4.0, 5.0]), axis=1)
+        np.testing.assert_allclose(core.batch_distance(rows, query), expected)
+        indices, distances = core.k_nearest(rows, query, 3)
+        np.testing.assert_array_equal(indices, np.argsort(expected, kind="stable")[:3])
+        np.testing.assert_allclose(distances, np.sort(expected)[:3])
+        assert len(core.k_nearest(rows, query, 50)[0]) == 10
+
+    def test_shape_mismatch(self, rows):
+        """Test that mismatched batches are rejected."""
+        with pytest.raises(RuntimeError):
+            core.batch_dot_product(rows, rows[:5])
+
+
+class TestNormalization:
+    """Test normalization kernels and the norm-cached batch."""
+
+    def test_batch_normalize(self, rows):
+        """Test normalizing into a new batch and in place."""
+        data = rows + 1.0
+        expected = data / np.linalg.norm(data, axis=1, keepdims=True)
+        np.testing.assert_allclose(np.asarray(core.batch_normalize(data)), expected)
+        batch = core.VectorBatch(data)
+        assert core.batch_normalize(batch, out=batch) is batch
+        np.testing.assert_allclose(np.asarray(batch), expected)
+
+    def test_normalize_zero_row(self):
+        """Test that zero rows are rejected."""
+        with pytest.raises(RuntimeError):
+            core.batch_normalize(np.zeros((2, 3)))
+
+    def test_cosine_matches_per_vector(self, rows):
+        """Test batch cosine similarity against the VectorND method."""
+        data = rows + 1.0
+        query = core.VectorND([1.0, -2.0, 0.5])
+        expected = [core.VectorND(list(r)).cosine_similarity(query) for r in data]
+        np.testing.assert_allclose(core.batch_cosine_similarity(data, query), expected)
+        cached = core.NormCachedBatch(data)
+        np.testing.assert_allclose(cached.cosine_similarity(query), expected)
+        np.testing.assert_allclose(cached.norms, np.linalg.norm(data, axis=1))
+
+    def test_norms_follow_mutation(self, rows):
+        """Test that set and extend keep the cached norms valid."""
+        cached = core.NormCachedBatch(rows + 1.0)
+        cached[0] = core.VectorND([3.0, 4.0, 0.0])
+        assert cached.norm(0) == 5.0
+        cached.extend(np.array([[0.0, 0.0, 2.0]]))
+        assert len(cached) == 11
+        assert cached.norm(10) == 2.0
+        assert not np.asarray(cached).flags.writeable
+
+    def test_extend_with_itself(self, rows):
+        """Test appending a batch's own rows, which grows the storage they view."""
+        cached = core.NormCachedBatch(rows + 1.0)
+        cached.extend(cached)
+        assert len(cached) == 20
+        np.testing.assert_array_equal(np.asarray(cached), np.vstack([rows, rows]) + 1.0)
+        np.testing.assert_allclose(cached.norms[10:], cached.norms[:10])
+
+    def test_exported_cache_cannot_grow(self, rows):
+        """Test that a live view blocks append, extend, reserve and clear."""
+        cached = core.NormCachedBatch(rows)
+        view = np.asarray(cached)
+        with pytest.raises(BufferError):
+            cached.extend(cached)
+        with pytest.raises(BufferError):
+            cached.clear()
+        del view
+        cached.extend(cached)
+        assert len(cached) == 20
+
+
+class TestTransforms:
+    """Test the Matrix type and batched linear/affine transforms."""
+
+    def test_transform_matches_numpy(self):
+        """Test fixed-size and generic shapes against NumPy."""
+        rng = np.random.default_rng(7)
+        for rows_out, cols in [(3, 3), (4, 4), (5, 5), (2, 9), (12, 6)]:
+            data = rng.standard_normal((37, cols))
+            mat = rng.standard_normal((rows_out, cols))
+            t = rng.standard_normal(rows_out)
+            np.testing.assert_allclose(np.asarray(core.transform(data, mat)), data @ mat.T)
+            shifted = core.transform_affine(data, mat, core.VectorND(list(t)))
+            np.testing.assert_allclose(np.asarray(shifted), data @ mat.T + t)
+
+    def test_rotation_matches_vector_rotate(self, rows):
+        """Test Matrix.rotation against VectorND.rotate."""
+        axis = core.VectorND([0.0, 0.6, 0.8])
+        rotated = np.asarray(core.transform(rows, core.Matrix.rotation(axis, 0.7)))
+        turned = [core.VectorND(list(r)).rotate(axis, 0.7) for r in rows]
+        expected = [[v[i] for i in range(3)] for v in turned]
+        np.testing.assert_allclose(rotated, expected, atol=1e-12)
+
+    def test_homogeneous_and_in_place(self, rows):
+        """Test a 4x4 homogeneous transform applied in place to 3D points."""
+        mat = np.eye(4)
+        mat[:3, 3] = [1.0, -2.0, 3.0]
+        mat[0, 1] = 0.5
+        batch = core.VectorBatch(rows)
+        assert core.transform_affine(batch, mat, out=batch) is batch
+        np.testing.assert_allclose(np.asarray(batch), rows @ mat[:3, :3].T + mat[:3, 3])
+        mat[3, 0] = 1.0
+        with pytest.raises(RuntimeError):
+            core.transform_affine(rows, mat)
+
+    def test_matrix_type(self):
+        """Test Matrix construction, indexing and products."""
+        mat = core.Matrix([[1.0, 2.0], [3.0, 4.0]])
+        assert (mat.rows, mat.cols) == (2, 2)
+        assert mat[1, 0] == 3.0
+        np.testing.assert_array_equal(np.asarray(mat @ core.Matrix.identity(2)), np.asarray(mat))
+        product = mat @ core.VectorND([1.0, 1.0])
+        assert (product[0], product[1]) == (3.0, 7.0)
+        assert mat.transpose()[0, 1] == 3.0
+        with pytest.raises(RuntimeError):
+            core.transform(np.ones((4, 3)), mat)
+
+
+class TestDimensionReduction:
+    """Test random projections and PCA against NumPy."""
+
+    def test_random_projection(self):
+        """Test both kinds against their matrices."""
+        rng = np.random.default_rng(8)
+        data = rng.standard_normal((300, 64))
+        for kind in (core.ProjectionKind.GAUSSIAN, core.ProjectionKind.SPARSE):
+            projection = core.RandomProjection(64, 16, kind, seed=3)
+            mat = np.asarray(projection.matrix)
+            assert mat.shape == (16, 64)
+            np.testing.assert_allclose(np.asarray(projection.transform(data)), data @ mat.T)
+        sparse = core.RandomProjection(64, 16, core.ProjectionKind.SPARSE)
+        assert sparse.density == 0.125
+        with pytest.raises(RuntimeError, match="Dimension mismatch"):
+            sparse.transform(np.ones((2, 3)))
+
+    def test_pca_matches_eigh(self):
+        """Test components and variances, fitted in chunks, against eigh."""
+        rng = np.random.default_rng(9)
+        data = rng.standard_normal((2000, 40)) * np.linspace(5.0, 0.1, 40) + 2.0
+        pca = core.Pca(40, 4)
+        for chunk in np.array_split(data, 7):
+            pca.partial_fit(chunk)
+        pca.fit()
+        values, vecs = np.linalg.eigh(np.cov(data, rowvar=False))
+        expected = vecs[:, ::-1][:, :4].T
+        expected *= np.sign(expected[np.arange(4), np.abs(expected).argmax(axis=1)])[:, None]
+        np.testing.assert_allclose(np.asarray(pca.components), expected, atol=1e-6)
+        np.testing.assert_allclose(pca.explained_variance, values[::-1][:4], rtol=1e-9)
+        np.testing.assert_allclose(list(pca.mean), data.mean(axis=0))
+
+        coords = np.asarray(pca.transform(data))
+        np.testing.assert_allclose(coords, (data - data.mean(axis=0)) @ expected.T, atol=1e-6)
+        assert np.asarray(pca.inverse_transform(coords)).shape == (2000, 40)
+
+    def test_pca_errors(self, rows):
+        """Test fitting requirements."""
+        pca = core.Pca(3, 2)
+        with pytest.raises(RuntimeError, match="not been fitted"):
+            pca.transform(rows)
+        with pytest.raises(RuntimeError, match="fewer than 2"):
+            pca.fit(rows[:1])
+        with pytest.raises(RuntimeError):
+            core.Pca(3, 4)
+
+
+class TestGeometryKernels:
+    """Test batched cross products, projections, reflections and angles."""
+
+    def test_match_vector_methods(self):
+        """Test every kernel against the per-pair VectorND methods."""
+        rng = np.random.default_rng(3)
+        a = rng.standard_normal((150, 3))
+        b = rng.standard_normal((150, 3))
+        pairs = [(core.VectorND(list(u)), core.VectorND(list(v))) for u, v in zip(a, b)]
+
+        def rows(vectors):
+            return [[v[i] for i in range(3)] for v in vectors]
+
+        np.testing.assert_allclose(np.asarray(core.batch_cross(a, b)), np.cross(a, b))
+        np.testing.assert_allclose(np.asarray(core.batch_project(a, b)),
+                                   rows(u.projection(v) for u, v in pairs))
+        np.testing.assert_allclose(np.asarray(core.batch_reflect(a, b)),
+                                   rows(u.reflection(v) for u, v in pairs))
+        np.testing.assert_allclose(core.batch_angle_between(a, b),
+                                   [u.angle_between(v) for u, v in pairs])
+
+    def test_single_vector_and_in_place(self, rows):
+        """Test broadcasting one normal and writing over the input."""
+        normal = core.VectorND([0.0, 0.0, 1.0])
+        batch = core.VectorBatch(rows)
+        assert core.batch_reflect(batch, normal, out=batch) is batch
+        np.testing.assert_array_equal(np.asarray(batch), rows * [1.0, 1.0, -1.0])
+        angles = core.batch_angle_between(rows, normal)
+        expected = np.arccos(rows[:, 2] / np.linalg.norm(rows, axis=1))
+        np.testing.assert_allclose(angles, expected)
+
+    def test_other_dimensions(self):
+        """Test projection of non-3D rows and the 3D-only cross product."""
+        a = np.arange(1.0, 9.0).reshape(2, 4)
+        onto = np.array([[1.0, 0.0, 0.0, 0.0]])
+        np.testing.assert_array_equal(np.asarray(core.batch_project(a, onto)),
+                                      [[1.0, 0, 0, 0], [5.0, 0, 0, 0]])
+        with pytest.raises(RuntimeError):
+            core.batch_cross(a, a)
+
+    def test_zero_vectors(self, rows):
+        """Test that zero vectors raise like the VectorND methods."""
+        with pytest.raises(RuntimeError):
+            core.batch_project(rows, np.zeros((1, 3)))
+        with pytest.raises(RuntimeError):
+            core.batch_angle_between(rows, core.VectorND([0.0, 0.0, 0.0]))
+
+
+class TestMortonOrder:
+    """Test Morton codes, radix argsort and row gathering."""
+
+    def test_codes_interleave_axes(self):
+        """Test codes of grid corners and the bit interleaving."""
+        points = np.array([[0.0, 0.0], [1.0, 0.0], [0.0, 1.0], [1.0, 1.0]])
+        codes = core.morton_codes(points, bits=32)
+        assert codes.dtype == np.uint32
+        x = int(codes[1])
+        assert x == sum(1 << (2 * b) for b in range(16))
+        assert int(codes[2]) == x << 1
+        assert int(codes[3]) == (1 << 32) - 1
+        assert codes[0] == 0
+        cube = np.array([[0.0, 0.0, 0.0], [0.0, 0.0, 2.0]])
+        assert int(core.morton_codes(cube)[1]) == sum(1 << (3 * b + 2) for b in range(21))
+        with pytest.raises(RuntimeError, match="2D or 3D"):
+            core.morton_codes(np.ones((3, 4)))
+
+    def test_order_and_gather(self):
+        """Test that the order sorts the codes and gathering follows it."""
+        rng = np.random.default_rng(11)
+        points = rng.uniform(-10.0, 10.0, (50000, 3))
+        order = core.morton_order(points)
+        codes = core.morton_codes(points)
+        np.testing.assert_array_equal(order, np.argsort(codes, kind="stable"))
+        gathered = core.gather_rows(points, order)
+        np.testing.assert_array_equal(np.asarray(gathered), points[order])
+        batch = core.VectorBatch(points)
+        assert core.gather_rows(batch, order, out=batch) is batch
+        np.testing.assert_array_equal(np.asarray(batch), points[order])
+        with pytest.raises(IndexError):
+            core.gather_rows(points, np.array([0, 50000]))
+
+    def test_radix_argsort(self):
+        """Test a stable argsort of 64-bit keys against NumPy."""
+        rng = np.random.default_rng(12)
+        shifts = rng.integers(0, 60, 100000).astype(np.uint64)
+        keys = rng.integers(0, 2**63, 100000, dtype=np.uint64) >> shifts
+        np.testing.assert_array_equal(core.radix_argsort(keys), np.argsort(keys, kind="stable"))
+
+
+class TestElementwiseKernels:
+    """Test broadcasting element-wise batch math."""
+
+    def test_match_numpy_broadcasting(self):
+        """Test every operand shape against NumPy broadcasting."""
+        rng = np.random.default_rng(5)
+        a = rng.uniform(0.5, 2.0, (40, 4))
+        operands = [
+            rng.uniform(0.5, 2.0, (40, 4)),
+            rng.uniform(0.5, 2.0, (1, 4)),
+            rng.uniform(0.5, 2.0, (40, 1)),
+            rng.uniform(0.5, 2.0, 4),
+            1.5,
+        ]
+        kernels = [
+            (core.batch_add, np.add),
+            (core.batch_subtract, np.subtract),
+            (core.batch_multiply, np.multiply),
+            (core.batch_divide, np.divide),
+            (core.batch_minimum, np.minimum),
+            (core.batch_maximum, np.maximum),
+        ]
+        for kernel, reference in kernels:
+            for b in operands:
+                np.testing.assert_array_equal(np.asarray(kernel(a, b)), reference(a, b))
+                np.testing.assert_array_equal(np.asarray(kernel(b, a)), reference(b, a))
+        vector = core.VectorND([1.0, 2.0, 3.0, 4.0])
+        np.testing.assert_array_equal(np.asarray(core.batch_multiply(a, vector)),
+                                      a * [1.0, 2.0, 3.0, 4.0])
+        np.testing.assert_allclose(np.asarray(core.batch_fma(a, operands[2], operands[1])),
+                                   a * operands[2] + operands[1])
+
+    def test_unary_functions(self, rows):
+        """Test abs, sqrt, exp and log against NumPy."""
+        values = rows - 10.0
+        np.testing.assert_array_equal(np.asarray(core.batch_abs(values)), np.abs(values))
+        np.testing.assert_allclose(np.asarray(core.batch_sqrt(rows)), np.sqrt(rows))
+        np.testing.assert_allclose(np.asarray(core.batch_exp(values / 10.0)),
+                                   np.exp(values / 10.0))
+        np.testing.assert_allclose(np.asarray(core.batch_log(rows + 1.0)), np.log(rows + 1.0))
+
+    def test_in_place(self, rows):
+        """Test writing the result over an input batch."""
+        batch = core.VectorBatch(rows)
+        assert core.batch_multiply(batch, 2.0, out=batch) is batch
+        np.testing.assert_array_equal(np.asarray(batch), rows * 2.0)
+
+    def test_zero_divisor_leaves_out_unchanged(self, rows):
+        """Test that a zero divisor raises before anything is written."""
+        out = core.VectorBatch(rows)
+        divisor = np.ones_like(rows)
+        divisor[7, 1] = 0.0
+        with pytest.raises(RuntimeError, match="Division by zero"):
+            core.batch_divide(rows + 1.0, divisor, out=out)
+        np.testing.assert_array_equal(np.asarray(out), rows)
+
+    def test_shape_mismatch(self, rows):
+        """Test that shapes that do not broadcast are rejected."""
+        with pytest.raises(RuntimeError, match="Batch size mismatch"):
+            core.batch_add(rows, rows[:4])
+        with pytest.raises(RuntimeError, match="Dimension mismatch"):
+            core.batch_multiply(rows, np.ones(2))
+
+
+class TestNearDuplicates:
+    """Test batch epsilon equality and near-duplicate grouping."""
+
+    def test_isclose_matches_vector_equality(self, rows):
+        """Test that closeness uses the tolerance of VectorND ==."""
+        other = rows.copy()
+        other[3, 1] += 5e-10
+        other[6, 2] += 2e-9
+        np.testing.assert_array_equal(core.batch_isclose(rows, other),
+                                      [i != 6 for i in range(10)])
+        assert not core.batch_allclose(rows, other)
+        assert core.batch_allclose(rows, other, tolerance=1e-8)
+        assert core.VectorND(list(rows[3])) == core.VectorND(list(other[3]))
+        np.testing.assert_array_equal(core.batch_isclose(rows, core.VectorND([3.0, 4.0, 5.0])),
+                                      [i == 1 for i in range(10)])
+
+    def test_groups_match_brute_force(self):
+        """Test grouping against an all-pairs check, including cell boundaries."""
+        rng = np.random.default_rng(11)
+        tolerance = 1e-3
+        base = rng.uniform(-2.0, 2.0, (60, 3))
+        noise = rng.uniform(-0.9, 0.9, (120, 3)) * tolerance
+        points = np.vstack([base, base[rng.integers(0, 60, 120)] + noise, base[:5]])
+        close = np.all(np.abs(points[:, None] - points[None]) < tolerance, axis=2)
+        parent = list(range(len(points)))
+        for i, j in zip(*np.nonzero(np.triu(close, 1))):
+            root_i, root_j = i, j
+            while parent[root_i] != root_i:
+                root_i = parent[root_i]
+            while parent[root_j] != root_j:
+                root_j = parent[root_j]
+            parent[max(root_i, root_j)] = min(root_i, root_j)
+        expected = {}
+        for i in range(len(points)):
+            root = i
+            while parent[root] != root:
+                root = parent[root]
+            expected.setdefault(root, []).append(i)
+        expected = [group for group in expected.values() if len(group) > 1]
+        assert core.find_near_duplicates(points, tolerance) == expected
+
+    def test_interleaved_groups_ordered_by_first_index(self):
+        """Test that a group is listed by its first row, not its first duplicate."""
+        points = np.array([[0.0], [10.0], [100.0], [10.0], [200.0], [0.0]])
+        assert core.find_near_duplicates(points, 1e-6) == [[0, 5], [1, 3]]
+
+    def test_non_finite_rows_are_not_grouped(self, rows):
+        """Test that rows with NaN or inf never join a group."""
+        points = np.vstack([rows, rows[:2]])
+        points[0, 0] = np.nan
+        points[10, 0] = np.nan
+        points[1, 2] = np.inf
+        points[11, 2] = np.inf
+        assert core.find_near_duplicates(points) == []
+
+    def test_invalid_arguments(self, rows):
+        """Test tolerance and shape validation."""
+        with pytest.raises(RuntimeError, match="Tolerance must be positive"):
+            core.find_near_duplicates(rows, 0.0)
+        with pytest.raises(RuntimeError, match="Batch size mismatch"):
+            core.batch_isclose(rows, rows[:4])
+        with pytest.raises(RuntimeError, match="Dimension mismatch"):
+            core.batch_allclose(rows, np.ones((10, 2)))
+
+
+class TestVectorHashTables:
+    """Test batch operations of VectorSet and VectorMap."""
+
+    def test_set_batches(self, rows):
+        """Test bulk insertion and membership against row-by-row results."""
+        points = np.vstack([rows, rows[:4] + 1e-12])
+        s = core.VectorSet(3)
+        np.testing.assert_array_equal(s.add_batch(points), [True] * 10 + [False] * 4)
+        assert len(s) == 10
+        np.testing.assert_array_equal(np.asarray(s.to_batch()), rows)
+        np.testing.assert_array_equal(s.contains_batch(rows + [0.0, 0.0, 0.5]),
+                                      [False] * 10)
+        assert len(core.VectorSet(points)) == 10
+
+    def test_large_batch(self):
+        """Test a batch large enough to be split across the thread pool."""
+        rng = np.random.default_rng(2)
+        points = rng.integers(0, 50, (20000, 2)).astype(np.float64)
+        s = core.VectorSet(points)
+        assert len(s) == len(np.unique(points, axis=0))
+        assert s.contains_batch(points).all()
+
+    def test_map_get_batch(self, rows):
+        """Test looking up a batch of keys at once."""
+        m = core.VectorMap(3)
+        for i, row in enumerate(rows):
+            m[core.VectorND(list(row))] = i
+        queries = np.vstack([rows[::3], [[-1.0, -1.0, -1.0]]])
+        assert m.get_batch(queries, default=-1) == [0, 3, 6, 9, -1]
+        np.testing.assert_array_equal(np.asarray(m.keys()), rows)
+
+
+class TestLshIndex:
+    """Test LSH queries against exact neighbors."""
+
+    def test_cosine_finds_perturbed_rows(self):
+        """Test that slightly perturbed rows find their source row first."""
+        rng = np.random.default_rng(3)
+        points = rng.normal(size=(5000, 32))
+        index = core.LshIndex(32, core.LshMetric.COSINE, tables=10, hashes=12, seed=1)
+        assert index.add_batch(points) == 0
+        assert len(index) == 5000
+        queries = points[:50] + rng.normal(scale=0.01, size=(50, 32))
+        ids, distances = index.query_batch(queries, 3)
+        assert ids.shape == (50, 3)
+        np.testing.assert_array_equal(ids[:, 0], np.arange(50))
+        assert (distances[:, 0] < 1e-3).all()
+
+    def test_euclidean_query_and_padding(self, rows):
+        """Test exact scoring of candidates and padding of missing results."""
+        index = core.LshIndex(3, core.LshMetric.EUCLIDEAN, tables=4, hashes=2, bucket_width=8.0)
+        index.add_batch(rows)
+        ids, distances = index.query(core.VectorND(list(rows[4])), 1)
+        assert list(ids) == [4] and distances[0] == 0.0
+        ids, distances = index.query_batch(np.array([[1e6, 1e6, 1e6]]), 2)
+        assert list(ids[0]) == [-1, -1]
+        assert np.isnan(distances).all()
+        assert set(index.candidates(core.VectorND(list(rows[4])))) >= {4}
+
+    def test_signatures(self):
+        """Test bit-packed signatures and their Hamming distances."""
+        rng = np.random.default_rng(4)
+        points = rng.normal(size=(100, 8))
+        index = core.LshIndex(8, tables=5, hashes=20)
+        index.add_batch(points)
+        query = core.VectorND(list(points[7]))
+        assert index.signature(query).shape == (2,)
+        hamming = index.hamming_distances(query)
+        assert hamming[7] == 0
+        assert hamming.max() <= 100
+        ids, _ = index.query(query, 1, max_candidates=1)
+        assert list(ids) == [7]
+
+    def test_errors(self):
+        """Test zero vectors, dimension mismatches and invalid parameters."""
+        index = core.LshIndex(3)
+        with pytest.raises(RuntimeError, match="zero vector"):
+            index.add_batch(np.array([[1.0, 0.0, 0.0], [0.0, 0.0, 0.0]]))
+        assert len(index) == 0
+        with pytest.raises(RuntimeError, match="Dimension mismatch"):
+            index.add(core.VectorND([1.0, 2.0]))
+        with pytest.raises(RuntimeError, match="at most 64"):
+            core.LshIndex(3, hashes=65)
+
+
+def brute_force_rays(triangles, origins, directions, t_max=np.inf):
+    """Nearest two-sided Moller-Trumbore hit of every ray against every triangle."""
+    v0 = triangles[:, 0:3]
+    e1 = triangles[:, 3:6] - v0
+    e2 = triangles[:, 6:9] - v0
+    p = np.cross(directions[:, None, :], e2)
+    s = origins[:, None, :] - v0
+    q = np.cross(s, e1)
+    with np.errstate(divide="ignore", invalid="ignore"):
+        inv = 1.0 / np.einsum("tk,rtk->rt", e1, p)
+        u = np.einsum("rtk,rtk->rt", s, p) * inv
+        w = np.einsum("rk,rtk->rt", directions, q) * inv
+        t = np.einsum("tk,rtk->rt", e2, q) * inv
+        valid = (u >= 0) & (w >= 0) & (u + w <= 1) & (t >= 0) & (t <= t_max)
+    t = np.where(valid, t, np.inf)
+    hit = t.argmin(axis=1)
+    best = t[np.arange(len(t)), hit]
+    hit[np.isinf(best)] = -1
+    return hit, best
+
+
+class TestBvh:
+    """Test BVH ray, segment and closest-point queries against brute force."""
+
+    @pytest.fixture
+    def triangles(self):
+        """Fixture for small random triangles scattered in a cube."""
+        rng = np.random.default_rng(5)
+        centers = rng.uniform(-10, 10, size=(800, 1, 3))
+        return (centers + rng.uniform(-1, 1, size=(800, 3, 3))).reshape(-1, 9)
+
+    def test_rays_match_brute_force(self, triangles):
+        """Test nearest hits of random rays, with a shared direction and t_max."""
+        rng = np.random.default_rng(6)
+        bvh = core.Bvh.from_triangles(triangles)
+        assert len(bvh) == 800
+        assert bvh.primitive == core.BvhPrimitive.TRIANGLE
+        assert bvh.node_count < 2 * len(bvh)
+        origins = rng.uniform(-12, 12, size=(301, 3))
+        directions = rng.normal(size=(301, 3))
+        hit, t = bvh.intersect(origins, directions, t_max=20.0)
+        expected, expected_t = brute_force_rays(triangles, origins, directions, 20.0)
+        assert (expected >= 0).sum() > 50
+        np.testing.assert_array_equal(hit, expected)
+        np.testing.assert_allclose(t[hit >= 0], expected_t[hit >= 0], rtol=1e-12)
+        assert np.isnan(t[hit < 0]).all()
+        shared = np.array([0.0, 0.0, 1.0])
+        hit, t = bvh.intersect(origins, shared)
+        expected, expected_t = brute_force_rays(triangles, origins, np.tile(shared, (301, 1)))
+        np.testing.assert_array_equal(hit, expected)
+
+    def test_segments(self, triangles):
+        """Test that segment t is the fraction of the way to the end point."""
+        rng = np.random.default_rng(7)
+        bvh = core.Bvh.from_triangles(triangles)
+        starts = rng.uniform(-12, 12, size=(200, 3))
+        ends = rng.uniform(-12, 12, size=(200, 3))
+        hit, t = bvh.intersect_segments(starts, ends)
+        expected, expected_t = brute_force_rays(triangles, starts, ends - starts, 1.0)
+        np.testing.assert_array_equal(hit, expected)
+        np.testing.assert_allclose(t[hit >= 0], expected_t[hit >= 0], rtol=1e-12)
+        assert (t[hit >= 0] <= 1.0).all()
+
+    def test_boxes(self):
+        """Test ray entry points and nearest points on a row of boxes."""
+        lows = np.array([[2.0 * i, 0.0, 0.0] for i in range(10)])
+        boxes = np.hstack([lows, lows + 1.0])
+        bvh = core.Bvh.from_boxes(boxes)
+        hit, t = bvh.intersect(np.array([[-5.0, 0.5, 0.5], [4.5, 0.5, 0.5], [0.0, 5.0, 0.0]]),
+                               np.array([1.0, 0.0, 0.0]))
+        assert list(hit) == [0, 2, -1]
+        np.testing.assert_allclose(t[:2], [5.0, 0.0])
+        points = np.array([[6.5, 3.0, 0.5], [-4.0, 0.5, 0.5], [50.0, 0.0, 0.0]])
+        ids, distances, closest = bvh.closest_points(points, max_distance=10.0)
+        assert list(ids) == [3, 0, -1]
+        np.testing.assert_allclose(distances[:2], [2.0, 4.0])
+        np.testing.assert_allclose(closest[:2], [[6.5, 1.0, 0.5], [0.0, 0.5, 0.5]])
+        assert np.isnan(closest[2]).all()
+
+    def test_closest_points(self, triangles):
+        """Test nearest distances against points sampled on every triangle."""
+        rng = np.random.default_rng(8)
+        bvh = core.Bvh.from_triangles(triangles)
+        points = rng.uniform(-12, 12, size=(50, 3))
+        ids, distances, closest = bvh.closest_points(points)
+        np.testing.assert_allclose(np.linalg.norm(closest - points, axis=1), distances)
+        # No sampled point on any triangle is nearer than the returned distance
+        weights = rng.dirichlet(np.ones(3), size=16)
+        samples = np.einsum("sv,tvk->tsk", weights, triangles.reshape(-1, 3, 3)).reshape(-1, 3)
+        sampled = np.linalg.norm(points[:, None, :] - samples[None], axis=2).min(axis=1)
+        assert (distances <= sampled + 1e-12).all()
+        vertex = triangles[ids, 0:3]
+        assert (distances <= np.linalg.norm(vertex - points, axis=1) + 1e-12).all()
+
+    def test_errors(self, triangles):
+        """Test primitive widths and query dimensions."""
+        with pytest.raises(RuntimeError, match="rows of 6"):
+            core.Bvh.from_boxes(triangles)
+        bvh = core.Bvh.from_triangles(triangles)
+        with pytest.raises(RuntimeError, match="Dimension mismatch"):
+            bvh.intersect(np.zeros((4, 2)), np.ones((4, 2)))
+        with pytest.raises(RuntimeError, match="Batch size mismatch"):
+            bvh.intersect(np.zeros((4, 3)), np.ones((3, 3)))
+        empty = core.Bvh.from_triangles(np.zeros((0, 9)))
+        hit, t = empty.intersect(np.zeros((2, 3)), np.ones((2, 3)))
+        assert list(hit) == [-1, -1] and np.isnan(t).all()
+
+
+class TestSparseVectors:
+    """Test sparse vectors and CSR batches against dense results."""
+
+    @pytest.fixture
+    def pair(self):
+        """Fixture for two overlapping sparse vectors and their dense forms."""
+        rng = np.random.default_rng(11)
+        dense = np.zeros((2, 5000))
+        for row, nnz in zip(dense, (40, 3000)):
+            row[rng.choice(5000, nnz, replace=False)] = rng.standard_normal(nnz)
+        sparse = [core.SparseVectorND.from_dense(core.VectorND(list(row))) for row in dense]
+        return sparse, dense
+
+    def test_construction(self):
+        """Test that entries are sorted and repeated indices summed."""
+        v = core.SparseVectorND(10, [7, 2, 7], [1.0, 2.0, 3.0])
+        assert v.nnz == 2
+        np.testing.assert_array_equal(v.indices, [2, 7])
+        assert v[7] == 4.0 and v[3] == 0.0
+        with pytest.raises(IndexError):
+            core.SparseVectorND(10, [10], [1.0])
+
+    def test_equality_ignores_construction(self):
+        """Test that explicit zeros and tiny differences compare like VectorND."""
+        explicit = core.SparseVectorND(10, [3, 1], [0.0, 2.0])
+        assert explicit.nnz == 1
+        merged = core.SparseVectorND(10, [1, 3], [1.0, 1.0]) - core.SparseVectorND(10, [3], [1.0])
+        merged = merged + core.SparseVectorND(10, [1], [1.0])
+        assert merged == explicit
+        assert explicit == merged + core.SparseVectorND(10, [4], [1e-12])
+        assert explicit != core.SparseVectorND(10, [1], [2.0 + 1e-6])
+
+    def test_operations_match_dense(self, pair):
+        """Test dot, norms, cosine, addition and scaling."""
+        (a, b), (da, db) = pair
+        dense_b = core.VectorND(list(db))
+        assert a.dot(b) == pytest.approx(da @ db)
+        assert b.dot(a) == pytest.approx(da @ db)
+        assert a.dot(dense_b) == pytest.approx(da @ db)
+        assert a.magnitude() == pytest.approx(np.linalg.norm(da))
+        expected = da @ db / (np.linalg.norm(da) * np.linalg.norm(db))
+        assert a.cosine_similarity(b) == pytest.approx(expected)
+        total = a + b
+        np.testing.assert_allclose([total[i] for i in range(5000)], da + db)
+        assert (a - a).nnz == 0
+        assert 2.0 * a == a * 2.0
+        summed = a + dense_b
+        assert summed[int(a.indices[0])] == pytest.approx(da[a.indices[0]] + db[a.indices[0]])
+
+    def test_csr_batch_scans(self, pair):
+        """Test CSR construction and corpus scans."""
+        (a, b), (da, db) = pair
+        batch = core.SparseBatch(5000)
+        batch.append(a)
+        batch.append(b)
+        assert len(batch) == 2 and batch.nnz == a.nnz + b.nnz
+        np.testing.assert_allclose(batch.dot(b), [da @ db, db @ db])
+        np.testing.assert_allclose(batch.dot(core.VectorND(list(db))), [da @ db, db @ db])
+        norms = np.linalg.norm([da, db], axis=1)
+        np.testing.assert_allclose(batch.cosine_similarity(b),
+                                   np.array([da @ db, db @ db]) / (norms * norms[1]))
+        copy = core.SparseBatch(5000, batch.indptr, batch.indices, batch.values)
+        assert copy[1] == b
+        np.testing.assert_array_equal(np.asarray(copy.to_dense()), [da, db])
+
+    def test_unsorted_csr_rows(self):
+        """Test that unsorted CSR rows are canonicalized."""
+        batch = core.SparseBatch(10, [0, 3, 5], [5, 1, 5, 2, 0], [1.0, 2.0, 3.0, 4.0, 5.0])
+        np.testing.assert_array_equal(batch.indptr, [0, 2, 4])
+        assert batch[0][5] == 4.0
+        with pytest.raises(RuntimeError):
+            core.SparseBatch(10, [0, 2], [1], [1.0])
+
+
+class TestConcurrentVectorStore:
+    """Test the append-only concurrent store and its snapshots."""
+
+    def test_append_and_snapshot(self, rows):
+        """Test appends, snapshot isolation and search."""
+        store = core.ConcurrentVectorStore(3, segment_rows=4)
+        assert store.extend(rows) == 0
+        assert store.append(core.VectorND([0.5, 0.5, 0.5])) == 10
+        with store.snapshot() as snap:
+            store.extend(rows)
+            assert len(snap) == 11 and len(store) == 21
+            assert snap[3][1] == rows[3][1]
+            indices, distances = snap.k_nearest(core.VectorND([0.0, 0.0, 0.0]), 2)
+            np.testing.assert_array_equal(indices, [10, 0])
+        with pytest.raises(RuntimeError):
+            snap.is_deleted(0)
+
+    def test_oversized_segments_rejected(self):
+        """Test that segment sizes past the addressable range are refused."""
+        for segment_rows in (2**63 + 1, 2**64 - 1):
+            with pytest.raises(RuntimeError, match="Segment rows must be at most"):
+                core.ConcurrentVectorStore(4, segment_rows=segment_rows)
+        assert core.ConcurrentVectorStore(4, segment_rows=3000).segment_rows == 4096
+
+    def test_remove_and_reclaim(self, rows):
+        """Test that deleted rows disappear from snapshots."""
+        store = core.ConcurrentVectorStore(3, segment_rows=4)
+        store.extend(rows)
+        snap = store.snapshot()
+        for index in range(5):
+            assert store.remove(index)
+        assert not store.remove(0)
+        store.collect()
+        assert snap.is_deleted(0) and not snap.is_deleted(5)
+        indices, batch = snap.to_batch()
+        np.testing.assert_array_equal(indices, range(5, 10))
+        np.testing.assert_array_equal(np.asarray(batch), rows[5:])
+        with pytest.raises(IndexError):
+            snap[0]
+        snap.release()
+
+    def test_concurrent_writers(self):
+        """Test that rows from several threads are all committed intact."""
+        store = core.ConcurrentVectorStore(4, segment_rows=64)
+
+        def write(worker):
+            for start in range(0, 2000, 50):
+                values = worker * 10000 + np.arange(start, start + 50, dtype=np.float64)
+                store.extend(np.repeat(values[:, None], 4, axis=1))
+
+        threads = [threading.Thread(target=write, args=(w,)) for w in range(4)]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+        indices, batch = store.snapshot().to_batch()
+        data = np.asarray(batch)
+        assert len(indices) == 8000
+        assert (data == data[:, :1]).all()
+        assert sorted(data[:, 0]) == sorted(w * 10000 + i for w in range(4) for i in range(2000))
+
+
+class TestAsyncBatchExecutor:
+    """Test the awaitable batch kernels."""
+
+    def test_results_match_sync_kernels(self, rows):
+        """Test that awaited results equal the synchronous kernels."""
+        from vectors import aio
+
+        query = core.VectorND([1.0, 0.0, 2.0])
+
+        async def run():
+            async with aio.AsyncBatchExecutor(max_in_flight=2) as executor:
+                return await asyncio.gather(
+                    executor.batch_dot_product(rows, rows),
+                    executor.batch_distance(rows, query),
+                    executor.batch_norms(rows),
+                    executor.centroid(rows),
+                    executor.k_nearest(rows, query, 3),
+                )
+
+        dots, distances, norms, center, (indices, _) = asyncio.run(run())
+        np.testing.assert_allclose(dots, core.batch_dot_product(rows, rows))
+        np.testing.assert_allclose(distances, core.batch_distance(rows, query))
+        np.testing.assert_allclose(norms, core.batch_norms(rows))
+        assert list(center) == list(core.centroid(rows))
+        np.testing.assert_array_equal(indices, core.k_nearest(rows, query, 3)[0])
+
+    def test_backpressure(self, rows):
+        """Test that no more than max_in_flight jobs are outstanding."""
+        from vectors import aio
+
+        async def run():
+            executor = aio.AsyncBatchExecutor(max_in_flight=2)
+            tasks = [asyncio.ensure_future(executor.batch_norms(rows)) for _ in range(8)]
+            await asyncio.sleep(0)
+            assert executor.in_flight <= 2
+            results = await asyncio.gather(*tasks)
+            await executor.aclose()
+            return results
+
+        assert len(asyncio.run(run())) == 8
+
+    def test_errors_and_cancellation(self, rows):
+        """Test that kernel errors propagate and cancelled jobs free their slot."""
+        from vectors import aio
+
+        async def run():
+            executor = aio.AsyncBatchExecutor(max_in_flight=1)
+            with pytest.raises(RuntimeError):
+                await executor.batch_distance(rows, core.VectorND([1.0]))
+            big = np.ones((200000, 8))
+            task = asyncio.ensure_future(executor.batch_norms(big))
+            await asyncio.sleep(0)
+            task.cancel()
+            with pytest.raises(asyncio.CancelledError):
+                await task
+            norms = await asyncio.wait_for(executor.batch_norms(rows), timeout=10)
+            await executor.aclose()
+            return norms
+
+        np.testing.assert_allclose(asyncio.run(run()), core.batch_norms(rows))
+
+    def test_native_job_handles(self, rows):
+        """Test the native executor directly."""
+        executor = core.AsyncExecutor(max_in_flight=1)
+        job = executor.submit_batch_norms(rows)
+        job.wait()
+        assert job.state == core.JobState.DONE
+        assert [j.id for j in executor.drain()] == [job.id]
+        np.testing.assert_allclose(job.result(), core.batch_norms(rows))
+        executor.close()
+        with pytest.raises(RuntimeError):
+            executor.submit_batch_norms(rows)
+
+    def test_job_inputs_stay_pinned(self):
+        """Test that a batch read by an undrained job cannot be reallocated."""
+        executor = core.AsyncExecutor(max_in_flight=1)
+        batch = core.VectorBatch(np.ones((1000, 4)))
+        job = executor.submit_batch_norms(batch)
+        with pytest.raises(BufferError):
+            batch.append(core.VectorND([1.0, 1.0, 1.0, 1.0]))
+        job.wait()
+        executor.drain()
+        batch.append(core.VectorND([1.0, 1.0, 1.0, 1.0]))
+        executor.close()
+
+    def test_default_executor_released_with_loop(self, rows):
+        """Test that each asyncio.run does not leave its default executor behind."""
+        import gc
+        import weakref
+        from vectors import aio
+
+        async def run():
+            await aio.batch_norms(rows)
+            return weakref.ref(aio.default_executor())
+
+        executor = asyncio.run(run())
+        gc.collect()
+        assert executor() is None
+
+
+class TestUfuncs:
+    """Test the NumPy generalized ufuncs."""
+
+    def test_broadcasting(self, rows):
+        """Test that the ufuncs broadcast over leading axes."""
+        from vectors import ufuncs
+
+        stacked = rows.reshape(2, 5, 3)
+        query = np.array([1.0, -2.0, 0.5])
+        np.testing.assert_allclose(ufuncs.dot(stacked, query), stacked @ query)
+        np.testing.assert_allclose(ufuncs.cross(stacked, query), np.cross(stacked, query))
+        np.testing.assert_allclose(ufuncs.magnitude(stacked), np.linalg.norm(stacked, axis=-1))
+        np.testing.assert_allclose(ufuncs.distance(stacked, query),
+                                   np.linalg.norm(stacked - query, axis=-1))
+        assert ufuncs.dot(stacked, query).shape == (2, 5)
+
+    def test_matches_vector_nd(self, rows):
+        """Test that results equal the VectorND methods exactly."""
+        from vectors import ufuncs
+
+        a = core.VectorND(list(rows[3]))
+        b = core.VectorND(list(rows[7]))
+        assert ufuncs.dot(rows[3], rows[7]) == a.dot(b)
+        assert ufuncs.distance(rows[3], rows[7]) == a.distance(b)
+        assert ufuncs.cosine_similarity(rows[3], rows[7]) == a.cosine_similarity(b)
+        assert list(ufuncs.normalize(rows[3])) == list(a.normalize())
+
+    def test_out_and_strided_inputs(self, rows):
+        """Test out= and inputs whose last axis is not contiguous."""
+        from vectors import ufuncs
+
+        columns = np.asfortranarray(rows)
+        out = np.empty(10)
+        result = ufuncs.dot(columns, columns, out=out)
+        assert result is out
+        np.testing.assert_allclose(out, np.einsum("ij,ij->i", rows, rows))
+        normalized = rows.copy()
+        ufuncs.normalize(normalized[1:], out=normalized[1:])
+        np.testing.assert_allclose(np.linalg.norm(normalized[1:], axis=-1), 1.0)
+
+    def test_zero_vector_and_shape_errors(self):
+        """Test NaN for zero vectors and errors for mismatched core dimensions."""
+        from vectors import ufuncs
+
+        with np.errstate(invalid="ignore"):
+            assert np.isnan(ufuncs.normalize(np.zeros(3))).all()
+        with pytest.raises(ValueError):
+            ufuncs.dot(np.ones(3), np.ones(4))
+        with pytest.raises(ValueError):
+            ufuncs.cross(np.ones(2), np.ones(2))
+
+
+class TestMappedVectorBatch:
+    """Test the memory-mapped vector file format."""
+
+    def test_write_and_map(self, tmp_path, rows):
+        """Test writing a file and running kernels over the mapping."""
+        path = str(tmp_path / "vectors.vec")
+        with core.VectorFileWriter(path, 3) as writer:
+            writer.write_batch(rows)
+            writer.write(core.VectorND([1.0, 1.0, 1.0]))
+        mapped = core.MappedVectorBatch(path)
+        assert len(mapped) == 11
+        view = np.asarray(mapped)
+        assert not view.flags.writeable
+        np.testing.assert_array_equal(view[:10], rows)
+        dots = core.batch_dot_product(mapped, mapped)
+        assert dots[10] == 3.0
+
+    def test_append(self, tmp_path, rows):
+        """Test appending to an existing file in chunks."""
+        path = str(tmp_path / "vectors.vec")
+        with core.VectorFileWriter(path, 3) as writer:
+            writer.write_batch(rows)
+        with core.VectorFileWriter(path, 3, append=True) as writer:
+            writer.write_batch(rows)
+            assert writer.count == 20
+        mapped = core.MappedVectorBatch(path)
+        assert len(mapped) == 20
+        center = core.centroid(mapped)
+        assert center[0] == rows[:, 0].mean()
+
+    def test_append_dimension_mismatch(self, tmp_path, rows):
+        """Test that appending with the wrong dimensions fails."""
+        path = str(tmp_path / "vectors.vec")
+        with core.VectorFileWriter(path, 3) as writer:
+            writer.write_batch(rows)
+        with pytest.raises(RuntimeError):
+            core.VectorFileWriter(path, 4, append=True)
+
+    def test_not_a_vector_file(self, tmp_path):
+        """Test that arbitrary files are rejected."""
+        path = tmp_path / "bogus.vec"
+        path.write_bytes(b"x" * 128)
+        with pytest.raises(RuntimeError):
+            core.MappedVectorBatch(str(path))
+
+
+def write_vecs(path, rows, dtype):
+    """Write rows in the .fvecs/.ivecs/.bvecs layout."""
+    with open(path, "wb") as f:
+        for row in rows.astype(dtype):
+            f.write(np.int32(len(row)).tobytes())
+            f.write(row.tobytes())
+
+
+class TestLoaders:
+    """Test the native dataset readers."""
+
+    @pytest.mark.parametrize("mmap", [False, True])
+    @pytest.mark.parametrize("ext,dtype", [("fvecs", np.float32), ("ivecs", np.int32),
+                                           ("bvecs", np.uint8)])
+    def test_vecs_formats(self, tmp_path, rows, ext, dtype, mmap):
+        """Test each vecs flavour through both read paths."""
+        path = str(tmp_path / ("data." + ext))
+        write_vecs(path, rows, dtype)
+        batch = core.load_vectors(path, mmap=mmap)
+        np.testing.assert_array_equal(np.asarray(batch), rows.astype(dtype))
+
+    @pytest.mark.parametrize("dtype", [np.float32, np.float64, np.int16, np.uint8])
+    def test_npy(self, tmp_path, rows, dtype):
+        """Test .npy files of several dtypes."""
+        path = str(tmp_path / "data.npy")
+        np.save(path, rows.astype(dtype))
+        np.testing.assert_array_equal(np.asarray(core.load_npy(path)), rows.astype(dtype))
+
+    def test_start_and_count(self, tmp_path, rows):
+        """Test reading a slice of the file."""
+        path = str(tmp_path / "data.fvecs")
+        write_vecs(path, rows, np.float32)
+        batch = core.load_fvecs(path, start=2, count=3)
+        np.testing.assert_array_equal(np.asarray(batch), rows[2:5])
+        assert len(core.load_fvecs(path, start=20)) == 0
+
+    def test_inconsistent_dimensions(self, tmp_path, rows):
+        """Test that records with a different dimension are rejected."""
+        path = str(tmp_path / "data.fvecs")
+        write_vecs(path, rows, np.float32)
+        with open(path, "r+b") as f:
+            f.seek(2 * (4 + 3 * 4))
+            f.write(np.int32(2).tobytes())
+        with pytest.raises(RuntimeError):
+            core.load_fvecs(path)
+
+    def test_fortran_order_rejected(self, tmp_path, rows):
+        """Test that Fortran-ordered arrays are rejected."""
+        path = str(tmp_path / "data.npy")
+        np.save(path, np.asfortranarray(rows))
+        with pytest.raises(RuntimeError):
+            core.load_npy(path)
+
+    @pytest.mark.parametrize("shape", [(2**62, 4), (1, 2**62)])
+    def test_malformed_npy_shape_rejected(self, tmp_path, shape):
+        """Test that a shape whose byte size wraps around is not trusted."""
+        header = "{'descr': '<f8', 'fortran_order': False, 'shape': %r, }" % (shape,)
+        header = header.ljust(117) + "\n"
+        path = tmp_path / "data.npy"
+        path.write_bytes(b"\x93NUMPY\x01\x00" + len(header).to_bytes(2, "little") +
+                         header.encode("latin1") + bytes(64))
+        with pytest.raises(RuntimeError, match="Truncated|Corrupt"):
+            core.load_npy(str(path))
+
+
+@pytest.fixture
+def shared(rows):
+    """Fixture for a shared-memory batch holding `rows`, unlinked afterwards."""
+    batch = core.SharedVectorBatch.create("vectra-test-" + uuid.uuid4().hex[:8], *rows.shape)
+    batch.assign(rows)
+    yield batch
+    batch.unlink()
+
+
+class TestSharedVectorBatch:
+    """Test batches in named shared memory."""
+
+    def test_attach_sees_same_rows(self, shared, rows):
+        """Test that an attached handle shares the creator's pages."""
+        attached = core.SharedVectorBatch(shared.name)
+        assert attached.read_only
+        np.testing.assert_array_equal(np.asarray(attached), rows)
+        shared[0] = core.VectorND([9.0, 9.0, 9.0])
+        assert attached[0][0] == 9.0
+
+    def test_kernels_run_in_place(self, shared, rows):
+        """Test read-only kernels directly on the segment."""
+        attached = core.SharedVectorBatch(shared.name)
+        np.testing.assert_allclose(core.batch_dot_product(attached, rows),
+                                   np.einsum("ij,ij->i", rows, rows))
+        indices, _ = core.k_nearest(attached, core.VectorND([0.0, 1.0, 2.0]), 1)
+        assert indices[0] == 0
+
+    def test_read_only_attach(self, shared):
+        """Test that read-only handles reject writes."""
+        attached = core.SharedVectorBatch(shared.name)
+        assert not np.asarray(attached).flags.writeable
+        with pytest.raises(RuntimeError):
+            attached[0] = core.VectorND([1.0, 2.0, 3.0])
+
+    def test_pickle_attaches_by_name(self, shared, rows):
+        """Test that pickling reattaches instead of copying."""
+        restored = pickle.loads(pickle.dumps(shared))
+        assert restored.name == shared.name
+        np.testing.assert_array_equal(np.asarray(restored), rows)
+
+    def test_create_existing_name_fails(self, shared):
+        """Test that create refuses to reuse a name."""
+        with pytest.raises(RuntimeError):
+            core.SharedVectorBatch.create(shared.name, 1, 1)
+
+
+class TestSerialization:
+    """Test pickling and the compact binary format."""
+
+    @pytest.mark.parametrize("protocol", [2, 4, 5])
+    def test_pickle_vector(self, protocol):
+        """Test pickling a VectorND under old and new protocols."""
+        v = core.VectorND([1.0, -2.5, 3.0])
+        restored = pickle.loads(pickle.dumps(v, protocol=protocol))
+        assert restored == v
+
+    @pytest.mark.parametrize("protocol", [2, 4, 5])
+    def test_pickle_batch(self, rows, protocol):
+        """Test pickling a VectorBatch."""
+        restored = pickle.loads(pickle.dumps(core.VectorBatch(rows), protocol=protocol))
+        np.testing.assert_array_equal(np.asarray(restored), rows)
+
+    def test_out_of_band_buffers(self, rows):
+        """Test that protocol 5 hands the rows over out-of-band."""
+        buffers = []
+        data = pickle.dumps(core.VectorBatch(rows), protocol=5, buffer_callback=buffers.append)
+        assert len(buffers) == 1
+        assert len(data) < rows.nbytes
+        restored = pickle.loads(data, buffers=buffers)
+        np.testing.assert_array_equal(np.asarray(restored), rows)
+
+    def test_pickle_mapped_batch(self, tmp_path, rows):
+        """Test that a mapped batch pickles as a reference to its file."""
+        path = str(tmp_path / "vectors.vec")
+        with core.VectorFileWriter(path, 3) as writer:
+            writer.write_batch(rows)
+        restored = pickle.loads(pickle.dumps(core.MappedVectorBatch(path)))
+        assert restored.path == path
+        np.testing.assert_array_equal(np.asarray(restored), rows)
+
+    def test_bytes_round_trip(self, rows):
+        """Test to_bytes/from_bytes for vectors and batches."""
+        v = core.VectorND([1.0, 2.0])
+        assert core.VectorND.from_bytes(v.to_bytes()) == v
+        data = core.VectorBatch(rows).to_bytes()
+        assert len(data) == 24 + rows.nbytes
+        restored = core.VectorBatch.from_bytes(memoryview(data))
+        np.testing.assert_array_equal(np.asarray(restored), rows)
+
+    def test_from_bytes_rejects_bad_data(self, rows):
+        """Test that truncated or foreign data is rejected."""
+        data = core.VectorBatch(rows).to_bytes()
+        with pytest.raises(RuntimeError):
+            core.VectorBatch.from_bytes(data[:-1])
+        with pytest.raises(RuntimeError):
+            core.VectorND.from_bytes(data)
+        with pytest.raises(RuntimeError):
+            core.VectorND.from_bytes(b"not vector data at all!!")
+
+    def test_oversized_batch_rejected(self):
+        """Test that a row count whose size wraps around is refused."""
+        batch = core.VectorBatch(4)
+        with pytest.raises(RuntimeError, match="Batch too large"):
+            batch.resize(2**62)
+        with pytest.raises(RuntimeError, match="Batch too large"):
+            batch.__setstate__((2**62, b""))
+        assert len(batch) == 0
+
+
+if __name__ == "__main__":
+    pytest.main([__file__])